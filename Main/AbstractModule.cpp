@@ -89,6 +89,10 @@ WorkStatus::WorkStatus()
   memset(lastStatuses,0,sizeof(uint8_t)*STATUSES_BYTES);
   memset(&State,0,sizeof(State));
   memset(&UsedPins,0,sizeof(UsedPins));
+
+#ifdef USE_DELTA_STATUS
+  changeSeq = 0;
+#endif
 }
 void WorkStatus::PinMode(byte pinNumber,byte mode, bool setMode)
 {
@@ -121,12 +125,17 @@ void WorkStatus::SaveWindowState(byte channel, byte state)
   // state у нас принимает значения HIGH или LOW, т.е. 0 или 1
   // channel - номер канала, от 0 до 31
 
+  unsigned long was = State.WindowsState;
+
   // сперва сбрасываем нужный бит
   State.WindowsState &= ~(1 << channel);
 
   // теперь, если нам передали не 0 - устанавливаем нужный бит
   if(state == RELAY_ON)
      State.WindowsState |= (1 << channel);
+
+  if(was != State.WindowsState)
+    StateChanged();
      
 }
 void WorkStatus::SaveLightChannelState(byte channel, byte state)
@@ -134,24 +143,34 @@ void WorkStatus::SaveLightChannelState(byte channel, byte state)
   if(channel > 7)
     return;
 
+  byte was = State.LightChannelsState;
+
   // сперва сбрасываем нужный бит
   State.LightChannelsState &= ~(1 << channel);
 
   // теперь, если нам передали не 0 - устанавливаем нужный бит
   if(state == RELAY_ON)
     State.LightChannelsState |= (1 << channel);  
+
+  if(was != State.LightChannelsState)
+    StateChanged();
 }
 void WorkStatus::SaveWaterChannelState(byte channel, byte state)
 {
   if(channel > 7)
     return;
 
+  byte was = State.WaterChannelsState;
+
   // сперва сбрасываем нужный бит
   State.WaterChannelsState &= ~(1 << channel);
 
   // теперь, если нам передали не 0 - устанавливаем нужный бит
   if(state == RELAY_ON)
     State.WaterChannelsState |= (1 << channel);
+
+  if(was != State.WaterChannelsState)
+    StateChanged();
 }
 void WorkStatus::PinWrite(byte pin, byte level)
 {
@@ -186,12 +205,17 @@ void WorkStatus::PinWrite(byte pin, byte level)
       return;
   #endif
 
+  byte was = State.PinsState[byte_num];
+
   // сперва сбрасываем нужный бит
   State.PinsState[byte_num] &= ~(1 << bit_num);
 
   // теперь, если нам передали не 0 - устанавливаем нужный бит
   if(level)
     State.PinsState[byte_num] |= (1 << bit_num);
+
+  if(was != State.PinsState[byte_num])
+    StateChanged();
 }
 void WorkStatus::CopyStatusModes()
 {
@@ -217,7 +241,11 @@ void WorkStatus::SetStatus(uint8_t bitNum, bool bOn)
   uint8_t byte_num = bitNum/8;
   uint8_t bit_num = bitNum%8;
 
+  uint8_t was = statuses[byte_num];
   bitWrite(statuses[byte_num],bit_num,(bOn ? 1 : 0));
+
+  if(was != statuses[byte_num])
+    StateChanged();
 }
 void WorkStatus::SetModeUnchanged()
 {
@@ -322,8 +350,8 @@ void OneState::Update(void* newData) // обновляем внутреннее
       case StateSoilMoisture: // и для влажности почвы используем структуру температуры
       case StatePH: // и для pH  используем структуру температуры
       {
-        Temperature* t1 = (Temperature*) Data;
-        Temperature* t2 = (Temperature*) PreviousData;
+        Temperature* t1 = (Temperature*) &DataValue;
+        Temperature* t2 = (Temperature*) &PreviousDataValue;
 
         *t2 = *t1; // сохраняем предыдущую температуру
 
@@ -344,8 +372,8 @@ void OneState::Update(void* newData) // обновляем внутреннее
 
       case StateLuminosity:
       {
-        long*  ui1 = (long*) Data;
-        long*  ui2 = (long*) PreviousData;
+        long*  ui1 = (long*) &DataValue;
+        long*  ui2 = (long*) &PreviousDataValue;
 
         *ui2 = *ui1; // сохраняем предыдущее состояние освещенности
 
@@ -357,8 +385,8 @@ void OneState::Update(void* newData) // обновляем внутреннее
       case StateWaterFlowInstant: // работаем с датчиками расхода воды
       case StateWaterFlowIncremental:
       {
-        unsigned long*  ui1 = (unsigned long*) Data;
-        unsigned long*  ui2 = (unsigned long*) PreviousData;
+        unsigned long*  ui1 = (unsigned long*) &DataValue;
+        unsigned long*  ui2 = (unsigned long*) &PreviousDataValue;
 
         *ui2 = *ui1; // сохраняем предыдущее состояние расхода воды
 
@@ -372,12 +400,36 @@ void OneState::Update(void* newData) // обновляем внутреннее
       break;
       
     } // switch
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    if(IsChanged()) // показания поменялись - помечаем датчик, чтобы правила его проверили
+    {
+      Dirty = 1;
+      ModuleState::MarkChanged();
+    }
+#endif
+
+#ifdef USE_DELTA_STATUS
+    // номер изменения ставим здесь, а не в ModuleState::UpdateState, т.к. часть модулей обновляет OneState напрямую
+    if(IsChanged())
+      ChangeSeq = ModuleState::NextChangeSequence();
+#endif
  
 }
 void OneState::Init(ModuleStates state, uint8_t idx)
 {
     Type = state;
     Index = idx;
+    DataValue = 0;
+    PreviousDataValue = 0;
+    
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    Dirty = 0;
+#endif
+
+#ifdef USE_DELTA_STATUS
+    ChangeSeq = ModuleState::NextChangeSequence(); // новый датчик - тоже изменение
+#endif
 
     switch(state)
     {
@@ -386,41 +438,34 @@ void OneState::Init(ModuleStates state, uint8_t idx)
       case StateSoilMoisture: // и для влажности почвы используем структуру температуры
       case StatePH: // и для pH  используем структуру температуры
       {
-      
-        Temperature* t1 = new Temperature;
-        Temperature* t2 = new Temperature;
-        
-        Data = t1;
-        PreviousData = t2;
+        // данные хранятся прямо в структуре, без выделения памяти
+        Temperature* t1 = (Temperature*) &DataValue;
+        Temperature* t2 = (Temperature*) &PreviousDataValue;
+
+        *t1 = Temperature(); // нет данных о температуре
+        *t2 = Temperature();
       }
         
       break;
 
       case StateLuminosity:
       {
-        long*  ui1 = new long;
-        long*  ui2 = new long;
+        long*  ui1 = (long*) &DataValue;
+        long*  ui2 = (long*) &PreviousDataValue;
 
         *ui1 = NO_LUMINOSITY_DATA; // нет данных об освещенности
         *ui2 = NO_LUMINOSITY_DATA;
-        
-        Data = ui1;
-        PreviousData = ui2;
       }
       break;
 
       case StateWaterFlowInstant:
       case StateWaterFlowIncremental:
       {
-        unsigned long*  ui1 = new unsigned long;
-        unsigned long*  ui2 = new unsigned long;
+        unsigned long*  ui1 = (unsigned long*) &DataValue;
+        unsigned long*  ui2 = (unsigned long*) &PreviousDataValue;
 
         *ui1 = 0; // нет данных о расходе воды
         *ui2 = 0;
-        
-        Data = ui1;
-        PreviousData = ui2;
-        
       }
       break;
 
@@ -439,20 +484,20 @@ OneState::operator String() // выводим текущие значения к
       case StatePH: // и для pH  используем структуру температуры
       {
       
-        Temperature* t1 = (Temperature*) Data;
+        Temperature* t1 = (Temperature*) &DataValue;
         return *t1;
       }
         
       case StateLuminosity:
       {
-        long*  ul1 = (long*) Data;
+        long*  ul1 = (long*) &DataValue;
         return String(*ul1);
       }
 
       case StateWaterFlowInstant:
       case StateWaterFlowIncremental:
       {
-        unsigned long*  ul1 = (unsigned long*) Data;
+        unsigned long*  ul1 = (unsigned long*) &DataValue;
         return String(*ul1);        
       }
 
@@ -483,11 +528,11 @@ OneState& OneState::operator=(const OneState& rhs)
         case StateSoilMoisture: // и для влажности почвы используем структуру температуры
         case StatePH: // и для pH  используем структуру температуры
         {
-          Temperature* rhs_t1 = (Temperature*) rhs.Data;
-          Temperature* rhs_t2 = (Temperature*) rhs.PreviousData;
+          Temperature* rhs_t1 = (Temperature*) &rhs.DataValue;
+          Temperature* rhs_t2 = (Temperature*) &rhs.PreviousDataValue;
 
-          Temperature* this_t1 = (Temperature*) Data;
-          Temperature* this_t2 = (Temperature*) PreviousData;
+          Temperature* this_t1 = (Temperature*) &DataValue;
+          Temperature* this_t2 = (Temperature*) &PreviousDataValue;
 
           *this_t1 = *rhs_t1;
           *this_t2 = *rhs_t2;
@@ -497,11 +542,11 @@ OneState& OneState::operator=(const OneState& rhs)
 
         case StateLuminosity:
         {
-          long*  rhs_ui1 = (long*) rhs.Data;
-          long*  rhs_ui2 = (long*) rhs.PreviousData;
+          long*  rhs_ui1 = (long*) &rhs.DataValue;
+          long*  rhs_ui2 = (long*) &rhs.PreviousDataValue;
   
-          long*  this_ui1 = (long*) Data;
-          long*  this_ui2 = (long*) PreviousData;
+          long*  this_ui1 = (long*) &DataValue;
+          long*  this_ui2 = (long*) &PreviousDataValue;
 
           *this_ui1 = *rhs_ui1;
           *this_ui2 = *rhs_ui2;
@@ -511,11 +556,11 @@ OneState& OneState::operator=(const OneState& rhs)
         case StateWaterFlowInstant:
         case StateWaterFlowIncremental:
         {
-          unsigned long*  rhs_ui1 = (unsigned long*) rhs.Data;
-          unsigned long*  rhs_ui2 = (unsigned long*) rhs.PreviousData;
+          unsigned long*  rhs_ui1 = (unsigned long*) &rhs.DataValue;
+          unsigned long*  rhs_ui2 = (unsigned long*) &rhs.PreviousDataValue;
   
-          unsigned long*  this_ui1 = (unsigned long*) Data;
-          unsigned long*  this_ui2 = (unsigned long*) PreviousData;
+          unsigned long*  this_ui1 = (unsigned long*) &DataValue;
+          unsigned long*  this_ui2 = (unsigned long*) &PreviousDataValue;
 
           *this_ui1 = *rhs_ui1;
           *this_ui2 = *rhs_ui2;
@@ -539,8 +584,8 @@ bool OneState::IsChanged()
         case StateSoilMoisture: // и для влажности почвы используем структуру температуры
         case StatePH: // и для pH  используем структуру температуры
         {
-          Temperature* t1 = (Temperature*) Data;
-          Temperature* t2 = (Temperature*) PreviousData;
+          Temperature* t1 = (Temperature*) &DataValue;
+          Temperature* t2 = (Temperature*) &PreviousDataValue;
 
           if(*t1 != *t2)
             return true; // температура изменилась
@@ -550,8 +595,8 @@ bool OneState::IsChanged()
 
         case StateLuminosity:
         {
-          long*  ui1 = (long*) Data;
-          long*  ui2 = (long*) PreviousData;
+          long*  ui1 = (long*) &DataValue;
+          long*  ui2 = (long*) &PreviousDataValue;
   
          if(*ui1 != *ui2)
           return true; // состояние освещенности изменилось
@@ -561,8 +606,8 @@ bool OneState::IsChanged()
         case StateWaterFlowInstant:
         case StateWaterFlowIncremental:
         {
-          unsigned long*  ui1 = (unsigned long*) Data;
-          unsigned long*  ui2 = (unsigned long*) PreviousData;
+          unsigned long*  ui1 = (unsigned long*) &DataValue;
+          unsigned long*  ui2 = (unsigned long*) &PreviousDataValue;
   
          if(*ui1 != *ui2)
           return true; // состояние освещенности изменилось
@@ -624,13 +669,13 @@ bool OneState::HasData()
     case StatePH:
     case StateSoilMoisture:
     {
-      Temperature* t = (Temperature*) Data;
+      Temperature* t = (Temperature*) &DataValue;
       return t->HasData();
     }
 
     case StateLuminosity:
     {
-      long*  ui1 = (long*) Data;
+      long*  ui1 = (long*) &DataValue;
       return *ui1 != NO_LUMINOSITY_DATA;
     }
 
@@ -655,7 +700,7 @@ uint8_t OneState::GetRawData(byte* outBuffer)
     case StateSoilMoisture:
     case StatePH:
     {
-        Temperature* t = (Temperature*) Data;
+        Temperature* t = (Temperature*) &DataValue;
         *outBuffer++ = t->Fract;
         *outBuffer = t->Value;
       return 2;
@@ -664,7 +709,7 @@ uint8_t OneState::GetRawData(byte* outBuffer)
     // для освещённости пишем два байта в сырые данные
     case StateLuminosity:
     {
-      long* lum = (long*) Data;
+      long* lum = (long*) &DataValue;
       memcpy(outBuffer,lum,2);
       return 2;
     }
@@ -672,7 +717,7 @@ uint8_t OneState::GetRawData(byte* outBuffer)
     case StateWaterFlowInstant:
     case StateWaterFlowIncremental:
     {
-      unsigned long* flow = (unsigned long*) Data;
+      unsigned long* flow = (unsigned long*) &DataValue;
       memcpy(outBuffer,flow,sizeof(unsigned long));
       return sizeof(unsigned long);
     }
@@ -681,6 +726,73 @@ uint8_t OneState::GetRawData(byte* outBuffer)
   }
   return 0;
 }
+bool OneState::GetFixedValue(long& value)
+{
+  if(!HasData())
+    return false;
+
+  switch(Type)
+  {
+    case StateTemperature:
+    case StateHumidity:
+    case StateSoilMoisture:
+    case StatePH:
+    {
+      Temperature* t = (Temperature*) &DataValue;
+      value = t->Value*100L;
+      if(t->Value < 0)
+        value -= t->Fract;
+      else
+        value += t->Fract;
+      return true;
+    }
+
+    case StateLuminosity:
+    {
+      long* lum = (long*) &DataValue;
+      value = *lum;
+      return true;
+    }
+
+    case StateWaterFlowInstant:
+    case StateWaterFlowIncremental:
+    {
+      unsigned long* flow = (unsigned long*) &DataValue;
+      value = (long) *flow;
+      return true;
+    }
+
+    case StateUnknown:
+      return false;
+  }
+
+  return false;
+}
+String OneState::FormatFixedValue(ModuleStates type, long value)
+{
+  switch(type)
+  {
+    case StateTemperature:
+    case StateHumidity:
+    case StateSoilMoisture:
+    case StatePH:
+    {
+      String result;
+      if(value < 0)
+      {
+        result = F("-");
+        value = -value;
+      }
+
+      sprintf_P(SD_BUFFER,(const char*) F("%ld,%02u"), value/100, (unsigned int) (value%100));
+      result += SD_BUFFER;
+      return result;
+    }
+
+    default:
+      return String(value);
+  }
+}
 String OneState::GetStringType(ModuleStates type)
 {
   switch(type)
@@ -740,50 +852,7 @@ ModuleStates OneState::GetType(const char* stringType)
 }
 OneState::~OneState()
 {
-  // подчищаем за собой
-  
-       switch(Type)
-      {
-        case StateTemperature:
-        case StateHumidity: // и для влажности используем структуру температуры
-        case StateSoilMoisture: // и для влажности почвы используем структуру температуры
-        case StatePH: // и для pH  используем структуру температуры
-        {
-          Temperature* t1 = (Temperature*) Data;
-          Temperature* t2 = (Temperature*) PreviousData;
-
-          delete t1;
-          delete t2;
-        }
-        break;
-
-        case StateLuminosity:
-        {
-          long*  ui1 = (long*) Data;
-          long*  ui2 = (long*) PreviousData;
-  
-          delete ui1;
-          delete ui2;
-        }  
-        break;
-
-        case StateWaterFlowInstant:
-        case StateWaterFlowIncremental:
-        {
-          unsigned long*  ui1 = (unsigned long*) Data;
-          unsigned long*  ui2 = (unsigned long*) PreviousData;
-  
-          delete ui1;
-          delete ui2;
-        }  
-        break;
-
-        case StateUnknown:
-        break;
-      
-      } // switch
- 
-  
+  // данные хранятся прямо в структуре, подчищать нечего
 }
 OneState::operator HumidityPair()
 {
@@ -795,7 +864,7 @@ OneState::operator HumidityPair()
   return HumidityPair(Humidity(),Humidity()); // undefined behaviour
   }
 
-    return HumidityPair(*((Humidity*)PreviousData),*((Humidity*)Data));  
+    return HumidityPair(*((Humidity*) &PreviousDataValue),*((Humidity*) &DataValue));  
 }
 OneState::operator TemperaturePair()
 {
@@ -807,7 +876,7 @@ OneState::operator TemperaturePair()
   return TemperaturePair(Temperature(),Temperature()); // undefined behaviour
   }
 
-    return TemperaturePair(*((Temperature*)PreviousData),*((Temperature*)Data));
+    return TemperaturePair(*((Temperature*) &PreviousDataValue),*((Temperature*) &DataValue));
 }
 OneState::operator LuminosityPair()
 {
@@ -818,7 +887,7 @@ OneState::operator LuminosityPair()
   #endif
   return LuminosityPair(0,0); // undefined behaviour
   }
-  return LuminosityPair(*((long*)PreviousData),*((long*)Data));   
+  return LuminosityPair(*((long*) &PreviousDataValue),*((long*) &DataValue));   
 }
 OneState::operator WaterFlowPair()
 {
@@ -829,7 +898,7 @@ OneState::operator WaterFlowPair()
   #endif
   return WaterFlowPair(0,0); // undefined behaviour
   }
-  return WaterFlowPair(*((unsigned long*)PreviousData),*((unsigned long*)Data));   
+  return WaterFlowPair(*((unsigned long*) &PreviousDataValue),*((unsigned long*) &DataValue));   
 }
 
 OneState operator-(const OneState& left, const OneState& right)
@@ -851,18 +920,18 @@ OneState operator-(const OneState& left, const OneState& right)
         case StateSoilMoisture: // и для влажности почвы используем структуру температуры
         case StatePH: // и для pH  используем структуру температуры
         {
-          Temperature* t1 = (Temperature*) left.Data;
-          Temperature* t2 = (Temperature*) right.Data;
+          Temperature* t1 = (Temperature*) &left.DataValue;
+          Temperature* t2 = (Temperature*) &right.DataValue;
 
 
-          Temperature* thisT = (Temperature*) result.Data;
+          Temperature* thisT = (Temperature*) &result.DataValue;
           if(t1->Value != NO_TEMPERATURE_DATA && t2->Value != NO_TEMPERATURE_DATA) // только если есть показания с датчиков
               *thisT = (*t1 - *t2); // получаем дельту текущих изменений
           
-          t1 = (Temperature*) left.PreviousData;
-          t2 = (Temperature*) right.PreviousData;
+          t1 = (Temperature*) &left.PreviousDataValue;
+          t2 = (Temperature*) &right.PreviousDataValue;
 
-          thisT = (Temperature*) result.PreviousData;
+          thisT = (Temperature*) &result.PreviousDataValue;
           if(t1->Value != NO_TEMPERATURE_DATA && t2->Value != NO_TEMPERATURE_DATA) // только если есть показания с датчиков
               *thisT = (*t1 - *t2); // получаем дельту предыдущих изменений
         
@@ -871,19 +940,19 @@ OneState operator-(const OneState& left, const OneState& right)
 
         case StateLuminosity:
         {
-          long*  ui1 = (long*) left.Data;
-          long*  ui2 = (long*) right.Data;
+          long*  ui1 = (long*) &left.DataValue;
+          long*  ui2 = (long*) &right.DataValue;
 
-          long* thisLong = (long*) result.Data;
+          long* thisLong = (long*) &result.DataValue;
 
           // получаем дельту текущих изменений
           if(*ui1 != NO_LUMINOSITY_DATA && *ui2 != NO_LUMINOSITY_DATA) // только если есть показания с датчиков
             *thisLong = abs((*ui1 - *ui2));
 
-          ui1 = (long*) left.PreviousData;
-          ui2 = (long*) right.PreviousData;
+          ui1 = (long*) &left.PreviousDataValue;
+          ui2 = (long*) &right.PreviousDataValue;
 
-          thisLong = (long*) result.PreviousData;
+          thisLong = (long*) &result.PreviousDataValue;
 
           // получаем дельту предыдущих изменений
           if(*ui1 != NO_LUMINOSITY_DATA && *ui2 != NO_LUMINOSITY_DATA) // только если есть показания с датчиков
@@ -894,18 +963,18 @@ OneState operator-(const OneState& left, const OneState& right)
         case StateWaterFlowInstant:
         case StateWaterFlowIncremental:
         {
-          unsigned long*  ui1 = (unsigned long*) left.Data;
-          unsigned long*  ui2 = (unsigned long*) right.Data;
+          unsigned long*  ui1 = (unsigned long*) &left.DataValue;
+          unsigned long*  ui2 = (unsigned long*) &right.DataValue;
 
-          unsigned long* thisUi = (unsigned long*) result.Data;
+          unsigned long* thisUi = (unsigned long*) &result.DataValue;
 
           // получаем дельту текущих изменений
           *thisUi = abs((*ui1 - *ui2));
 
-          ui1 = (unsigned long*) left.PreviousData;
-          ui2 = (unsigned long*) right.PreviousData;
+          ui1 = (unsigned long*) &left.PreviousDataValue;
+          ui2 = (unsigned long*) &right.PreviousDataValue;
 
-          thisUi = (unsigned long*) result.PreviousData;
+          thisUi = (unsigned long*) &result.PreviousDataValue;
 
           // получаем дельту предыдущих изменений
           *thisUi = abs((*ui1 - *ui2));
@@ -963,6 +1032,14 @@ Temperature operator-(const Temperature& left, const Temperature& right)
   
     return Temperature(res/100, res%100); // дельта у нас всегда положительная.
 }
+uint16_t ModuleState::layoutVersion = 0;
+#ifdef USE_EVENT_DRIVEN_ALERTS
+uint16_t ModuleState::changesVersion = 0;
+#endif
+#ifdef USE_DELTA_STATUS
+uint32_t ModuleState::changeSequence = 0;
+#endif
+
 ModuleState::ModuleState() : supportedStates(0)
 {
   
@@ -971,16 +1048,51 @@ bool ModuleState::HasState(ModuleStates state)
 {
   return ( (supportedStates & state) == state);
 }
+StateTypeSlot* ModuleState::GetSlot(ModuleStates state)
+{
+  // типов состояний в одном модуле - единицы, так что пробегаем их все
+  size_t cnt = slots.size();
+  for(size_t i=0;i<cnt;i++)
+  {
+    StateTypeSlot* slot = slots[i];
+    if(slot->Type == state)
+      return slot;
+  }
+
+  return NULL;
+}
+void ModuleState::RebuildOrders(StateTypeSlot* slot)
+{
+  slot->Orders.Clear();
+  
+  size_t cnt = slot->States.size();
+  for(size_t i=0;i<cnt;i++)
+  {
+    uint8_t idx = slot->States[i]->GetIndex();
+    
+    while(slot->Orders.size() <= idx) // расширяем таблицу до нужного индекса
+      slot->Orders.push_back(NO_STATE_ORDER);
+
+    if(slot->Orders[idx] == NO_STATE_ORDER) // при повторе индекса находим первое добавленное состояние, как и раньше
+      slot->Orders[idx] = i;
+  } // for
+}
 void ModuleState::RemoveState(ModuleStates state, uint8_t idx)
 {
+  StateTypeSlot* slot = GetSlot(state);
+  if(!slot)
+    return;
+
+  StateVec& states = slot->States;
   size_t cnt = states.size();
   for(size_t i=0;i<cnt;i++)
   {
     OneState* os = states[i];
-    if(os->GetType() == state && os->GetIndex() == idx)
+    if(os->GetIndex() == idx)
     {
       // нашли нужное состояние, удаляем его
       delete os;
+      layoutVersion++;
       // теперь сдвигаем на пустое место
       size_t wIdx = i;
       while(wIdx < cnt-1)
@@ -995,8 +1107,10 @@ void ModuleState::RemoveState(ModuleStates state, uint8_t idx)
     } // if
   } // for
 
+  RebuildOrders(slot);
+
   // теперь проверяем - если больше нет такого состояния - обнуляем его флаг.
-  if(!HasState(state)) // нет такого состояния
+  if(!states.size()) // нет такого состояния
     supportedStates &= ~state; // инвертируем все биты в state, кроме выставленного, и применяем эту маску к supportedStates. 
     // В результате в supportedStates очистятся только те биты, которые были выставлены в state.
 }
@@ -1004,20 +1118,40 @@ OneState* ModuleState::AddState(ModuleStates state, uint8_t idx)
 {
     supportedStates |= state;
     OneState* s = new OneState(state,idx);
-    states.push_back(s); // сохраняем состояние
+    layoutVersion++;
+
+    StateTypeSlot* slot = GetSlot(state);
+    if(!slot) // первое состояние такого типа
+    {
+      slot = new StateTypeSlot;
+      slot->Type = state;
+      slots.push_back(slot);
+    }
+
+    // сохраняем состояние
+    slot->States.push_back(s);
+
+    // и запоминаем, под каким номером лежит датчик с таким индексом
+    while(slot->Orders.size() <= idx)
+      slot->Orders.push_back(NO_STATE_ORDER);
+
+    if(slot->Orders[idx] == NO_STATE_ORDER)
+      slot->Orders[idx] = slot->States.size() - 1;
     
     return s;
 }
 bool ModuleState::HasChanges()
 {
-  size_t sz = states.size();
-  for(size_t i=0;i<sz;i++)
+  size_t slotsCnt = slots.size();
+  for(size_t i=0;i<slotsCnt;i++)
   {
-      OneState* s = states[i];
-
-      if(s->IsChanged())
+    StateVec& states = slots[i]->States;
+    size_t sz = states.size();
+    for(size_t j=0;j<sz;j++)
+    {
+      if(states[j]->IsChanged())
         return true;
-
+    } // for
   } // for
 
   return false;
@@ -1025,16 +1159,12 @@ bool ModuleState::HasChanges()
 }
 void ModuleState::UpdateState(ModuleStates state, uint8_t idx, void* newData)
 {
-  size_t sz = states.size();
-  for(size_t i=0;i<sz;i++)
+  OneState* s = GetState(state,idx);
+  if(s)
   {
-      OneState* s = states[i];
-      if(s->GetType() == state && s->GetIndex() == idx)
-      {
-        s->Update(newData);
-        return;
-      } // if
-  } // for
+    s->Update(newData);
+    return;
+  }
 
 #ifdef _DEBUG
 Serial.println(F("[ERR] - UpdateState FAILED!"));
@@ -1042,47 +1172,31 @@ Serial.println(F("[ERR] - UpdateState FAILED!"));
 }
 uint8_t ModuleState::GetStateCount(ModuleStates state)
 {
-  uint8_t result = 0;
-  size_t sz = states.size();
-  
-  for(size_t i=0;i<sz;i++)
-  {
-      OneState* s = states[i];
-      if(s->GetType() == state)
-        result++;
-  }
-  
-  return result;
+  StateTypeSlot* slot = GetSlot(state);
+  if(!slot)
+    return 0;
+    
+  return slot->States.size();
 }
 OneState* ModuleState::GetStateByOrder(ModuleStates state, uint8_t orderNum)
 {
-  size_t sz = states.size();
-  uint8_t cntr = 0;
-  for(size_t i=0;i<sz;i++)
-  {
-      OneState* s = states[i];
-      if(s->GetType() == state)
-      {
-        if(cntr == orderNum)
-          return s;
-
-          cntr++;
-      }
-  }
+  StateTypeSlot* slot = GetSlot(state);
+  if(!slot || orderNum >= slot->States.size())
+    return NULL;
 
-    return NULL;  
+  return slot->States[orderNum];
 }
 OneState* ModuleState::GetState(ModuleStates state, uint8_t idx)
 {
-  size_t sz = states.size();
-  for(size_t i=0;i<sz;i++)
-  {
-      OneState* s = states[i];
-      if(s->GetType() == state && s->GetIndex() == idx)
-        return s;
-  }
+  StateTypeSlot* slot = GetSlot(state);
+  if(!slot || idx >= slot->Orders.size())
+    return NULL;
 
+  uint8_t order = slot->Orders[idx];
+  if(order == NO_STATE_ORDER)
     return NULL;
+
+  return slot->States[order];
 }
 
 char SD_BUFFER[SD_BUFFER_LENGTH] = {0};
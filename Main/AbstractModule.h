@@ -161,8 +161,19 @@ class OneState
     ModuleStates Type; // тип состояния (температура, освещенность, каналы реле)
     
     uint8_t Index; // индекс (например, датчика температуры)
-    void* Data; // данные с датчика
-    void* PreviousData; // предыдущие данные с датчика
+    
+    // данные хранятся прямо в структуре: 4 байта хватает на любой тип показаний
+    // (Temperature, long, unsigned long), память в куче под них не выделяется
+    unsigned long DataValue; // данные с датчика
+    unsigned long PreviousDataValue; // предыдущие данные с датчика
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    uint8_t Dirty; // показания изменились, и правила, которые следят за датчиком, ещё их не проверили
+#endif
+
+#ifdef USE_DELTA_STATUS
+    uint32_t ChangeSeq; // номер изменения, на котором показания датчика менялись последний раз
+#endif
 
     public:
 
@@ -178,8 +189,22 @@ class OneState
     void Update(void* newData); // обновляет состояние
     bool IsChanged(); // тестирует, есть ли изменения
     bool HasData(); // проверяет, есть ли данные от датчика
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    bool IsDirty() {return Dirty;}
+    void ClearDirty() {Dirty = 0;}
+#endif
+
+#ifdef USE_DELTA_STATUS
+    uint32_t GetChangeSeq() {return ChangeSeq;}
+#endif
     uint8_t GetRawData(byte* outBuffer); // копирует сырые данные в выходной буфер, возвращает размер скопированных данных 
 
+    // показания в целых единицах (сотые доли для температуры, влажности, влажности почвы и pH; люксы для освещённости,
+    // значение счётчика для расхода воды), false - если показаний нет
+    bool GetFixedValue(long& value);
+    static String FormatFixedValue(ModuleStates type, long value); // значение в целых единицах - в строку, как в остальных ответах
+
     OneState& operator=(const OneState& rhs); // копирует состояние из одной структуры в другую, если структуры одинаковых типов, индексы при этом остаются нетронутыми
 
     friend OneState operator-(const OneState& left, const OneState& right); // оператор получения дельты состояний, индексы игнорируются, типы - должны быть одинаковыми
@@ -206,14 +231,56 @@ class OneState
 
 typedef Vector<OneState*> StateVec;
 
+#define NO_STATE_ORDER 0xFF // нет датчика с таким индексом
+
+struct StateTypeSlot
+{
+  ModuleStates Type; // тип состояний в слоте
+  StateVec States; // состояния этого типа, в порядке добавления
+  Vector<uint8_t> Orders; // индекс датчика -> номер состояния в States, NO_STATE_ORDER, если датчика с таким индексом нет
+};
+
+typedef Vector<StateTypeSlot*> StateSlotsVec;
+
 class ModuleState
 {
  uint8_t supportedStates; // какие состояния поддерживаем?
- StateVec states; // какие состояния поддерживаем?
+ StateSlotsVec slots; // состояния, разложенные по типам, для быстрого поиска по индексу датчика
+
+ StateTypeSlot* GetSlot(ModuleStates state); // возвращает слот состояний нужного типа, или NULL
+ void RebuildOrders(StateTypeSlot* slot); // перестраивает привязку индексов датчиков к номерам состояний в слоте
+
+ static uint16_t layoutVersion; // меняется при добавлении или удалении состояния в любом модуле
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+ static uint16_t changesVersion; // меняется при изменении показаний любого датчика
+#endif
+
+#ifdef USE_DELTA_STATUS
+ static uint32_t changeSequence; // сквозной номер изменения показаний датчиков и состояния контроллера
+#endif
 
 public:
   ModuleState();
 
+  // версия раскладки состояний: если изменилась - ранее запомненные указатели на OneState могли стать недействительными
+  static uint16_t GetLayoutVersion() { return layoutVersion; }
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  // версия показаний: если изменилась - какой-то из датчиков поменял показания и помечен как изменённый
+  static uint16_t GetChangesVersion() { return changesVersion; }
+  static void MarkChanged() { changesVersion++; }
+#endif
+
+#ifdef USE_DELTA_STATUS
+  // номер последнего изменения, и следующий номер изменения (0 пропускается - им клиент просит полный статус)
+  static uint32_t GetChangeSequence() { return changeSequence; }
+  static uint32_t NextChangeSequence() { if(!++changeSequence) changeSequence = 1; return changeSequence; }
+  // было ли изменение с номером seq после изменения с номером since. Счётчик 32-битный и на практике не переполняется;
+  // номер из прошлой загрузки отсекает эпоха в CTGET=0|DELTA, а номер больше текущего - ошибка клиента: тоже отдаём всё.
+  static bool IsChangedSince(uint32_t seq, uint32_t since) { return !since || since > changeSequence || seq > since; }
+#endif
+
   bool HasState(ModuleStates state); // проверяет, поддерживаются ли такие состояния?
   bool HasChanges(); // проверяет, есть ли изменения во внутреннем состоянии модуля?
   
@@ -256,6 +323,9 @@ public:
   
 };
 
+typedef uint8_t ModuleHandle; // короткий идентификатор модуля - его индекс в списке зарегистрированных модулей
+#define NO_MODULE_HANDLE 0xFF // модуль не найден
+
 // абстрактный класс резервирования датчиков
 class ReservationResolver
 {
@@ -299,7 +369,18 @@ class WorkStatus
 
   ControllerState State;
 
+#ifdef USE_DELTA_STATUS
+  uint32_t changeSeq; // номер изменения, на котором последний раз менялись статусы или состояние контроллера
+  void StateChanged() { changeSeq = ModuleState::NextChangeSequence(); }
+#else
+  void StateChanged() {}
+#endif
+
   public:
+
+#ifdef USE_DELTA_STATUS
+    uint32_t GetChangeSeq() {return changeSeq;}
+#endif
   
     void SetStatus(uint8_t bitNum, bool bOn);
     void WriteStatus(Stream* pStream, bool bAsTextHex);
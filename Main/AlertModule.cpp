@@ -19,6 +19,11 @@ AlertRule::AlertRule()
 {
   rawCommand = NULL;
   linkedModule = NULL;
+  targetModuleHandle = NO_MODULE_HANDLE;
+  watchedState = NULL;
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  reserveUsed = false;
+#endif
   
   Settings.StartTime = 0;
   Settings.WorkTime = 0;
@@ -124,6 +129,52 @@ const char* AlertRule::GetTargetCommandModuleName()
   return GetKnownModuleName(Settings.TargetModuleNameIndex);
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+AbstractModule* AlertRule::GetTargetModule()
+{
+  if(targetModuleHandle == NO_MODULE_HANDLE) // ещё не искали модуль
+    targetModuleHandle = MainController->GetModuleHandle(GetTargetCommandModuleName());
+
+  return MainController->GetModuleByHandle(targetModuleHandle);
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void AlertRule::Compile()
+{
+  watchedState = NULL;
+  
+  if(!linkedModule)
+    return;
+
+  ModuleStates stateType = StateUnknown;
+  switch(Settings.Target)
+  {
+    case rtTemp: stateType = StateTemperature; break;
+    case rtLuminosity: stateType = StateLuminosity; break;
+    case rtHumidity: stateType = StateHumidity; break;
+    case rtSoilMoisture: stateType = StateSoilMoisture; break;
+    case rtPH: stateType = StatePH; break;
+    default: return; // за пином и временем следим без состояний
+  } // switch
+
+  watchedState = linkedModule->State.GetState(stateType,Settings.SensorIndex);
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#ifdef USE_EVENT_DRIVEN_ALERTS
+bool AlertRule::NeedPolling()
+{
+  switch(Settings.Target)
+  {
+    case rtPinState: // уровень на пине сам о своём изменении не сообщает
+    case rtUnknown: // работаем только по времени
+      return true;
+
+    case rtTemp: // температуры открытия/закрытия могут поменять в настройках
+      return Settings.DataSource != tsPassed;
+  }
+
+  return reserveUsed;
+}
+#endif
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool AlertRule::HasTargetCommand()
 {
   if(Settings.TargetCommandType == commandUnparsed)
@@ -278,6 +329,10 @@ void AlertRule::Update(uint16_t dt
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool AlertRule::HasAlert()
 {
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  reserveUsed = false;
+#endif
+
   if(!linkedModule || !Settings.Enabled || !Settings.CanWork)
     return false;
 
@@ -286,10 +341,7 @@ bool AlertRule::HasAlert()
   {
     case rtTemp: // проверяем температуру
     {
-     if(!linkedModule->State.HasState(StateTemperature))  // не поддерживаем температуру
-        return false;
-
-     OneState* os = linkedModule->State.GetState(StateTemperature,Settings.SensorIndex);
+       OneState* os = watchedState; // состояние нашли при компиляции правил
        
      if(!os) // не срослось
       return false;
@@ -301,6 +353,9 @@ bool AlertRule::HasAlert()
 
        if(curTemp == NO_TEMPERATURE_DATA) // нет датчика на линии
        {
+#ifdef USE_EVENT_DRIVEN_ALERTS
+         reserveUsed = true; // резервный датчик может поменять показания, не трогая наш
+#endif
         // пытаемся найти резервирование
         OneState* reservedState = MainController->GetReservedState(linkedModule,StateTemperature,Settings.SensorIndex);
         if(!reservedState)
@@ -345,10 +400,7 @@ bool AlertRule::HasAlert()
         return true; // в этом случае считаем, что работать мы можем при любом раскладе
       } // if
       
-     if(!linkedModule->State.HasState(StateLuminosity))  // не поддерживаем освещенность
-        return false;
-
-       OneState* os = linkedModule->State.GetState(StateLuminosity,Settings.SensorIndex);
+       OneState* os = watchedState; // состояние нашли при компиляции правил
        
        if(!os) // не срослось
         return false;
@@ -358,6 +410,9 @@ bool AlertRule::HasAlert()
 
        if(lum == NO_LUMINOSITY_DATA) // нет датчика на линии
        {
+#ifdef USE_EVENT_DRIVEN_ALERTS
+         reserveUsed = true;
+#endif
         // пытаемся найти резервирование
         OneState* reservedState = MainController->GetReservedState(linkedModule,StateLuminosity,Settings.SensorIndex);
         if(!reservedState)
@@ -383,10 +438,7 @@ bool AlertRule::HasAlert()
 
     case rtHumidity: // следим за влажностью
     {
-     if(!linkedModule->State.HasState(StateHumidity))  // не поддерживаем влажность
-        return false;
-
-       OneState* os = linkedModule->State.GetState(StateHumidity,Settings.SensorIndex);
+       OneState* os = watchedState; // состояние нашли при компиляции правил
        if(!os) // не срослось
         return false;
 
@@ -395,6 +447,9 @@ bool AlertRule::HasAlert()
 
        if(curHumidity == NO_TEMPERATURE_DATA) // нет датчика на линии
        {
+#ifdef USE_EVENT_DRIVEN_ALERTS
+         reserveUsed = true;
+#endif
            // пытаемся найти резервирование
           OneState* reservedState = MainController->GetReservedState(linkedModule,StateHumidity,Settings.SensorIndex);
           if(!reservedState)
@@ -421,10 +476,7 @@ bool AlertRule::HasAlert()
 
    case rtSoilMoisture: // следим за влажностью почвы
     {
-     if(!linkedModule->State.HasState(StateSoilMoisture))  // не поддерживаем влажность
-        return false;
-
-       OneState* os = linkedModule->State.GetState(StateSoilMoisture,Settings.SensorIndex);
+       OneState* os = watchedState; // состояние нашли при компиляции правил
        if(!os) // не срослось
         return false;
        
@@ -433,6 +485,9 @@ bool AlertRule::HasAlert()
 
        if(curHumidity == NO_TEMPERATURE_DATA) // нет датчика на линии
        {
+#ifdef USE_EVENT_DRIVEN_ALERTS
+         reserveUsed = true;
+#endif
           // пытаемся найти резервирование
           OneState* reservedState = MainController->GetReservedState(linkedModule,StateSoilMoisture,Settings.SensorIndex);
           if(!reservedState)
@@ -458,10 +513,7 @@ bool AlertRule::HasAlert()
 
     case rtPH: // следим за pH
     {
-     if(!linkedModule->State.HasState(StatePH))  // не поддерживаем pH
-        return false;
-
-       OneState* os = linkedModule->State.GetState(StatePH,Settings.SensorIndex);
+       OneState* os = watchedState; // состояние нашли при компиляции правил
        if(!os) // не срослось
         return false;
 
@@ -470,6 +522,9 @@ bool AlertRule::HasAlert()
 
        if(curHumidity == NO_TEMPERATURE_DATA) // нет датчика на линии
        {
+#ifdef USE_EVENT_DRIVEN_ALERTS
+         reserveUsed = true;
+#endif
          // пытаемся найти резервирование
           OneState* reservedState = MainController->GetReservedState(linkedModule,StatePH,Settings.SensorIndex);
           if(!reservedState)
@@ -680,6 +735,8 @@ uint8_t AlertRule::Load(uint16_t readAddr)
   uint16_t curReadAddr = readAddr;
   linkedRulesIndices.Clear();
   delete[] rawCommand; rawCommand = NULL;
+  targetModuleHandle = NO_MODULE_HANDLE;
+  watchedState = NULL; // состояние найдём при компиляции правил
 
   // сначала читаем настройки
   EEPROM.get(curReadAddr,Settings);
@@ -728,6 +785,8 @@ bool AlertRule::Construct(AbstractModule* lm, const Command& command)
   // конструируем команду
   linkedModule = lm;
   Settings.LinkedModuleNameIndex = GetKnownModuleID(lm->GetID());
+  targetModuleHandle = NO_MODULE_HANDLE; // модуль для команды поищем заново
+  watchedState = NULL; // состояние найдём при компиляции правил
 
   // чистим имена связанных правил, об удалении памяти имён заботится родитель
   linkedRulesIndices.Clear();
@@ -1068,6 +1127,7 @@ bool AlertModule::AddRule(AbstractModule* m, const Command& c)
   if(r && !strcmp(r->GetName(),rName.c_str()))
   {
      // нашли такое правило, просто модифицируем его
+     needCompile = true;
      return r->Construct(m,c);
   }
  } // for
@@ -1085,8 +1145,10 @@ bool AlertModule::AddRule(AbstractModule* m, const Command& c)
     return false;
    }
    alertRules[rulesCnt] = ar;
+   ruleFlags[rulesCnt] = 0;
 
     rulesCnt++;
+    needCompile = true;
     return true;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -1097,6 +1159,9 @@ void AlertModule::Setup()
   LoadRules();
 
   lastUpdateCall = 0;
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  checkedChangesVersion = ModuleState::GetChangesVersion();
+#endif
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void AlertModule::InitRules()
@@ -1105,7 +1170,10 @@ void AlertModule::InitRules()
   for(uint8_t i=0;i<MAX_ALERT_RULES;i++)
   {
     alertRules[i] = NULL;
+    ruleFlags[i] = 0;
   } // for
+
+  needCompile = true;
   
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -1114,86 +1182,174 @@ void AlertModule::Update(uint16_t dt)
   // обновление модуля алертов тут
 
   lastUpdateCall += dt;
-    
-  if(lastUpdateCall < ALERT_UPDATE_INTERVAL) // обновляем согласно настроенному интервалу
+
+  bool timerTick = (lastUpdateCall >= ALERT_UPDATE_INTERVAL); // пора обновить состояние правил по времени
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  // проверяем правила сразу, как только у какого-либо датчика поменялись показания,
+  // а всё остальное - раз в ALERT_UPDATE_INTERVAL
+  uint16_t changesVersion = ModuleState::GetChangesVersion();
+  bool haveChanges = (changesVersion != checkedChangesVersion);
+  
+  if(!timerTick && !haveChanges && !needCompile && !WORK_STATUS.IsModeChanged())
     return;
+
+  checkedChangesVersion = changesVersion;
+#else
+  if(!timerTick) // обновляем согласно настроенному интервалу
+    return;
+#endif
      
 #ifdef USE_DS3231_REALTIME_CLOCK
   DS3231Clock rtc = MainController->GetClock();
-  DS3231Time tm = rtc.getTime();
+  DS3231Time tm;
+  if(timerTick) // время нужно только для обновления правил по таймеру
+    tm = rtc.getTime();
 #endif
 
+  // правила или состояния модулей поменялись - пересобираем таблицу, и проверяем все правила
+  bool checkAll = true;
+  
+  if(needCompile || compiledLayoutVersion != ModuleState::GetLayoutVersion())
+    CompileRules();
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  else
+    checkAll = false;
+#endif
 
-  RulesVector raisedAlerts;
+  bool raisedChanged = checkAll; // изменился ли список сработавших правил?
   
   for(uint8_t i=0;i<rulesCnt;i++)
   {
     AlertRule* r = alertRules[i];
-    if(!r)
-      break;
+    bool needCheck = checkAll;
 
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    needCheck = needCheck || r->IsStateDirty();
+    
+    if(timerTick)
+    {
+      bool couldWork = r->GetCanWork();
+#endif
       // сначала обновляем состояние правила
       r->Update(lastUpdateCall
 #ifdef USE_DS3231_REALTIME_CLOCK
 ,tm.hour, tm.minute, tm.dayOfWeek
 #endif
         );
+#ifdef USE_EVENT_DRIVEN_ALERTS
+      needCheck = needCheck || (couldWork != r->GetCanWork()) || r->NeedPolling();
+    } // if(timerTick)
+#endif
 
-      
-      if(r->HasAlert())
-      {
-        // помещаем это правило в список сработавших правил
-          raisedAlerts.push_back(r);
-          
-      } // if(r->HasAlert())
+    if(!needCheck)
+      continue;
+
+    bool raised = r->HasAlert();
+    if(raised != ((ruleFlags[i] & RULE_FLAG_RAISED) != 0))
+    {
+      ruleFlags[i] ^= RULE_FLAG_RAISED;
+      raisedChanged = true;
+    }
   } // for
 
-  // проверяем список сработавших правил, на предмет связи их с другими сработавшими правилами
-  RulesVector workRules; // правила, с которыми будем работать после разрешения конфликтов
+#ifdef USE_EVENT_DRIVEN_ALERTS
+  // все изменения показаний учли
+  for(uint8_t i=0;i<rulesCnt;i++)
+    alertRules[i]->ClearStateDirty();
+#endif
+
+  if(timerTick)
+    lastUpdateCall = lastUpdateCall - ALERT_UPDATE_INTERVAL;
+
+  if(!raisedChanged && !WORK_STATUS.IsModeChanged()) // ничего не поменялось, команды слать не надо
+    return;
 
-  // разрешаем конфликты. Для этого надо пройти по всем цепочкам правил и разрешить все зависимости,
+  // разрешаем конфликты. Надо пройти по всем цепочкам правил и разрешить все зависимости,
   // например: у нас есть три сработавших правила: 1 - просто, второе - не выполнять, если сработало
   // правило 3, 3 - не выполнять, если сработало правило 1. Очевидно, что в конечном списке
   // должны остаться правила 1 и 2, а не только 1, как будет, если смотреть правила поочерёдно,
   // и отбрасывать без учёта цепочек зависимостей.
+  // Порядок вычисления построен при компиляции так, что правила, от которых мы зависим, уже
+  // проверены к моменту проверки текущего, поэтому хватает одного прохода: правило работает,
+  // если сработало само и ни одно из связанных с ним правил не работает.
 
-  SolveConflicts(raisedAlerts,workRules); // разрешаем все конфликты
+  for(uint8_t i=0;i<rulesCnt;i++)
+    ruleFlags[i] &= ~RULE_FLAG_WORKS;
   
-  // тут можем работать со сработавшими правилами спокойно
-  size_t sz = workRules.size();
+  for(uint8_t i=0;i<rulesCnt;i++)
+  {
+    uint8_t ruleIdx = evalOrder[i];
+
+    if(!(ruleFlags[ruleIdx] & RULE_FLAG_RAISED))
+      continue;
 
+    bool canWork = true;
+    for(uint16_t j=linksStart[ruleIdx];j<linksStart[ruleIdx+1];j++)
+    {
+      if(ruleFlags[compiledLinks[j]] & RULE_FLAG_WORKS) // связанное правило работает, текущее игнорируем
+      {
+        canWork = false;
+        break;
+      }
+    } // for
 
+    if(canWork)
+      ruleFlags[ruleIdx] |= RULE_FLAG_WORKS;
+      
+  } // for
 
   if(WORK_STATUS.IsModeChanged())
   {
     WORK_STATUS.SetModeUnchanged();
-    lastIterationRaisedRules.Clear();
+    
+    for(uint8_t i=0;i<rulesCnt;i++)
+      ruleFlags[i] &= ~RULE_FLAG_WORKED_LAST;
   }
   
-  for(size_t i=0;i<sz;i++)
+  // тут можем работать со сработавшими правилами спокойно, идём в порядке их номеров
+  for(uint8_t i=0;i<rulesCnt;i++)
   {
-    // для каждого правила в списке вызываем связанную команду
-    AlertRule* r = workRules[i];
+    uint8_t flags = ruleFlags[i];
 
-    if(IsRuleRaisedOnLastIteration(r)) // если правило срабатывало на предыдущей итерации - не надо ещё раз посылать эту команду.
-    {
+    // запоминаем, работало ли правило на этой итерации
+    if(flags & RULE_FLAG_WORKS)
+      ruleFlags[i] |= RULE_FLAG_WORKED_LAST;
+    else
+      ruleFlags[i] &= ~RULE_FLAG_WORKED_LAST;
+
+    if(!(flags & RULE_FLAG_WORKS))
       continue;
-    }
+      
+    if(flags & RULE_FLAG_WORKED_LAST) // если правило срабатывало на предыдущей итерации - не надо ещё раз посылать эту команду.
+      continue;
+    
+    // для каждого правила в списке вызываем связанную команду
+    AlertRule* r = alertRules[i];
       
     
     if(r->HasTargetCommand()) // надо отправлять команду
     {
       Command cmd;
+      AbstractModule* targetModule = r->GetTargetModule(); // модуль уже найден правилом, не ищем его по имени
       
-         // копируем имя модуля в строку, потому что методы GetTargetCommandModuleName и GetTargetCommand пользуют общий буфер,
+      if(targetModule)
+      {
+         // имя берём у самого модуля - методы GetTargetCommandModuleName и GetTargetCommand пользуют общий буфер,
          // и перезатрут данные друг друга.
+         cmd.Construct(targetModule->GetID(),r->GetTargetCommand(),ctSET);
+      }
+      else
+      {
+         // модуля нет в системе, пусть контроллер сам ответит, что модуль неизвестен
          String moduleId = r->GetTargetCommandModuleName();
          cmd.Construct(moduleId.c_str(),r->GetTargetCommand(),ctSET);
+      }
          cmd.SetInternal(true); // говорим, что команда - от одного модуля к другому
 
         // НЕ БУДЕМ НИКУДА ПЛЕВАТЬСЯ ОТВЕТОМ ОТ МОДУЛЯ
         //cmd.SetIncomingStream(&Serial);
-        MainController->ProcessModuleCommand(cmd,NULL);
+        MainController->ProcessModuleCommand(cmd,targetModule);
 
         // дёргаем функцию обновления других вещей - типа, кооперативная работа
         yield();
@@ -1206,73 +1362,82 @@ void AlertModule::Update(uint16_t dt)
       MainController->Alarm(r);
  
   } // for
-
-  lastIterationRaisedRules = workRules; // сохраняем список сработавших на этой итерации правил
-
-  lastUpdateCall = lastUpdateCall - ALERT_UPDATE_INTERVAL;
   
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-bool AlertModule::IsRuleRaisedOnLastIteration(AlertRule* rule)
-{
-    for(size_t i=0;i<lastIterationRaisedRules.size();i++)
-    {
-      AlertRule* r = lastIterationRaisedRules[i];
-      if(r == rule)
-      {
-        return true;
-      }
-    }
-    
-    return false;
-}
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-bool AlertModule::CanWorkWithRule(RulesVector& checkedRules, AlertRule* rule, RulesVector& raisedAlerts)
+void AlertModule::CompileRules()
 {
+  needCompile = false;
+  compiledLayoutVersion = ModuleState::GetLayoutVersion();
+  compiledLinks.Clear();
 
-  yield(); // дёргаем многозадачность за хвост
-  
-  size_t cnt = rule->GetLinkedRulesCount();
-  if(!cnt)
-    return true; // нет связанных правил, при срабатывании которых мы должны игнорировать текущее
-
+  uint8_t pending[MAX_ALERT_RULES]; // сколько связанных правил ещё не поставлено в порядок вычисления
 
-  // проверяем, есть ли мы уже в списке проверенных правил, если есть - считаем, что с этим правилом работать нельзя,
-  // и удаляем его из списка
-  size_t sz = checkedRules.size();
-  for(size_t i=0;i<sz;i++)
+  // ищем состояния, за которыми следят правила, и переводим имена связанных правил в их индексы
+  for(uint8_t i=0;i<rulesCnt;i++)
   {
-      if(checkedRules[i] == rule) // нашли кольцевую рекурсию
+    AlertRule* r = alertRules[i];
+    r->Compile();
+    ruleFlags[i] &= ~RULE_FLAG_PLACED;
+    
+    linksStart[i] = compiledLinks.size();
+    
+    size_t cnt = r->GetLinkedRulesCount();
+    for(size_t j=0;j<cnt;j++)
+    {
+      uint8_t nameIdx = r->GetLinkedRuleNameIndex(j);
+      for(uint8_t k=0;k<rulesCnt;k++)
       {
-        return false;
-      }
+        // ссылку правила на само себя не учитываем - она никогда не мешала ему работать
+        if(k != i && alertRules[k]->GetNameIndex() == nameIdx)
+        {
+          compiledLinks.push_back(k);
+          break;
+        }
+      } // for
+    } // for
+
+    pending[i] = compiledLinks.size() - linksStart[i];
   } // for
+  
+  linksStart[rulesCnt] = compiledLinks.size();
 
-  for(uint8_t i=0;i<cnt;i++)
+  // строим порядок вычисления: правило ставим только после всех правил, на которые оно завязано
+  uint8_t placed = 0;
+  bool anyPlaced = true;
+  while(anyPlaced)
   {
-    // проходимся по всем именам связанных с нашим правил, и разрешаем конфликты по цепочке
-    const char* linkedRuleName = rule->GetLinkedRuleName(i);
-    AlertRule* linkedRule = GetLinkedRule(linkedRuleName,raisedAlerts);
-        
-      if(linkedRule) // нашли сработавшее правило, от которого мы зависим
+    anyPlaced = false;
+    for(uint8_t i=0;i<rulesCnt;i++)
+    {
+      if((ruleFlags[i] & RULE_FLAG_PLACED) || pending[i])
+        continue;
+
+      evalOrder[placed++] = i;
+      ruleFlags[i] |= RULE_FLAG_PLACED;
+      anyPlaced = true;
+
+      // у всех правил, завязанных на текущее, одной неразрешённой зависимостью меньше
+      for(uint8_t k=0;k<rulesCnt;k++)
       {
-        if(!linkedRule->GetLinkedRulesCount()) // сразу нашли сработавшее связанное правило без зависимостей
-          return false; // с текущим правилом работать нельзя!
-          
-          checkedRules.push_back(rule); // помещаем текущий проверяемый узел в стек, чтобы не было кольцевой рекурсии
+        for(uint16_t j=linksStart[k];j<linksStart[k+1];j++)
+        {
+          if(compiledLinks[j] == i)
+            pending[k]--;
+        }
+      } // for
+    } // for
+  } // while
 
-          // К СОЖАЛЕНИЮ, РЕШАЕМ РЕКУРСИВНО :(
-          if(CanWorkWithRule(checkedRules,linkedRule,raisedAlerts)) // с правилом, на которое мы завязаны, работать можно, поэтому игнорируем текущее
-            return false;
-            
-          checkedRules.pop(); // извлекаем последний элемент
- 
-      } // if linkedRule
-    
+  // оставшиеся правила завязаны в кольцо - ставим их в конец по порядку номеров,
+  // ещё не проверенные на текущей итерации правила из кольца считаются неработающими.
+  for(uint8_t i=0;i<rulesCnt;i++)
+  {
+    if(!(ruleFlags[i] & RULE_FLAG_PLACED))
+      evalOrder[placed++] = i;
     
-  } // for
-return true;
-  
+    ruleFlags[i] &= ~RULE_FLAG_PLACED;
+  }
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 size_t AlertModule::AddParam(char* nm, bool& added)
@@ -1290,33 +1455,6 @@ size_t AlertModule::AddParam(char* nm, bool& added)
   return (paramsArray.size()-1);
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-AlertRule* AlertModule::GetLinkedRule(const char* linkedRuleName,RulesVector& raisedAlerts)
-{
-  size_t sz = raisedAlerts.size();
-  for(size_t i=0;i<sz;i++)
-  {
-      AlertRule* r = raisedAlerts[i];
-      if(!strcmp(r->GetName(),linkedRuleName))
-        return r;
-  }
-  return NULL;
-}
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-void AlertModule::SolveConflicts(RulesVector& raisedAlerts,RulesVector& workRules)
-{
-  // разрешаем конфликты
-  RulesVector checkedRules; // список уже проверенных правил, для разрешения кольцевой рекурсии
-  
-  size_t sz = raisedAlerts.size();
-    for(size_t i=0;i<sz;i++)
-    {
-        AlertRule* rule = raisedAlerts[i];
-        if(CanWorkWithRule(checkedRules, rule, raisedAlerts)) // разрешили все зависимости
-            workRules.push_back(rule);
-          
-    } // for
-}
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool  AlertModule::ExecCommand(const Command& command, bool wantAnswer)
 {
   if(wantAnswer) 
@@ -1378,6 +1516,8 @@ bool  AlertModule::ExecCommand(const Command& command, bool wantAnswer)
                          rule->SetEnabled(bEnabled);
                    } // for
 
+                   needCompile = true; // правила включили или выключили - проверим их все заново
+
                    PublishSingleton.Status = true;
                    PublishSingleton = RULE_STATE; 
                    PublishSingleton << PARAM_DELIMITER <<  sParam << PARAM_DELIMITER << state;
@@ -1392,6 +1532,7 @@ bool  AlertModule::ExecCommand(const Command& command, bool wantAnswer)
                          if(rule && !strcmp(rule->GetName(),rName.c_str()))
                          {
                           rule->SetEnabled(bEnabled);
+                          needCompile = true;
                           PublishSingleton.Status = true;
                           PublishSingleton = RULE_STATE; 
                           PublishSingleton << PARAM_DELIMITER <<  sParam << PARAM_DELIMITER << state;
@@ -1428,7 +1569,7 @@ bool  AlertModule::ExecCommand(const Command& command, bool wantAnswer)
                   // чистим все параметры, поскольку у нас больше нет правил
                   ClearParams();
 
-                  rulesCnt = 0;
+                  InitRules();
                   
                   PublishSingleton.Status = true;
                   PublishSingleton = RULE_DELETE; 
@@ -1455,9 +1596,12 @@ bool  AlertModule::ExecCommand(const Command& command, bool wantAnswer)
                       for(uint8_t i=deletedIdx+1;i<rulesCnt;i++) // сдвигаем массив
                       {
                         alertRules[i-1] = alertRules[i];
+                        ruleFlags[i-1] = ruleFlags[i];
                       } // for
 
                     rulesCnt--;
+                    alertRules[rulesCnt] = NULL;
+                    needCompile = true;
 
                     //TODO: Удалять из параметров имя правила и у всех связанных правил удалять индекс этого имени!!!
  
@@ -102,6 +102,11 @@ class AlertRule
 
     char* rawCommand; // сырая команда, если Settings.TargetCommandType == commandUnparsed, то вся команда будет здесь    
     AbstractModule* linkedModule; // модуль, показания которого надо отслеживать
+    ModuleHandle targetModuleHandle; // модуль, которому посылается команда, ищется при первом срабатывании правила
+    OneState* watchedState; // состояние, за которым следит правило, ищется при компиляции правил
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    bool reserveUsed; // при последней проверке у датчика не было показаний, смотрели в резервный
+#endif
     LinkedRulesToIdxVector linkedRulesIndices; // привязка имён связанных правил к их индексу у родителя
     const char* GetKnownModuleName(uint8_t type);
     
@@ -125,11 +130,23 @@ class AlertRule
     const char* GetAlertRule();
 
     const char* GetTargetCommandModuleName();
+    AbstractModule* GetTargetModule(); // возвращает модуль, которому посылается команда
     const char* GetLinkedModuleName();
     uint8_t GetKnownModuleID(const char* moduleName);
 
     size_t GetLinkedRulesCount();
     const char* GetLinkedRuleName(uint8_t idx);
+    uint8_t GetLinkedRuleNameIndex(uint8_t idx) { return linkedRulesIndices[idx]; } // индекс имени связанного правила у родителя
+    uint8_t GetNameIndex() { return Settings.RuleNameIndex; } // индекс нашего имени у родителя
+
+    void Compile(); // ищет состояние, за которым следим, чтобы не искать его при каждой проверке
+
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    bool GetCanWork() {return Settings.CanWork; } // попадаем ли в рабочее время?
+    bool NeedPolling(); // правило нельзя проверять только по изменению показаний датчика, его надо опрашивать по таймеру
+    bool IsStateDirty() { return watchedState && watchedState->IsDirty(); } // показания датчика, за которым следим, изменились?
+    void ClearStateDirty() { if(watchedState) watchedState->ClearDirty(); }
+#endif
 
     uint8_t Save(uint16_t writeAddr); // сохраняем себя в EEPROM, возвращаем кол-во записанных байт
     uint8_t Load(uint16_t readAddr); // читаем себя из EEPROM, возвращаем кол-во прочитанных байт
@@ -148,12 +165,29 @@ class AlertRule
 typedef Vector<AlertRule*> RulesVector;
 typedef Vector<char*> NamesVector;
 
+// флаги правил в скомпилированной таблице
+#define RULE_FLAG_WORKS 1 // правило сработало и не перекрыто связанными правилами
+#define RULE_FLAG_WORKED_LAST 2 // правило работало на прошлой итерации, команду повторно не шлём
+#define RULE_FLAG_PLACED 4 // правило уже поставлено в порядок вычисления (используется только при компиляции)
+#define RULE_FLAG_RAISED 8 // правило сработало при последней проверке
+
 class AlertModule : public AbstractModule
 {
   private:
   
-    RulesVector lastIterationRaisedRules; // список правил, сработавших на текущей итерации
-    bool IsRuleRaisedOnLastIteration(AlertRule* rule);
+    // скомпилированная таблица правил: порядок вычисления, в котором каждое правило идёт после тех,
+    // на которые оно завязано, и индексы связанных правил, разложенные подряд в одном массиве
+    uint8_t evalOrder[MAX_ALERT_RULES]; // порядок вычисления правил
+    uint16_t linksStart[MAX_ALERT_RULES+1]; // с какого места в compiledLinks начинаются связанные правила у правила с индексом i (связей бывает больше 255)
+    LinkedRulesToIdxVector compiledLinks; // индексы связанных правил в массиве alertRules
+    uint8_t ruleFlags[MAX_ALERT_RULES]; // флаги правил, RULE_FLAG_*
+    bool needCompile; // правила изменились, надо перекомпилировать
+    uint16_t compiledLayoutVersion; // версия раскладки состояний, при которой компилировали правила
+#ifdef USE_EVENT_DRIVEN_ALERTS
+    uint16_t checkedChangesVersion; // версия показаний датчиков, при которой последний раз проверяли правила
+#endif
+
+    void CompileRules();
 
     NamesVector paramsArray; // всякие общие имена храним здесь
     void ClearParams();
@@ -165,10 +199,6 @@ class AlertModule : public AbstractModule
     void InitRules();
     bool AddRule(AbstractModule* m, const Command& c);
 
-    void SolveConflicts(RulesVector& raisedAlerts,RulesVector& workRules);
-    bool CanWorkWithRule(RulesVector& checkedRules, AlertRule* rule,RulesVector& raisedAlerts);
-    AlertRule* GetLinkedRule(const char* linkedRuleName,RulesVector& raisedAlerts);
-
     void LoadRules();
     void SaveRules();
     
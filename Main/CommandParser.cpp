@@ -10,25 +10,129 @@ Command::~Command()
 {
   Clear();
 }
+void Command::Construct(const char* moduleID,const char* rawArgs, const char* ct)
+{
+  uint8_t commandType = ctGET;
+  if(!strcmp_P(ct,(const char*) CMD_SET))
+    commandType = ctSET;
+
+  Construct(moduleID,rawArgs,commandType);
+ 
+}
+#ifdef USE_INPLACE_COMMAND_PARSER
 size_t Command::GetArgsCount() const
 { 
-  return arguments.size();
+  return argsCount;
 }
  const char* Command::GetArg(size_t idx) const
 {
-  if(idx < arguments.size())
-    return arguments[idx];
+  if(idx < argsCount)
+    return &(buffer[argsOffsets[idx]]);
 
  return NULL;
 }
-void Command::Construct(const char* moduleID,const char* rawArgs, const char* ct)
+void Command::ParseArguments(const char* rawArgs, size_t writeIdx)
 {
-  uint8_t commandType = ctGET;
-  if(!strcmp_P(ct,(const char*) CMD_SET))
-    commandType = ctSET;
+  if(!rawArgs) // нет аргументов
+    return;
 
-  Construct(moduleID,rawArgs,commandType);
- 
+  // последний байт буфера всегда оставляем под завершающий ноль
+  const size_t maxIdx = COMMAND_BUFFER_LENGTH - 1;
+
+  while(*rawArgs && argsCount < MAX_ARGS_IN_LIST)
+  {
+    if(writeIdx >= maxIdx) // не влезаем в буфер
+      break;
+      
+    argsOffsets[argsCount++] = writeIdx;
+
+    // копируем аргумент до разделителя, разделитель заменяем на ноль
+    while(*rawArgs && *rawArgs != '|' && writeIdx < maxIdx)
+      buffer[writeIdx++] = *rawArgs++;
+
+    if(*rawArgs && *rawArgs != '|') // аргумент обрезан - не влез в буфер, отбрасываем его
+    {
+      argsCount--;
+      break;
+    }
+
+    buffer[writeIdx++] = '\0';
+
+    if(*rawArgs) // перемещаемся за разделитель
+      rawArgs++;
+    
+  } // while
+
+  if(*rawArgs) // что-то не влезло: лимит аргументов или буфер
+    truncated = true;
+
+  if(writeIdx > maxIdx)
+    writeIdx = maxIdx;
+    
+  buffer[writeIdx] = '\0';
+}
+void Command::Construct(const char* id, const char* rawArgs, uint8_t ct)
+{
+  Clear(); // сбрасываем все настройки
+  
+    Type = ct;
+
+    // копируем ID модуля в начало буфера
+    size_t len = strlen(id);
+    if(len > COMMAND_BUFFER_LENGTH - 1)
+    {
+      len = COMMAND_BUFFER_LENGTH - 1;
+      truncated = true;
+    }
+      
+    memcpy(buffer,id,len);
+    buffer[len] = '\0';
+
+    // разбиваем на аргументы
+    ParseArguments(rawArgs,len+1);
+}
+void Command::Construct(const char* rawCommand, uint8_t ct)
+{
+  Clear(); // сбрасываем все настройки
+  
+    Type = ct;
+
+    // копируем ID модуля до первого разделителя
+    size_t len = 0;
+    while(*rawCommand && *rawCommand != '|' && len < COMMAND_BUFFER_LENGTH - 1)
+      buffer[len++] = *rawCommand++;
+      
+    buffer[len] = '\0';
+
+    if(*rawCommand && *rawCommand != '|') // ID модуля не влез в буфер
+      truncated = true;
+
+    if(*rawCommand != '|') // нет аргументов
+      return;
+
+    // разбиваем на аргументы
+    ParseArguments(rawCommand + 1,len+1);  
+}
+void Command::Clear()
+{
+  Type = ctUNKNOWN;
+  IncomingStream = NULL;
+  bIsInternal = false;
+  argsCount = 0;
+  truncated = false;
+  buffer[0] = '\0';
+}
+#else
+size_t Command::GetArgsCount() const
+{ 
+  return arguments.size();
+}
+ const char* Command::GetArg(size_t idx) const
+{
+  if(idx < arguments.size())
+    return arguments[idx];
+
+ return NULL;
 }
 void Command::Construct(const char* id, const char* rawArgs, uint8_t ct)
 {
@@ -89,6 +193,27 @@ void Command::Clear()
   arguments.Clear();
 
 }
+void Command::Construct(const char* rawCommand, uint8_t ct)
+{
+  // ищем, есть ли разделитель в строке. Если он есть, значит, передали ещё и параметры помимо просто имени модуля
+  const char* delimPtr = strchr(rawCommand,'|');
+  if(!delimPtr)
+  {
+    Construct(rawCommand,NULL,ct);
+    return;
+  }
+
+  // есть параметры, надо выцепить имя модуля
+  size_t len = (delimPtr - rawCommand);
+  
+  char* moduleName = new char[len+1];
+  memset(moduleName,0,len+1);
+  strncpy(moduleName,rawCommand,len);
+  
+  Construct(moduleName,delimPtr+1,ct);
+  delete[] moduleName;
+}
+#endif // USE_INPLACE_COMMAND_PARSER
   
 CommandParser::CommandParser()
 {  
@@ -130,28 +255,11 @@ bool CommandParser::ParseCommand(const String& command, Command& outCommand)
   // перемещаемся за тип команды и знак '='
   readPtr += CMD_TYPE_LEN + 1;
 
-  // ищем, есть ли разделитель в строке. Если он есть, значит, передали ещё и параметры помимо просто имени модуля
-  const char* delimPtr = strchr(readPtr,'|');
-  if(!delimPtr)
-  {
-    // без параметров, тупо конструируем и выходим
-     outCommand.Construct(readPtr,NULL,commandType);
-     return true;
-  }
+  // дальше идёт имя модуля и параметры через разделитель, их раскладывает сама команда
+  outCommand.Construct(readPtr,commandType);
 
-  // есть параметры, надо выцепить имя модуля
-  size_t len = (delimPtr - readPtr);
-
-  
-  char* moduleName = new char[len+1];
-  memset(moduleName,0,len+1);
-  strncpy(moduleName,readPtr,len);
-  
-  delimPtr++;
-
-  outCommand.Construct(moduleName,delimPtr,commandType);
-  delete[] moduleName;
-  return true;
+  // урезанную команду не выполняем - вызывающий ответит ошибкой
+  return !outCommand.IsTruncated();
    
 }
 
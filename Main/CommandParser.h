@@ -32,7 +32,15 @@ ctGET,
 ctSET,
 } COMMAND_TYPE; // тип команды
 
+#ifdef USE_INPLACE_COMMAND_PARSER
+
+#if COMMAND_BUFFER_LENGTH > 256
+#error COMMAND_BUFFER_LENGTH IS LIMITED to 256 !!!
+#endif
+
+#else
 typedef Vector<char*> CommandArgsVec;
+#endif
 
 class Command
 {
@@ -40,11 +48,23 @@ class Command
 
 
     Stream* IncomingStream; // поток, из которого пришла команда
+    
+#ifdef USE_INPLACE_COMMAND_PARSER
+    // режим разбора без работы с кучей: ID модуля и аргументы лежат в собственном буфере команды,
+    // друг за другом, разделённые нулями. ID модуля - с начала буфера, для аргументов храним смещения.
+    char buffer[COMMAND_BUFFER_LENGTH]; // буфер с ID модуля и аргументами
+    uint8_t argsOffsets[MAX_ARGS_IN_LIST]; // смещения аргументов в буфере
+    uint8_t argsCount; // кол-во аргументов
+    bool truncated; // команда не влезла в буфер или в MAX_ARGS_IN_LIST аргументов целиком
+    
+    void ParseArguments(const char* rawArgs, size_t writeIdx); // раскладывает аргументы по буферу, начиная с позиции writeIdx
+#else
     CommandArgsVec arguments; // аргументы команды
+    String ModuleID; // ID модуля
+#endif
     
     bool bIsInternal; // флаг того, что команда получена от другого зарегистрированного модуля
     uint8_t Type; // тип команды
-    String ModuleID; // ID модуля
 
     void Clear();
 
@@ -61,13 +81,27 @@ class Command
     
     void Construct(const char* moduleID,const char* rawArgs, uint8_t ct); // конструирует команду из переданных аргументов
     void Construct(const char* moduleID,const char* rawArgs, const char* ct); // конструирует команду из переданных аргументов
+    void Construct(const char* rawCommand, uint8_t ct); // конструирует команду из строки вида MODULE_ID|ARG1|ARG2
 
 
     // возвращает тип команды
     uint8_t GetType() const {return Type;}
 
     // возвращает ID программного модуля, которому адресована команда
+#ifdef USE_INPLACE_COMMAND_PARSER
+    String GetTargetModuleID() const {return String(buffer);}
+    const char* GetTargetModuleIDPtr() const {return buffer;} // без создания копии строки
+#else
     String GetTargetModuleID() const {return ModuleID;}
+    const char* GetTargetModuleIDPtr() const {return ModuleID.c_str();}
+#endif
+
+    // true, если при разборе часть команды отброшена - такую команду выполнять нельзя
+#ifdef USE_INPLACE_COMMAND_PARSER
+    bool IsTruncated() const {return truncated;}
+#else
+    bool IsTruncated() const {return false;}
+#endif
 
     // возвращает количество переданных аргументов
     size_t GetArgsCount() const;
@@ -1,5 +1,6 @@
 #include "DS18B20Query.h"
 #include <OneWire.h>
+#include <EEPROM.h>
 #include "Globals.h"
 #include "AbstractModule.h"
 
@@ -34,6 +35,8 @@ void DS18B20Support::setResolution(DS18B20Resolution res)
    ow.reset();
    
 }
+static bool DecodeScratchpad(const byte* data, DSSensorType type, DS18B20Temperature* result);
+
 bool DS18B20Support::readTemperature(DS18B20Temperature* result,DSSensorType type)
 {
   result->Whole = NO_TEMPERATURE_DATA; // нет данных с датчика
@@ -60,7 +63,12 @@ bool DS18B20Support::readTemperature(DS18B20Temperature* result,DSSensorType typ
   for(uint8_t i=0;i<9;i++)
     data[i] = ow.read();
 
+  return DecodeScratchpad(data,type,result);
+}
 
+// переводит скратчпад датчика в температуру, false - если не сошлась контрольная сумма
+static bool DecodeScratchpad(const byte* data, DSSensorType type, DS18B20Temperature* result)
+{
  if (OneWire::crc8( data, 8) != data[8]) // проверяем контрольную сумму
       return false;
   
@@ -94,3 +102,228 @@ bool DS18B20Support::readTemperature(DS18B20Temperature* result,DSSensorType typ
     
 }
 
+bool DS18B20Bus::isValidAddress(const uint8_t* addr)
+{
+  // DS18B20 или DS18S20 с верной контрольной суммой адреса, стёртая EEPROM и пустой индекс сюда не проходят
+  return (addr[0] == 0x28 || addr[0] == 0x10) && OneWire::crc8(addr,7) == addr[7];
+}
+
+void DS18B20Bus::saveAddress(uint8_t sensorIndex)
+{
+  uint16_t writeAddr = eepromAddress + sensorIndex*8;
+  const uint8_t* addr = &(addresses[sensorIndex*8]);
+
+  for(uint8_t i=0;i<8;i++)
+    EEPROM.write(writeAddr++,addr[i]);
+}
+
+static int8_t FindAddress(const uint8_t* addresses, uint8_t maxSensors, const uint8_t* addr)
+{
+  for(uint8_t i=0;i<maxSensors;i++)
+  {
+    if(!memcmp(&(addresses[i*8]),addr,8))
+      return i;
+  }
+  return -1;
+}
+
+uint8_t DS18B20Bus::begin(uint8_t pin, uint8_t _maxSensors, uint16_t _eepromAddress)
+{
+  WORK_STATUS.PinMode(pin,INPUT,false);
+
+  ow = new OneWire(pin);
+  maxSensors = _maxSensors;
+  eepromAddress = _eepromAddress;
+  addresses = new uint8_t[maxSensors*8];
+
+  // читаем адреса, закреплённые за индексами раньше
+  uint16_t readAddr = eepromAddress;
+  for(uint8_t i=0;i<maxSensors;i++)
+  {
+    uint8_t* addr = &(addresses[i*8]);
+    for(uint8_t j=0;j<8;j++)
+      addr[j] = EEPROM.read(readAddr++);
+
+    if(!isValidAddress(addr)) // индекс свободен
+      memset(addr,0,8);
+  }
+
+  search();
+
+  return getSensorsCount();
+}
+
+uint8_t DS18B20Bus::search()
+{
+  static const uint8_t emptyAddress[8] = {0};
+
+  lastSearchAt = millis();
+  readFailed = false;
+
+  if(!ow)
+    return 0;
+
+  uint8_t found = 0; // биты индексов, чьи датчики нашлись на линии
+  const uint8_t allFound = (1 << maxSensors) - 1;
+  uint8_t added = 0;
+  bool noFreeIndex = false;
+
+  // ищем датчики температуры на линии, остальные устройства пропускаем
+  uint8_t addr[8];
+  ow->reset_search();
+
+  while(ow->search(addr))
+  {
+    if(!isValidAddress(addr)) // битый адрес или не датчик температуры
+      continue;
+
+    int8_t idx = FindAddress(addresses,maxSensors,addr);
+    if(idx < 0) // новый датчик - отдаём ему свободный индекс
+    {
+      idx = FindAddress(addresses,maxSensors,emptyAddress);
+      if(idx < 0)
+      {
+        noFreeIndex = true;
+        continue;
+      }
+
+      memcpy(&(addresses[idx*8]),addr,8);
+      saveAddress(idx);
+      added++;
+    }
+
+    found |= (1 << idx);
+  } // while
+
+  if(!noFreeIndex || found == allFound)
+    return added;
+
+  // новым датчикам не хватило свободных индексов - отдаём им индексы датчиков, которых на линии нет (датчик заменили)
+  ow->reset_search();
+
+  while(found != allFound && ow->search(addr))
+  {
+    if(!isValidAddress(addr) || FindAddress(addresses,maxSensors,addr) >= 0)
+      continue;
+
+    for(uint8_t i=0;i<maxSensors;i++)
+    {
+      if(found & (1 << i))
+        continue;
+
+      memcpy(&(addresses[i*8]),addr,8);
+      saveAddress(i);
+      found |= (1 << i);
+      added++;
+      break;
+    } // for
+  } // while
+
+  return added;
+}
+
+bool DS18B20Bus::isSearchNeeded(uint16_t searchInterval)
+{
+  if(!ow)
+    return false;
+
+  // все известные датчики ответили и свободных индексов нет - искать некого
+  if(!readFailed && getSensorsCount() >= maxSensors)
+    return false;
+
+  return (millis() - lastSearchAt >= searchInterval);
+}
+
+uint8_t DS18B20Bus::getSensorsCount()
+{
+  uint8_t cnt = 0;
+  for(uint8_t i=0;i<maxSensors;i++)
+  {
+    if(addresses[i*8])
+      cnt++;
+  }
+  return cnt;
+}
+
+void DS18B20Bus::setResolution(DS18B20Resolution res)
+{
+  if(!ow || !ow->reset()) // нет датчиков
+    return;
+
+   ow->skip(); // пишем всем датчикам сразу (SKIP ROM)
+   ow->write(0x4E); // запускаем запись в scratchpad
+
+   ow->write(0); // верхний температурный порог 
+   ow->write(0); // нижний температурный порог
+   ow->write(res); // разрешение датчика
+
+   ow->reset();
+   ow->skip();
+   ow->write(0x48); // COPY SCRATCHPAD
+   delay(10);
+   ow->reset();
+
+   // время конвертации: 93,75 мс на 9 бит, с каждым битом разрешения - вдвое больше
+   switch(res)
+   {
+    case temp9bit: conversionTime = 94; break;
+    case temp10bit: conversionTime = 188; break;
+    case temp11bit: conversionTime = 375; break;
+    default: conversionTime = 750; break;
+   }
+}
+
+bool DS18B20Bus::startConversion()
+{
+  if(!ow || !ow->reset()) // нет датчиков
+    return false;
+
+  ow->skip(); // конвертацию запускаем на всех датчиках сразу (SKIP ROM)
+  ow->write(0x44);
+
+  inConversion = true;
+  conversionStartedAt = millis();
+
+  return true;
+}
+
+bool DS18B20Bus::isConversionDone()
+{
+  if(!inConversion || millis() - conversionStartedAt < conversionTime)
+    return false;
+
+  inConversion = false;
+  return true;
+}
+
+bool DS18B20Bus::readTemperature(uint8_t sensorIndex, DS18B20Temperature* result)
+{
+  result->Whole = NO_TEMPERATURE_DATA; // нет данных с датчика
+  result->Fract = 0;
+
+  if(sensorIndex >= maxSensors)
+    return false;
+
+  const uint8_t* addr = &(addresses[sensorIndex*8]);
+  if(!addr[0]) // за индексом ещё нет датчика
+    return false;
+
+  bool done = false;
+  if(ow->reset())
+  {
+    ow->select(addr); // обращаемся к датчику по адресу (MATCH ROM)
+    ow->write(0xBE); // читаем scratchpad
+
+    byte data[9];
+    for(uint8_t i=0;i<9;i++)
+      data[i] = ow->read();
+
+    // тип датчика узнаём по коду семейства в адресе
+    done = DecodeScratchpad(data,addr[0] == 0x10 ? DS18S20 : DS18B20,result);
+  }
+
+  if(!done) // датчик не ответил - при следующем поиске посмотрим, не заменили ли его
+    readFailed = true;
+
+  return done;
+}
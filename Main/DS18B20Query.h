@@ -2,6 +2,7 @@
 #define _DS18B20_QUERY_H
 
 #include <Arduino.h>
+#include <OneWire.h>
 
 typedef struct
 {
@@ -41,4 +42,41 @@ class DS18B20Support
     
 };
 
+// несколько датчиков на одной линии: индекс датчика закреплён за его адресом и хранится в EEPROM, конвертация
+// запускается сразу на всех датчиках, а показания читаются по адресам после её окончания, без ожидания в цикле.
+// Если датчик не ответил или есть свободные индексы - линия время от времени просматривается заново (search)
+class DS18B20Bus
+{
+  private:
+
+    OneWire* ow;
+    uint8_t* addresses; // адреса датчиков по их индексам, по 8 байт на датчик; пустой индекс - нулевой код семейства
+    uint8_t maxSensors; // сколько индексов
+    uint16_t eepromAddress; // где в EEPROM хранятся адреса
+    uint16_t conversionTime; // сколько мс длится конвертация при текущем разрешении
+    unsigned long conversionStartedAt; // когда (millis) запустили конвертацию
+    unsigned long lastSearchAt; // когда (millis) последний раз искали датчики
+    bool inConversion;
+    bool readFailed; // какой-то из известных датчиков не ответил
+
+    static bool isValidAddress(const uint8_t* addr);
+    void saveAddress(uint8_t sensorIndex);
+
+  public:
+    DS18B20Bus() : ow(NULL), addresses(NULL), maxSensors(0), eepromAddress(0), conversionTime(750), conversionStartedAt(0),
+      lastSearchAt(0), inConversion(false), readFailed(false) {};
+
+    uint8_t begin(uint8_t pin, uint8_t maxSensors, uint16_t eepromAddress); // читает адреса из EEPROM и ищет датчики на линии, возвращает кол-во известных
+    uint8_t search(); // ищет датчики на линии, новым выдаёт индексы, возвращает кол-во новых
+    bool isSearchNeeded(uint16_t searchInterval); // true, если пора заново искать датчики
+    void setResolution(DS18B20Resolution res); // выставляет разрешение сразу всем датчикам на линии
+    
+    bool startConversion(); // запускает конвертацию на всех датчиках, возвращает false, если на линии никого нет
+    bool isConversionDone(); // true, если конвертация была запущена и уже закончилась
+    bool readTemperature(uint8_t sensorIndex, DS18B20Temperature* result); // читает показания датчика по его адресу
+
+    uint8_t getSensorsCount(); // за сколькими индексами закреплены адреса
+    
+};
+
 #endif
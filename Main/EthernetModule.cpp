@@ -20,8 +20,59 @@ void EthernetModule::Setup()
   #endif
   
   bInited = false;
+
+  #ifdef W5100_KEEP_ALIVE
+    connectedSockets = 0;
+    idleCheckTimer = 0;
+  #endif
+  
+}
+
+#ifdef W5100_KEEP_ALIVE
+void EthernetModule::CheckIdleClients()
+{
+  unsigned long now = millis();
   
+  for(uint8_t sockNumber=0;sockNumber<MAX_LAN_CLIENTS;sockNumber++)
+  {
+    uint8_t mask = (1 << sockNumber);
+    EthernetClient client(sockNumber);
+    
+    if(!client.connected())
+    {
+      // клиент отсоединился сам (или сокет просто слушает порт) - забываем про него.
+      // Закрывать такой сокет нельзя - библиотека сама возвращает его в режим прослушки.
+      if(connectedSockets & mask)
+      {
+        connectedSockets &= ~mask;
+        clientCommands[sockNumber] = F("");
+      }
+      continue;
+    }
+
+    if(!(connectedSockets & mask))
+    {
+      // новое соединение, отсчитываем время простоя с этого момента
+      connectedSockets |= mask;
+      lastActivity[sockNumber] = now;
+      continue;
+    }
+
+    if(now - lastActivity[sockNumber] >= W5100_IDLE_TIMEOUT)
+    {
+      #ifdef ETHERNET_DEBUG
+        Serial.print(F("[LAN] close idle client #"));
+        Serial.println(sockNumber);
+      #endif
+      
+      client.stop();
+      connectedSockets &= ~mask;
+      clientCommands[sockNumber] = F("");
+    }
+    
+  } // for
 }
+#endif
 
 void EthernetModule::Update(uint16_t dt)
 { 
@@ -69,6 +120,11 @@ void EthernetModule::Update(uint16_t dt)
     // есть активный клиент
     uint8_t sockNumber = client.getSocketNumber(); // получили номер сокета клиента
 
+  #ifdef W5100_KEEP_ALIVE
+    lastActivity[sockNumber] = millis();
+    connectedSockets |= (1 << sockNumber);
+  #endif
+
     while(client.available()) // пока есть данные с клиента
     {
       char c = client.read(); // читаем символ
@@ -91,17 +147,27 @@ void EthernetModule::Update(uint16_t dt)
           // запустили команду в обработку
           MainController->ProcessModuleCommand(cmd);
         }
+        else
+        if(cmd.IsTruncated()) // команда не влезла целиком - урезанную не выполняем
+          MainController->PublishParseError(cmd,&client);
+
+        // очищаем внутренний буфер, подготавливая его к приёму следующей команды
+        clientCommands[sockNumber] = F(""); 
 
+      #ifdef W5100_KEEP_ALIVE
+        // соединение не закрываем: клиент может прислать следующие команды, ответы на них
+        // уйдут по порядку, т.к. команды выполняются одна за другой. Закроет соединение либо
+        // сам клиент, либо мы - по таймауту простоя.
+        continue;
+      #else
         // останавливаем клиента, т.к. все данные ему уже посланы.
         // даже если команда неправильная - считаем, что раз мы
         // получили строку, значит, имеем полное право с ней работать,
         // и каждый ССЗБ, если пришло что-то не то.
         client.stop();
-
-        // очищаем внутренний буфер, подготавливая его к приёму следующей команды
-        clientCommands[sockNumber] = F(""); 
         
         break; // выходим из цикла
+      #endif
         
       } // if(c == '\n')
 
@@ -116,6 +182,15 @@ void EthernetModule::Update(uint16_t dt)
     
   } // if(client)
 
+  #ifdef W5100_KEEP_ALIVE
+    idleCheckTimer += dt;
+    if(idleCheckTimer >= 1000) // раз в секунду проверяем простаивающие соединения
+    {
+      idleCheckTimer = 0;
+      CheckIdleClients();
+    }
+  #endif
+
 }
 
 bool EthernetModule::ExecCommand(const Command& command, bool wantAnswer)
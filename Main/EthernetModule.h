@@ -11,6 +11,13 @@ class EthernetModule : public AbstractModule // модуль поддержки
 
     bool bInited;
     String clientCommands[MAX_LAN_CLIENTS]; // наши команды с клиентов
+
+  #ifdef W5100_KEEP_ALIVE
+    unsigned long lastActivity[MAX_LAN_CLIENTS]; // когда от клиента последний раз что-то приходило
+    uint8_t connectedSockets; // битовая маска сокетов, соединение на которых мы уже видели
+    uint16_t idleCheckTimer; // таймер проверки простаивающих соединений
+    void CheckIdleClients(); // закрываем соединения, по которым давно ничего не приходило
+  #endif
   
   public:
     EthernetModule() : AbstractModule("LAN") {}
@@ -27,6 +27,7 @@
 //#define USE_PH_MODULE // закомментировать, если не нужен модуль снятия показаний с датчиков pH и контроля за дозированием реагентов в систему
 #define USE_LOG_MODULE // закомментировать, если не нужен модуль логгирования информации. Внимание: модуль работает только с модулем реального времени (USE_DS3231_REALTIME_CLOCK должна быть определена!)
 #define USE_DELTA_MODULE // закомментировать, если не нужно собирать показания дельт с датчиков (разница показаний между двумя датчиками)
+//#define USE_HISTORY_MODULE // раскомментировать, если нужна история показаний датчиков в оперативной памяти (минимум/максимум/среднее за последние N минут без чтения SD), настройки - см. ниже
 #define USE_WATERFLOW_MODULE // закомментировать, если не нужны датчик(и) расхода воды (пин(ы) 2 (и 3) меги), настройки - см. ниже
 #define USE_COMPOSITE_COMMANDS_MODULE // закомментировать, если не нужен модуль составных команд (позволяет выполнить скопом несколько разных действий, используется правилами)
 #define USE_RESERVATION_MODULE // закомментировать, если не нужем модуль резервирования датчиков (когда при отсутствии показаний с одного датчика показания берутся со связанных с ним).
@@ -67,6 +68,12 @@
 #define USE_WINDOWS_MANUAL_MODE_DIODE // закомментировать, если не нужен диод, мигающий в ручном режиме управления фрамугами (пин DIODE_WINDOWS_MANUAL_MODE_PIN)
 #define USE_WATERING_MANUAL_MODE_DIODE // закомментировать, если не нужен диод, мигающий в ручном режиме управления поливом (пин DIODE_WATERING_MANUAL_MODE_PIN)
 #define USE_LIGHT_MANUAL_MODE_DIODE // закомментировать, если не нужен диод, мигающий в ручном режиме управления досветкой (пин DIODE_LIGHT_MANUAL_MODE_PIN)
+//--------------------------------------------------------------------------------------------------------------------------------
+// сборка на ПК (папка Tests): HostConfig.h теста отключает модули, которым нужно железо
+//--------------------------------------------------------------------------------------------------------------------------------
+#ifdef HOST_BUILD
+#include "HostConfig.h"
+#endif
 
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -96,13 +103,18 @@
 // настройки RS-485
 //--------------------------------------------------------------------------------------------------------------------------------
 #define RS_485_SERIAL Serial3 // ВНИМАНИЕ! СЛЕДИТЕ ЗА ОТСУТСТВИЕМ КОНФЛИКТОВ С SERIAL. ЭТОТ ЖЕ SERIAL ИСПОЛЬЗУЕТСЯ Nextion, т.е. либо Nextion по Serial, либо - RS-485!!!
-#define RS_485_UCSR UCSR3A // регистр, связанный с номером UART RS_485_SERIAL
-#define RS_485_TXC TXC3 // бит ТХ, связанный с номером UART RS_485_SERIAL
+#define RS_485_UCSRB UCSR3B // регистр управления, связанный с номером UART RS_485_SERIAL
+#define RS_485_TXCIE TXCIE3 // бит разрешения прерывания по окончанию передачи, связанный с номером UART RS_485_SERIAL
+#define RS_485_UDRIE UDRIE3 // бит прерывания по освобождению регистра данных, связанный с номером UART RS_485_SERIAL
+#define RS_485_TX_vect USART3_TX_vect // вектор прерывания по окончанию передачи, связанный с номером UART RS_485_SERIAL
 #define RS_485_DE_PIN 26 // номер пина, на котором будет происходить переключение приёма/передачи по RS-485
 #define RS485_SPEED 57600 // скорость работы по RS-485
 #define RS495_STATE_PUSH_FREQUENCY 1000 // через сколько миллисекунд писать в шину RS-485 слепок состояния контроллера
 #define RS485_ONE_SENSOR_UPDATE_INTERVAL 1234 // через сколько миллисекунд запрашивать с шины RS-485 показания одного датчика (полный цикл опроса будет равен интервалу*кол-во датчиков в системе)
 #define RS485_BYTES_TIMEOUT 10 // кол-во байт, после неуспешной попытки вычитки которых принимать решение о таймауте (если данные по RS-485 не ходят - увеличьте это значение).
+//#define RS485_BATCH_POLL // раскомментировать, чтобы одним запросом получать показания со всех датчиков модуля (до трёх), на котором висит опрашиваемый датчик.
+// Датчики, показания с которых уже пришли, в этом проходе очереди не опрашиваются, и полный цикл опроса равен интервалу*кол-во модулей.
+// ВНИМАНИЕ! Все модули на шине RS-485 должны быть прошиты версией прошивки с поддержкой этого запроса!
 //--------------------------------------------------------------------------------------------------------------------------------
 // настройки nRF
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -110,6 +122,8 @@
 #define NRF_CE_PIN A8 // номер пина CE для модуля nRF
 #define NRF_CSN_PIN A9 // номер пина CSN для модуля nRF
 #define NRF_CONTROLLER_STATE_CHECK_FREQUENCY 789 // через сколько миллисекунд проверять смену состояния контроллера (для отсылки в эфир при изменениях)
+#define NRF_SENSOR_TIMEOUT_MARGIN 3000 // сколько миллисекунд сверх интервала отсылки показаний модулем ждать, прежде чем выставить датчику "нет данных"
+#define NRF_MAX_PACKETS_PER_UPDATE 5 // сколько пакетов максимум вычитывать из труб nRF за один проход (приёмный буфер nRF - на три пакета)
 #define NRF_REBOOT_PIN 30 // номер пина для пересброса питания nRF (в текущей версии управление питанием не реализовано - на этот пин для платы просто подаётся нужный уровень)
 #define NRF_POWER_ON HIGH
 #define NRF_POWER_OFF LOW
@@ -133,7 +147,9 @@
 #define EEPROM_RULES_START_ADDR 1025 // со второго килобайта в EEPROM идут правила
 #define PH_SETTINGS_EEPROM_ADDR 2800 // с какого адреса идут настройки PH-модуля: заголовок (2 байта), номер пина, с которого читать показания (1 байт), калибровка (в сотых долях, 2 байта), остальное - пока резерв
 #define TIMERS_EEPROM_ADDR 2850 // у нас 4 таймера, на каждый - 10 байт + заголовок (2 байта), итого - 42 байта 
-#define RESERVATION_ADDR 2900 // адрес, с которого пишутся настройки резервирования (173 байта до составных команд; 10 списков по 12 байт + 3 байта = 123 байта, запас ещё есть)
+#define DELTA_EPOCH_EEPROM_ADDR 2892 // номер загрузки контроллера для CTGET=0|DELTA (2 байта, USE_DELTA_STATUS), увеличивается при каждом старте
+#define RESERVATION_ADDR 2900 // адрес, с которого пишутся настройки резервирования (10 списков по 12 байт + 3 байта = 123 байта)
+#define DS18B20_BUS_EEPROM_ADDR 3023 // адреса датчиков на линии USE_DS18B20_BUS по их индексам: по 8 байт на датчик, 50 байт до составных команд - на 6 датчиков
 #define COMPOSITE_COMMANDS_START_ADDR 3073 // с четвёртого килобайта в EEPROM идут составные команды
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -163,7 +179,9 @@
 //--------------------------------------------------------------------------------------------------------------------------------
 // настройки максимумов
 //--------------------------------------------------------------------------------------------------------------------------------
-#define MAX_ALERT_RULES 30 // максимальное кол-во поддерживаемых правил
+#ifndef MAX_ALERT_RULES // тест на ПК (Tests/AlertRules) собирается и с большим кол-вом правил
+#define MAX_ALERT_RULES 30 // максимальное кол-во поддерживаемых правил (не больше 255)
+#endif
 #define MAX_DELTAS 20 // максимальное кол-во дельт. Внимание: на 20 дельт нужно примерно 500 байт в EEPROM, поэтому если нужно больше 20 - смените адрес записи правил в EEPROM на бОльший!
 
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -233,6 +251,13 @@
 //--------------------------------------------------------------------------------------------------------------------------------
 #define LOG_ACTIONS_ENABLED // закомментировать, если не нужна запись действий на карту (например, события "включён полив" и т.п.)
 
+//--------------------------------------------------------------------------------------------------------------------------------
+// настройки модуля истории показаний
+//--------------------------------------------------------------------------------------------------------------------------------
+#define HISTORY_BUFFER_SIZE 1024 // сколько байт оперативной памяти отдать под историю, делится поровну между датчиками (на замер уходит 1 байт, при резком скачке - 3)
+#define HISTORY_MAX_SENSORS 16 // для скольких датчиков максимум храним историю (на каждый - ещё 20 байт ОЗУ)
+#define HISTORY_SAMPLE_INTERVAL 60000 // через сколько мс снимать показания в историю
+
 //--------------------------------------------------------------------------------------------------------------------------------
 // настройки модуля влажности
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -264,6 +289,12 @@
 // например, ADD_T(22,DS18S20) добавляет датчик типа DS18S20 на 22-й пин
 // ДЛЯ ПЛАТЫ ВЫВОДЫ ПО УМОЛЧАНИЮ, ПОДТЯНУТЫЕ РЕЗИСТОРАМИ - A11, A12, A13
 #define TEMP_SENSORS_PINS ADD_T(A11,DS18B20)//, ADD_T(32,DS18B20) // пины, на которых висят наши датчики температуры (указываются через запятую, общее кол-во равно SUPPORTED_SENSORS)
+//#define USE_DS18B20_BUS // раскомментировать, если все SUPPORTED_SENSORS датчиков температуры висят на одном пине DS18B20_BUS_PIN (TEMP_SENSORS_PINS тогда не используется).
+// Индекс датчика закрепляется за его адресом и хранится в EEPROM (DS18B20_BUS_EEPROM_ADDR), поэтому после перезагрузки
+// и замены соседних датчиков индексы не меняются. Новый датчик получает свободный индекс, а если свободных нет - индекс
+// датчика, который пропал с линии (замена сгоревшего). Тип датчика определяется по адресу. Не больше 6 датчиков.
+#define DS18B20_BUS_PIN A11 // пин, на котором висят все датчики температуры при USE_DS18B20_BUS
+#define DS18B20_BUS_SEARCH_INTERVAL 60000 // не чаще чем через сколько мс заново искать датчики на линии, если какой-то не ответил или есть свободные индексы (поиск занимает линию на ~13 мс на каждый датчик)
 
 #define SUPPORTED_WINDOWS 8 // кол-во поддерживаемых окон (по два реле на мотор, для 8-ми канального модуля реле - 4 окна)
 // пины реле управления фрамугами (попарно, через запятую!) На каждом пине висит одно реле, пара реле (например,
@@ -353,6 +384,13 @@
 #define W5100_REBOOT_PIN 44 // номер пина, на котором будет управление питанием W5100 - пока реализовано только включение
 #define W5100_POWER_OFF LOW // уровень для выключения питания
 #define W5100_POWER_ON HIGH // уровень для включения питания
+//#define W5100_KEEP_ALIVE // раскомментировать, если не надо разрывать соединение после каждой команды: клиент может посылать команды одну за другой по одному соединению
+#define W5100_IDLE_TIMEOUT 15000 // через сколько мс закрывать соединение, по которому ничего не приходит (при W5100_KEEP_ALIVE)
+// ВНИМАНИЕ! W5100_KEEP_ALIVE ускоряет только сторонних клиентов, которые шлют несколько команд по одному соединению.
+// Веб-интерфейс из папки WEB шлёт одну команду на соединение: cron.php - только CTGET=0|STAT на каждый контроллер,
+// x_query_controller.php и x_set_controller.php - по одной команде на HTTP-запрос, - поэтому для него ничего не меняется.
+// Держать соединения между HTTP-запросами (pfsockopen) веб-интерфейс не будет: у W5100 всего 4 сокета, и каждый
+// процесс PHP держал бы свой до W5100_IDLE_TIMEOUT
 
 //--------------------------------------------------------------------------------------------------------------------------------
 // Настройки Nextion
@@ -475,6 +513,17 @@
 #define WIFI_EVENT_FUNC serialEvent2 // функция для обработки событий входящего трафика от модуля
 #define WIFI_BAUDRATE 115200 // скорость работы с UART для WI-FI
 #define WIFI_TCP_KEEP_ALIVE // не разрывать соединение после отсыла ответа
+//#define WIFI_STREAM_RESPONSES // раскомментировать, если длинные ответы на CTGET не надо складывать во временный файл на SD: команда выполняется повторно для каждого пакета, и в ESP уходит только нужный кусок ответа.
+// Повторно выполняются только команды из списка WIFI_STREAM_COMMANDS в TCPClient.cpp (без побочных эффектов, однострочный ответ зависит только от настроек:
+// CTGET=0|LIST, CTGET=ALERT|RULE_VIEW, CTGET=RSRV|VIEW) и CTGET=0|STAT - его статусы и показания датчиков запоминаются при первом выполнении
+// (по 1 байту ОЗУ на байт показаний, на время отсыла ответа), остальные CTGET пишут хвост ответа на SD, как обычно.
+// Если при повторном выполнении ответ изменился, клиент вместо конца строки ответа получает ER=STREAM_BROKEN, и соединение закрывается.
+//#define WIFI_BYTE_PARSER // раскомментировать, если входящий поток от ESP надо разбирать побайтово, без String: данные пакетов +IPD сразу уходят клиенту, в т.ч. двоичные
+#define WIFI_LINE_BUFFER_SIZE 64 // размер буфера для строки ответа ESP при побайтовом разборе (более длинные строки обрезаются)
+//#define WIFI_SHORTEST_FIRST // раскомментировать, если пакеты клиентам надо отсылать не строго по кругу, а сначала тем, кому осталось отослать меньше всего (короткие ответы не ждут окончания выгрузки логов)
+// Замер на ПК (Tests/WiFiSchedule, make bench): средние ответы в несколько пакетов приходят быстрее, короткие - так же, как и по кругу,
+// а их худшая задержка растёт: клиент, которого обошли WIFI_MAX_SKIPPED_PACKETS раз, получает пакет раньше них.
+#define WIFI_MAX_SKIPPED_PACKETS 4 // сколько раз подряд клиента с готовыми пакетами могут обойти клиенты с более короткими ответами
 #define STATION_ID F("TEPLICA") // ID точки доступа, которую создаёт модуль WI-FI
 #define STATION_PASSWORD F("12345678") // пароль к точке доступа, которую создаёт вай-фай (МИНИМУМ 8 СИМВОЛОВ, ИНАЧЕН НЕ БУДЕТ РАБОТАТЬ!)
 #define ROUTER_ID F("")  // SSID домашнего роутера, к которому коннектится модуль WI-FI
@@ -598,6 +647,12 @@
 #error PLEASE DONT USE BOTH ESP8266 AND W5100 MODULES !!!
 #endif
 //--------------------------------------------------------------------------------------------------------------------------------
+// запрещаем вешать на одну линию больше датчиков, чем помещается адресов в EEPROM
+//--------------------------------------------------------------------------------------------------------------------------------
+#if defined(USE_DS18B20_BUS) && SUPPORTED_SENSORS > 6
+#error DS18B20 BUS SENSORS COUNT IS LIMITED to 6 !!!
+#endif
+//--------------------------------------------------------------------------------------------------------------------------------
 // запрещаем использовать более одного дисплея в прошивке
 //--------------------------------------------------------------------------------------------------------------------------------
 #if defined(USE_LCD_MODULE) && defined(USE_NEXTION_MODULE)
@@ -619,12 +674,15 @@
 //#define UNI_DEBUG // отладочный режим универсальных модулей, (НЕ РАБОТАЕТ СОВМЕСТНО С КОНФИГУРАТОРОМ!!!)
 //#define PH_DEBUG // раскомментировать для отладочного режима (НЕ РАБОТАЕТ СОВМЕСТНО С КОНФИГУРАТОРОМ !!!)
 //#define IOT_UNIT_TEST // режим юнит-тестирования, не раскомментировать без понимания того, что делаем.
+//#define USE_LOOP_PROFILER // раскомментировать, если нужен профилировщик времени выполнения Update и ExecCommand модулей (CTGET=0|PROF), требует около 32 байт ОЗУ на модуль
 
 //--------------------------------------------------------------------------------------------------------------------------------
 // настройки максимумов
 //--------------------------------------------------------------------------------------------------------------------------------
 #define MAX_ARGS_IN_LIST 20 // максимальное кол-во аргументов у команды, передаваемой контроллеру по UART
 #define MAX_RECEIVE_BUFFER_LENGTH 256 // максимальная длина (в байтах) пакета в сети, дла защиты от спама
+//#define USE_INPLACE_COMMAND_PARSER // раскомментировать, если команды надо разбирать без выделения памяти в куче (ID модуля и аргументы хранятся в буфере самой команды; команды, не влезшие в буфер или в MAX_ARGS_IN_LIST аргументов, отклоняются с ER=COMMAND_TOO_LONG)
+#define COMMAND_BUFFER_LENGTH MAX_RECEIVE_BUFFER_LENGTH // размер буфера команды при разборе без выделения памяти (максимум 256 байт, каждая команда занимает его на стеке!)
 
 //--------------------------------------------------------------------------------------------------------------------------------
 // настройки модуля алертов (событий по срабатыванию каких-либо условий)
@@ -645,6 +703,7 @@
 // Специальный параметр ALL (CTSET=ALERT|RULE_DELETE|ALL) удаляет все правила.
 
 #define SAVE_RULES F("SAVE") // команда "сохранить правила", CTSET=ALERT|SAVE
+//#define USE_EVENT_DRIVEN_ALERTS // раскомментировать, если правила надо проверять сразу при изменении показаний датчиков, а не всё подряд раз в ALERT_UPDATE_INTERVAL мс (требует 1 байт ОЗУ на каждый датчик)
 #define GREATER_THAN F(">") // больше чем
 #define GREATER_OR_EQUAL_THAN F(">=") // больше либо равно
 #define LESS_THAN F("<") // меньше чем
@@ -668,6 +727,23 @@
 //#define LOG_CHANGE_TYPE_TO_IDX // раскомментировать, если нужен лог меньшего размера.
 // в этом случае в каждой строке вместо названия типа датчика подставляется его индекс в системе.
 //#define WRITE_ABSENT_SENSORS_DATA // раскомментировать, если надо писать показания датчика, даже если показаний с него нет
+//#define USE_LOG_WRITE_BUFFER // раскомментировать, если строки лога надо копить в ОЗУ и писать на карту целыми секторами, а не сливать после каждой строки
+#define LOG_WRITE_BUFFER_SIZE 512 // размер буфера записи лога, байт (кратно размеру сектора SD-карты, 512 байт). Занимает ОЗУ только при USE_LOG_WRITE_BUFFER!
+#define LOG_FLUSH_INTERVAL 900000 // не реже, чем через сколько мс сливать накопленные в буфере строки лога на карту (900000 - каждые 15 минут)
+//#define USE_BINARY_LOG // раскомментировать, если лог надо писать в двоичном виде (файлы YYYYMMDD.BIN, записи фиксированной длины, в разы меньше CSV).
+// Перед записями пишется словарь модулей и типов датчиков (заново после старта контроллера и при изменении списка модулей),
+// в CSV файл переводит скрипт WEB/binlog2csv.php с учётом LOG_CNANGE_NAME_TO_IDX и LOG_CHANGE_TYPE_TO_IDX
+#define BINARY_LOG_SIGNATURE "GHBL" // сигнатура двоичного лога, 4 символа
+#define BINARY_LOG_VERSION 2 // версия формата двоичного лога
+//#define USE_LOG_ROLLUPS // раскомментировать, если кроме лога надо вести часовые и суточные сводки показаний (мин/макс/среднее).
+// Сводки дописываются в файлы logs/YYYYMMDD.HRL (строки HH,MODULE_NAME,SENSOR_TYPE,SENSOR_IDX,COUNT,MIN,MAX,AVG)
+// и logs/YYYYMM.DAY (то же самое, но вместо часа - день месяца), забираются командой CTGET=LOG|FILE|имя файла
+#define LOG_ROLLUP_MAX_SENSORS 16 // для скольких датчиков вести сводки, каждый занимает 31 байт ОЗУ
+//#define USE_LOG_INDEX // раскомментировать, если рядом с логом надо вести индекс logs/YYYYMMDD.IDX - смещения начала каждого
+// интервала в LOG_INDEX_BUCKET_MINUTES минут, по нему команда RANGE отдаёт кусок лога, не вычитывая файл целиком.
+// Запись индекса - 5 байт: номер интервала от начала суток (1 байт), смещение в файле лога (4 байта, младшим байтом вперёд).
+// Только для CSV-лога: при USE_BINARY_LOG индекс не ведётся, а RANGE отвечает NOT_SUPPORTED (двоичный лог забирается целиком командой FILE)
+#define LOG_INDEX_BUCKET_MINUTES 15 // длина интервала индекса лога, минут (не меньше 6, чтобы номер интервала влез в байт)
 #define LOG_TEMP_TYPE F("RT") // тип для температуры, который запишется в файл
 #define LOG_HUMIDITY_TYPE F("RH") // тип для влажности, который запишется в файл
 #define LOG_LUMINOSITY_TYPE F("RL") // тип для освещенности, который запишется в файл
@@ -679,7 +755,12 @@
 #define ACTIONS_DIRECTORY F("actions") // название папки с логами действий на карточке
 #define END_OF_FILE F("END_OF_FILE") // какую строку посылаем, когда весь файл вычитали
 #define FOLLOW F("FOLLOW") // ответ, что файл будет выслан следующими строками
-#define FILE_COMMAND F("FILE") // получить данные с файла
+#define FILE_COMMAND F("FILE") // получить данные с файла: CTGET=LOG|FILE|20170101.LOG, или кусок файла: CTGET=LOG|FILE|20170101.LOG|смещение|длина
+// на запрос куска файла ответ вида OK=FOLLOW|смещение|длина|размер файла, потом данные, потом OK=LOG|END_OF_FILE|CRC16 (4 HEX-символа, полином 0xA001)
+#define NEW_DATA_COMMAND F("NEW") // получить данные, дописанные в файл лога с последней синхронизации: CTGET=LOG|NEW|20170101.LOG, или CTGET=LOG|NEW|20170101.LOG|макс. длина
+#define SYNC_COMMAND F("SYNC") // подтвердить получение данных до смещения: CTSET=LOG|SYNC|20170101.LOG|смещение
+#define RANGE_COMMAND F("RANGE") // получить кусок лога за время: CTGET=LOG|RANGE|20170101|12:00|15:30, ответ - как на запрос куска файла.
+// Отдаются целые интервалы индекса, в которые попадает запрошенное время, лишние строки по краям отбрасывает клиент
 #define ACTIONS_COMAND F("ACTION") // получить данные с файла действий
 
 
@@ -761,9 +842,11 @@
 #define OK_ANSWER F("OK") // ответ - всё ок
 #define ERR_ANSWER F("ER") // ответ - ошибка
 #define UNKNOWN_MODULE F("UNKNOWN_MODULE") // запрос к неизвестному модулю
+#define COMMAND_TOO_LONG F("COMMAND_TOO_LONG") // команда не влезла в буфер разбора или в MAX_ARGS_IN_LIST аргументов
 #define PARAMS_MISSED F("PARAMS_MISSED") // пропущены параметры команды
 #define UNKNOWN_COMMAND F("UNKNOWN_COMMAND") // неизвестная команда
 #define NOT_SUPPORTED F("NOT_SUPPORTED") // не поддерживается
+#define STREAM_BROKEN F("STREAM_BROKEN") // ответ изменился при повторном выполнении команды (WIFI_STREAM_RESPONSES)
 
 //--------------------------------------------------------------------------------------------------------------------------------
 // РАЗДЕЛИТЕЛЬ ПАРАМЕТРОВ
@@ -844,6 +927,12 @@
 #define DELTA_VIEW_COMMAND F("VIEW") // просмотр дельты по индексу, CTGET=DELTA|VIEW|0
 #define DELTA_COUNT_COMMAND F("CNT") // получить кол-во сохранённых дельт, CTGET=DELTA|CNT
 
+//--------------------------------------------------------------------------------------------------------------------------------
+// настройки модуля истории показаний
+//--------------------------------------------------------------------------------------------------------------------------------
+#define HISTORY_INFO_COMMAND F("INFO") // CTGET=HIST|INFO, ответ OK=HIST|INFO|Кол-во_датчиков|Байт_на_датчик|Интервал_замеров_в_секундах
+// CTGET=HIST|MODULE_NAME|SENSOR_TYPE|SENSOR_IDX|MINUTES - статистика за последние MINUTES минут, ответ OK=HIST|MODULE_NAME|SENSOR_TYPE|SENSOR_IDX|MINUTES|Кол-во_замеров|MIN|MAX|AVG
+
 //--------------------------------------------------------------------------------------------------------------------------------
 // настройки модуля LOOP
 //--------------------------------------------------------------------------------------------------------------------------------
@@ -908,6 +997,11 @@
 #define REG_ERR F("EXIST") // модуль уже зарегистрирован
 #define UNKNOWN_PROPERTY F("UNKNOWN_PROPERTY") // неизвестное свойство
 #define STATUS_COMMAND F("STAT") // получить статус внутренних состояний в виде закодированного пакета, CTGET=0|STAT
+#define STATUS_BINARY_COMMAND F("STATB") // то же, что и STAT, только в двоичном виде: CTGET=0|STATB, ответ OK=STATB|Длина\r\n, затем Длина байт данных и 2 байта CRC16 (старшим вперёд)
+//#define USE_DELTA_STATUS // раскомментировать, если нужна команда CTGET=0|DELTA|Эпоха.N - только изменения с момента изменения номер N (требует 4 байта ОЗУ на каждый датчик)
+#define DELTA_COMMAND F("DELTA") // CTGET=0|DELTA|Эпоха.N, ответ OK=DELTA|Эпоха.Новый_номер|HEX-статусы_и_состояние_контроллера (пусто, если не менялись)|МОДУЛЬ,HEX-записи|... Запись - тип, индекс, показания.
+// Эпоха - номер загрузки контроллера (DELTA_EPOCH_EEPROM_ADDR), после перезагрузки номера изменений идут заново: клиент передаёт то, что получил
+// в прошлом ответе, и если эпоха не совпала (или передан 0) - получает всё
 #define RESET_COMMAND F("RST") // перезагрузить контроллер
 #define ID_COMMAND F("ID") // получить/установить ID контроллера
 #define WIRED_COMMAND F("WIRED") // получить список кол-ва проводных датчиков, CTGET=0|WIRED (Температура|Влажность|Освещенность|Влажность почвы|PH)
@@ -917,6 +1011,7 @@
 #define UNI_REGISTER F("U_REG") // запрос CTSET=0|U_REG|SCRATCHPAD_DATA, регистрирует подсоединённый к линии регистрации датчик, возвращает OK=ADDED, если датчик есть, и ERR=U_NONE, если датчика на линии нет
 #define UNI_DIFFERENT_SCRATCHPAD F("SCRATCH_TYPE_ERROR") // ошибка при регистрации, разные типы скратчпада переданы
 #define UNI_RF_CHANNEL_COMMAND F("RF") // команда на получение/установку канала для nRF
+#define PROF_COMMAND F("PROF") // получить данные профилировщика, CTGET=0|PROF, ответ OK=PROF|loop_min|loop_avg|loop_max|MODULE,upd_min,upd_avg,upd_max,exec_min,exec_avg,exec_max|..., время - в мкс. Сброс счётчиков - CTSET=0|PROF
 #define PINS_COMMAND F("PINS") // получить состояние пинов, CTGET=0|PINS, ответ OK=PINS|Кол-во_байт_в_пакете|HEX-пакет_занятых_пинов|HEX-пакет_режима_пинов
 //--------------------------------------------------------------------------------------------------------------------------------
 #define SD_BUFFER_LENGTH 128 // размер буфера для блочного чтения с SD
@@ -251,6 +251,18 @@ float HTU21D::readHumidity(HTU21D_humdOperationMode sensorOperationMode)
     return HTU21D_ERROR;
   }
 
+  return humidity = rawToHumidity(rawHumidity);
+}
+
+/**************************************************************************/
+/*
+    Converts raw humidity value to %RH
+*/
+/**************************************************************************/
+float HTU21D::rawToHumidity(uint16_t rawHumidity)
+{
+  float humidity = 0;
+
   rawHumidity ^= 0x02;                                //clear status bits, humidity measurement always returns xxxxxx10 in the LSB field
   humidity     = 0.001907 * (float)rawHumidity - 6;
   
@@ -357,7 +369,99 @@ float HTU21D::readTemperature(HTU21D_tempOperationMode sensorOperationMode)
     return HTU21D_ERROR;
   }
 
-  return temperature = 0.002681 * (float)rawTemperature - 46.85;   //temperature measurement always returns xxxxxx00 in the LSB field
+  return temperature = rawToTemperature(rawTemperature);
+}
+
+/**************************************************************************/
+/*
+    Converts raw temperature value to C
+*/
+/**************************************************************************/
+float HTU21D::rawToTemperature(uint16_t rawTemperature)
+{
+  return 0.002681 * (float)rawTemperature - 46.85;                 //temperature measurement always returns xxxxxx00 in the LSB field
+}
+
+/**************************************************************************/
+/*
+    Non-blocking measurement, step 1: sends trigger command & returns
+
+    Use "HTU21D_TRIGGER_HUMD_MEASURE_NOHOLD" or "HTU21D_TRIGGER_TEMP_MEASURE_NOHOLD"
+    mode, so I2C bus stays free while sensor is measuring.
+    "SI70xx_TEMP_READ_AFTER_RH_MEASURMENT" is allowed too, result of this
+    command is ready immediately.
+
+    Returns false, if sensor didn't ACK the command
+*/
+/**************************************************************************/
+bool HTU21D::triggerMeasurement(uint8_t sensorOperationMode)
+{
+  Wire.beginTransmission(HTU21D_ADDRESS);
+  #if ARDUINO >= 100
+  Wire.write(sensorOperationMode);
+  #else
+  Wire.send(sensorOperationMode);
+  #endif
+  return (Wire.endTransmission(true) == 0);
+}
+
+/**************************************************************************/
+/*
+    Max. conversion time for current resolution, msec
+
+    NOTE: max. values of HTU21D, Si7021 & SHT21 datasheets, so the first
+          read attempt after this time succeeds for any of these sensors
+*/
+/**************************************************************************/
+uint8_t HTU21D::measurementTime(bool humidityMeasurement)
+{
+  switch(_HTU21D_Resolution)
+  {
+    case HTU21D_RES_RH8_TEMP12:
+      return humidityMeasurement ? 7  : 22;                        //RH: Si7021 - 3.1+3.8msec, T: SHT21 - 22msec
+    case HTU21D_RES_RH10_TEMP13:
+      return humidityMeasurement ? 11 : 43;                        //RH: Si7021 - 4.5+6.2msec, T: SHT21 - 43msec
+    case HTU21D_RES_RH11_TEMP11:
+      return humidityMeasurement ? 15 : 11;                        //RH: SHT21 - 15msec, T: SHT21 - 11msec
+    default:
+      return humidityMeasurement ? 29 : 85;                        //RH: SHT21 - 29msec, T: SHT21 - 85msec
+  }
+}
+
+/**************************************************************************/
+/*
+    Non-blocking measurement, step 2: reads result of triggered measurement
+
+    Makes one read attempt only. In No Hold master mode sensor NACKs read
+    request until measurement is done - then HTU21D_MEASURE_NOT_READY is
+    returned & caller should try again later.
+*/
+/**************************************************************************/
+HTU21D_measureStatus HTU21D::readMeasurement(uint16_t &rawData)
+{
+  uint8_t checksum = 0;
+
+  if (Wire.requestFrom(HTU21D_ADDRESS, 3) != 3)
+  {
+    return HTU21D_MEASURE_NOT_READY;
+  }
+
+  #if ARDUINO >= 100
+  rawData  = Wire.read() << 8;
+  rawData |= Wire.read();
+  checksum = Wire.read();
+  #else
+  rawData  = Wire.receive() << 8;
+  rawData |= Wire.receive();
+  checksum = Wire.receive();
+  #endif
+
+  if (checkCRC8(rawData) != checksum)
+  {
+    return HTU21D_MEASURE_ERROR;
+  }
+
+  return HTU21D_MEASURE_OK;
 }
 
 /**************************************************************************/
@@ -0,0 +1,302 @@
+#include "HistoryModule.h"
+#include "ModuleController.h"
+
+void HistoryModule::Setup()
+{
+  // настройка модуля тут
+  ringsCount = 0;
+  ringSize = 0;
+  layoutVersion = 0;
+  isInited = false;
+  sampleTimer = 0;
+}
+
+bool HistoryModule::IsTracked(ModuleStates type)
+{
+  // расход воды не храним - для него есть накопительные счётчики
+  return (type == StateTemperature || type == StateHumidity || type == StateLuminosity || type == StateSoilMoisture || type == StatePH);
+}
+
+void HistoryModule::InitRings()
+{
+  isInited = true;
+  layoutVersion = ModuleState::GetLayoutVersion();
+  ringsCount = 0;
+
+  // собираем датчики со всех модулей, пока хватает места под кольца
+  size_t modulesCount = MainController->GetModulesCount();
+  for(size_t i=0;i<modulesCount && ringsCount < HISTORY_MAX_SENSORS;i++)
+  {
+    AbstractModule* mod = MainController->GetModule(i);
+    if(mod == this)
+      continue;
+
+    for(uint8_t t=0;t<8 && ringsCount < HISTORY_MAX_SENSORS;t++)
+    {
+      ModuleStates type = (ModuleStates) (1 << t);
+      if(!IsTracked(type))
+        continue;
+
+      uint8_t cnt = mod->State.GetStateCount(type);
+      for(uint8_t k=0;k<cnt && ringsCount < HISTORY_MAX_SENSORS;k++)
+      {
+        HistoryRing& ring = rings[ringsCount++];
+        memset(&ring,0,sizeof(HistoryRing));
+        ring.State = mod->State.GetStateByOrder(type,k);
+      }
+    } // for
+  } // for
+
+  // буфер делим поровну: так памяти гарантированно хватит, сколько бы датчиков ни было
+  ringSize = ringsCount ? HISTORY_BUFFER_SIZE/ringsCount : 0;
+  for(uint8_t i=0;i<ringsCount;i++)
+    rings[i].Start = i*ringSize;
+
+  #ifdef _DEBUG
+    Serial.print(F("[HIST] sensors: "));
+    Serial.print(ringsCount);
+    Serial.print(F(", bytes per sensor: "));
+    Serial.println(ringSize);
+  #endif
+}
+
+uint8_t HistoryModule::GetByte(const HistoryRing& ring, uint16_t offset)
+{
+  return buffer[ring.Start + (ring.Head + offset) % ringSize];
+}
+
+void HistoryModule::PushByte(HistoryRing& ring, uint8_t b)
+{
+  buffer[ring.Start + (ring.Head + ring.Used) % ringSize] = b;
+  ring.Used++;
+}
+
+uint8_t HistoryModule::DecodeSample(const HistoryRing& ring, uint16_t offset, long& delta, bool& hasData)
+{
+  uint8_t b = GetByte(ring,offset);
+  hasData = (b != HISTORY_NO_DATA);
+  delta = 0;
+
+  if(!hasData)
+    return 1;
+
+  if(b == HISTORY_ESCAPE)
+  {
+    delta = (int16_t) (GetByte(ring,offset+1) | (GetByte(ring,offset+2) << 8));
+    return 3;
+  }
+
+  delta = (int8_t) b;
+  return 1;
+}
+
+void HistoryModule::DropOldest(HistoryRing& ring)
+{
+  if(!ring.Samples)
+    return;
+
+  long delta;
+  bool hasData;
+  uint8_t len = DecodeSample(ring,0,delta,hasData);
+
+  ring.Base += delta;
+  ring.Head = (ring.Head + len) % ringSize;
+  ring.Used -= len;
+  ring.Samples--;
+}
+
+void HistoryModule::AddSample(HistoryRing& ring)
+{
+  if(ringSize < 3) // в такое кольцо не влезет даже один замер
+    return;
+
+  long value;
+  bool hasData = ring.State->GetFixedValue(value);
+
+  if(hasData && !ring.HasValue)
+  {
+    // первое показание: начинаем считать дельты прямо с него. Замеры без показаний, которые уже лежат в кольце,
+    // от базового значения не зависят.
+    ring.HasValue = true;
+    ring.Base = value;
+    ring.Last = value;
+  }
+
+  long delta = hasData ? value - ring.Last : 0;
+  uint8_t len = (!hasData || (delta >= -126 && delta <= 127)) ? 1 : 3;
+
+  while(ringSize - ring.Used < len) // освобождаем место под новый замер
+    DropOldest(ring);
+
+  if(!hasData)
+  {
+    PushByte(ring,HISTORY_NO_DATA);
+  }
+  else
+  if(len == 1)
+  {
+    PushByte(ring,(uint8_t) (int8_t) delta);
+  }
+  else
+  {
+    // большой скачок не влезает и в два байта - пишем, сколько влезло, остаток уйдёт со следующими замерами
+    if(delta > 32767)
+      delta = 32767;
+    else
+    if(delta < -32768)
+      delta = -32768;
+
+    PushByte(ring,HISTORY_ESCAPE);
+    PushByte(ring,(uint8_t) (delta & 0xFF));
+    PushByte(ring,(uint8_t) ((delta >> 8) & 0xFF));
+  }
+
+  ring.Last += delta;
+  ring.Samples++;
+}
+
+bool HistoryModule::GetStats(OneState* os, uint16_t minutes, HistoryStats& stats)
+{
+  memset(&stats,0,sizeof(HistoryStats));
+
+  if(!isInited || layoutVersion != ModuleState::GetLayoutVersion())
+    return false;
+
+  HistoryRing* ring = NULL;
+  for(uint8_t i=0;i<ringsCount;i++)
+  {
+    if(rings[i].State == os)
+    {
+      ring = &(rings[i]);
+      break;
+    }
+  }
+
+  if(!ring)
+    return false;
+
+  // сколько последних замеров приходится на запрошенное время
+  unsigned long wanted = (minutes*60000UL + HISTORY_SAMPLE_INTERVAL - 1)/HISTORY_SAMPLE_INTERVAL;
+  uint16_t skip = wanted < ring->Samples ? ring->Samples - wanted : 0;
+
+  long acc = ring->Base;
+  long sum = 0;
+  uint16_t offset = 0;
+
+  for(uint16_t i=0;i<ring->Samples;i++)
+  {
+    long delta;
+    bool hasData;
+    offset += DecodeSample(*ring,offset,delta,hasData);
+    acc += delta;
+
+    if(i < skip || !hasData)
+      continue;
+
+    if(!stats.Samples || acc < stats.Min)
+      stats.Min = acc;
+    if(!stats.Samples || acc > stats.Max)
+      stats.Max = acc;
+
+    sum += acc;
+    stats.Samples++;
+  } // for
+
+  if(stats.Samples)
+    stats.Mean = sum/stats.Samples;
+
+  return true;
+}
+
+void HistoryModule::Update(uint16_t dt)
+{
+  sampleTimer += dt;
+  if(sampleTimer < HISTORY_SAMPLE_INTERVAL)
+    return;
+
+  sampleTimer = 0;
+
+  // раскладку делаем при первом замере, когда все датчики уже зарегистрированы, и заново - если состав датчиков поменялся
+  if(!isInited || layoutVersion != ModuleState::GetLayoutVersion())
+    InitRings();
+
+  for(uint8_t i=0;i<ringsCount;i++)
+    AddSample(rings[i]);
+}
+
+bool  HistoryModule::ExecCommand(const Command& command, bool wantAnswer)
+{
+  if(wantAnswer)
+    PublishSingleton = UNKNOWN_COMMAND;
+
+  size_t argsCount = command.GetArgsCount();
+
+  if(command.GetType() == ctGET)
+  {
+    if(!argsCount)
+    {
+      if(wantAnswer)
+        PublishSingleton = PARAMS_MISSED;
+    }
+    else
+    {
+      String arg = command.GetArg(0);
+      if(arg == HISTORY_INFO_COMMAND) // CTGET=HIST|INFO
+      {
+        if(wantAnswer)
+        {
+          PublishSingleton.Status = true;
+          PublishSingleton = HISTORY_INFO_COMMAND;
+          PublishSingleton << PARAM_DELIMITER << ringsCount << PARAM_DELIMITER << ringSize
+          << PARAM_DELIMITER << (HISTORY_SAMPLE_INTERVAL/1000);
+        }
+      } // HISTORY_INFO_COMMAND
+      else
+      {
+        // CTGET=HIST|MODULE|TYPE|IDX|MINUTES
+        if(argsCount < 4)
+        {
+          if(wantAnswer)
+            PublishSingleton = PARAMS_MISSED;
+        }
+        else
+        {
+          AbstractModule* mod = MainController->GetModuleByID(command.GetArg(0));
+          ModuleStates type = OneState::GetType(command.GetArg(1));
+          uint8_t sensorIdx = atoi(command.GetArg(2));
+          uint16_t minutes = atoi(command.GetArg(3));
+
+          OneState* os = mod ? mod->State.GetState(type,sensorIdx) : NULL;
+          HistoryStats stats;
+
+          if(os && GetStats(os,minutes,stats))
+          {
+            if(wantAnswer)
+            {
+              PublishSingleton.Status = true;
+              PublishSingleton = mod->GetID();
+              PublishSingleton << PARAM_DELIMITER << command.GetArg(1) << PARAM_DELIMITER << sensorIdx
+              << PARAM_DELIMITER << minutes << PARAM_DELIMITER << stats.Samples;
+
+              if(stats.Samples)
+              {
+                PublishSingleton << PARAM_DELIMITER << OneState::FormatFixedValue(type,stats.Min)
+                << PARAM_DELIMITER << OneState::FormatFixedValue(type,stats.Max)
+                << PARAM_DELIMITER << OneState::FormatFixedValue(type,stats.Mean);
+              }
+            }
+          }
+          else
+          {
+            if(wantAnswer)
+              PublishSingleton = NOT_SUPPORTED;
+          }
+        } // else
+      } // else
+    } // else
+  } // ctGET
+
+  MainController->Publish(this,command);
+
+  return true;
+}
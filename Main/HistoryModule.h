@@ -0,0 +1,67 @@
+#ifndef _HISTORY_MODULE_H
+#define _HISTORY_MODULE_H
+
+#include "AbstractModule.h"
+
+// кольцо истории одного датчика. Замеры хранятся дельтами к предыдущему замеру:
+// 1 байт, если дельта помещается в -126..127, иначе - HISTORY_ESCAPE и 2 байта дельты;
+// HISTORY_NO_DATA - в момент замера с датчика не было показаний.
+#define HISTORY_NO_DATA 0x80
+#define HISTORY_ESCAPE 0x81
+
+typedef struct
+{
+  OneState* State; // датчик, показания которого храним
+  uint16_t Start; // начало кольца в общем буфере
+  uint16_t Head; // смещение самого старого замера от начала кольца
+  uint16_t Used; // сколько байт кольца занято
+  uint16_t Samples; // сколько замеров в кольце
+  long Base; // значение, к которому прибавляется дельта самого старого замера
+  long Last; // значение последнего замера, к нему прибавляется дельта следующего
+  bool HasValue; // было ли хоть одно показание с датчика
+
+} HistoryRing;
+
+typedef struct
+{
+  uint16_t Samples; // сколько замеров с показаниями попало в выборку
+  long Min; // минимум, в единицах хранения (сотые доли для температуры, влажности, pH; люксы для освещённости)
+  long Max; // максимум
+  long Mean; // среднее
+
+} HistoryStats;
+
+class HistoryModule : public AbstractModule // модуль истории показаний датчиков в оперативной памяти
+{
+  private:
+
+    uint8_t buffer[HISTORY_BUFFER_SIZE]; // общий буфер под кольца всех датчиков
+    HistoryRing rings[HISTORY_MAX_SENSORS];
+    uint8_t ringsCount; // сколько датчиков отслеживаем
+    uint16_t ringSize; // размер кольца одного датчика, байт
+    uint16_t layoutVersion; // версия раскладки состояний, при которой раскладывали кольца
+    bool isInited;
+    unsigned long sampleTimer;
+
+    void InitRings(); // раскладываем буфер по датчикам
+    void AddSample(HistoryRing& ring); // добавляем текущее показание датчика в кольцо
+    void PushByte(HistoryRing& ring, uint8_t b);
+    uint8_t GetByte(const HistoryRing& ring, uint16_t offset);
+    uint8_t DecodeSample(const HistoryRing& ring, uint16_t offset, long& delta, bool& hasData); // возвращает длину замера в байтах
+    void DropOldest(HistoryRing& ring); // выкидываем самый старый замер из кольца
+
+    static bool IsTracked(ModuleStates type); // храним ли историю для датчиков этого типа
+
+  public:
+    HistoryModule() : AbstractModule("HIST") {}
+
+    bool ExecCommand(const Command& command, bool wantAnswer);
+    void Setup();
+    void Update(uint16_t dt);
+
+    // статистика за последние minutes минут по датчику; возвращает false, если история по датчику не ведётся
+    bool GetStats(OneState* os, uint16_t minutes, HistoryStats& stats);
+
+};
+
+#endif
@@ -14,13 +14,17 @@ void HumidityModule::Setup()
 
   si7021.begin(); // настраиваем датчик Si7021
   dummyAnswer.IsOK = false;
+  nextSensor = SUPPORTED_HUMIDITY_SENSORS; // цикл опроса начнётся по интервалу
+  si7021Index = 0;
   
   for(uint8_t i=0;i<SUPPORTED_HUMIDITY_SENSORS;i++)
    {
     State.AddState(StateHumidity,i); // поддерживаем и влажность,
     State.AddState(StateTemperature,i); // и температуру
-    // запускаем конвертацию с датчиков при старте, через 2 секунды нам вернётся измеренная влажность и температура
-    QuerySensor(HUMIDITY_SENSORS_ARRAY[i].pin,HUMIDITY_SENSORS_ARRAY[i].type);
+    // запускаем конвертацию с датчиков DHT при старте, через 2 секунды нам вернётся измеренная влажность и температура.
+    // Si7021 меряет по запросу, его опросим в первом цикле.
+    if(HUMIDITY_SENSORS_ARRAY[i].type != SI7021)
+      QuerySensor(HUMIDITY_SENSORS_ARRAY[i].pin,HUMIDITY_SENSORS_ARRAY[i].type);
    }
    #endif  
  }
@@ -50,9 +54,60 @@ const HumidityAnswer& HumidityModule::QuerySensor(uint8_t pin, HumiditySensorTyp
   return dummyAnswer;
 }
 #endif
+#if SUPPORTED_HUMIDITY_SENSORS > 0
+void HumidityModule::SaveAnswer(uint8_t idx, const HumidityAnswer& answer)
+{
+  Humidity h;
+  Temperature t;
+
+  if(answer.IsOK)
+  {
+    h.Value = answer.Humidity;
+    h.Fract = answer.HumidityDecimal;
+
+    t.Value = answer.Temperature;
+    t.Fract = answer.TemperatureDecimal;
+  } // if
+
+  // сохраняем данные в состоянии модуля - индексы мы назначаем сами, последовательно, поэтому дыр в нумерации датчиков нет
+  State.UpdateState(StateTemperature,idx,(void*)&t);
+  State.UpdateState(StateHumidity,idx,(void*)&h);
+}
+void HumidityModule::QueryNextSensor()
+{
+  const HumiditySensorRecord& rec = HUMIDITY_SENSORS_ARRAY[nextSensor];
+
+  if(rec.type == SI7021)
+  {
+    // Si7021 не ждём: запускаем измерение и идём к следующему датчику, результат заберём в Update, когда он будет готов
+    if(si7021.isBusy()) // датчик ещё занят предыдущим измерением
+      return;
+
+    si7021Index = nextSensor++;
+    
+    if(!si7021.startMeasure()) // датчик не ответил
+      SaveAnswer(si7021Index,si7021.getAnswer());
+
+    return;
+  }
+
+  SaveAnswer(nextSensor,QuerySensor(rec.pin,rec.type));
+  nextSensor++;
+}
+#endif
 void HumidityModule::Update(uint16_t dt)
 { 
   // обновление модуля тут
+
+  #if SUPPORTED_HUMIDITY_SENSORS > 0
+  // измерение Si7021 идёт параллельно с опросом остальных датчиков - забираем результат, как только он готов
+  if(si7021.update())
+    SaveAnswer(si7021Index,si7021.getAnswer());
+
+  // за один вызов опрашиваем не больше одного датчика, чтобы надолго не задерживать loop()
+  if(nextSensor < SUPPORTED_HUMIDITY_SENSORS)
+    QueryNextSensor();
+  #endif
  
   lastUpdateCall += dt;
   if(lastUpdateCall < HUMIDITY_UPDATE_INTERVAL) // обновляем согласно настроенному интервалу
@@ -60,28 +115,10 @@ void HumidityModule::Update(uint16_t dt)
   else
     lastUpdateCall = 0; 
 
-  // получаем данные с датчиков влажности
+  // начинаем новый цикл опроса датчиков влажности
   #if SUPPORTED_HUMIDITY_SENSORS > 0
-  for(uint8_t i=0;i<SUPPORTED_HUMIDITY_SENSORS;i++)
-   {
-      Humidity h;
-      Temperature t;
-      HumidityAnswer answer = QuerySensor(HUMIDITY_SENSORS_ARRAY[i].pin,HUMIDITY_SENSORS_ARRAY[i].type);
-
-      if(answer.IsOK)
-      {
-        h.Value = answer.Humidity;
-        h.Fract = answer.HumidityDecimal;
-
-        t.Value = answer.Temperature;
-        t.Fract = answer.TemperatureDecimal;
-      } // if
-
-      // сохраняем данные в состоянии модуля - индексы мы назначаем сами, последовательно, поэтому дыр в нумерации датчиков нет
-      State.UpdateState(StateTemperature,i,(void*)&t);
-      State.UpdateState(StateHumidity,i,(void*)&h);
-   }  // for
-   #endif
+  nextSensor = 0;
+  #endif
 
 }
 
@@ -23,6 +23,11 @@ class HumidityModule : public AbstractModule // модуль управлени
     Si7021 si7021; // класс опроса датчиков Si7021
     HumidityAnswer dummyAnswer;
     const HumidityAnswer& QuerySensor(uint8_t pin, HumiditySensorType type); // опрашивает сенсор
+
+    uint8_t nextSensor; // какой датчик опрашиваем следующим в текущем цикле опроса
+    uint8_t si7021Index; // для какого датчика идёт измерение Si7021
+    void QueryNextSensor(); // опрашивает один датчик из цикла опроса
+    void SaveAnswer(uint8_t idx, const HumidityAnswer& answer); // сохраняет показания датчика в состояние модуля
 #endif
 
     uint16_t lastUpdateCall;
@@ -17,6 +17,11 @@ bool InteropStream::QueryCommand(COMMAND_TYPE cType, const String& command, bool
  
  CHECK_PUBLISH_CONSISTENCY; // проверяем структуру публикации на предмет того, что там ничего нет
 
+  Command cmd;
+
+#ifdef USE_INPLACE_COMMAND_PARSER
+  cmd.Construct(command.c_str(),cType); // команда сама разложит имя модуля и параметры по своему буферу
+#else
   String data = command; // копируем во внутренний буфер, т.к. входной параметр - const
    
   int delimIdx = data.indexOf('|');
@@ -29,8 +34,8 @@ bool InteropStream::QueryCommand(COMMAND_TYPE cType, const String& command, bool
 
   const char* moduleId = data.c_str();
   
-  Command cmd;
   cmd.Construct(moduleId,params,cType);
+#endif
 
   //data = F("");
   
@@ -1,24 +1,32 @@
 #include "LogModule.h"
 #include "ModuleController.h"
 #include "TinyVector.h"
+#include <util/crc16.h>
 
 #ifdef LOGGING_DEBUG_MODE
   #define LOG_DEBUG_WRITE(s) Serial.println((s))
 #endif 
 
 #define WRITE_TO_FILE(f,str) f.write((const uint8_t*) str.c_str(),str.length())
-#define WRITE_TO_LOG(str) WRITE_TO_FILE(logFile,str)
+#define WRITE_TO_LOG(str) WriteToLog((const uint8_t*) str.c_str(),str.length())
 #define WRITE_TO_ACTION_LOG(str) WRITE_TO_FILE(actionFile,str)
 
 String LogModule::_COMMA;
 String LogModule::_NEWLINE;
 
+#ifdef USE_BINARY_LOG
+// какие состояния пишем в двоичный лог
+static const ModuleStates BINARY_LOG_STATES[] = {StateTemperature, StateHumidity, StateLuminosity, StateWaterFlowIncremental, StateSoilMoisture, StatePH};
+#endif
+
 void LogModule::Setup()
 {
     LogModule::_COMMA = COMMA_DELIMITER;
     LogModule::_NEWLINE = NEWLINE;
 
     currentLogFileName.reserve(20); // резервируем память, чтобы избежать фрагментации
+    syncFileName.reserve(13);
+    syncOffset = 0;
 
    lastUpdateCall = 0;
    #ifdef USE_DS3231_REALTIME_CLOCK
@@ -31,6 +39,27 @@ void LogModule::Setup()
    lastActionsDOW = -1;
 #endif   
 
+#ifdef USE_LOG_WRITE_BUFFER
+   logBufferPos = 0;
+   logBufferLimit = LOG_WRITE_BUFFER_SIZE;
+   lastLogFlush = 0;
+#endif
+
+#ifdef USE_LOG_INDEX
+   lastIndexedBucket = -1;
+#endif
+
+#ifdef USE_BINARY_LOG
+   binaryDictionaryModules = 0;
+#endif
+
+#ifdef USE_LOG_ROLLUPS
+   rollupsCount = 0;
+   rollupsLayoutVersion = 0;
+   rollupsInited = false;
+   hasRollupTime = false;
+#endif
+
    hasSD = MainController->HasSDCard();
    loggingInterval = LOGGING_INTERVAL; // по умолчанию, берём из Globals.h. Позже - будет из настроек.
   // настройка модуля тут
@@ -169,7 +198,10 @@ void LogModule::CreateNewLogFile(const DS3231Time& tm)
     return;
   
     if(logFile) // есть открытый файл
+    {
+      FlushLog(); // сливаем накопленное
       logFile.close(); // закрываем его
+    }
 
    // формируем имя нашего нового лог-файла:
    // формат YYYYMMDD.LOG
@@ -185,7 +217,11 @@ void LogModule::CreateNewLogFile(const DS3231Time& tm)
     currentLogFileName += F("0");
    currentLogFileName += String(tm.dayOfMonth);
 
+   #ifdef USE_BINARY_LOG
+   currentLogFileName += F(".BIN");
+   #else
    currentLogFileName += F(".LOG");
+   #endif
 
    String logDirectory = LOGS_DIRECTORY; // папка с логами
    if(!SD.exists(logDirectory)) // нет папки LOGS_DIRECTORY
@@ -221,6 +257,12 @@ void LogModule::CreateNewLogFile(const DS3231Time& tm)
    #ifdef LOGGING_DEBUG_MODE
     LOG_DEBUG_WRITE(String(F("File ")) + currentLogFileName + String(F(" successfully created!")));
    #endif
+
+   #ifdef USE_LOG_WRITE_BUFFER
+    // файл дописывается в конец, поэтому первый раз копим только до границы сектора
+    logBufferPos = 0;
+    logBufferLimit = LOG_WRITE_BUFFER_SIZE - (logFile.size() % LOG_WRITE_BUFFER_SIZE);
+   #endif
     
    }
    else
@@ -232,9 +274,14 @@ void LogModule::CreateNewLogFile(const DS3231Time& tm)
    }
 
    // файл создали, можем с ним работать.
-#ifdef ADD_LOG_HEADER
+#ifdef USE_BINARY_LOG
+   TryAddBinaryHeader(tm); // двоичному логу заголовок нужен всегда
+   binaryDictionaryModules = 0; // а словарь пишем в каждый открытый файл заново - после перезапуска порядок модулей может быть другим
+#else
+  #ifdef ADD_LOG_HEADER
    TryAddFileHeader(); // пытаемся добавить заголовок в файл
-#endif   
+  #endif   
+#endif
       
 }
 #ifdef ADD_LOG_HEADER
@@ -397,6 +444,153 @@ void LogModule::TryAddFileHeader()
   } // if(!sz) - файл пуст
 }
 #endif
+#ifdef USE_BINARY_LOG
+void LogModule::WriteBinaryString(const String& str)
+{
+  WriteBinaryByte(str.length());
+  WRITE_TO_LOG(str);
+}
+void LogModule::TryAddBinaryHeader(const DS3231Time& tm)
+{
+  if(logFile.size()) // файл уже начат, заголовок в нём есть
+    return;
+
+  const char* signature = BINARY_LOG_SIGNATURE;
+  WriteToLog((const uint8_t*) signature,4);
+  WriteBinaryByte(BINARY_LOG_VERSION);
+  WriteBinaryByte(sizeof(BinaryLogRecord));
+  WriteBinaryByte(tm.year & 0xFF);
+  WriteBinaryByte(tm.year >> 8);
+  WriteBinaryByte(tm.month);
+  WriteBinaryByte(tm.dayOfMonth);
+
+  // флаги - как переводить записи в CSV, чтобы вышло то же, что пишет CSV-лог с этими настройками
+  uint8_t flags = 0;
+  #ifdef LOG_CNANGE_NAME_TO_IDX
+  flags |= BINARY_LOG_FLAG_NAME_TO_IDX;
+  #endif
+  #ifdef LOG_CHANGE_TYPE_TO_IDX
+  flags |= BINARY_LOG_FLAG_TYPE_TO_IDX;
+  #endif
+  WriteBinaryByte(flags);
+}
+void LogModule::TryAddBinaryDictionary()
+{
+  // модули только добавляются (RemoteModule регистрируется на лету) и не удаляются, поэтому
+  // список модулей поменялся, если поменялось их кол-во
+  size_t cnt = MainController->GetModulesCount();
+  if(cnt == binaryDictionaryModules) // словарь в файле актуален
+    return;
+
+  binaryDictionaryModules = cnt;
+
+  uint16_t mark = BINARY_LOG_DICTIONARY_MARK;
+  WriteToLog((const uint8_t*) &mark,sizeof(mark));
+
+  // словарь модулей: индекс модуля в системе - его имя
+  WriteBinaryByte(cnt);
+  
+  for(size_t i=0;i<cnt;i++)
+  {
+    WriteBinaryByte(i);
+    WriteBinaryString(MainController->GetModule(i)->GetID());
+  }
+
+  // словарь типов датчиков: тип - его название в CSV-логе
+  const uint8_t typesCnt = sizeof(BINARY_LOG_STATES)/sizeof(BINARY_LOG_STATES[0]);
+  WriteBinaryByte(typesCnt);
+  
+  for(uint8_t i=0;i<typesCnt;i++)
+  {
+    String typeName;
+    switch(BINARY_LOG_STATES[i])
+    {
+      case StateTemperature: typeName = LOG_TEMP_TYPE; break;
+      case StateHumidity: typeName = LOG_HUMIDITY_TYPE; break;
+      case StateLuminosity: typeName = LOG_LUMINOSITY_TYPE; break;
+      case StateWaterFlowIncremental: typeName = LOG_WATERFLOW_TYPE; break;
+      case StateSoilMoisture: typeName = LOG_SOIL_TYPE; break;
+      case StatePH: typeName = LOG_PH_TYPE; break;
+      default: break;
+    }
+    
+    WriteBinaryByte(BINARY_LOG_STATES[i]);
+    WriteBinaryString(typeName);
+  } // for
+}
+#endif // USE_BINARY_LOG
+#ifdef USE_LOG_INDEX
+void LogModule::UpdateLogIndex(const DS3231Time& tm)
+{
+  uint8_t bucket = (tm.hour*60 + tm.minute)/LOG_INDEX_BUCKET_MINUTES;
+  if(bucket == lastIndexedBucket) // смещение для этого интервала уже записано
+    return;
+
+  // данные интервала начнутся с конца файла - с учётом того, что ещё лежит в буфере записи
+  uint32_t offset = logFile.size();
+  #ifdef USE_LOG_WRITE_BUFFER
+  offset += logBufferPos;
+  #endif
+
+  // индекс лежит рядом с логом, имя то же, расширение - .IDX
+  String indexFileName = currentLogFileName.substring(0,currentLogFileName.lastIndexOf('.'));
+  indexFileName += F(".IDX");
+
+  File indexFile = SD.open(indexFileName,FILE_WRITE);
+  if(!indexFile)
+    return;
+
+  uint8_t record[5];
+  record[0] = bucket;
+  record[1] = offset & 0xFF;
+  record[2] = (offset >> 8) & 0xFF;
+  record[3] = (offset >> 16) & 0xFF;
+  record[4] = (offset >> 24) & 0xFF;
+
+  indexFile.write(record,sizeof(record));
+  indexFile.close();
+
+  lastIndexedBucket = bucket;
+}
+
+bool LogModule::GetRangeFromIndex(const String& indexFilePath, uint16_t fromMinutes, uint16_t toMinutes, uint32_t& offset, uint32_t& length)
+{
+  File indexFile = SD.open(indexFilePath,FILE_READ);
+  if(!indexFile)
+    return false;
+
+  uint8_t fromBucket = fromMinutes/LOG_INDEX_BUCKET_MINUTES;
+  uint8_t toBucket = toMinutes/LOG_INDEX_BUCKET_MINUTES;
+
+  // после перезапуска контроллера или перевода часов интервал может встретиться в индексе несколько раз,
+  // поэтому берём наименьшие смещения: начало - среди запрошенных интервалов, конец - среди следующих за ними
+  uint32_t start = 0xFFFFFFFF;
+  uint32_t end = 0xFFFFFFFF;
+  uint8_t record[5];
+
+  while(indexFile.read(record,sizeof(record)) == sizeof(record))
+  {
+    uint32_t recordOffset = record[1] | (((uint32_t) record[2]) << 8) | (((uint32_t) record[3]) << 16) | (((uint32_t) record[4]) << 24);
+
+    if(record[0] >= fromBucket && record[0] <= toBucket)
+    {
+      if(recordOffset < start)
+        start = recordOffset;
+    }
+    else
+    if(record[0] > toBucket && recordOffset < end)
+      end = recordOffset;
+  } // while
+
+  indexFile.close();
+
+  // нет данных за запрошенное время - смещение за концом файла даст пустой кусок
+  offset = start;
+  length = (start != 0xFFFFFFFF && end != 0xFFFFFFFF && end > start) ? end - start : 0; // 0 - до конца файла
+
+  return true;
+}
+#endif // USE_LOG_INDEX
 void LogModule::GatherLogInfo(const DS3231Time& tm)
 {
   // собираем информацию в лог
@@ -408,15 +602,71 @@ void LogModule::GatherLogInfo(const DS3231Time& tm)
     #endif
     return;
   }
+
+#if defined(USE_LOG_INDEX) && !defined(USE_BINARY_LOG)
+  UpdateLogIndex(tm); // запоминаем, с какого места в файле начинаются данные текущего интервала
+#endif
   
+#ifndef USE_LOG_WRITE_BUFFER
   logFile.flush(); // сливаем информацию на карту
   
   yield(); // т.к. запись на SD-карту у нас может занимать какое-то время - дёргаем кооперативный режим
+#endif
  
     #ifdef LOGGING_DEBUG_MODE
     LOG_DEBUG_WRITE(F("Gathering sensors data..."));
     #endif
 
+#ifdef USE_BINARY_LOG
+
+  TryAddBinaryDictionary(); // записи ниже ссылаются на модули по индексу - словарь для них должен быть в файле
+
+  // в двоичном логе строки не нужны - пишем записи фиксированной длины
+  BinaryLogRecord record;
+  record.Minutes = tm.hour*60 + tm.minute;
+  
+  size_t modulesCnt = MainController->GetModulesCount();
+  for(size_t i=0;i<modulesCnt;i++)
+  {
+    AbstractModule* m = MainController->GetModule(i);
+    if(m == this) // пропускаем себя
+      continue;
+
+    record.ModuleHandle = i;
+    
+    for(uint8_t j=0;j<sizeof(BINARY_LOG_STATES)/sizeof(BINARY_LOG_STATES[0]);j++)
+    {
+      ModuleStates state = BINARY_LOG_STATES[j];
+      uint8_t stateCnt = m->State.GetStateCount(state);
+      record.SensorType = state;
+      
+      for(uint8_t stateIdx = 0; stateIdx < stateCnt;stateIdx++)
+      {
+        OneState* os = m->State.GetStateByOrder(state,stateIdx);
+        if(!os)
+          continue;
+
+        #ifndef WRITE_ABSENT_SENSORS_DATA
+        if(!os->HasData()) 
+          continue;
+        #endif
+
+        record.SensorIndex = os->GetIndex();
+        memset(record.RawData,0,sizeof(record.RawData));
+        os->GetRawData(record.RawData);
+
+        WriteToLog((const uint8_t*) &record,sizeof(BinaryLogRecord));
+      } // for
+    } // for
+  } // for
+
+#ifndef USE_LOG_WRITE_BUFFER
+  logFile.flush(); // сливаем данные на карту
+  yield(); // т.к. запись на SD-карту у нас может занимать какое-то время - дёргаем кооперативный режим
+#endif
+
+#else // !USE_BINARY_LOG
+
   // строка с данными у нас имеет вид:
   // HH:MM,MODULE_NAME,SENSOR_TYPE,SENSOR_IDX,SENSOR_DATA
   // и соответствует формату CSV, т.е. если в данных есть "," и другие запрещенные символы, то данные обрамляются двойными кавычками
@@ -507,7 +757,7 @@ void LogModule::GatherLogInfo(const DS3231Time& tm)
         #endif
 
         // теперь последовательно проходим по вектору состояний, проверяя, есть ли такое
-        String sensorIdx, stateType;
+        String stateType;
         for(size_t j=0;j<statesTypes.size();j++)
         {
             ModuleStates state = statesTypes[j]; // получили тип интересующего нас состояния            
@@ -523,14 +773,12 @@ void LogModule::GatherLogInfo(const DS3231Time& tm)
                   OneState* os = m->State.GetStateByOrder(state,stateIdx);
                   if(os)
                   {
-                      sensorIdx = String(os->GetIndex());
-                      
                       #ifndef WRITE_ABSENT_SENSORS_DATA
                       if(os->HasData()) 
                       #endif
                       {
                           // пишем строку с данными               
-                          WriteLogLine(hhmm,moduleName,stateType,sensorIdx,*os);
+                          WriteLogLine(hhmm,moduleName,stateType,os->GetIndex(),*os);
                       } // if                      
                   } // if (os)
               } // for
@@ -542,26 +790,99 @@ void LogModule::GatherLogInfo(const DS3231Time& tm)
     } // for
 
   
+#endif // USE_BINARY_LOG
+  
     // записали, выдохнули, расслабились.
     #ifdef LOGGING_DEBUG_MODE
     LOG_DEBUG_WRITE(F("Sensors data gathered."));
     #endif
   
 }
-void LogModule::WriteLogLine(const String& hhmm, const String& moduleName, const String& sensorType, const String& sensorIdx, const String& sensorData)
+void LogModule::WriteLogLine(const String& hhmm, const String& moduleName, const String& sensorType, uint8_t sensorIdx, const String& sensorData)
 {
+  char idxBuff[4]; // индекс датчика - не больше трёх цифр
+  itoa(sensorIdx,idxBuff,10);
+  
   // пишем строку с данными в лог
   // HH:MM,MODULE_NAME,SENSOR_TYPE,SENSOR_IDX,SENSOR_DATA\r\n
   WRITE_TO_LOG(hhmm);             WRITE_TO_LOG(LogModule::_COMMA);
   WRITE_TO_LOG(moduleName);       WRITE_TO_LOG(LogModule::_COMMA);
   WRITE_TO_LOG(sensorType);       WRITE_TO_LOG(LogModule::_COMMA);
-  WRITE_TO_LOG(sensorIdx);        WRITE_TO_LOG(LogModule::_COMMA);
-  WRITE_TO_LOG(csv(sensorData));  WRITE_TO_LOG(LogModule::_NEWLINE);
+  WriteToLog((const uint8_t*) idxBuff,strlen(idxBuff)); WRITE_TO_LOG(LogModule::_COMMA);
+  WriteCsvToLog(sensorData);      WRITE_TO_LOG(LogModule::_NEWLINE);
 
+#ifndef USE_LOG_WRITE_BUFFER
   logFile.flush(); // сливаем данные на карту
 
   yield(); // т.к. запись на SD-карту у нас может занимать какое-то время - дёргаем кооперативный режим
+#endif
 
+}
+void LogModule::WriteToLog(const uint8_t* data, size_t len)
+{
+#ifdef USE_LOG_WRITE_BUFFER
+  while(len)
+  {
+    size_t toCopy = logBufferLimit - logBufferPos;
+    if(toCopy > len)
+      toCopy = len;
+
+    memcpy(&(logBuffer[logBufferPos]),data,toCopy);
+    logBufferPos += toCopy;
+    data += toCopy;
+    len -= toCopy;
+
+    if(logBufferPos >= logBufferLimit) // накопили до границы сектора - пишем весь буфер разом
+    {
+      logFile.write(logBuffer,logBufferPos);
+      logBufferPos = 0;
+      logBufferLimit = LOG_WRITE_BUFFER_SIZE;
+      
+      yield(); // т.к. запись на SD-карту у нас может занимать какое-то время - дёргаем кооперативный режим
+    }
+  } // while
+#else
+  logFile.write(data,len);
+#endif
+}
+void LogModule::FlushLog()
+{
+#ifdef USE_LOG_WRITE_BUFFER
+  lastLogFlush = 0;
+
+  if(!logFile) // некуда сливать
+  {
+    logBufferPos = 0;
+    return;
+  }
+
+  if(logBufferPos)
+  {
+    logFile.write(logBuffer,logBufferPos);
+    logBufferPos = 0;
+  }
+
+  // после частичной записи копим только до следующей границы сектора
+  logBufferLimit = LOG_WRITE_BUFFER_SIZE - (logFile.size() % LOG_WRITE_BUFFER_SIZE);
+#endif
+
+  if(logFile)
+    logFile.flush();
+}
+void LogModule::WriteCsvToLog(const String& data)
+{
+  // в большинстве случаев обрамлять нечего - тогда пишем данные как есть, без промежуточных строк
+  const char* str = data.c_str();
+  size_t len = data.length();
+  
+  if(!strpbrk(str,"\",;\r\n") && data.indexOf(LogModule::_COMMA) == -1 && data.indexOf(LogModule::_NEWLINE) == -1)
+  {
+    WriteToLog((const uint8_t*) str,len);
+    return;
+  }
+
+  String escaped = csv(data);
+  WRITE_TO_LOG(escaped);
 }
 String LogModule::csv(const String& src)
 {
@@ -588,8 +909,179 @@ String LogModule::csv(const String& src)
 
   return input;
 }
+#ifdef USE_LOG_ROLLUPS
+void LogModule::InitRollups()
+{
+  rollupsInited = true;
+  rollupsLayoutVersion = ModuleState::GetLayoutVersion();
+  rollupsCount = 0;
+
+  // те же типы датчиков, что и в истории показаний: расход воды уже накопительный, для него сводки не нужны
+  static const ModuleStates ROLLUP_STATES[] = { StateTemperature, StateHumidity, StateLuminosity, StateSoilMoisture, StatePH };
+
+  size_t modulesCnt = MainController->GetModulesCount();
+  for(size_t i=0;i<modulesCnt && rollupsCount < LOG_ROLLUP_MAX_SENSORS;i++)
+  {
+    AbstractModule* m = MainController->GetModule(i);
+    if(m == this) // пропускаем себя
+      continue;
+
+    for(uint8_t j=0;j<sizeof(ROLLUP_STATES)/sizeof(ROLLUP_STATES[0]) && rollupsCount < LOG_ROLLUP_MAX_SENSORS;j++)
+    {
+      uint8_t stateCnt = m->State.GetStateCount(ROLLUP_STATES[j]);
+      for(uint8_t stateIdx=0;stateIdx<stateCnt && rollupsCount < LOG_ROLLUP_MAX_SENSORS;stateIdx++)
+      {
+        OneState* os = m->State.GetStateByOrder(ROLLUP_STATES[j],stateIdx);
+        if(!os)
+          continue;
+
+        RollupSlot& slot = rollups[rollupsCount++];
+        memset(&slot,0,sizeof(RollupSlot));
+        slot.State = os;
+        slot.ModuleHandle = i;
+      } // for
+    } // for
+  } // for
+}
+
+void LogModule::AddRollupValue(RollupValue& rv, long value)
+{
+  if(!rv.Count || value < rv.Min)
+    rv.Min = value;
+  if(!rv.Count || value > rv.Max)
+    rv.Max = value;
+
+  rv.Sum += value;
+  rv.Count++;
+}
+
+void LogModule::WriteRollups(const DS3231Time& tm, bool daily)
+{
+  // имя файла: YYYYMMDD.HRL для часовых сводок, YYYYMM.DAY - для суточных
+  String fileName = LOGS_DIRECTORY;
+  fileName += F("/");
+  fileName += String(tm.year);
+
+  if(tm.month < 10)
+    fileName += F("0");
+  fileName += String(tm.month);
+
+  if(!daily)
+  {
+    if(tm.dayOfMonth < 10)
+      fileName += F("0");
+    fileName += String(tm.dayOfMonth);
+  }
+
+  fileName += daily ? F(".DAY") : F(".HRL");
+
+  File rollupFile = SD.open(fileName,FILE_WRITE);
+
+  // первое поле строки - час для часовой сводки и день месяца - для суточной
+  uint8_t period = daily ? tm.dayOfMonth : tm.hour;
+  String periodStr;
+  if(period < 10)
+    periodStr = F("0");
+  periodStr += String(period);
+
+  String line;
+  for(uint8_t i=0;i<rollupsCount;i++)
+  {
+    RollupSlot& slot = rollups[i];
+    RollupValue& rv = daily ? slot.Day : slot.Hour;
+
+    if(rv.Count && rollupFile)
+    {
+      ModuleStates type = slot.State->GetType();
+      
+      // HH,MODULE_NAME,SENSOR_TYPE,SENSOR_IDX,COUNT,MIN,MAX,AVG\r\n
+      line = periodStr;
+      line += LogModule::_COMMA;
+      
+      #ifdef LOG_CNANGE_NAME_TO_IDX
+      line += String(slot.ModuleHandle);
+      #else
+      line += MainController->GetModule(slot.ModuleHandle)->GetID();
+      #endif
+      line += LogModule::_COMMA;
+
+      #ifdef LOG_CHANGE_TYPE_TO_IDX
+      line += String(type);
+      #else
+      switch(type)
+      {
+        case StateTemperature: line += LOG_TEMP_TYPE; break;
+        case StateHumidity: line += LOG_HUMIDITY_TYPE; break;
+        case StateLuminosity: line += LOG_LUMINOSITY_TYPE; break;
+        case StateSoilMoisture: line += LOG_SOIL_TYPE; break;
+        case StatePH: line += LOG_PH_TYPE; break;
+        default: break;
+      }
+      #endif
+      line += LogModule::_COMMA;
+
+      line += String(slot.State->GetIndex()); line += LogModule::_COMMA;
+      line += String(rv.Count);               line += LogModule::_COMMA;
+      line += csv(OneState::FormatFixedValue(type,rv.Min)); line += LogModule::_COMMA;
+      line += csv(OneState::FormatFixedValue(type,rv.Max)); line += LogModule::_COMMA;
+      line += csv(OneState::FormatFixedValue(type,rv.Sum/rv.Count));
+      line += LogModule::_NEWLINE;
+
+      rollupFile.write((const uint8_t*) line.c_str(),line.length());
+    }
+
+    memset(&rv,0,sizeof(RollupValue)); // начинаем новый период
+  } // for
+
+  if(rollupFile)
+    rollupFile.close();
+
+  yield(); // т.к. запись на SD-карту у нас может занимать какое-то время - дёргаем кооперативный режим
+}
+
+void LogModule::UpdateRollups(const DS3231Time& tm)
+{
+  // датчики собираем при первом вызове, когда все модули уже зарегистрированы, и заново - если состав датчиков поменялся.
+  // Накопленное при этом теряется: указатели на старые состояния уже могут быть недействительны.
+  if(!rollupsInited || rollupsLayoutVersion != ModuleState::GetLayoutVersion())
+    InitRollups();
+
+  if(hasRollupTime)
+  {
+    bool newDay = (tm.dayOfMonth != rollupTime.dayOfMonth || tm.month != rollupTime.month || tm.year != rollupTime.year);
+    if(newDay || tm.hour != rollupTime.hour)
+    {
+      // период закончился - пишем сводки с тем временем, к которому они относятся
+      WriteRollups(rollupTime,false);
+      if(newDay)
+        WriteRollups(rollupTime,true);
+    }
+  }
+
+  rollupTime = tm;
+  hasRollupTime = true;
+
+  long value;
+  for(uint8_t i=0;i<rollupsCount;i++)
+  {
+    RollupSlot& slot = rollups[i];
+    if(!slot.State->GetFixedValue(value)) // нет показаний с датчика
+      continue;
+
+    AddRollupValue(slot.Hour,value);
+    AddRollupValue(slot.Day,value);
+  } // for
+}
+#endif // USE_LOG_ROLLUPS
+
 void LogModule::Update(uint16_t dt)
 { 
+#ifdef USE_LOG_WRITE_BUFFER
+  lastLogFlush += dt;
+  if(lastLogFlush >= LOG_FLUSH_INTERVAL) // давно не сливали накопленное на карту
+    FlushLog();
+#endif
+
   lastUpdateCall += dt;
   if(lastUpdateCall < loggingInterval) // не надо обновлять ничего - не пришло время
     return;
@@ -608,6 +1100,9 @@ void LogModule::Update(uint16_t dt)
   if(lastDOW != tm.dayOfWeek) // наступил следующий день недели, надо создать новый лог-файл
   {
    lastDOW = tm.dayOfWeek;
+#ifdef USE_LOG_INDEX
+   lastIndexedBucket = -1; // в новом файле индекс начинается заново
+#endif
    CreateNewLogFile(tm); // создаём новый файл
 #ifdef LOG_ACTIONS_ENABLED
    EnsureActionsFileCreated(); // создаём новый файл действий, если он ещё не был создан
@@ -615,11 +1110,90 @@ void LogModule::Update(uint16_t dt)
   }
 
   GatherLogInfo(tm); // собираем информацию в лог
+#ifdef USE_LOG_ROLLUPS
+  UpdateRollups(tm); // накапливаем показания для часовых и суточных сводок
+#endif
 #endif    
   // обновление модуля тут
 
 }
 
+bool LogModule::SendFile(const Command& command, const String& fullFilePath, uint32_t offset, uint32_t length, bool ranged)
+{
+  File fRead = SD.open(fullFilePath,FILE_READ);
+  if(!fRead)
+    return false;
+
+  // файл открыли, подгоняем запрошенный кусок под размер файла
+  uint32_t fileSize = fRead.size();
+  if(offset > fileSize)
+    offset = fileSize;
+
+  if(!length || length > fileSize - offset) // длина 0 - до конца файла
+    length = fileSize - offset;
+
+  fRead.seek(offset);
+  
+  // сперва отправим в поток строчку OK=FOLLOW
+  Stream* writeStream = command.GetIncomingStream();
+  writeStream->print(OK_ANSWER);
+  writeStream->print(COMMAND_DELIMITER);
+  writeStream->print(FOLLOW);
+
+  if(ranged) // для куска файла сообщаем, что именно отдаём
+  {
+    writeStream->print(PARAM_DELIMITER);
+    writeStream->print(offset);
+    writeStream->print(PARAM_DELIMITER);
+    writeStream->print(length);
+    writeStream->print(PARAM_DELIMITER);
+    writeStream->print(fileSize);
+  }
+  writeStream->println();
+
+  //теперь читаем из файла блоками, делая паузы для вызова yield через несколько блоков
+  const int DELAY_AFTER = 2;
+  int delayCntr = 0;
+  uint16_t crc = 0;
+
+  while(length)
+  {
+    uint16_t toRead = length > SD_BUFFER_LENGTH ? SD_BUFFER_LENGTH : length;
+    int readed = fRead.read(SD_BUFFER,toRead);
+    if(readed <= 0) // файл кончился раньше, чем думали
+      break;
+
+    writeStream->write((const uint8_t*) SD_BUFFER,readed);
+    length -= readed;
+
+    if(ranged)
+    {
+      for(int i=0;i<readed;i++)
+        crc = _crc16_update(crc,SD_BUFFER[i]);
+    }
+    
+    delayCntr++;
+    if(delayCntr > DELAY_AFTER)
+    {
+      delayCntr = 0;
+      yield(); // даём поработать другим модулям
+    }
+  } // while
+  
+  fRead.close(); // закрыли файл
+  
+  PublishSingleton.Status = true;
+  PublishSingleton = END_OF_FILE; // выдаём OK=END_OF_FILE
+
+  if(ranged) // и контрольную сумму куска, чтобы клиент мог проверить, что получил его целым
+  {
+    PublishSingleton << PARAM_DELIMITER << WorkStatus::ToHex(crc >> 8);
+    PublishSingleton << WorkStatus::ToHex(crc & 0xFF);
+  }
+
+  return true;
+}
+
 bool LogModule::ExecCommand(const Command& command, bool wantAnswer)
 {
   UNUSED(wantAnswer);
@@ -632,63 +1206,107 @@ if(hasSD)
   if(command.GetType() == ctSET) 
   {
     PublishSingleton = NOT_SUPPORTED;
+
+    if(argsCnt > 2 && !strcmp_P(command.GetArg(0),(const char*) SYNC_COMMAND))
+    {
+      // клиент подтвердил, что забрал файл лога до переданного смещения
+      syncFileName = command.GetArg(1);
+      syncOffset = strtoul(command.GetArg(2),NULL,10);
+
+      PublishSingleton.Status = true;
+      PublishSingleton = SYNC_COMMAND;
+      PublishSingleton << PARAM_DELIMITER << syncFileName << PARAM_DELIMITER << syncOffset;
+    }
   }
   else
   {
     if(argsCnt > 0)
     {
       String cmd = command.GetArg(0);
-      if(cmd == FILE_COMMAND)
+      bool newDataRequested = (cmd == NEW_DATA_COMMAND);
+      #ifdef USE_LOG_INDEX
+      bool rangeRequested = (cmd == RANGE_COMMAND);
+      #else
+      bool rangeRequested = false;
+      #endif
+
+      #ifdef USE_BINARY_LOG
+      if(rangeRequested)
+      {
+        // кусок двоичного лога без заголовка со словарём прочитать нечем - отдаём только весь файл
+        PublishSingleton = NOT_SUPPORTED;
+      }
+      else
+      #endif
+      if(cmd == FILE_COMMAND || newDataRequested || rangeRequested)
       {
         // надо отдать файл
-        if(argsCnt > 1)
+        if(argsCnt > (rangeRequested ? 3 : 1))
         {
           // получаем полное имя файла
           String fileNameRequested = command.GetArg(1);
+          
+          #ifdef USE_LOG_INDEX
+          if(rangeRequested) // для куска лога за время передают только дату, YYYYMMDD
+            fileNameRequested += F(".LOG");
+          #endif
+          
           String fullFilePath = LOGS_DIRECTORY;
           fullFilePath += F("/");
           fullFilePath += fileNameRequested;
 
+          // по умолчанию - отдаём весь файл
+          bool ranged = newDataRequested;
+          uint32_t offset = 0;
+          uint32_t length = 0;
+
+          if(newDataRequested)
+          {
+            // отдаём то, что дописано с последней синхронизации этого файла
+            if(syncFileName == fileNameRequested)
+              offset = syncOffset;
+
+            if(argsCnt > 2)
+              length = strtoul(command.GetArg(2),NULL,10);
+          }
+          else
+#ifdef USE_LOG_INDEX
+          if(rangeRequested)
+          {
+            // время - в виде HH:MM, переводим в минуты от начала суток
+            const char* from = command.GetArg(2);
+            const char* to = command.GetArg(3);
+            const char* fromMinutes = strchr(from,':');
+            const char* toMinutes = strchr(to,':');
+            
+            String indexFilePath = fullFilePath.substring(0,fullFilePath.lastIndexOf('.'));
+            indexFilePath += F(".IDX");
+
+            // индекса нет - лог писался без него, отдаём файл целиком
+            ranged = GetRangeFromIndex(indexFilePath,atoi(from)*60 + (fromMinutes ? atoi(fromMinutes+1) : 0),
+              atoi(to)*60 + (toMinutes ? atoi(toMinutes+1) : 0),offset,length);
+          }
+          else
+#endif
+          if(argsCnt > 2) // запросили кусок файла
+          {
+            ranged = true;
+            offset = strtoul(command.GetArg(2),NULL,10);
+            if(argsCnt > 3)
+              length = strtoul(command.GetArg(3),NULL,10);
+          }
+
           if(SD.exists(fullFilePath.c_str()))
           {
             // такой файл существует, можно отдавать
             if(logFile)
+            {
+              FlushLog(); // сливаем накопленное, чтобы отдать файл целиком
               logFile.close(); // сперва закрываем текущий лог-файл
+            }
 
-            // теперь можно открывать файл на чтение
-            File fRead = SD.open(fullFilePath,FILE_READ);
-            if(fRead)
-            {
-              // файл открыли, можно читать
-              // сперва отправим в потом строчку OK=FOLLOW
-              Stream* writeStream = command.GetIncomingStream();
-              writeStream->print(OK_ANSWER);
-              writeStream->print(COMMAND_DELIMITER);
-              writeStream->println(FOLLOW);
-
-              //теперь читаем из файла блоками, делая паузы для вызова yield через несколько блоков
-              const int DELAY_AFTER = 2;
-              int delayCntr = 0;
-
-              uint16_t readed;
-
-               while(fRead.available())
-               {
-                readed = fRead.read(SD_BUFFER,SD_BUFFER_LENGTH);
-                writeStream->write(SD_BUFFER,readed);
-                delayCntr++;
-                if(delayCntr > DELAY_AFTER)
-                {
-                  delayCntr = 0;
-                  yield(); // даём поработать другим модулям
-                }
-               } // while
-              
-              
-              fRead.close(); // закрыли файл
-              PublishSingleton.Status = true;
-              PublishSingleton = END_OF_FILE; // выдаём OK=END_OF_FILE
-            } // if(fRead)
+            // теперь можно отдавать файл
+            SendFile(command,fullFilePath,offset,length,ranged);
 
             #ifdef USE_DS3231_REALTIME_CLOCK
                 DS3231Time tm = rtc.getTime();
@@ -722,40 +1340,8 @@ if(hasSD)
             if(actionFile)
               actionFile.close(); // сперва закрываем текущий файл действий
 
-            // теперь можно открывать файл на чтение
-            File fRead = SD.open(fullFilePath,FILE_READ);
-            if(fRead)
-            {
-              // файл открыли, можно читать
-              // сперва отправим в потом строчку OK=FOLLOW
-              Stream* writeStream = command.GetIncomingStream();
-              writeStream->print(OK_ANSWER);
-              writeStream->print(COMMAND_DELIMITER);
-              writeStream->println(FOLLOW);
-
-              //теперь читаем из файла блоками, делая паузы для вызова yield через несколько блоков
-              const int DELAY_AFTER = 2;
-              int delayCntr = 0;
-
-              uint16_t readed;
-
-               while(fRead.available())
-               {
-                readed = fRead.read(SD_BUFFER,SD_BUFFER_LENGTH);
-                writeStream->write(SD_BUFFER,readed);
-                delayCntr++;
-                if(delayCntr > DELAY_AFTER)
-                {
-                  delayCntr = 0;
-                  yield(); // даём поработать другим модулям
-                }
-               } // while
-              
-              
-              fRead.close(); // закрыли файл
-              PublishSingleton.Status = true;
-              PublishSingleton = END_OF_FILE; // выдаём OK=END_OF_FILE
-            } // if(fRead)
+            // теперь можно отдавать файл
+            SendFile(command,fullFilePath,0,0,false);
 
             #if defined(USE_DS3231_REALTIME_CLOCK) && defined(LOG_ACTIONS_ENABLED)
                 DS3231Time tm = rtc.getTime();
@@ -786,4 +1372,3 @@ if(hasSD)
 
   return true;
 }
-
@@ -12,6 +12,50 @@ typedef struct
   
 } LogAction; // структура с описанием действий, которые произошли 
 
+#ifdef USE_BINARY_LOG
+// запись двоичного лога. Выравнивания на AVR нет, поэтому пишем структуру в файл как есть.
+// Формат файла:
+// заголовок: BINARY_LOG_SIGNATURE, версия (1 байт), длина записи (1 байт), год (2 байта), месяц (1 байт), день (1 байт),
+// флаги BINARY_LOG_FLAG_* (1 байт);
+// дальше - записи BinaryLogRecord и словари подряд до конца файла. Многобайтовые значения - младшим байтом вперёд.
+// Словарь: BINARY_LOG_DICTIONARY_MARK (2 байта, на месте Minutes записи), кол-во модулей (1 байт), для каждого модуля -
+// индекс (1 байт), длина имени (1 байт), имя; кол-во типов датчиков (1 байт), для каждого типа - тип (1 байт),
+// длина имени (1 байт), имя. Словарь пишется перед первой записью после старта контроллера и при изменении списка модулей,
+// и действует для всех записей после него.
+#define BINARY_LOG_DICTIONARY_MARK 0xFFFF // минут от начала суток столько не бывает
+#define BINARY_LOG_FLAG_NAME_TO_IDX 1 // LOG_CNANGE_NAME_TO_IDX - в CSV вместо имени модуля пишется его индекс
+#define BINARY_LOG_FLAG_TYPE_TO_IDX 2 // LOG_CHANGE_TYPE_TO_IDX - в CSV вместо названия типа пишется его числовое значение
+typedef struct
+{
+  uint16_t Minutes; // минут от начала суток
+  uint8_t ModuleHandle; // индекс модуля в системе
+  uint8_t SensorType; // тип датчика, ModuleStates
+  uint8_t SensorIndex; // индекс датчика
+  uint8_t RawData[4]; // данные, как их отдаёт OneState::GetRawData, неиспользуемые байты - нули
+  
+} BinaryLogRecord;
+#endif
+
+#ifdef USE_LOG_ROLLUPS
+typedef struct
+{
+  long Min;
+  long Max;
+  long Sum;
+  uint16_t Count; // сколько показаний накоплено, 0 - за период показаний не было
+  
+} RollupValue; // накопленные за период показания датчика, в единицах OneState::GetFixedValue
+
+typedef struct
+{
+  OneState* State; // датчик, по которому ведём сводку
+  uint8_t ModuleHandle; // индекс модуля в системе
+  RollupValue Hour; // сводка за текущий час
+  RollupValue Day; // сводка за текущие сутки
+  
+} RollupSlot;
+#endif
+
 class LogModule : public AbstractModule // модуль логгирования данных с датчиков
 {
   private:
@@ -39,14 +83,59 @@ class LogModule : public AbstractModule // модуль логгирования
 
   void CreateNewLogFile(const DS3231Time& tm);
   void GatherLogInfo(const DS3231Time& tm); 
+#ifdef USE_BINARY_LOG
+  size_t binaryDictionaryModules; // для скольких модулей записан словарь в текущий файл, 0 - словаря ещё нет
+  void TryAddBinaryHeader(const DS3231Time& tm); // пишет заголовок в пустой файл
+  void TryAddBinaryDictionary(); // пишет словарь модулей и типов, если его ещё нет в файле или список модулей изменился
+  void WriteBinaryByte(uint8_t b) { WriteToLog(&b,1); }
+  void WriteBinaryString(const String& str); // пишет строку в виде "длина, символы"
+#endif
 #ifdef ADD_LOG_HEADER  
   void TryAddFileHeader();
 #endif  
 
   String csv(const String& input);
 
+#ifdef USE_LOG_ROLLUPS
+  RollupSlot rollups[LOG_ROLLUP_MAX_SENSORS];
+  uint8_t rollupsCount; // для скольких датчиков ведём сводки
+  uint16_t rollupsLayoutVersion; // версия раскладки состояний, при которой собирали датчики
+  bool rollupsInited;
+  DS3231Time rollupTime; // к какому часу и дню относятся накопленные показания
+  bool hasRollupTime;
+
+  void InitRollups(); // собираем датчики, по которым ведём сводки
+  void UpdateRollups(const DS3231Time& tm); // накапливаем показания, на смене часа и суток пишем сводки на карту
+  void WriteRollups(const DS3231Time& tm, bool daily); // дописывает сводки за час или сутки в файл и обнуляет их
+  static void AddRollupValue(RollupValue& rv, long value);
+#endif
+
+#ifdef USE_LOG_WRITE_BUFFER
+  uint8_t logBuffer[LOG_WRITE_BUFFER_SIZE]; // буфер записи в лог
+  uint16_t logBufferPos; // сколько байт накоплено в буфере
+  uint16_t logBufferLimit; // сколько байт копим, чтобы запись на карту закончилась ровно на границе сектора
+  unsigned long lastLogFlush; // сколько мс прошло с последнего слива буфера на карту
+#endif
+
+  void WriteToLog(const uint8_t* data, size_t len); // пишет данные в лог (через буфер, если он включен)
+  void WriteCsvToLog(const String& data); // пишет в лог данные, обрамляя их по правилам CSV
+  void FlushLog(); // сливает накопленные данные лога на карту
+
+#ifdef USE_LOG_INDEX
+  int16_t lastIndexedBucket; // для какого интервала уже записали смещение в индекс, -1 - ни для какого
+  void UpdateLogIndex(const DS3231Time& tm); // записывает в индекс смещение начала интервала, если он сменился
+  // ищет по индексу кусок лога со временем от fromMinutes до toMinutes (минут от начала суток), возвращает false, если индекса нет
+  bool GetRangeFromIndex(const String& indexFilePath, uint16_t fromMinutes, uint16_t toMinutes, uint32_t& offset, uint32_t& length);
+#endif
+
+  String syncFileName; // имя файла лога, для которого запомнили смещение синхронизации
+  uint32_t syncOffset; // до какого места клиент уже забрал файл лога
+
+  // отдаёт файл (или его кусок, если ranged == true) в поток команды, возвращает false, если файл не открылся
+  bool SendFile(const Command& command, const String& fullFilePath, uint32_t offset, uint32_t length, bool ranged);
+
   // HH:MM,MODULE_NAME,SENSOR_TYPE,SENSOR_IDX,SENSOR_DATA\r\n
-  void WriteLogLine(const String& hhmm, const String& moduleName, const String& sensorType, const String& sensorIdx, const String& sensorData);
+  void WriteLogLine(const String& hhmm, const String& moduleName, const String& sensorType, uint8_t sensorIdx, const String& sensorData);
   
   public:
     LogModule() : AbstractModule("LOG") {}
@@ -54,6 +54,10 @@
 #include "DeltaModule.h"
 #endif
 
+#ifdef USE_HISTORY_MODULE
+#include "HistoryModule.h"
+#endif
+
 #ifdef USE_LCD_MODULE
 #include "LCDModule.h"
 #endif
@@ -203,6 +207,11 @@ LogModule logModule;
 DeltaModule deltaModule;
 #endif
 
+#ifdef USE_HISTORY_MODULE
+// модуль истории показаний датчиков
+HistoryModule historyModule;
+#endif
+
 #ifdef USE_LCD_MODULE
 // модуль LCD
 LCDModule lcdModule;
@@ -255,10 +264,16 @@ TimerModule timerModule;
 #ifdef USE_WIFI_MODULE
 // модуль работы по Wi-Fi
 WiFiModule wifiModule;
+#ifndef WIFI_BYTE_PARSER
 String* wiFiReceiveBuff;
+#endif
 
 void WIFI_EVENT_FUNC()
 {
+#ifdef WIFI_BYTE_PARSER
+  while(WIFI_SERIAL.available())
+    wifiModule.ProcessIncomingByte(WIFI_SERIAL.read());
+#else
   char ch;
   while(WIFI_SERIAL.available())
   {
@@ -278,7 +293,7 @@ void WIFI_EVENT_FUNC()
           *wiFiReceiveBuff += NEWLINE; 
         }
           
-        wifiModule.ProcessAnswerLine(*wiFiReceiveBuff);
+        wifiModule.ProcessAnswerLine(wiFiReceiveBuff->c_str());
         //wiFiReceiveBuff = F("");
         delete wiFiReceiveBuff;
         wiFiReceiveBuff = new String();
@@ -288,7 +303,7 @@ void WIFI_EVENT_FUNC()
         if(wifiModule.WaitForDataWelcome && ch == '>') // ждут команду >
         {
           wifiModule.WaitForDataWelcome = false;
-          wifiModule.ProcessAnswerLine(F(">"));
+          wifiModule.ProcessAnswerLine(">");
         }
         else
           *wiFiReceiveBuff += ch;
@@ -296,7 +311,7 @@ void WIFI_EVENT_FUNC()
   
     
   } // while
-   
+#endif   
 }
 
 #endif
@@ -375,6 +390,10 @@ void setup()
   #ifdef USE_DELTA_MODULE
   controller.RegisterModule(&deltaModule);
   #endif
+
+  #ifdef USE_HISTORY_MODULE
+  controller.RegisterModule(&historyModule);
+  #endif
   
   #ifdef USE_LCD_MODULE
   controller.RegisterModule(&lcdModule);
@@ -419,7 +438,9 @@ void setup()
 
   // модуль Wi-Fi регистрируем до модуля SMS, поскольку Wi-Fi дешевле, чем GPRS, для отсыла данных в IoT-хранилища
   #ifdef USE_WIFI_MODULE
+  #ifndef WIFI_BYTE_PARSER
   wiFiReceiveBuff = new String();
+  #endif
   controller.RegisterModule(&wifiModule);
   #endif 
 
@@ -540,6 +561,10 @@ void loop()
     
     lastMillis = curMillis; // сохраняем последнее значение вызова millis()
 
+   #ifdef USE_LOOP_PROFILER
+     controller.ProfileLoop(); // считаем время между вызовами loop
+   #endif
+
 
    #ifdef USE_EXTERNAL_WATCHDOG
      updateExternalWatchdog();
@@ -590,7 +615,9 @@ void loop()
     } // if
     else
     {
-      // что-то пошло не так, игнорируем команду
+      // что-то пошло не так, игнорируем команду; если команду пришлось урезать - сообщаем об ошибке
+      if(cmd.IsTruncated())
+        controller.PublishParseError(cmd,commandsFromSerial.GetStream());
     } // else
     
     commandsFromSerial.ClearCommand(); // очищаем полученную команду
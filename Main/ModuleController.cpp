@@ -13,6 +13,12 @@ ModuleController::ModuleController() : cParser(NULL)
 #endif
 {
   reservationResolver = NULL;
+  
+#ifdef USE_LOOP_PROFILER
+  lastLoopMicros = 0;
+  loopProfile.Reset();
+#endif
+
   PublishSingleton.Text.reserve(SHARED_BUFFER_LENGTH); // 500 байт для ответа от модуля должно хватить.
 }
 #ifdef USE_DS3231_REALTIME_CLOCK
@@ -76,6 +82,25 @@ void ModuleController::RegisterModule(AbstractModule* mod)
   {
     mod->Setup(); // настраиваем
     modules.push_back(mod);
+
+    // вставляем индекс модуля в отсортированный по ID список, сдвигая хвост
+    ModuleHandle handle = modules.size() - 1;
+    sortedModules.push_back(handle);
+    
+    size_t wIdx = sortedModules.size() - 1;
+    while(wIdx > 0 && strcmp(modules[sortedModules[wIdx-1]]->GetID(),mod->GetID()) > 0)
+    {
+      sortedModules[wIdx] = sortedModules[wIdx-1];
+      wIdx--;
+    }
+    sortedModules[wIdx] = handle;
+
+#ifdef USE_LOOP_PROFILER
+    ModuleProfileInfo pi;
+    pi.Update.Reset();
+    pi.Exec.Reset();
+    profiles.push_back(pi);
+#endif
   }
 }
 
@@ -130,16 +155,45 @@ void ModuleController::Publish(AbstractModule* module,const Command& sourceComma
 }
 AbstractModule* ModuleController::GetModuleByID(const String& id)
 {
-  size_t sz = modules.size();
-  for(size_t i=0;i<sz;i++)
-  { 
-    AbstractModule* mod = modules[i];
-    if(!strcmp(mod->GetID(),id.c_str()) )
-      return mod;
-  } // for
-  return NULL;
+  return GetModuleByID(id.c_str());
+}
+AbstractModule* ModuleController::GetModuleByID(const char* id)
+{
+  return GetModuleByHandle(GetModuleHandle(id));
 }
+ModuleHandle ModuleController::GetModuleHandle(const char* id)
+{
+  // двоичный поиск по отсортированному списку модулей
+  size_t left = 0;
+  size_t right = sortedModules.size();
+  
+  while(left < right)
+  {
+    size_t mid = (left + right)/2;
+    ModuleHandle handle = sortedModules[mid];
+    int cmp = strcmp(modules[handle]->GetID(),id);
+
+    if(!cmp)
+      return handle;
 
+    if(cmp < 0)
+      left = mid + 1;
+    else
+      right = mid;
+  } // while
+  
+  return NO_MODULE_HANDLE;
+}
+
+void ModuleController::PublishParseError(Command& c, Stream* answerStream)
+{
+  // молча выполнить урезанную команду нельзя - сообщаем в тот поток, откуда пришел запрос
+  c.SetIncomingStream(answerStream);
+  PublishSingleton.AddModuleIDToAnswer = false;
+  PublishSingleton.Status = false;
+  PublishSingleton = COMMAND_TOO_LONG;
+  PublishToCommandStream(NULL,c);
+}
 void ModuleController::ProcessModuleCommand(const Command& c, AbstractModule* mod)
 {
 
@@ -148,7 +202,7 @@ void ModuleController::ProcessModuleCommand(const Command& c, AbstractModule* mo
 #endif  
 
 if(!mod) // ничего не передали, надо искать модуль
-  mod =  GetModuleByID(c.GetTargetModuleID());
+  mod =  GetModuleByID(c.GetTargetModuleIDPtr());
   
  if(!mod)
  {
@@ -171,7 +225,20 @@ CHECK_PUBLISH_CONSISTENCY;
 
  PublishSingleton.Reset(); // очищаем структуру для публикации
  PublishSingleton.Busy = true; // говорим, что структура занята для публикации
+
+#ifdef USE_LOOP_PROFILER
+ unsigned long startMicros = micros();
+#endif
+
  mod->ExecCommand(c,true);//c.GetIncomingStream() != NULL); // выполняем его команду
+
+#ifdef USE_LOOP_PROFILER
+ // информацию профилировщика ищем только после выполнения команды: команда могла зарегистрировать
+ // новый модуль (CTSET=0|ADD), и тогда вектор профилей переехал в другое место в куче
+ ModuleProfileInfo* pi = GetProfileOf(mod);
+ if(pi)
+  pi->Exec.Add(micros() - startMicros);
+#endif
  
 }
 
@@ -191,12 +258,53 @@ void ModuleController::UpdateModules(uint16_t dt, CallbackUpdateFunc func)
   { 
     AbstractModule* mod = modules[i];
    
+#ifdef USE_LOOP_PROFILER
+    unsigned long startMicros = micros();
+#endif
+
       // ОБНОВЛЯЕМ СОСТОЯНИЕ МОДУЛЕЙ
       mod->Update(dt);
 
+#ifdef USE_LOOP_PROFILER
+    profiles[i].Update.Add(micros() - startMicros);
+#endif
+
     if(func) // вызываем функцию после обновления каждого модуля
       func(mod);
   
   } // for
 }
 
+#ifdef USE_LOOP_PROFILER
+ModuleProfileInfo* ModuleController::GetProfileOf(AbstractModule* mod)
+{
+  size_t sz = modules.size();
+  for(size_t i=0;i<sz;i++)
+  {
+    if(modules[i] == mod)
+      return &(profiles[i]);
+  }
+  return NULL;
+}
+void ModuleController::ProfileLoop()
+{
+  unsigned long curMicros = micros();
+  
+  if(lastLoopMicros) // первый вызов не считаем
+    loopProfile.Add(curMicros - lastLoopMicros);
+    
+  lastLoopMicros = curMicros;
+}
+void ModuleController::ResetProfiler()
+{
+  loopProfile.Reset();
+  lastLoopMicros = 0;
+  
+  size_t sz = profiles.size();
+  for(size_t i=0;i<sz;i++)
+  {
+    profiles[i].Update.Reset();
+    profiles[i].Exec.Reset();
+  }
+}
+#endif // USE_LOOP_PROFILER
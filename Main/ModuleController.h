@@ -26,10 +26,67 @@ typedef Vector<AbstractModule*> ModulesVec;
 
 typedef void (*CallbackUpdateFunc)(AbstractModule* mod);
 
+#ifdef USE_LOOP_PROFILER
+// счётчик профилировщика - минимальное, среднее и максимальное время выполнения, в микросекундах
+struct ProfileCounter
+{
+  unsigned long Min; // минимальное время, мкс
+  unsigned long Max; // максимальное время, мкс
+  unsigned long Total; // суммарное время, мкс
+  unsigned long Calls; // кол-во замеров
+
+  void Reset()
+  {
+    Min = 0xFFFFFFFF;
+    Max = 0;
+    Total = 0;
+    Calls = 0;
+  }
+
+  void Add(unsigned long duration)
+  {
+    if(duration < Min)
+      Min = duration;
+
+    if(duration > Max)
+      Max = duration;
+
+    if(Total + duration < Total) // сумма переполнится - уполовиниваем накопленное, среднее при этом сохраняется
+    {
+      Total /= 2;
+      Calls /= 2;
+    }
+    
+    Total += duration;
+    Calls++;
+  }
+
+  unsigned long GetMin() const { return Calls ? Min : 0; }
+  unsigned long GetAvg() const { return Calls ? Total/Calls : 0; }
+};
+
+typedef struct
+{
+  ProfileCounter Update; // время вызова Update модуля
+  ProfileCounter Exec; // время вызова ExecCommand модуля
+  
+} ModuleProfileInfo; // информация профилировщика по одному модулю
+
+typedef Vector<ModuleProfileInfo> ProfilesVec;
+#endif // USE_LOOP_PROFILER
+
 class ModuleController
 {
  private:
   ModulesVec modules; // список зарегистрированных модулей
+  Vector<ModuleHandle> sortedModules; // индексы модулей, отсортированные по их ID, для двоичного поиска
+
+#ifdef USE_LOOP_PROFILER
+  ProfilesVec profiles; // информация профилировщика, по индексам - как в списке модулей
+  ProfileCounter loopProfile; // время между вызовами loop
+  unsigned long lastLoopMicros; // когда последний раз вызывался loop
+  ModuleProfileInfo* GetProfileOf(AbstractModule* mod); // возвращает информацию профилировщика для модуля
+#endif
   
   CommandParser* cParser; // парсер текстовых команд
 
@@ -91,9 +148,14 @@ public:
   size_t GetModulesCount() {return modules.size(); }
   AbstractModule* GetModule(size_t idx) {return modules[idx]; }
   AbstractModule* GetModuleByID(const String& id);
+  AbstractModule* GetModuleByID(const char* id);
+
+  ModuleHandle GetModuleHandle(const char* id); // возвращает короткий идентификатор модуля по его ID, или NO_MODULE_HANDLE
+  AbstractModule* GetModuleByHandle(ModuleHandle h) {return h < modules.size() ? modules[h] : NULL; }
 
   void RegisterModule(AbstractModule* mod);
   void ProcessModuleCommand(const Command& c, AbstractModule* thisModule=NULL);
+  void PublishParseError(Command& c, Stream* answerStream); // отвечает ошибкой на команду, которую не удалось разобрать целиком
   
   void UpdateModules(uint16_t dt, CallbackUpdateFunc func);
   
@@ -104,6 +166,13 @@ public:
   void SetCommandParser(CommandParser* c) {cParser = c;};
   CommandParser* GetCommandParser() {return cParser;}
 
+#ifdef USE_LOOP_PROFILER
+  void ProfileLoop(); // вызывается в начале каждого loop, считает время между вызовами
+  void ResetProfiler(); // сбрасывает все счётчики профилировщика
+  ProfileCounter& GetLoopProfile() {return loopProfile;}
+  ModuleProfileInfo& GetModuleProfile(size_t idx) {return profiles[idx];}
+#endif
+
   void Alarm(AlertRule* rule); // обработчик тревог
   #ifdef USE_ALARM_DISPATCHER
     AlarmDispatcher* GetAlarmDispatcher(){ return &alarmDispatcher;}
@@ -3,6 +3,11 @@
 
 Si7021::Si7021()
 {
+  state = si7021Idle;
+  measureStartedAt = 0;
+  measureTime = 0;
+  humidity = 0;
+  dt.IsOK = false;
 }
 
 void Si7021::begin()
@@ -50,24 +55,7 @@ const HumidityAnswer& Si7021::read()
   humidity = sensor.readHumidity();
   temperature = sensor.readTemperature();
 
-  if(((int)humidity) == HTU21D_ERROR || ((int)temperature) == HTU21D_ERROR)
-  {
-    dt.IsOK = false;
-  }
-  else
-  {
-     dt.IsOK = true;
-     
-    int iTmp = humidity*100;
-    
-    dt.Humidity = iTmp/100;
-    dt.HumidityDecimal = iTmp%100;
-    
-    iTmp = temperature*100;
-    
-    dt.Temperature = iTmp/100;
-    dt.TemperatureDecimal = iTmp%100;   
-  }
+  setAnswer(humidity,temperature);
 
  /* 
   uint16_t humidity = 0;
@@ -159,3 +147,92 @@ const HumidityAnswer& Si7021::read()
   
   return dt;
 }
+void Si7021::setAnswer(float humidity, float temperature)
+{
+  if(((int)humidity) == HTU21D_ERROR || ((int)temperature) == HTU21D_ERROR)
+  {
+    dt.IsOK = false;
+  }
+  else
+  {
+     dt.IsOK = true;
+     
+    int iTmp = humidity*100;
+    
+    dt.Humidity = iTmp/100;
+    dt.HumidityDecimal = iTmp%100;
+    
+    iTmp = temperature*100;
+    
+    dt.Temperature = iTmp/100;
+    dt.TemperatureDecimal = iTmp%100;   
+  }
+}
+bool Si7021::startMeasure()
+{
+  dt.IsOK = false;
+  
+  // измеряем в режиме No Hold: шина I2C свободна, пока датчик меряет, и её могут использовать другие устройства
+  if(!sensor.triggerMeasurement(HTU21D_TRIGGER_HUMD_MEASURE_NOHOLD))
+  {
+    state = si7021Idle;
+    return false;
+  }
+
+  state = si7021WaitHumidity;
+  measureTime = sensor.measurementTime(true);
+  measureStartedAt = millis();
+  
+  return true;
+}
+bool Si7021::finishMeasure()
+{
+  dt.IsOK = false;
+  state = si7021Idle;
+  return true;
+}
+bool Si7021::update()
+{
+  if(state == si7021Idle)
+    return false;
+
+  unsigned long elapsed = millis() - measureStartedAt;
+  if(elapsed < measureTime) // датчик ещё меряет, на шину не лезем
+    return false;
+
+  uint16_t raw;
+  HTU21D_measureStatus status = sensor.readMeasurement(raw);
+
+  if(status == HTU21D_MEASURE_NOT_READY)
+  {
+    // датчик медленнее, чем по даташиту - попробуем в следующий раз, если не вышло время
+    if(elapsed < SI7021_MEASURE_TIMEOUT)
+      return false;
+
+    return finishMeasure();
+  }
+
+  if(status != HTU21D_MEASURE_OK)
+    return finishMeasure();
+
+  if(state == si7021WaitHumidity)
+  {
+    // влажность есть, запускаем измерение температуры
+    humidity = HTU21D::rawToHumidity(raw);
+    
+    if(!sensor.triggerMeasurement(HTU21D_TRIGGER_TEMP_MEASURE_NOHOLD))
+      return finishMeasure();
+
+    state = si7021WaitTemperature;
+    measureTime = sensor.measurementTime(false);
+    measureStartedAt = millis();
+    
+    return false;
+  }
+
+  // температура есть - измерение закончено
+  state = si7021Idle;
+  setAnswer(humidity,HTU21D::rawToTemperature(raw));
+  
+  return true;
+}
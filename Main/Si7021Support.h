@@ -22,6 +22,16 @@ enum
 };
 */
 
+#define SI7021_MEASURE_TIMEOUT 150 // сколько мс ждём результата измерения, прежде чем считать датчик отвалившимся
+
+typedef enum
+{
+  si7021Idle, // ничего не измеряем
+  si7021WaitHumidity, // ждём окончания измерения влажности
+  si7021WaitTemperature // ждём окончания измерения температуры
+  
+} Si7021MeasureState;
+
 class Si7021
 {
   public:
@@ -29,12 +39,27 @@ class Si7021
     Si7021();    
     void begin();
     
-    const HumidityAnswer& read();
+    const HumidityAnswer& read(); // блокирующее чтение: ждёт окончания обоих измерений
+
+    // неблокирующее чтение: startMeasure запускает измерение и сразу возвращается,
+    // update надо дёргать периодически - он вернёт true, когда результат готов (см. getAnswer)
+    bool startMeasure();
+    bool update();
+    bool isBusy() { return state != si7021Idle; }
+    const HumidityAnswer& getAnswer() { return dt; }
     
   private:
     HumidityAnswer dt;
     HTU21D sensor;
 
+    Si7021MeasureState state;
+    unsigned long measureStartedAt; // когда (millis) запустили текущее измерение
+    uint8_t measureTime; // сколько мс длится текущее измерение
+    float humidity; // измеренная влажность, пока ждём температуру
+
+    void setAnswer(float humidity, float temperature);
+    bool finishMeasure(); // заканчивает измерение с ошибкой
+
   //  void setResolution();
   //  uint8_t read8(uint8_t reg);
     
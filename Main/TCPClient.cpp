@@ -1,15 +1,34 @@
 #include "TCPClient.h"
 #include "InteropStream.h"
+#ifdef WIFI_STREAM_RESPONSES
+#include <util/crc16.h>
+#endif
 
 // CLIENT IMPLEMENTATION
 #define TCP_WRITE_TO_FILE(dt) workFile.write((const uint8_t*) dt.c_str(), dt.length())
 
+#ifdef WIFI_STREAM_RESPONSES
+// команды, которые можно выполнять повторно для каждого пакета: без побочных эффектов (не читают SD, не дёргают yield),
+// ответ - одна строка, и зависит он только от настроек, а не от показаний датчиков и времени.
+// CTGET=0|STAT зависит от показаний, но при повторном выполнении берёт их из снимка, сделанного при первом (StatusSnapshot)
+const char _stream_LIST[] PROGMEM = "CTGET=0|LIST";
+const char _stream_STAT[] PROGMEM = "CTGET=0|STAT";
+const char _stream_RULE_VIEW[] PROGMEM = "CTGET=ALERT|RULE_VIEW";
+const char _stream_RSRV_VIEW[] PROGMEM = "CTGET=RSRV|VIEW";
+const char* const WIFI_STREAM_COMMANDS[] PROGMEM = {_stream_LIST, _stream_STAT, _stream_RULE_VIEW, _stream_RSRV_VIEW};
+#endif
+
 TCPClient::TCPClient()
 {
   state.isConnected = false;
   commandHolder = new String();//F("");
   cachedData = new String();
   state.hasFullCommand = false; 
+  state.lastWasCR = false;
+#ifdef WIFI_STREAM_RESPONSES
+  streamMode = tsmCache;
+  replayStream = NULL;
+#endif
   Clear();
 }
 TCPClient::~TCPClient()
@@ -18,6 +37,7 @@ TCPClient::~TCPClient()
 void TCPClient::SetConnected(bool c) 
 {
   state.isConnected = c;
+  state.lastWasCR = false; // новое соединение - перевод строки от прошлого не ждём
   
 }
 void TCPClient::Clear()
@@ -31,6 +51,16 @@ void TCPClient::Clear()
   //cachedData = F("");
   delete cachedData;
   cachedData = new String();
+
+#ifdef WIFI_STREAM_RESPONSES
+  state.replayResponse = false;
+  state.streamBroken = false;
+  uncachedLength = 0;
+  sentCrc = 0;
+  answerCrc = 0;
+  replayCommand = String();
+  statusSnapshot.Clear();
+#endif
 }
 void TCPClient::Update()
 {
@@ -53,12 +83,19 @@ void TCPClient::CommandRequested(int dataLen, const char* command)
   int ln = 0;
   while(ln < dataLen)
   {
-    if(*command == '\r') // если прямо в пакете нашли \r - значит, команда получена полностью, иначе - будем ждать следующего пакета
+    bool lastWasCR = state.lastWasCR;
+    uint8_t what = WiFiClassifyCommandByte(*command,lastWasCR);
+    state.lastWasCR = lastWasCR;
+
+    if(what == wcbEndOfCommand) // если прямо в пакете нашли перевод строки - значит, команда получена полностью, иначе - будем ждать следующего пакета
     {
       state.hasFullCommand = true; // выставляем флаг, что мы получили полную команду, и выходим
       break;
     }
-    *commandHolder += *command; // складываем байтики во внутренний буфер
+    
+    if(what == wcbAppend)
+      *commandHolder += *command; // складываем байтики во внутренний буфер
+      
     ln++;
     command++;
   }
@@ -95,12 +132,37 @@ bool TCPClient::Prepare(const char* command)
    Command cmd;
    if(cParser->ParseCommand(command, cmd))
    {
+     #ifdef WIFI_STREAM_RESPONSES
+     // команду из списка можно выполнить повторно, поэтому только считаем длину ответа, ничего не записывая на SD
+     if(cType == ctGET && CanReplay(command))
+     {
+      streamMode = tsmMeasure;
+      statusSnapshot.Record(); // запоминаем показания, из которых строится ответ
+      ActiveStatusSnapshot = &statusSnapshot;
+     }
+     #endif
      
      // команду разобрали, надо назначить поток вывода в неё
      cmd.SetIncomingStream(this);
      // и просим контроллер выполнить эту команду
      MainController->ProcessModuleCommand(cmd);
 
+     #ifdef WIFI_STREAM_RESPONSES
+     if(streamMode == tsmMeasure)
+     {
+        streamMode = tsmCache;
+        ActiveStatusSnapshot = NULL;
+        
+        if(uncachedLength > 0) // ответ не влез в кеш - хвост ответа будем получать повторным выполнением команды для каждого пакета
+        {
+          state.replayResponse = true;
+          replayCommand = command;
+        }
+        else
+          statusSnapshot.Clear(); // ответ целиком в кеше, снимок больше не нужен
+     } // if(streamMode == tsmMeasure)
+     #endif
+
      // в файл всё записано на этом этапе
    }
    else // не удалось распарсить, пишем в файл ошибку
@@ -124,6 +186,11 @@ bool TCPClient::Prepare(const char* command)
     // переходим на начало файла
     workFile.seek(0);
   }
+
+#ifdef WIFI_STREAM_RESPONSES
+  if(state.replayResponse) // длину хвоста ответа посчитали при первом выполнении команды
+    contentLength += uncachedLength;
+#endif
   
  // вычисляем кол-во пакетов, которые нам надо послать
  if(contentLength < MAX_PACKET_LENGTH)
@@ -195,12 +262,58 @@ size_t TCPClient::write(uint8_t toWr)
 {
  // чтение ответов от модулей с кешированием первых N байт
 
+#ifdef WIFI_STREAM_RESPONSES
+ if(streamMode == tsmReplay)
+ {
+    replayAnswerCrc = _crc16_update(replayAnswerCrc,toWr);
+    
+    if(replayPos < windowStart) // эту часть ответа уже отослали, считаем по ней CRC для сверки
+      replayCrc = _crc16_update(replayCrc,toWr);
+    else
+    if(replayPos < windowEnd && !state.streamBroken) // нужный кусок - сразу в поток
+    {
+      if(replayPos == windowStart && replayCrc != sentCrc) // начало ответа не совпало с тем, что уже отослали
+        state.streamBroken = true;
+
+      // ответ однострочный, перевод строки в нём - только в самом конце, а его мы придерживаем до сверки.
+      // перевод строки раньше - ответ стал короче, отдавать его нельзя: клиент примет обрезанный ответ за целый.
+      if(toWr == '\r' || toWr == '\n')
+        state.streamBroken = true;
+
+      if(!state.streamBroken)
+      {
+        replayStream->write(toWr);
+        sentCrc = _crc16_update(sentCrc,toWr);
+        replayWritten++;
+      }
+    }
+    
+    replayPos++;
+    return 1;
+ }
+
+ if(streamMode == tsmMeasure) // запоминаем CRC и конец ответа, чтобы сверять с ними ответ при повторном выполнении
+ {
+    answerCrc = _crc16_update(answerCrc,toWr);
+    memmove(answerEnd,answerEnd+1,TCP_ANSWER_END_LENGTH-1);
+    answerEnd[TCP_ANSWER_END_LENGTH-1] = toWr;
+ }
+#endif
+
  if(cachedData->length() < CACHE_LENGTH) // ещё можно писать в кеш
  {
   *cachedData += (char) toWr;
   return 1;
  }
 
+#ifdef WIFI_STREAM_RESPONSES
+ if(streamMode == tsmMeasure) // на SD не пишем, только считаем длину
+ {
+  uncachedLength++;
+  return 1;
+ }
+#endif
+
  OpenSDFile();
  
  if(workFile)
@@ -230,7 +343,7 @@ bool TCPClient::SendPacket(Stream* s)
        // длина оставшихся к отсылу данных больше, чем размер одного пакета.
        // поэтому можем отсылать пакет целиком, предварительно его сформировав.
      //  String str = cachedData.substring(0,nextPacketLength);
-       s->write(cachedData->c_str(),nextPacketLength); // пишем данные в поток
+       WriteCached(s,nextPacketLength); // пишем данные в поток
        *cachedData = cachedData->substring(nextPacketLength);
        
     }
@@ -240,18 +353,13 @@ bool TCPClient::SendPacket(Stream* s)
       // необходимое кол-во байт из данных.
       uint16_t dataLeft = nextPacketLength - cachedData->length();
 
-      s->write(cachedData->c_str(),cachedData->length()); // пишем данные в поток
+      WriteCached(s,cachedData->length()); // пишем данные в поток
       //cachedData = F("");
       delete cachedData;
       cachedData = new String();
 
      // тут вычитываем данные из файла, длиной dataLeft
-        if(workFile) // если файл открыт
-        {
-        // Блочное чтение из файла в нашем случае показало себя медленней, чем побайтовое (WTF???)            
-          for(uint16_t i=0;i<dataLeft;i++)
-            s->write(workFile.read()); // пишем данные в поток
-        }
+      WriteUncached(s,dataLeft);
 
     } // else
      
@@ -260,12 +368,7 @@ bool TCPClient::SendPacket(Stream* s)
   else
   {
     // уже только работа с файлом
-    if(workFile)
-    {
-      // у нас идёт работа только с данными, полученными с контроллера
-      for(uint16_t i=0;i<nextPacketLength;i++) // читаем данные из файла и выдаём их в поток
-        s->write(workFile.read());
-    }
+    WriteUncached(s,nextPacketLength);
   } // else
   
   
@@ -285,6 +388,109 @@ bool TCPClient::SendPacket(Stream* s)
   
   return (packetsLeft > 0); // если ещё есть пакеты - продолжаем отсылать
 }
+void TCPClient::WriteCached(Stream* s, uint16_t len)
+{
+  s->write(cachedData->c_str(),len);
+  
+#ifdef WIFI_STREAM_RESPONSES
+  const char* ptr = cachedData->c_str();
+  for(uint16_t i=0;i<len;i++)
+    sentCrc = _crc16_update(sentCrc,*ptr++);
+#endif
+}
+void TCPClient::WriteUncached(Stream* s, uint16_t len)
+{
+#ifdef WIFI_STREAM_RESPONSES
+  if(state.replayResponse)
+  {
+    Replay(s,len);
+    return;
+  }
+#endif
+  
+  if(workFile) // если файл открыт
+  {
+  // Блочное чтение из файла в нашем случае показало себя медленней, чем побайтовое (WTF???)            
+    for(uint16_t i=0;i<len;i++)
+      s->write(workFile.read()); // пишем данные в поток
+  }
+}
+#ifdef WIFI_STREAM_RESPONSES
+bool TCPClient::CanReplay(const char* command)
+{
+  for(uint8_t i=0;i<sizeof(WIFI_STREAM_COMMANDS)/sizeof(WIFI_STREAM_COMMANDS[0]);i++)
+  {
+    const char* streamCommand = (const char*) pgm_read_ptr(&(WIFI_STREAM_COMMANDS[i]));
+    size_t len = strlen_P(streamCommand);
+
+    // команда должна совпасть целиком, дальше - только аргументы
+    if(!strncmp_P(command,streamCommand,len) && (command[len] == '\0' || command[len] == '|'))
+      return true;
+  }
+
+  return false;
+}
+void TCPClient::Replay(Stream* s, uint16_t len)
+{
+  // конец ответа (перевод строки) модуль при повторном выполнении не отдаёт - его отдаём сами, когда сверим весь ответ
+  unsigned long replayEnd = contentLength - TCP_ANSWER_END_LENGTH;
+  
+  // в пакете сначала могли быть данные из кеша, отдаём то, что идёт сразу за ними
+  windowStart = sentContentLength + (nextPacketLength - len);
+  windowEnd = min(windowStart + len,replayEnd);
+  replayPos = 0;
+  replayCrc = 0;
+  replayAnswerCrc = 0;
+  replayWritten = 0;
+  replayStream = s;
+  streamMode = tsmReplay;
+  statusSnapshot.Replay(); // показания - те же, что и при первом выполнении
+  ActiveStatusSnapshot = &statusSnapshot;
+
+  Command cmd;
+  if(MainController->GetCommandParser()->ParseCommand(replayCommand.c_str(), cmd))
+  {
+    cmd.SetIncomingStream(this);
+    MainController->ProcessModuleCommand(cmd);
+  }
+
+  streamMode = tsmCache;
+  ActiveStatusSnapshot = NULL;
+
+  if(replayPos != contentLength || replayAnswerCrc != answerCrc) // ответ изменился между выполнениями команды
+    state.streamBroken = true;
+
+  uint16_t written = replayWritten;
+  
+  if(!state.streamBroken)
+  {
+    // весь ответ сошёлся с первым выполнением - можно отдавать его конец, если он попал в пакет
+    for(unsigned long pos = max(windowStart,replayEnd); pos < windowStart + len; pos++, written++)
+    {
+      uint8_t b = answerEnd[pos - replayEnd];
+      s->write(b);
+      sentCrc = _crc16_update(sentCrc,b);
+    }
+  }
+  else
+  {
+    // данные у клиента уже порченые - добиваем пакет ошибкой, этот пакет последний, дальше соединение закроется
+    WriteStreamBroken(s,len - written);
+    packetsLeft = 1;
+  }
+}
+void TCPClient::WriteStreamBroken(Stream* s, uint16_t len)
+{
+  // ESP ждёт ровно столько байт, сколько обещали. Перевода строки не пишем: клиент не получит конца строки ответа
+  // и после закрытия соединения поймёт, что ответ неполный, а не примет обрезанный ответ за целый.
+  String err = ERR_ANSWER;
+  err += COMMAND_DELIMITER;
+  err += STREAM_BROKEN;
+
+  for(uint16_t i=0;i<len;i++)
+    s->write(err[i % err.length()]);
+}
+#endif
 uint16_t TCPClient::GetPacketLength()
 {
   return nextPacketLength;
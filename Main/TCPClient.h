@@ -4,6 +4,8 @@
 #include "ModuleController.h"
 #include <SD.h>
 #include <Arduino.h>
+#include "WiFiByteParser.h"
+#include "ZeroStreamListener.h"
 
 // класс обработки запроса, посланного по TCP/IP на ESP8266. Подготавливает данные,
 // настраивает кол-во пакетов для отсылки, отсылает очередной пакет по приглашению.
@@ -17,15 +19,33 @@
 // не помещается в CACHE_LENGTH. Такие вот пляски.
 
 #define CACHE_LENGTH 256 // сколько байт кешировать в ответе
+#ifdef WIFI_STREAM_RESPONSES
+#define TCP_ANSWER_END_LENGTH 2 // сколько последних байт ответа (перевод строки) отдаём только после сверки всего ответа
+#endif
 
 typedef struct
 {
     bool isConnected : 1; // флаг, что клиент подсоединён
     bool hasFullCommand : 1; // флаг, что приняли всю команду
     uint8_t tcpClientID : 6; // ID клиента
+    bool lastWasCR : 1; // последний байт команды был \r - следующий за ним \n команду не начинает
+#ifdef WIFI_STREAM_RESPONSES
+    bool replayResponse : 1; // хвост ответа получаем повторным выполнением команды, а не из файла
+    bool streamBroken : 1; // при повторном выполнении команда выдала другой ответ, соединение надо закрыть
+#endif
   
 } TCPClientState;
 
+#ifdef WIFI_STREAM_RESPONSES
+typedef enum
+{
+  tsmCache, // пишем в кеш, не влезло - в файл на SD
+  tsmMeasure, // пишем в кеш, не влезло - только считаем длину
+  tsmReplay // повторное выполнение команды: отдаём в поток только нужный кусок ответа
+  
+} TCPStreamMode;
+#endif
+
 class TCPClient : public Stream
 {
   private:
@@ -43,6 +63,30 @@ class TCPClient : public Stream
     unsigned long sentContentLength; // какую общую длину уже отослали
 
     File workFile; // файл, в который мы будем складывать ответы от модулей
+
+#ifdef WIFI_STREAM_RESPONSES
+    TCPStreamMode streamMode; // куда сейчас пишутся данные, выдаваемые модулем
+    String replayCommand; // команда, которую выполняем повторно для каждого пакета
+    unsigned long uncachedLength; // сколько байт ответа не влезло в кеш
+    unsigned long replayPos; // сколько байт ответа выдал модуль при повторном выполнении
+    unsigned long windowStart; // с какого байта ответа отдаём данные при повторном выполнении
+    unsigned long windowEnd; // до какого байта ответа отдаём данные при повторном выполнении
+    uint16_t replayWritten; // сколько байт отдали в поток при повторном выполнении
+    uint16_t sentCrc; // CRC уже отосланной части ответа
+    uint16_t replayCrc; // CRC начала ответа при повторном выполнении, должна совпасть с sentCrc
+    uint16_t answerCrc; // CRC всего ответа при первом выполнении команды
+    uint16_t replayAnswerCrc; // CRC всего ответа при повторном выполнении, должна совпасть с answerCrc
+    uint8_t answerEnd[TCP_ANSWER_END_LENGTH]; // последние байты ответа при первом выполнении команды
+    Stream* replayStream; // куда отдаём кусок ответа при повторном выполнении
+    StatusSnapshot statusSnapshot; // показания датчиков для повторного выполнения CTGET=0|STAT
+
+    static bool CanReplay(const char* command); // есть ли команда в списке WIFI_STREAM_COMMANDS
+    void Replay(Stream* s, uint16_t len); // выполняет команду повторно и отдаёт в поток len байт ответа, следующих за уже отосланными
+    void WriteStreamBroken(Stream* s, uint16_t len); // забивает len байт пакета текстом ошибки, без перевода строки
+#endif
+
+    void WriteCached(Stream* s, uint16_t len); // отдаёт в поток len байт из кеша
+    void WriteUncached(Stream* s, uint16_t len); // отдаёт в поток len байт из файла или повторным выполнением команды
     
     String* cachedData; // данные, которые будем кешировать для отсыла
     String* commandHolder; // сюда складываем команду
@@ -71,6 +115,12 @@ class TCPClient : public Stream
 
     bool HasPacket() {return (packetsLeft > 0);} // есть ли ещё пакеты для отправки?
 
+#ifdef WIFI_STREAM_RESPONSES
+    bool IsStreamBroken() {return state.streamBroken;} // ответ при повторном выполнении команды изменился - клиент получил неполные данные
+#else
+    bool IsStreamBroken() {return false;}
+#endif
+
     // вызываем по приходу данных для клиента, концом команды считается \r\n. Клиент ничего не делает в этом методе,
     // поскольку посылка ответа может быть асинхронной. Данные подготавливаются в методе Update, который вызывается тогда,
     // когда входящие из порта данные уже обработаны. Если клиенту придёт новая команда до тех пор, пока не подготовлены
@@ -3,7 +3,7 @@
 
 TempSensors* WindowModule = NULL;
 
-#if SUPPORTED_SENSORS > 0
+#if SUPPORTED_SENSORS > 0 && !defined(USE_DS18B20_BUS)
 static TempSensorSettings TEMP_SENSORS[] = { TEMP_SENSORS_PINS };
 #endif
 
@@ -276,6 +276,15 @@ void TempSensors::Setup()
    #if SUPPORTED_SENSORS > 0
    tempData.Whole = 0;
    tempData.Fract = 0;
+   #ifdef USE_DS18B20_BUS
+   for(uint8_t i=0;i<SUPPORTED_SENSORS;i++)
+    State.AddState(StateTemperature,i);
+
+   // читаем адреса датчиков из EEPROM, ищем датчики на линии и сразу запускаем конвертацию, показания прочитаем по её окончании
+   tempBus.begin(DS18B20_BUS_PIN,SUPPORTED_SENSORS,DS18B20_BUS_EEPROM_ADDR);
+   tempBus.setResolution(temp12bit); // устанавливаем разрешение датчиков
+   tempBus.startConversion();
+   #else
    for(uint8_t i=0;i<SUPPORTED_SENSORS;i++)
    {
     State.AddState(StateTemperature,i);
@@ -286,6 +295,7 @@ void TempSensors::Setup()
     
     tempSensor.readTemperature(&tempData,(DSSensorType)TEMP_SENSORS[i].type);
    }
+   #endif // USE_DS18B20_BUS
    #endif
 
   
@@ -368,6 +378,12 @@ void TempSensors::Update(uint16_t dt)
  #endif 
 
 
+#if defined(USE_DS18B20_BUS) && SUPPORTED_SENSORS > 0
+  // конвертация идёт без нас - как только закончилась, читаем свежие показания
+  if(tempBus.isConversionDone())
+    ReadBusSensors();
+#endif
+
   lastUpdateCall += dt;
   if(lastUpdateCall < TEMP_UPDATE_INTERVAL) // обновляем согласно настроенному интервалу
     return;
@@ -376,6 +392,14 @@ void TempSensors::Update(uint16_t dt)
 
   // опрашиваем наши датчики
   #if SUPPORTED_SENSORS > 0
+  #ifdef USE_DS18B20_BUS
+  // какой-то датчик не ответил или есть свободные индексы - смотрим, кто сейчас висит на линии
+  if(tempBus.isSearchNeeded(DS18B20_BUS_SEARCH_INTERVAL) && tempBus.search())
+    tempBus.setResolution(temp12bit); // новым датчикам - то же разрешение
+
+  if(!tempBus.startConversion()) // на линии никого нет - выставляем всем датчикам "нет данных"
+    ReadBusSensors();
+  #else
   Temperature t;
   for(uint8_t i=0;i<SUPPORTED_SENSORS;i++)
   {
@@ -395,12 +419,40 @@ void TempSensors::Update(uint16_t dt)
     }
     State.UpdateState(StateTemperature,i,(void*)&t); // обновляем состояние температуры, индексы датчиков у нас идут без дырок, поэтому с итератором цикла вызывать можно
   } // for
+  #endif // USE_DS18B20_BUS
   #endif
 
-  smallSensorsChange = 0;
+  #ifndef USE_DS18B20_BUS
+  smallSensorsChange = 0; // в режиме одной линии сбрасывается после чтения показаний
+  #endif
 
 
 }
+#if defined(USE_DS18B20_BUS) && SUPPORTED_SENSORS > 0
+void TempSensors::ReadBusSensors()
+{
+  Temperature t;
+  for(uint8_t i=0;i<SUPPORTED_SENSORS;i++)
+  {
+    t.Value = NO_TEMPERATURE_DATA;
+    t.Fract = 0;
+
+    // за индексом может ещё не быть датчика или датчик пропал с линии - тогда показаний нет
+    if(tempBus.readTemperature(i,&tempData))
+    {
+      t.Value = tempData.Whole;
+    
+      if(tempData.Negative)
+        t.Value = -t.Value;
+
+      t.Fract = tempData.Fract + smallSensorsChange;
+    }
+    State.UpdateState(StateTemperature,i,(void*)&t);
+  } // for
+
+  smallSensorsChange = 0;
+}
+#endif
 bool  TempSensors::ExecCommand(const Command& command, bool wantAnswer)
 {
   GlobalSettings* sett = MainController->GetSettings();
@@ -110,7 +110,12 @@ class TempSensors : public AbstractModule // модуль опроса темп
     BlinkModeInterop blinker;
 #endif    
 
+    #ifdef USE_DS18B20_BUS
+    DS18B20Bus tempBus; // все датчики на одной линии
+    void ReadBusSensors(); // читает показания со всех датчиков на линии после окончания конвертации
+    #else
     DS18B20Support tempSensor;
+    #endif
     DS18B20Temperature tempData;
     
   public:
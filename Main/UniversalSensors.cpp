@@ -19,6 +19,11 @@ UniRS485Gate::UniRS485Gate()
 #ifdef USE_UNI_EXECUTION_MODULE  
   updateTimer = 0;
 #endif  
+
+  busState = RS485BusIdle;
+  waitForAnswer = false;
+  bytesReaded = 0;
+  lastByteTime = 0;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
 #ifdef USE_UNIVERSAL_SENSORS
@@ -68,52 +73,513 @@ void UniRS485Gate::Setup()
   
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
-byte UniRS485Gate::crc8(const byte *addr, byte len)
+void UniRS485Gate::transmitComplete()
+{
+  // пакет ушёл в шину целиком - если ждём ответа, сразу переключаемся на приём, чтобы не потерять его первые байты
+  if(waitForAnswer)
+    enableReceive();
+
+  lastByteTime = micros();
+  busState = waitForAnswer ? RS485BusReceive : RS485BusIdle;
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+ISR(RS_485_TX_vect)
+{
+  // пока HardwareSerial досылает байты из своего буфера - передача не закончена,
+  // флаг TXC между байтами может выставиться, если прерывания были надолго запрещены
+  if(RS_485_UCSRB & _BV(RS_485_UDRIE))
+    return;
+
+  RS_485_UCSRB &= ~_BV(RS_485_TXCIE); // прерывание нужно только на один пакет
+  RS485.transmitComplete();
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniRS485Gate::sendPacket(bool wantAnswer)
+{
+  UniFramePacket(packet); // заголовок, окончание и контрольная сумма
+
+  waitForAnswer = wantAnswer;
+  busState = RS485BusTransmit;
+
+  // пакет целиком ложится в буфер HardwareSerial, поэтому запись не блокирует.
+  // Об окончании передачи узнаем по прерыванию TXC - его флаг HardwareSerial сбрасывает при каждой записи в порт
+  RS_485_SERIAL.write((const uint8_t *)&packet,sizeof(RS485Packet));
+  RS_485_UCSRB |= _BV(RS_485_TXCIE);
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniRS485Gate::processBus()
+{
+  if(busState != RS485BusReceive) // шина свободна или передача ещё идёт - окончание передачи отловит прерывание
+    return;
+
+  // забираем всё, что успело прийти с прошлого вызова
+  byte* writePtr = (byte*) &packet;
+  while(bytesReaded < sizeof(RS485Packet) && RS_485_SERIAL.available())
+  {
+    writePtr[bytesReaded++] = (byte) RS_485_SERIAL.read();
+    lastByteTime = micros(); // сбрасываем таймаут
+  }
+
+  bool received = (bytesReaded == sizeof(RS485Packet));
+  
+  if(!received)
+  {
+    // вычисляем таймаут как время для чтения RS485_BYTES_TIMEOUT байт.
+    // в RS485_SPEED - у нас скорость в битах в секунду, на один байт уходит 10 бит.
+    const unsigned long readTimeout  = (10000000ul/RS485_SPEED)*RS485_BYTES_TIMEOUT;
+    
+    if(micros() - lastByteTime <= readTimeout) // ответ ещё может прийти - ждём в следующих вызовах
+      return;
+
+    #ifdef RS485_DEBUG
+      Serial.println(F("TIMEOUT REACHED!!!"));
+    #endif
+  }
+  #ifdef RS485_DEBUG
+  else
+    Serial.println(F("Packet received from slave!"));
+  #endif
+
+  // обмен закончен, опять переключаемся на передачу
+  enableSend();
+  busState = RS485BusIdle;
+
+  #ifdef USE_UNIVERSAL_SENSORS
+  if(received)
+    processSensorAnswer();
+  #ifdef RS485_DEBUG
+  else
+    Serial.println(F("Received uncompleted packet :("));
+  #endif
+  #endif // USE_UNIVERSAL_SENSORS
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+#ifdef USE_UNIVERSAL_SENSORS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniRS485Gate::advanceQueue()
+{
+  currentQueuePos++;
+
+  if(currentQueuePos >= queue.size()) // достигли конца очереди, начинаем сначала
+  {
+    currentQueuePos = 0;
+    
+    #ifdef RS485_BATCH_POLL
+    // начинается новый проход - опрашивать опять надо всех
+    for(size_t i=0;i<queue.size();i++)
+      queue[i].polled = false;
+    #endif
+  }
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniRS485Gate::requestSensorData()
 {
-  byte crc = 0;
-  while (len--) 
+#ifdef RS485_BATCH_POLL
+  // пропускаем датчики, показания с которых уже пришли в этом проходе очереди вместе с другими датчиками того же модуля.
+  // В конце очереди отметки сбрасываются, поэтому цикл конечен
+  while(queue[currentQueuePos].polled)
+    advanceQueue();
+#endif
+  
+  currentItem = queue[currentQueuePos];
+  advanceQueue();
+
+  // мы не можем обновлять состояние датчика в дефолтные значения здесь, поскольку
+  // мы не знаем, откуда с него могут придти данные. В случае с работой через 1-Wire
+  // состояние автоматически обновляется, поскольку считается, что если модуль есть
+  // на линии - с него будут данные. У нас же ситуация обстоит по-другому:
+  // мы проходим все зарегистрированные универсальные датчики, и не можем
+  // делать вывод - висит ли модуль с датчиком на линии RS-485, или работает по радиоканалу,
+  // или - работает по 1-Wire. Поэтому мы не вправе делать никаких предположений и менять
+  // показания датчика на вид <нет данных>, поскольку очерёдность вызовов опроса
+  // универсальных модулей по разным шлюзам не определена. 
+  // поэтому мы сбрасываем состояния только тех датчиков, которые хотя бы однажды
+  // откликнулись по шине RS-495.
+
+  if(isInOnlineQueue(currentItem))
+  {
+    byte sType = currentItem.sensorType;
+    byte sIndex = currentItem.sensorIndex;
+    // датчик был онлайн, сбрасываем его показания в "нет данных" перед опросом
+    UniDispatcher.AddUniSensor((UniSensorType)sType,sIndex);
+
+    // проверяем тип датчика, которому надо выставить "нет данных"
+    switch(currentItem.sensorType)
     {
-    byte inbyte = *addr++;
-    for (byte i = 8; i; i--)
+      case uniTemp:
+      {
+        // температура
+        Temperature t;
+        // получаем состояния
+        UniSensorState states;
+        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+        {
+          if(states.State1)
+            states.State1->Update(&t);
+        } // if
+      }
+      break;
+
+      case uniHumidity:
+      {
+        // влажность
+        Humidity h;
+        // получаем состояния
+        UniSensorState states;
+        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+        {
+          if(states.State1)
+            states.State1->Update(&h);
+                              
+          if(states.State2)
+            states.State2->Update(&h);
+        } // if                        
+      }
+      break;
+
+      case uniLuminosity:
+      {
+        // освещённость
+        long lum = NO_LUMINOSITY_DATA;
+        // получаем состояния
+        UniSensorState states;
+        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+        {
+          if(states.State1)
+            states.State1->Update(&lum);
+        } // if                        
+        
+        
+      }
+      break;
+
+      case uniSoilMoisture: // влажность почвы
+      case uniPH: // показания pH
       {
-      byte mix = (crc ^ inbyte) & 0x01;
-      crc >>= 1;
-      if (mix) 
-        crc ^= 0x8C;
-      inbyte >>= 1;
-      }  // end of for
-    }  // end of while
-  return crc;  
+        
+        Humidity h;
+        // получаем состояния
+        UniSensorState states;
+        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+        {
+          if(states.State1)
+            states.State1->Update(&h);
+        } // if                        
+        
+      }
+      break;
+      
+    } // switch
+    
+  } // if in online queue
+
+  memset(&packet,0,sizeof(RS485Packet)); 
+
+  packet.direction = RS485FromMaster; // направление - от нас ведомым
+  #ifdef RS485_BATCH_POLL
+  packet.type = RS485AllSensorsDataPacket; // это пакет - запрос на показания всех датчиков модуля, на котором висит датчик
+  #else
+  packet.type = RS485SensorDataPacket; // это пакет - запрос на показания с датчиков
+  #endif
+
+  byte* dest = packet.data;
+  // в первом байте - тип датчика для опроса
+  *dest = currentItem.sensorType;
+  dest++;
+  // во втором байте - индекс датчика, зарегистрированный в системе
+  *dest = currentItem.sensorIndex;
+
+  #ifdef RS485_DEBUG
+
+  // отладочная информация
+  Serial.print(F("Request data for sensor type="));
+  Serial.print(currentItem.sensorType);
+  Serial.print(F(" and index="));
+  Serial.println(currentItem.sensorIndex);
+
+  #endif
+
+  // пакет готов к отправке, отправляем его и сразу готовимся к приёму ответа
+  bytesReaded = 0;
+  sendPacket(true);
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
-void UniRS485Gate::waitTransmitComplete()
+void UniRS485Gate::applySensorData(const RS485QueueItem& item, const byte* readDataPtr)
 {
-  // ждём завершения передачи по UART
-  while(!(RS_485_UCSR & _BV(RS_485_TXC) ));
+  byte sType = item.sensorType;
+  byte sIndex = item.sensorIndex;
+
+  // добавляем наш тип сенсора в систему, если этого ещё не сделано
+  UniDispatcher.AddUniSensor((UniSensorType)sType,sIndex);
+
+  // добавляем датчик в список онлайн-датчиков
+  if(!isInOnlineQueue(item))
+    sensorsOnlineQueue.push_back(item);
+
+  // проверяем тип датчика, с которого читали показания
+  switch(sType)
+  {
+    case uniTemp:
+    {
+      // температура
+      // получаем данные температуры
+      Temperature t;
+      t.Value = (int8_t) *readDataPtr++;
+      t.Fract = *readDataPtr;
+
+      #ifdef RS485_DEBUG
+        Serial.print(F("Temperature: "));
+        Serial.println(t);
+      #endif
+
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+      {
+        if(states.State1)
+        {
+          #ifdef RS485_DEBUG
+            Serial.println(F("Update data in controller..."));
+          #endif
+          
+          states.State1->Update(&t);
+        }
+      } // if
+    }
+    break;
+
+    case uniHumidity:
+    {
+      // влажность
+      Humidity h;
+      h.Value = (int8_t) *readDataPtr++;
+      h.Fract = *readDataPtr++;
+
+      // температура
+      Temperature t;
+      t.Value = (int8_t) *readDataPtr++;
+      t.Fract = *readDataPtr++;
+
+      #ifdef RS485_DEBUG
+        Serial.print(F("Humidity: "));
+        Serial.println(h);
+      #endif
+
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+      {
+          #ifdef RS485_DEBUG
+            Serial.println(F("Update data in controller..."));
+          #endif
+
+        if(states.State1)
+          states.State1->Update(&t);
+
+        if(states.State2)
+          states.State2->Update(&h);
+          
+      } // if                        
+    }
+    break;
+
+    case uniLuminosity:
+    {
+      // освещённость
+      long lum;
+      memcpy(&lum,readDataPtr,sizeof(long));
+
+      #ifdef RS485_DEBUG
+        Serial.print(F("Luminosity: "));
+        Serial.println(lum);
+      #endif
+
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+      {
+        if(states.State1)
+        {
+          #ifdef RS485_DEBUG
+            Serial.println(F("Update data in controller..."));
+          #endif
+          
+          states.State1->Update(&lum);
+        }
+      } // if                        
+      
+      
+    }
+    break;
+
+    case uniSoilMoisture: // влажность почвы
+    case uniPH:  // показания pH
+    {
+      
+      Humidity h;
+      h.Value = (int8_t) *readDataPtr++;
+      h.Fract = *readDataPtr;
+
+      #ifdef RS485_DEBUG
+        if(sType == uniSoilMoisture)
+          Serial.print(F("Soil moisture: "));
+        else
+          Serial.print(F("pH: "));
+          
+        Serial.println(h);
+      #endif
+
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
+      {
+        if(states.State1)
+        {
+          #ifdef RS485_DEBUG
+            Serial.println(F("Update data in controller..."));
+          #endif
+          
+          states.State1->Update(&h);
+        }
+      } // if                        
+      
+    }
+    break;
+    
+  } // switch
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
-void UniRS485Gate::Update(uint16_t dt)
+void UniRS485Gate::processSensorAnswer()
 {
+  // пакет получен полностью, парсим его
+  #ifdef RS485_DEBUG
+    Serial.println(F("Packet from slave received, parse it..."));
+  #endif
+  
+  if(UniHasPacketHeader(packet) && UniHasPacketTail(packet))
+  {
+    #ifdef RS485_DEBUG
+      Serial.println(F("Header and tail ok."));
+    #endif
+    
+    // проверяем crc
+    if(UniIsCrcValid(packet))
+    {
+      #ifdef RS485_DEBUG
+        Serial.println(F("Checksum ok."));
+      #endif
+      
+      // теперь проверяем, нам ли пакет
+      if(packet.direction == RS485FromSlave && packet.type == RS485SensorDataPacket)
+      {
+        #ifdef RS485_DEBUG
+          Serial.println(F("Packet type ok"));
+        #endif
+
+        byte* readDataPtr = packet.data;
+        // проверяем - байт типа и байт индекса должны совпадать с посланными в шину
+        byte sType = *readDataPtr++;
+        byte sIndex = *readDataPtr++;
+        
+        if(sType == currentItem.sensorType && sIndex == currentItem.sensorIndex)
+        {
+          #ifdef RS485_DEBUG
+            Serial.println(F("Reading sensor data..."));
+          #endif
+
+          applySensorData(currentItem,readDataPtr);
+        }
+        #ifdef RS485_DEBUG
+        else
+        {
+          Serial.println(F("Received data from unknown sensor :("));
+        }
+        #endif
+      }
+      #ifdef RS485_BATCH_POLL
+      else
+      if(packet.direction == RS485FromSlave && packet.type == RS485AllSensorsDataPacket)
+      {
+        // модуль прислал показания всех своих датчиков: в первом байте - их кол-во, дальше - записи RS485SensorData
+        byte cnt = packet.data[0];
+        if(cnt > RS485_MAX_BATCH_SENSORS)
+          cnt = RS485_MAX_BATCH_SENSORS;
+
+        const RS485SensorData* entries = (const RS485SensorData*) &(packet.data[1]);
+
+        // ответ должен быть именно на наш запрос - среди датчиков модуля должен быть запрошенный
+        bool answerOk = false;
+        for(byte i=0;i<cnt;i++)
+        {
+          if(entries[i].sensorType == currentItem.sensorType && entries[i].sensorIndex == currentItem.sensorIndex)
+          {
+            answerOk = true;
+            break;
+          }
+        } // for
 
-  static RS485Packet packet;
+        for(byte i=0;answerOk && i<cnt;i++)
+        {
+          // обновляем только зарегистрированные в системе датчики, и отмечаем, что в этом проходе очереди их больше опрашивать не надо
+          for(size_t k=0;k<queue.size();k++)
+          {
+            if(queue[k].sensorType == entries[i].sensorType && queue[k].sensorIndex == entries[i].sensorIndex)
+            {
+              queue[k].polled = true;
+              applySensorData(queue[k],entries[i].data);
+              break;
+            }
+          } // for
+        } // for
+
+        #ifdef RS485_DEBUG
+        if(!answerOk)
+          Serial.println(F("Received data from unknown module :("));
+        #endif
+      }
+      #endif // RS485_BATCH_POLL
+      #ifdef RS485_DEBUG
+      else
+      {
+        Serial.println(F("Wrong packet type :("));
+      }
+      #endif
+    }
+    #ifdef RS485_DEBUG
+    else
+    {
+      Serial.println(F("Bad checksum :("));
+    }
+    #endif
+  }
+  #ifdef RS485_DEBUG
+  else
+  {
+    Serial.println(F("Head or tail of packet is invalid :("));
+  } // else
+  #endif
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+#endif // USE_UNIVERSAL_SENSORS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniRS485Gate::Update(uint16_t dt)
+{
+  // сперва продвигаем текущий обмен по шине: пока он не закончен - новых пакетов не шлём,
+  // а таймеры продолжают тикать, и отложенный пакет уйдёт сразу, как освободится шина
+  processBus();
   
   #ifdef USE_UNI_EXECUTION_MODULE
 
   // посылаем в шину данные для исполнительных модулей
   
     updateTimer += dt;
-    if(updateTimer > RS495_STATE_PUSH_FREQUENCY)
+    if(updateTimer > RS495_STATE_PUSH_FREQUENCY && busState == RS485BusIdle)
     {
       updateTimer = 0;
 
       // тут посылаем слепок состояния контроллера
         memset(&packet,0,sizeof(RS485Packet));
         
-        packet.header1 = 0xAB;
-        packet.header2 = 0xBA;
-        packet.tail1 = 0xDE;
-        packet.tail2 = 0xAD;
-
         packet.direction = RS485FromMaster;
         packet.type = RS485ControllerStatePacket;
 
@@ -122,14 +588,8 @@ void UniRS485Gate::Update(uint16_t dt)
         void* src = &curState;
         memcpy(dest,src,sizeof(ControllerState));
 
-        const byte* b = (const byte*) &packet;
-        packet.crc8 = crc8(b,sizeof(RS485Packet)-1);
-
-        // пишем в шину RS-495 слепок состояния контроллера
-        RS_485_SERIAL.write((const uint8_t *)&packet,sizeof(RS485Packet));
-
-        // теперь ждём завершения передачи
-        waitTransmitComplete();
+        // пишем в шину RS-495 слепок состояния контроллера, ответа на него не будет
+        sendPacket(false);
         
     }
   #endif // USE_UNI_EXECUTION_MODULE
@@ -151,6 +611,9 @@ void UniRS485Gate::Update(uint16_t dt)
             RS485QueueItem qi;
             qi.sensorType = sensorType;
             qi.sensorIndex = k;
+            #ifdef RS485_BATCH_POLL
+            qi.polled = false;
+            #endif
             queue.push_back(qi);
           } // for
           
@@ -163,411 +626,15 @@ void UniRS485Gate::Update(uint16_t dt)
   
 
     sensorsTimer += dt;
-    if(sensorsTimer > RS485_ONE_SENSOR_UPDATE_INTERVAL)
+    if(sensorsTimer > RS485_ONE_SENSOR_UPDATE_INTERVAL && busState == RS485BusIdle)
     {
       sensorsTimer = 0;
 
       // настало время опроса датчиков на шине
       if(queue.size())
       {
-        // есть очередь для опроса
-        RS485QueueItem* qi = &(queue[currentQueuePos]);
-        currentQueuePos++;
-
-        // мы не можем обновлять состояние датчика в дефолтные значения здесь, поскольку
-        // мы не знаем, откуда с него могут придти данные. В случае с работой через 1-Wire
-        // состояние автоматически обновляется, поскольку считается, что если модуль есть
-        // на линии - с него будут данные. У нас же ситуация обстоит по-другому:
-        // мы проходим все зарегистрированные универсальные датчики, и не можем
-        // делать вывод - висит ли модуль с датчиком на линии RS-485, или работает по радиоканалу,
-        // или - работает по 1-Wire. Поэтому мы не вправе делать никаких предположений и менять
-        // показания датчика на вид <нет данных>, поскольку очерёдность вызовов опроса
-        // универсальных модулей по разным шлюзам не определена. 
-        // поэтому мы сбрасываем состояния только тех датчиков, которые хотя бы однажды
-        // откликнулись по шине RS-495.
-
-        if(isInOnlineQueue(*qi))
-        {
-          byte sType = qi->sensorType;
-          byte sIndex = qi->sensorIndex;
-          // датчик был онлайн, сбрасываем его показания в "нет данных" перед опросом
-          UniDispatcher.AddUniSensor((UniSensorType)sType,sIndex);
-
-                    // проверяем тип датчика, которому надо выставить "нет данных"
-                    switch(qi->sensorType)
-                    {
-                      case uniTemp:
-                      {
-                        // температура
-                        Temperature t;
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                            states.State1->Update(&t);
-                        } // if
-                      }
-                      break;
-
-                      case uniHumidity:
-                      {
-                        // влажность
-                        Humidity h;
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                            states.State1->Update(&h);
-                                              
-                          if(states.State2)
-                            states.State2->Update(&h);
-                        } // if                        
-                      }
-                      break;
-
-                      case uniLuminosity:
-                      {
-                        // освещённость
-                        long lum = NO_LUMINOSITY_DATA;
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                            states.State1->Update(&lum);
-                        } // if                        
-                        
-                        
-                      }
-                      break;
-
-                      case uniSoilMoisture: // влажность почвы
-                      case uniPH: // показания pH
-                      {
-                        
-                        Humidity h;
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                            states.State1->Update(&h);
-                        } // if                        
-                        
-                      }
-                      break;
-                      
-                    } // switch
-          
-        } // if in online queue
-        
-        
-        if(currentQueuePos >= queue.size()) // достигли конца очереди, начинаем сначала
-          currentQueuePos = 0;
-
-
-        memset(&packet,0,sizeof(RS485Packet)); 
-        packet.header1 = 0xAB;
-        packet.header2 = 0xBA;
-        packet.tail1 = 0xDE;
-        packet.tail2 = 0xAD;
-
-        packet.direction = RS485FromMaster; // направление - от нас ведомым
-        packet.type = RS485SensorDataPacket; // это пакет - запрос на показания с датчиков
-
-        byte* dest = packet.data;
-        // в первом байте - тип датчика для опроса
-        *dest = qi->sensorType;
-        dest++;
-        // во втором байте - индекс датчика, зарегистрированный в системе
-        *dest = qi->sensorIndex;
-
-        // считаем контрольную сумму
-        const byte* b = (const byte*) &packet;
-        packet.crc8 = crc8(b,sizeof(RS485Packet)-1);
-
-
-        #ifdef RS485_DEBUG
-
-        // отладочная информация
-        Serial.print(F("Request data for sensor type="));
-        Serial.print(qi->sensorType);
-        Serial.print(F(" and index="));
-        Serial.println(qi->sensorIndex);
-
-        #endif
-
-        // пакет готов к отправке, отправляем его
-        RS_485_SERIAL.write((const uint8_t *)&packet,sizeof(RS485Packet));
-        waitTransmitComplete(); // ждём окончания посыла
-        // теперь переключаемся на приём
-        enableReceive();
-
-        // поскольку мы сразу же переключились на приём - можем дать поработать критичному ко времени коду
-        yield();
-
-        // и получаем наши байты
-        memset(&packet,0,sizeof(RS485Packet));
-        byte* writePtr = (byte*) &packet;
-        byte bytesReaded = 0; // кол-во прочитанных байт
-        // запоминаем время начала чтения
-        unsigned long startReadingTime = micros();
-        // вычисляем таймаут как время для чтения десяти байт.
-        // в RS485_SPEED - у нас скорость в битах в секунду. Для чтения десяти байт надо вычитать 100 бит.
-        const unsigned long readTimeout  = (10000000ul/RS485_SPEED)*RS485_BYTES_TIMEOUT; // кол-во микросекунд, необходимое для вычитки десяти байт
-
-        // начинаем читать данные
-        while(1)
-        {
-          if( micros() - startReadingTime > readTimeout)
-          {
-            #ifdef RS485_DEBUG
-              Serial.println(F("TIMEOUT REACHED!!!"));
-            #endif
-            
-            break;
-          } // if
-
-          if(RS_485_SERIAL.available())
-          {
-            startReadingTime = micros(); // сбрасываем таймаут
-            *writePtr++ = (byte) RS_485_SERIAL.read();
-            bytesReaded++;
-          } // if available
-
-          if(bytesReaded == sizeof(RS485Packet)) // прочитали весь пакет
-          {
-            #ifdef RS485_DEBUG
-              Serial.println(F("Packet received from slave!"));
-            #endif
-            
-            break;
-          }
-          
-        } // while
-
-        // затем опять переключаемся на передачу
-        enableSend();
-
-        // теперь парсим пакет
-        if(bytesReaded == sizeof(RS485Packet))
-        {
-          // пакет получен полностью, парсим его
-          #ifdef RS485_DEBUG
-            Serial.println(F("Packet from slave received, parse it..."));
-          #endif
-          
-          bool headOk = packet.header1 == 0xAB && packet.header2 == 0xBA;
-          bool tailOk = packet.tail1 == 0xDE && packet.tail2 == 0xAD;
-          if(headOk && tailOk)
-          {
-            #ifdef RS485_DEBUG
-              Serial.println(F("Header and tail ok."));
-            #endif
-            
-            // вычисляем crc
-            byte crc = crc8((const byte*)&packet,sizeof(RS485Packet)-1);
-            if(crc == packet.crc8)
-            {
-              #ifdef RS485_DEBUG
-                Serial.println(F("Checksum ok."));
-              #endif
-              
-              // теперь проверяем, нам ли пакет
-              if(packet.direction == RS485FromSlave && packet.type == RS485SensorDataPacket)
-              {
-                #ifdef RS485_DEBUG
-                  Serial.println(F("Packet type ok"));
-                #endif
-
-                byte* readDataPtr = packet.data;
-                // проверяем - байт типа и байт индекса должны совпадать с посланными в шину
-                byte sType = *readDataPtr++;
-                byte sIndex = *readDataPtr++;
-                
-                if(sType == qi->sensorType && sIndex == qi->sensorIndex)
-                {
-                  #ifdef RS485_DEBUG
-                    Serial.println(F("Reading sensor data..."));
-                  #endif
-
-                  // добавляем наш тип сенсора в систему, если этого ещё не сделано
-                  UniDispatcher.AddUniSensor((UniSensorType)sType,sIndex);
-
-                  // добавляем датчик в список онлайн-датчиков
-                  if(!isInOnlineQueue(*qi))
-                    sensorsOnlineQueue.push_back(*qi);
-
-                    // проверяем тип датчика, с которого читали показания
-                    switch(sType)
-                    {
-                      case uniTemp:
-                      {
-                        // температура
-                        // получаем данные температуры
-                        Temperature t;
-                        t.Value = (int8_t) *readDataPtr++;
-                        t.Fract = *readDataPtr;
-
-                        #ifdef RS485_DEBUG
-                          Serial.print(F("Temperature: "));
-                          Serial.println(t);
-                        #endif
-
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                          {
-                            #ifdef RS485_DEBUG
-                              Serial.println(F("Update data in controller..."));
-                            #endif
-                            
-                            states.State1->Update(&t);
-                          }
-                        } // if
-                      }
-                      break;
-
-                      case uniHumidity:
-                      {
-                        // влажность
-                        Humidity h;
-                        h.Value = (int8_t) *readDataPtr++;
-                        h.Fract = *readDataPtr++;
-
-                        // температура
-                        Temperature t;
-                        t.Value = (int8_t) *readDataPtr++;
-                        t.Fract = *readDataPtr++;
-
-                        #ifdef RS485_DEBUG
-                          Serial.print(F("Humidity: "));
-                          Serial.println(h);
-                        #endif
-
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                            #ifdef RS485_DEBUG
-                              Serial.println(F("Update data in controller..."));
-                            #endif
-
-                          if(states.State1)
-                            states.State1->Update(&t);
-
-                          if(states.State2)
-                            states.State2->Update(&h);
-                            
-                        } // if                        
-                      }
-                      break;
-
-                      case uniLuminosity:
-                      {
-                        // освещённость
-                        long lum;
-                        memcpy(&lum,readDataPtr,sizeof(long));
-
-                        #ifdef RS485_DEBUG
-                          Serial.print(F("Luminosity: "));
-                          Serial.println(lum);
-                        #endif
-
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                          {
-                            #ifdef RS485_DEBUG
-                              Serial.println(F("Update data in controller..."));
-                            #endif
-                            
-                            states.State1->Update(&lum);
-                          }
-                        } // if                        
-                        
-                        
-                      }
-                      break;
-
-                      case uniSoilMoisture: // влажность почвы
-                      case uniPH:  // показания pH
-                      {
-                        
-                        Humidity h;
-                        h.Value = (int8_t) *readDataPtr++;
-                        h.Fract = *readDataPtr;
-
-                        #ifdef RS485_DEBUG
-                          if(sType == uniSoilMoisture)
-                            Serial.print(F("Soil moisture: "));
-                          else
-                            Serial.print(F("pH: "));
-                            
-                          Serial.println(h);
-                        #endif
-
-                        // получаем состояния
-                        UniSensorState states;
-                        if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                        {
-                          if(states.State1)
-                          {
-                            #ifdef RS485_DEBUG
-                              Serial.println(F("Update data in controller..."));
-                            #endif
-                            
-                            states.State1->Update(&h);
-                          }
-                        } // if                        
-                        
-                      }
-                      break;
-                      
-                    } // switch
-                }
-                #ifdef RS485_DEBUG
-                else
-                {
-                  Serial.println(F("Received data from unknown sensor :("));
-                }
-                #endif
-              }
-              #ifdef RS485_DEBUG
-              else
-              {
-                Serial.println(F("Wrong packet type :("));
-              }
-              #endif
-            }
-            #ifdef RS485_DEBUG
-            else
-            {
-              Serial.println(F("Bad checksum :("));
-            }
-            #endif
-          }
-          #ifdef RS485_DEBUG
-          else
-          {
-            Serial.println(F("Head or tail of packet is invalid :("));
-          } // else
-          #endif
-        }
-        #ifdef RS485_DEBUG
-        else
-        {
-          Serial.println(F("Received uncompleted packet :("));
-        } // else
-        #endif
-          
-        
+        // есть очередь для опроса, запрашиваем показания, ответ разберём в следующих вызовах
+        requestSensorData();
       } // if(queue.size())
       #ifdef RS485_DEBUG
       else
@@ -576,7 +643,6 @@ void UniRS485Gate::Update(uint16_t dt)
       }
       #endif
         
-      
     } // if(sensorsTimer > _upd_interval)
     
   #endif // USE_UNIVERSAL_SENSORS
@@ -1718,7 +1784,7 @@ bool UniScratchpadClass::read()
       raw[i] = ow.read();
       
     // проверяем контрольную сумму
-    bool isCrcGood =  OneWire::crc8(raw, sizeof(UniRawScratchpad)-1) == raw[sizeof(UniRawScratchpad)-1];
+    bool isCrcGood = UniIsCrcValid(*scratchpad);
 
    #ifdef UNI_DEBUG
     if(isCrcGood) {
@@ -1764,7 +1830,7 @@ bool UniScratchpadClass::write()
   scratchpad->head.controller_id = UniDispatcher.GetControllerID();
   
   // подсчитываем контрольную сумму и записываем её в последний байт скратчпада
-  scratchpad->crc8 = OneWire::crc8((byte*) scratchpad, sizeof(UniRawScratchpad)-1);
+  UniSetCrc(*scratchpad);
 
   if(!ow.reset()) // нет датчика на линии
     return false; 
@@ -1894,6 +1960,7 @@ UniNRFGate::UniNRFGate()
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
 bool UniNRFGate::isInOnlineQueue(byte sensorType,byte sensorIndex, byte& result_index)
 {
+  // ищем с головы: показания обычно приходят от датчика, срок ожидания которого подходит первым
   for(size_t i=0;i<sensorsOnlineQueue.size();i++)
     if(sensorsOnlineQueue[i].sensorType == sensorType && sensorsOnlineQueue[i].sensorIndex == sensorIndex)
     {
@@ -1903,6 +1970,155 @@ bool UniNRFGate::isInOnlineQueue(byte sensorType,byte sensorIndex, byte& result_
   return false;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniNRFGate::removeFromQueue(byte idx)
+{
+  NRFQueueItem* items = sensorsOnlineQueue.pData();
+  size_t cnt = sensorsOnlineQueue.size();
+  
+  memmove(&(items[idx]),&(items[idx+1]),(cnt - idx - 1)*sizeof(NRFQueueItem));
+  sensorsOnlineQueue.pop();
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniNRFGate::insertIntoQueue(const NRFQueueItem& item)
+{
+  sensorsOnlineQueue.push_back(item);
+
+  // новый срок обычно самый поздний, поэтому ищем место с хвоста - как правило, датчик так и остаётся в хвосте
+  NRFQueueItem* items = sensorsOnlineQueue.pData();
+  size_t pos = sensorsOnlineQueue.size() - 1;
+  
+  while(pos > 0 && (long)(items[pos-1].deadline - item.deadline) > 0)
+  {
+    items[pos] = items[pos-1];
+    pos--;
+  }
+
+  items[pos] = item;
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniNRFGate::scheduleSensor(byte sensorType, byte sensorIndex, uint16_t queryInterval)
+{
+  unsigned long nowTime = millis();
+  
+  NRFQueueItem qi;
+  byte result_index = 0;
+  
+  if(isInOnlineQueue(sensorType,sensorIndex,result_index))
+  {
+    // он уже был онлайн - учимся на том, как часто модуль на самом деле присылает показания
+    qi = sensorsOnlineQueue[result_index];
+    removeFromQueue(result_index);
+
+    unsigned long observed = (nowTime - qi.gotLastDataAt)/1000;
+    
+    // пропущенные пакеты в среднее не берём, иначе один потерянный пакет надолго растянет ожидание
+    if(observed <= 2ul*max(qi.reportPeriod,queryInterval))
+      qi.reportPeriod = (qi.reportPeriod*3ul + observed)/4;
+  }
+  else
+  {
+    // датчик не был в онлайн очереди, надо его туда добавить
+    qi.sensorType = sensorType;
+    qi.sensorIndex = sensorIndex;
+    qi.reportPeriod = queryInterval;
+  }
+
+  qi.queryInterval = queryInterval; // интервал могли поменять из конфигуратора
+  qi.gotLastDataAt = nowTime;
+
+  // ждём следующих показаний не меньше, чем интервал из настроек модуля, плюс запас
+  qi.deadline = nowTime + max(qi.reportPeriod,queryInterval)*1000ul + NRF_SENSOR_TIMEOUT_MARGIN;
+
+  insertIntoQueue(qi);
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniNRFGate::setNoData(byte sensorType, byte sensorIndex)
+{
+  UniDispatcher.AddUniSensor((UniSensorType)sensorType,sensorIndex);
+
+  // проверяем тип датчика, которому надо выставить "нет данных"
+  switch(sensorType)
+  {
+    case uniTemp:
+    {
+      // температура
+      Temperature t;
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sensorType,sensorIndex,states))
+      {
+        if(states.State1)
+          states.State1->Update(&t);
+      } // if
+    }
+    break;
+
+    case uniHumidity:
+    {
+      // влажность
+      Humidity h;
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sensorType,sensorIndex,states))
+      {
+        if(states.State1)
+          states.State1->Update(&h);
+
+        if(states.State2)
+          states.State2->Update(&h);
+      } // if                        
+    }
+    break;
+
+    case uniLuminosity:
+    {
+      // освещённость
+      long lum = NO_LUMINOSITY_DATA;
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sensorType,sensorIndex,states))
+      {
+        if(states.State1)
+          states.State1->Update(&lum);
+      } // if                        
+      
+      
+    }
+    break;
+
+    case uniSoilMoisture: // влажность почвы
+    case uniPH: // показания pH
+    {
+      
+      Humidity h;
+      // получаем состояния
+      UniSensorState states;
+      if(UniDispatcher.GetRegisteredStates((UniSensorType)sensorType,sensorIndex,states))
+      {
+        if(states.State1)
+          states.State1->Update(&h);
+      } // if                        
+      
+    }
+    break;
+    
+  } // switch
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void UniNRFGate::checkStaleSensors()
+{
+  unsigned long nowTime = millis();
+
+  // в голове очереди - датчик, срок ожидания показаний которого истекает первым
+  while(sensorsOnlineQueue.size() && (long)(nowTime - sensorsOnlineQueue[0].deadline) > 0)
+  {
+    // датчик не откликался дольше, чем интервал между опросами плюс запас,
+    // надо ему выставить показания "нет данных" и удалить его из очереди
+    setNoData(sensorsOnlineQueue[0].sensorType,sensorsOnlineQueue[0].sensorIndex);
+    removeFromQueue(0);
+  } // while
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
 void UniNRFGate::Setup()
 {
   #ifdef USE_NRF_REBOOT_PIN
@@ -1932,120 +2148,8 @@ void UniNRFGate::Update(uint16_t dt)
   if(!nRFInited)
     return;
 
-  static uint16_t onlineCheckTimer = 0;
-  onlineCheckTimer += dt;
-  if(onlineCheckTimer > 5000)
-  {
-    onlineCheckTimer = 0;
-
-    //Тут, раз в пять секунд - мы должны проверять, не истёк ли интервал
-    // получения показаний с датчиков, показания с которых были получены ранее.
-    // если интервал истёк - мы должны выставить датчику показания "нет данных"
-    // и удалить его из очереди.
-
-    byte count_passes = sensorsOnlineQueue.size();
-    byte cur_idx = count_passes-1;
-
-    unsigned long nowTime = millis();
-
-    // проходим от хвоста до головы
-    while(count_passes)
-    {
-      NRFQueueItem* qi = &(sensorsOnlineQueue[cur_idx]);
-
-      // вычисляем интервал в миллисекундах
-      unsigned long query_interval = qi->queryInterval*1000;
-      
-      // смотрим, не истёк ли интервал с момента последнего опроса
-      if((nowTime - qi->gotLastDataAt) > (query_interval+3000) )
-      {
-        
-        // датчик не откликался дольше, чем интервал между опросами плюс дельта в 3 секунды,
-        // надо ему выставить показания "нет данных"
-          byte sType = qi->sensorType;
-          byte sIndex = qi->sensorIndex;
-        
-          UniDispatcher.AddUniSensor((UniSensorType)sType,sIndex);
-
-            // проверяем тип датчика, которому надо выставить "нет данных"
-            switch(qi->sensorType)
-            {
-              case uniTemp:
-              {
-                // температура
-                Temperature t;
-                // получаем состояния
-                UniSensorState states;
-                if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                {
-                  if(states.State1)
-                    states.State1->Update(&t);
-                } // if
-              }
-              break;
-
-              case uniHumidity:
-              {
-                // влажность
-                Humidity h;
-                // получаем состояния
-                UniSensorState states;
-                if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                {
-                  if(states.State1)
-                    states.State1->Update(&h);
-
-                  if(states.State2)
-                    states.State2->Update(&h);
-                } // if                        
-              }
-              break;
-
-              case uniLuminosity:
-              {
-                // освещённость
-                long lum = NO_LUMINOSITY_DATA;
-                // получаем состояния
-                UniSensorState states;
-                if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                {
-                  if(states.State1)
-                    states.State1->Update(&lum);
-                } // if                        
-                
-                
-              }
-              break;
-
-              case uniSoilMoisture: // влажность почвы
-              case uniPH: // показания pH
-              {
-                
-                Humidity h;
-                // получаем состояния
-                UniSensorState states;
-                if(UniDispatcher.GetRegisteredStates((UniSensorType)sType,sIndex,states))
-                {
-                  if(states.State1)
-                    states.State1->Update(&h);
-                } // if                        
-                
-              }
-              break;
-              
-            } // switch
-
-        // теперь удаляем оффлайн-датчик из очереди
-        sensorsOnlineQueue.pop();
-        
-      } // if((nowTime
-      
-      count_passes--;
-      cur_idx--;
-    } // while
-    
-   
-  } // if onlineCheckTimer
+  // датчики в очереди упорядочены по сроку ожидания показаний, поэтому проверяем только голову очереди
+  checkStaleSensors();
 
   static uint16_t controllerStateTimer = 0;
   controllerStateTimer += dt;
@@ -2063,7 +2167,7 @@ void UniNRFGate::Update(uint16_t dt)
         // состояние контроллера изменилось, посылаем его в эфир
          memcpy(&(packet.state),&st,sizeof(ControllerState));
          packet.controller_id = UniDispatcher.GetControllerID();
-         packet.crc8 = OneWire::crc8((const byte*) &packet,sizeof(packet)-1);
+         UniSetCrc(packet);
     
          #ifdef NRF_DEBUG
          Serial.println(F("Controller state changed, send it..."));
@@ -2086,11 +2190,12 @@ void UniNRFGate::Update(uint16_t dt)
       
   } // if(controllerStateTimer > NRF_CONTROLLER_STATE_CHECK_FREQUENCY
 
-  // тут читаем данные из труб
+  // тут читаем данные из труб: вычитываем всё, что накопилось, чтобы при большом кол-ве модулей не переполнялся приёмный буфер nRF
   uint8_t pipe_num = 0; // из какой трубы пришло
-  if(radio.available(&pipe_num))
+  static UniRawScratchpad nrfScratch;
+  
+  for(byte packetsRead = 0; packetsRead < NRF_MAX_PACKETS_PER_UPDATE && radio.available(&pipe_num); packetsRead++)
   {
-     static UniRawScratchpad nrfScratch;
      // читаем скратч
      radio.read(&nrfScratch,PAYLOAD_SIZE);
 
@@ -2098,8 +2203,7 @@ void UniNRFGate::Update(uint16_t dt)
       Serial.println(F("Received the scratch via radio..."));
      #endif
 
-     byte checksum = OneWire::crc8((const byte*)&nrfScratch,sizeof(UniRawScratchpad)-1);
-     if(checksum == nrfScratch.crc8)
+     if(UniIsCrcValid(nrfScratch))
      {
       #ifdef NRF_DEBUG
       Serial.println(F("Checksum OK"));
@@ -2133,25 +2237,8 @@ void UniNRFGate::Update(uint16_t dt)
                 if(ut == uniNone || ourScrath->sensors[i].index == NO_SENSOR_REGISTERED) // нет типа датчика
                   continue;
             
-                // имеем тип датчика, можем проверять, есть ли он у нас в онлайновых
-                byte result_index = 0;
-                if(isInOnlineQueue(type,ourScrath->sensors[i].index,result_index))
-                {
-                  // он уже был онлайн, надо сбросить таймер опроса
-                  NRFQueueItem* qi = &(sensorsOnlineQueue[result_index]);
-                  qi->gotLastDataAt = millis();
-                }
-                else
-                {
-                  // датчик не был в онлайн очереди, надо его туда добавить
-                  NRFQueueItem qi;
-                  qi.sensorType = type;
-                  qi.sensorIndex = ourScrath->sensors[i].index;
-                  qi.queryInterval = ourScrath->query_interval_min*60 + ourScrath->query_interval_sec;
-                  qi.gotLastDataAt = millis();
-
-                  sensorsOnlineQueue.push_back(qi);
-                } // else
+                // имеем тип датчика, переставляем его в очереди по новому сроку ожидания показаний
+                scheduleSensor(type,ourScrath->sensors[i].index,ourScrath->query_interval_min*60 + ourScrath->query_interval_sec);
                 
               } // for
 
@@ -2179,7 +2266,7 @@ void UniNRFGate::Update(uint16_t dt)
      #endif
     
     
-  } // available
+  } // for
   
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include "ModuleController.h"
 #include "TinyVector.h"
+#include "UniFraming.h"
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
 // команды
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -348,7 +349,8 @@ class NextionUniClient : public AbstractUniClient
 #ifdef USE_RS485_GATE
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
 enum {RS485FromMaster = 1, RS485FromSlave = 2};
-enum {RS485ControllerStatePacket = 1, RS485SensorDataPacket = 2};
+enum {RS485ControllerStatePacket = 1, RS485SensorDataPacket = 2, RS485AllSensorsDataPacket = 3};
+enum {RS485BusIdle, RS485BusTransmit, RS485BusReceive}; // что сейчас происходит на шине
 //----------------------------------------------------------------------------------------------------------------
 typedef struct
 {
@@ -372,9 +374,22 @@ typedef struct
 {
   byte sensorType; // тип датчика
   byte sensorIndex; // зарегистрированный в системе индекс
+#ifdef RS485_BATCH_POLL
+  bool polled; // показания уже пришли в этом проходе очереди
+#endif
   
 } RS485QueueItem; // запись в очереди на чтение показаний из шины
 //----------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+  byte sensorType; // тип датчика
+  byte sensorIndex; // зарегистрированный в системе индекс
+  byte data[4]; // показания, как в пакете RS485SensorDataPacket
+  
+} RS485SensorData; // показания одного датчика в ответе на пакет RS485AllSensorsDataPacket
+//----------------------------------------------------------------------------------------------------------------
+#define RS485_MAX_BATCH_SENSORS ((sizeof(ControllerState)-1)/sizeof(RS485SensorData)) // сколько показаний влезает в один пакет
+//----------------------------------------------------------------------------------------------------------------
 typedef Vector<RS485QueueItem> RS485Queue; // очередь к опросу
 //----------------------------------------------------------------------------------------------------------------
 class UniRS485Gate // класс для работы универсальных модулей через RS-485
@@ -384,15 +399,23 @@ class UniRS485Gate // класс для работы универсальных
     void Setup();
     void Update(uint16_t dt);
 
+    void transmitComplete(); // вызывается из прерывания по окончанию передачи
+
   private:
 #ifdef USE_UNI_EXECUTION_MODULE
     unsigned long updateTimer;
 #endif    
 
-    void waitTransmitComplete();
+    RS485Packet packet; // пакет, который передаём или принимаем
+    volatile byte busState; // что сейчас происходит на шине
+    volatile bool waitForAnswer; // после передачи пакета ждём ответа
+    byte bytesReaded; // сколько байт ответа уже прочитали
+    unsigned long lastByteTime; // когда (micros) пришёл последний байт ответа или закончилась передача
+
+    void sendPacket(bool wantAnswer); // начинает передачу пакета, дожидаться её окончания не надо
+    void processBus(); // продвигает обмен по шине, не блокируя выполнение
     void enableSend();
     void enableReceive();
-    byte crc8(const byte *addr, byte len);
 
   #ifdef USE_UNIVERSAL_SENSORS // если комплимся с поддержкой модулей с датчиками - тогда обрабатываем очередь
 
@@ -401,6 +424,12 @@ class UniRS485Gate // класс для работы универсальных
     RS485Queue queue;
     byte currentQueuePos;
     unsigned long sensorsTimer;
+    RS485QueueItem currentItem; // датчик, с которого ждём показания
+
+    void advanceQueue(); // переходит к следующему датчику в очереди
+    void requestSensorData(); // посылает в шину запрос показаний очередного датчика
+    void applySensorData(const RS485QueueItem& item, const byte* readDataPtr); // обновляет показания датчика пришедшими данными
+    void processSensorAnswer(); // разбирает ответ модуля с датчиками
   #endif  
     
 };
@@ -427,8 +456,10 @@ typedef struct
   
   byte sensorType; // тип датчика
   byte sensorIndex; // зарегистрированный в системе индекс
-  uint16_t queryInterval; // интервал между получениями информации с датчика
+  uint16_t queryInterval; // интервал между получениями информации с датчика, с (из скратчпада модуля)
+  uint16_t reportPeriod; // фактический интервал между получениями информации с датчика, с (усреднённый)
   unsigned long gotLastDataAt; // колда были получены последние данные
+  unsigned long deadline; // до какого момента (millis) ждём следующих показаний
   
 } NRFQueueItem;
 //----------------------------------------------------------------------------------------------------------------
@@ -452,8 +483,13 @@ class UniNRFGate
     NRFControllerStatePacket packet;
     bool nRFInited;
 
-    NRFQueue sensorsOnlineQueue;
+    NRFQueue sensorsOnlineQueue; // датчики, с которых были показания, упорядочены по сроку ожидания следующих показаний
     bool isInOnlineQueue(byte sensorType,byte sensorIndex, byte& result_index);
+    void scheduleSensor(byte sensorType, byte sensorIndex, uint16_t queryInterval); // датчик прислал показания, переставляем его в очереди
+    void insertIntoQueue(const NRFQueueItem& item); // вставляет датчик в очередь с сохранением порядка
+    void removeFromQueue(byte idx);
+    void checkStaleSensors(); // выставляет "нет данных" датчикам, показаний с которых не было дольше положенного
+    void setNoData(byte sensorType, byte sensorIndex);
   
 };
 //-------------------------------------------------------------------------------------------------------------------------------------------------------
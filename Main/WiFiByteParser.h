@@ -0,0 +1,191 @@
+#ifndef _WIFI_BYTE_PARSER_H
+#define _WIFI_BYTE_PARSER_H
+//--------------------------------------------------------------------------------------------------------------------------------
+// Разбор потока от ESP8266: побайтовый разбор для WIFI_BYTE_PARSER и накопление команд клиентов.
+// Зависит только от Arduino.h, поэтому проверяется на ПК тестом из папки Tests/WiFiByteParser.
+//--------------------------------------------------------------------------------------------------------------------------------
+#include <Arduino.h>
+//--------------------------------------------------------------------------------------------------------------------------------
+#ifndef WIFI_LINE_BUFFER_SIZE
+#define WIFI_LINE_BUFFER_SIZE 64 // размер буфера для строки ответа ESP (задаётся в Globals.h)
+#endif
+//--------------------------------------------------------------------------------------------------------------------------------
+// разбираем заголовок +IPD,<ID клиента>,<длина данных>:<данные>
+//--------------------------------------------------------------------------------------------------------------------------------
+inline bool WiFiParseIPDHeader(const char* line, int& clientID, int& dataLen, const char*& data)
+{
+  const char* ptr = strchr(line,',');
+  if(!ptr)
+    return false;
+
+  ptr++; // перешли за запятую, парсим ID клиента
+  clientID = atoi(ptr);
+
+  ptr = strchr(ptr,',');
+  if(!ptr)
+    return false;
+
+  ptr++; // за запятую
+  dataLen = atoi(ptr);
+
+  ptr = strchr(ptr,':');
+  if(!ptr)
+    return false;
+
+  data = ptr + 1; // за двоеточие
+  return true;
+}
+//--------------------------------------------------------------------------------------------------------------------------------
+// накопление команды клиента: команда заканчивается на \r, \n или \r\n. Клиенты, которые шлют только \n,
+// тоже должны получать ответ, а \n сразу после \r - хвост того же перевода строки, новую команду он не начинает.
+//--------------------------------------------------------------------------------------------------------------------------------
+typedef enum
+{
+  wcbAppend, // байт - часть команды
+  wcbSkip, // байт пропускаем
+  wcbEndOfCommand // команда получена полностью
+
+} WiFiCommandByte;
+
+inline uint8_t WiFiClassifyCommandByte(char ch, bool& lastWasCR) // lastWasCR - был ли предыдущий байт \r
+{
+  bool afterCR = lastWasCR;
+  lastWasCR = (ch == '\r');
+
+  if(ch == '\n' && afterCR)
+    return wcbSkip;
+
+  if(ch == '\r' || ch == '\n')
+    return wcbEndOfCommand;
+
+  return wcbAppend;
+}
+//--------------------------------------------------------------------------------------------------------------------------------
+typedef enum
+{
+  wbpLine, // принимаем строку ответа
+  wbpIPDHeader, // принимаем заголовок +IPD,<ID>,<длина>:
+  wbpIPDData // принимаем данные пакета
+
+} WiFiByteParserState;
+
+typedef enum
+{
+  wbrNothing, // байт принят, делать ничего не надо
+  wbrLine, // принята строка ответа - см. GetLine
+  wbrIPDHeader, // принят заголовок +IPD - см. GetLine и GetIPDClientID, дальше пойдут данные пакета
+  wbrIPDData, // байт - данные пакета для клиента GetIPDClientID
+  wbrDataWelcome // пришло приглашение > на отсыл данных
+
+} WiFiByteParserResult;
+//--------------------------------------------------------------------------------------------------------------------------------
+class WiFiByteParser // побайтовый разбор потока от ESP, без выделения памяти
+{
+  public:
+    WiFiByteParser() { Reset(); }
+
+    void Reset() // забываем недопринятую строку или пакет
+    {
+      lineBuffer[0] = '\0';
+      lineBufferPos = 0;
+      parserState = wbpLine;
+      ipdClientID = -1;
+      ipdDataLeft = 0;
+    }
+
+    // разбирает очередной байт, возвращает WiFiByteParserResult. waitForDataWelcome - ждём ли приглашения >
+    uint8_t Feed(char ch, bool waitForDataWelcome)
+    {
+      switch(parserState)
+      {
+        case wbpIPDData:
+        {
+          // данные пакета отдаём как есть, вместе с \r и \n
+          if(!--ipdDataLeft)
+            parserState = wbpLine;
+
+          return wbrIPDData;
+        }
+
+        case wbpIPDHeader:
+        {
+          if(ch == '\r')
+            return wbrNothing;
+
+          if(ch == '\n') // заголовок оборвался - обрабатываем как обычную строку
+            return FinishLine();
+
+          Append(ch);
+
+          if(ch != ':')
+            return wbrNothing;
+
+          // заголовок принят полностью, данные пакета в строку не попадают
+          FinishLine();
+
+          int dataLen = 0;
+          const char* data;
+          if(!WiFiParseIPDHeader(lineBuffer,ipdClientID,dataLen,data) || dataLen < 0)
+            dataLen = 0;
+
+          ipdDataLeft = dataLen;
+          if(ipdDataLeft)
+            parserState = wbpIPDData;
+
+          return wbrIPDHeader;
+        }
+
+        case wbpLine:
+        default:
+        {
+          if(ch == '\r')
+            return wbrNothing;
+
+          if(ch == '\n')
+            return FinishLine();
+
+          if(waitForDataWelcome && ch == '>') // ждут приглашения на отсыл данных
+            return wbrDataWelcome;
+
+          Append(ch);
+
+          // строка начинается с "+IPD," - дальше идёт заголовок пакета с данными
+          if(lineBufferPos == 5 && !strncmp_P(lineBuffer,PSTR("+IPD,"),5))
+          {
+            ipdClientID = -1;
+            parserState = wbpIPDHeader;
+          }
+
+          return wbrNothing;
+        }
+
+      } // switch
+    }
+
+    const char* GetLine() const { return lineBuffer; } // строка ответа или заголовок +IPD, действительна до следующего байта
+    int GetIPDClientID() const { return ipdClientID; } // клиент, которому идут данные пакета
+
+  private:
+
+    char lineBuffer[WIFI_LINE_BUFFER_SIZE]; // буфер для строки ответа или заголовка +IPD
+    uint8_t lineBufferPos; // сколько байт в буфере
+    uint8_t parserState; // состояние разбора входящего потока
+    int ipdClientID; // клиент из заголовка +IPD
+    uint16_t ipdDataLeft; // сколько байт данных пакета осталось принять
+
+    void Append(char ch) // строки длиннее буфера обрезаются
+    {
+      if(lineBufferPos < WIFI_LINE_BUFFER_SIZE-1)
+        lineBuffer[lineBufferPos++] = ch;
+    }
+
+    uint8_t FinishLine()
+    {
+      lineBuffer[lineBufferPos] = '\0';
+      lineBufferPos = 0;
+      parserState = wbpLine;
+      return wbrLine;
+    }
+};
+//--------------------------------------------------------------------------------------------------------------------------------
+#endif
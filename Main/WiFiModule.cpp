@@ -74,12 +74,52 @@ void WiFiModule::SendData(IoTService service,uint16_t dataLength, IOT_OnWriteToS
 }
 #endif   
 
-bool WiFiModule::IsKnownAnswer(const String& line)
+// таблица известных нам ответов ESP: первые WIFI_EXACT_ANSWERS_COUNT ответов должны совпадать со строкой целиком,
+// остальные - стоять в конце строки
+const char _wifi_OK[] PROGMEM = "OK";
+const char _wifi_ERROR[] PROGMEM = "ERROR";
+const char _wifi_FAIL[] PROGMEM = "FAIL";
+const char _wifi_SEND_OK[] PROGMEM = "SEND OK";
+const char _wifi_SEND_FAIL[] PROGMEM = "SEND FAIL";
+
+const char* const WIFI_KNOWN_ANSWERS[] PROGMEM = {_wifi_OK, _wifi_ERROR, _wifi_FAIL, _wifi_SEND_OK, _wifi_SEND_FAIL};
+#define WIFI_EXACT_ANSWERS_COUNT 3
+
+bool WiFiModule::IsKnownAnswer(const char* line)
 {
-  return ( line == F("OK") || line == F("ERROR") || line == F("FAIL") || line.endsWith(F("SEND OK")) || line.endsWith(F("SEND FAIL")));
+  size_t lineLen = strlen(line);
+  
+  for(uint8_t i=0;i<sizeof(WIFI_KNOWN_ANSWERS)/sizeof(WIFI_KNOWN_ANSWERS[0]);i++)
+  {
+    const char* answer = (const char*) pgm_read_ptr(&(WIFI_KNOWN_ANSWERS[i]));
+    
+    if(i < WIFI_EXACT_ANSWERS_COUNT)
+    {
+      if(!strcmp_P(line,answer))
+        return true;
+        
+      continue;
+    }
+
+    size_t answerLen = strlen_P(answer);
+    if(lineLen >= answerLen && !strcmp_P(line + lineLen - answerLen,answer))
+      return true;
+  }
+
+  return false;
 }
 
-void WiFiModule::ProcessAnswerLine(const String& line)
+bool WiFiModule::IsIPD(const char* line)
+{
+  return !strncmp_P(line,(const char*) F("+IPD"),4);
+}
+
+bool WiFiModule::HasFailure(const char* line)
+{
+  return (strstr_P(line,(const char*) F("FAIL")) || strstr_P(line,(const char*) F("ERROR")));
+}
+
+void WiFiModule::ProcessAnswerLine(const char* line)
 {
 
    flags.isAnyAnswerReceived = true; 
@@ -89,7 +129,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
   #endif
 
    // проверяем, не перезагрузился ли модем
-  if(line == F("ready") && currentAction != wfaWantReady) // мы проверяем на ребут только тогда, когда сами его не вызвали
+  if(!strcmp_P(line,(const char*) F("ready")) && currentAction != wfaWantReady) // мы проверяем на ребут только тогда, когда сами его не вызвали
   {
     #ifdef WIFI_DEBUG
       WIFI_DEBUG_WRITE(F("ESP boot found, init queue.."),currentAction);
@@ -113,7 +153,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
     currentAction != wfaActualSendIoTData &&  // если мы не в процессе отсыла данных в IoT
 #endif
     
-    line.startsWith(F("+IPD")))
+    IsIPD(line))
   {
     ProcessQuery(line); // разбираем пришедшую команду
   } // if
@@ -124,7 +164,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
     case wfaWantReady:
     {
       // ждём ответа "ready" от модуля
-      if(line == F("ready")) // получили
+      if(!strcmp_P(line,(const char*) F("ready"))) // получили
       {
         #ifdef WIFI_DEBUG
           WIFI_DEBUG_WRITE(F("[OK] => ESP restarted."),currentAction);
@@ -277,7 +317,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
     {
       // мы тут, понимаешь ли, ждём ответа на отсыл данных в IoT.
       // Ждём до тех пор, пока не получен известный нам ответ или строка не начинается с +IPD
-      bool isIpd = line.startsWith(F("+IPD"));
+      bool isIpd = IsIPD(line);
       if(/*IsKnownAnswer(line) || */isIpd)
       {
         // дождались, следовательно, можем вызывать коллбэк, сообщая, что мы успешно отработали
@@ -329,7 +369,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
 
         
         // один из известных нам ответов
-        if(line == F("OK"))
+        if(!strcmp_P(line,(const char*) F("OK")))
         {
          #ifdef WIFI_DEBUG
           WIFI_DEBUG_WRITE(F("IoT connection OK, continue..."),currentAction);
@@ -372,7 +412,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
           WIFI_DEBUG_WRITE(F("IoT, waiting for \">\"..."),currentAction);
         #endif 
 
-      if(line == F(">")) // дождались приглашения
+      if(!strcmp_P(line,(const char*) F(">"))) // дождались приглашения
       {
         #ifdef WIFI_DEBUG
           WIFI_DEBUG_WRITE(F("\">\" FOUND, sending data to IoT..."),currentAction);
@@ -386,7 +426,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
                
       }
       else
-      if(line.indexOf(F("FAIL")) != -1 || line.indexOf(F("ERROR")) != -1)
+      if(HasFailure(line))
       {
          // всё плохо 
         #ifdef WIFI_DEBUG
@@ -412,7 +452,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
           WIFI_DEBUG_WRITE(F("Waiting for \">\"..."),currentAction);
         #endif        
             
-      if(line == F(">")) // дождались приглашения
+      if(!strcmp_P(line,(const char*) F(">"))) // дождались приглашения
       {
         #ifdef WIFI_DEBUG
           WIFI_DEBUG_WRITE(F("\">\" FOUND, sending the data..."),currentAction);
@@ -424,7 +464,7 @@ void WiFiModule::ProcessAnswerLine(const String& line)
         flags.inSendData = true; // выставляем флаг, что мы отсылаем данные, и тогда очередь обработки клиентов не будет чухаться
       }
       else
-      if(line.indexOf(F("FAIL")) != -1 || line.indexOf(F("ERROR")) != -1)
+      if(HasFailure(line))
       {
         // передача данных клиенту неудачна, отсоединяем его принудительно
          #ifdef WIFI_DEBUG
@@ -462,8 +502,13 @@ void WiFiModule::ProcessAnswerLine(const String& line)
         WIFI_DEBUG_WRITE(String(F("No packets in client #")) + String(currentClientIDX),currentAction);
         #endif
 
-         #ifndef WIFI_TCP_KEEP_ALIVE  // если надо разрывать соединение после отсыла результатов - разрываем его
+          // если надо разрывать соединение после отсыла результатов - разрываем его; если клиент получил
+          // порченый ответ - разрываем соединение в любом случае, чтобы он не принял его за целый
+         #ifdef WIFI_TCP_KEEP_ALIVE
+          if(clients[currentClientIDX].IsConnected() && clients[currentClientIDX].IsStreamBroken())
+         #else
           if(clients[currentClientIDX].IsConnected())
+         #endif
           {
             #ifdef WIFI_DEBUG
             WIFI_DEBUG_WRITE(String(F("Client #")) + String(currentClientIDX) + String(F(" has no packets, closing connection...")),currentAction);
@@ -471,11 +516,10 @@ void WiFiModule::ProcessAnswerLine(const String& line)
             actionsQueue.push_back(wfaCIPCLOSE); // добавляем команду на закрытие соединения
             flags.inSendData = true; // пока не обработаем отсоединение клиента - не разрешаем посылать пакеты другим клиентам
           } // if
-        #endif  
         
         } // if
       
-        if(line.indexOf(F("FAIL")) != -1 || line.indexOf(F("ERROR")) != -1)
+        if(HasFailure(line))
         {
           // передача данных клиенту неудачна, отсоединяем его принудительно
            #ifdef WIFI_DEBUG
@@ -513,30 +557,26 @@ void WiFiModule::ProcessAnswerLine(const String& line)
   } // switch
 
   // смотрим, может - есть статус клиента
-  int idx = line.indexOf(F(",CONNECT"));
-  if(idx != -1)
+  if(strstr_P(line,(const char*) F(",CONNECT")))
   {
-    // клиент подсоединился
-    String s = line.substring(0,idx);
-    int clientID = s.toInt();
+    // клиент подсоединился, номер клиента - в начале строки
+    int clientID = atoi(line);
     if(clientID >= 0 && clientID < MAX_WIFI_CLIENTS)
     {
    #ifdef WIFI_DEBUG
-    WIFI_DEBUG_WRITE(String(F("[CLIENT CONNECTED] - ")) + s,currentAction);
+    WIFI_DEBUG_WRITE(String(F("[CLIENT CONNECTED] - ")) + String(clientID),currentAction);
    #endif     
       clients[clientID].SetConnected(true);
     }
   } // if
-  idx = line.indexOf(F(",CLOSED"));
- if(idx != -1)
+ if(strstr_P(line,(const char*) F(",CLOSED")))
   {
     // клиент отсоединился
-    String s = line.substring(0,idx);
-    int clientID = s.toInt();
+    int clientID = atoi(line);
     if(clientID >= 0 && clientID < MAX_WIFI_CLIENTS)
     {
    #ifdef WIFI_DEBUG
-   WIFI_DEBUG_WRITE(String(F("[CLIENT DISCONNECTED] - ")) + s,currentAction);
+   WIFI_DEBUG_WRITE(String(F("[CLIENT DISCONNECTED] - ")) + String(clientID),currentAction);
    #endif     
       clients[clientID].SetConnected(false);
       
@@ -545,31 +585,13 @@ void WiFiModule::ProcessAnswerLine(const String& line)
   
   
 }
-void WiFiModule::ProcessQuery(const String& command)
+void WiFiModule::ProcessQuery(const char* command)
 {
+  int clientID, dataLen;
+  const char* data;
   
-  int idx = command.indexOf(F(",")); // ищем первую запятую после +IPD
-  const char* ptr = command.c_str();
-  ptr += idx+1;
-  // перешли за запятую, парсим ID клиента
-  String connectedClientID = F("");
-  while(*ptr != ',')
-  {
-    connectedClientID += (char) *ptr;
-    ptr++;
-  }
-  ptr++; // за запятую
-  String dataLen;
-  while(*ptr != ':')
-  {
-    dataLen += (char) *ptr;
-    ptr++; // перешли на начало данных
-  }
-  
-  ptr++; // за двоеточие
-
-  // тут пришла команда, разбираем её
-  ProcessCommand(connectedClientID.toInt(),dataLen.toInt(),ptr);
+  if(WiFiParseIPDHeader(command,clientID,dataLen,data))
+    ProcessCommand(clientID,dataLen,data); // тут пришла команда, разбираем её
    
 }
 void WiFiModule::ProcessCommand(int clientID, int dataLen, const char* command)
@@ -598,6 +620,49 @@ void WiFiModule::ProcessCommand(int clientID, int dataLen, const char* command)
         clients[clientID].CommandRequested(dataLen,command); // говорим клиенту, чтобы сложил во внутренний буфер
   } // if
  }
+#ifdef WIFI_BYTE_PARSER
+void WiFiModule::ProcessIncomingByte(char ch)
+{
+  switch(byteParser.Feed(ch,WaitForDataWelcome))
+  {
+    case wbrIPDData:
+    {
+      // данные пакета отдаём клиенту как есть, вместе с \r и \n - по ним клиент определяет конец команды
+      if(ipdClientID < MAX_WIFI_CLIENTS)
+        clients[ipdClientID].CommandRequested(1,&ch);
+    }
+    break;
+
+    case wbrIPDHeader:
+    {
+      // заголовок принят полностью. Данные пакета в строку не попадают, поэтому ProcessAnswerLine отработает
+      // всё, что связано с +IPD, кроме складывания данных клиенту - их мы отдадим клиенту сами, по мере прихода.
+      bool dataForClient = true;
+      #if defined(USE_IOT_MODULE) && defined(USE_WIFI_MODULE_AS_IOT_GATE)
+        dataForClient = (currentAction != wfaActualSendIoTData); // ответ сервера IoT никому не нужен
+      #endif
+
+      int clientID = byteParser.GetIPDClientID();
+      ProcessAnswerLine(byteParser.GetLine());
+
+      ipdClientID = (dataForClient && clientID >= 0 && clientID < MAX_WIFI_CLIENTS) ? clientID : MAX_WIFI_CLIENTS;
+    }
+    break;
+
+    case wbrLine:
+      ProcessAnswerLine(byteParser.GetLine());
+    break;
+
+    case wbrDataWelcome: // ждали приглашения >
+    {
+      WaitForDataWelcome = false;
+      ProcessAnswerLine(">");
+    }
+    break;
+    
+  } // switch
+}
+#endif
 void WiFiModule::Setup()
 {
   // настройка модуля тут
@@ -660,11 +725,20 @@ void WiFiModule::InitQueue(bool addRebootCommand)
     actionsQueue.pop();
 
   WaitForDataWelcome = false; // не ждём приглашения
+
+  #ifdef WIFI_BYTE_PARSER
+    // после перезагрузки ESP недопринятый пакет уже не придёт
+    byteParser.Reset();
+  #endif
   
   nextClientIDX = 0;
   currentClientIDX = 0;
   flags.inSendData = false;
 
+  #ifdef WIFI_SHORTEST_FIRST
+    memset(clientSkips,0,sizeof(clientSkips));
+  #endif
+
   // инициализируем время отсылки команды и получения ответа
   sendCommandTime = millis();
   answerWaitTimer = 0;
@@ -1063,11 +1137,62 @@ void WiFiModule::UpdateClients()
     
   // тут ищем, какой клиент сейчас хочет отослать данные
 
+#ifdef WIFI_SHORTEST_FIRST
+  // сначала даём всем клиентам подготовить ответы, потом выбираем клиента, которому осталось отослать меньше всего пакетов:
+  // короткие ответы уходят между пакетами длинных. Клиент, которого обошли WIFI_MAX_SKIPPED_PACKETS раз подряд,
+  // получает пакет вне очереди, чтобы длинная выгрузка не стояла на месте, пока другие клиенты опрашивают контроллер.
+  uint8_t selectedIDX = MAX_WIFI_CLIENTS;
+  uint16_t selectedPackets = 0xFFFF;
+  
+  for(uint8_t i=0;i<MAX_WIFI_CLIENTS;i++)
+  {
+    uint8_t idx = (nextClientIDX + i) % MAX_WIFI_CLIENTS; // при равенстве пакетов - по кругу, начиная с nextClientIDX
+    
+    clients[idx].Update(); // обновляем внутреннее состояние клиента - здесь он может подготовить данные к отправке, например
+
+    if(!(clients[idx].IsConnected() && clients[idx].HasPacket()))
+    {
+      clientSkips[idx] = 0;
+      continue;
+    }
+
+    if(clientSkips[idx] >= WIFI_MAX_SKIPPED_PACKETS)
+    {
+      // клиент заждался
+      selectedIDX = idx;
+      selectedPackets = 0;
+      continue;
+    }
+
+    if(clients[idx].GetPacketsLeft() < selectedPackets)
+    {
+      selectedIDX = idx;
+      selectedPackets = clients[idx].GetPacketsLeft();
+    }
+    
+  } // for
+
+  for(uint8_t idx=0;idx<MAX_WIFI_CLIENTS;idx++)
+  {
+    if(idx == selectedIDX)
+      clientSkips[idx] = 0;
+    else
+    if(clients[idx].IsConnected() && clients[idx].HasPacket() && clientSkips[idx] < 0xFF)
+      clientSkips[idx]++;
+  }
+
+  nextClientIDX = selectedIDX; // выбранный клиент - последний, дальше по кругу начинаем со следующего за ним
+  
+  for(uint8_t idx = selectedIDX; idx < MAX_WIFI_CLIENTS; idx++)
+  {
+    ++nextClientIDX;
+#else
   for(uint8_t idx = nextClientIDX;idx < MAX_WIFI_CLIENTS; idx++)
   { 
     ++nextClientIDX; // переходим на следующего клиента, как только текущему будет послан один пакет
 
     clients[idx].Update(); // обновляем внутреннее состояние клиента - здесь он может подготовить данные к отправке, например
+#endif
     
     if(clients[idx].IsConnected() && clients[idx].HasPacket())
     {
@@ -5,6 +5,9 @@
 #include "TinyVector.h"
 #include "Settings.h"
 #include "TCPClient.h"
+#ifdef WIFI_BYTE_PARSER
+#include "WiFiByteParser.h"
+#endif
 
 #if defined(USE_IOT_MODULE) && defined(USE_WIFI_MODULE_AS_IOT_GATE)
 #include "IoT.h"
@@ -69,10 +72,12 @@ class WiFiModule : public AbstractModule // модуль поддержки WI-F
     unsigned long rebootStartTime;
 
     
-    bool IsKnownAnswer(const String& line); // если ответ нам известный, то возвращает true
+    bool IsKnownAnswer(const char* line); // если ответ нам известный, то возвращает true
+    bool IsIPD(const char* line); // строка начинается с +IPD
+    bool HasFailure(const char* line); // в строке есть FAIL или ERROR
     void SendCommand(const String& command, bool addNewLine=true); // посылает команды модулю вай-фай
     void ProcessQueue(); // разбираем очередь команд
-    void ProcessQuery(const String& command); // обрабатываем запрос
+    void ProcessQuery(const char* command); // обрабатываем запрос
     void ProcessCommand(int clientID, int dataLen,const char* command);
     void UpdateClients();
     
@@ -85,8 +90,17 @@ class WiFiModule : public AbstractModule // модуль поддержки WI-F
     // список клиентов
     TCPClient clients[MAX_WIFI_CLIENTS];
 
+    #ifdef WIFI_SHORTEST_FIRST
+      uint8_t clientSkips[MAX_WIFI_CLIENTS]; // сколько раз подряд клиента с готовыми пакетами обошли другие клиенты
+    #endif
+
     void InitQueue(bool addRebootCommand=true);
 
+    #ifdef WIFI_BYTE_PARSER
+      WiFiByteParser byteParser; // побайтовый разбор входящего потока
+      uint8_t ipdClientID; // клиент, которому идут данные пакета (MAX_WIFI_CLIENTS - данные никому не нужны)
+    #endif
+
     #if defined(USE_IOT_MODULE) && defined(USE_WIFI_MODULE_AS_IOT_GATE)
       IOT_OnWriteToStream iotWriter;
       IOT_OnSendDataDone iotDone;
@@ -98,13 +112,21 @@ class WiFiModule : public AbstractModule // модуль поддержки WI-F
     #endif
   
   public:
-    WiFiModule() : AbstractModule("WIFI") {}
+    WiFiModule() : AbstractModule("WIFI")
+    #ifdef WIFI_BYTE_PARSER
+    , ipdClientID(MAX_WIFI_CLIENTS)
+    #endif
+    {}
 
     bool ExecCommand(const Command& command, bool wantAnswer);
     void Setup();
     void Update(uint16_t dt);
 
-    void ProcessAnswerLine(const String& line);
+    void ProcessAnswerLine(const char* line);
+    
+    #ifdef WIFI_BYTE_PARSER
+    void ProcessIncomingByte(char ch); // разбираем входящий поток от ESP побайтово, без выделения памяти
+    #endif
     volatile bool WaitForDataWelcome; // флаг, что мы ждём приглашения на отсыл данных - > (плохое ООП, негодное :) )
 
 #if defined(USE_IOT_MODULE) && defined(USE_WIFI_MODULE_AS_IOT_GATE)
@@ -6,6 +6,10 @@
 
 #include "UniversalSensors.h"
 #include "InteropStream.h"
+#include <util/crc16.h>
+#ifdef USE_DELTA_STATUS
+#include <EEPROM.h>
+#endif
 
 #ifdef USE_UNIVERSAL_SENSORS
 
@@ -33,6 +37,13 @@ void ZeroStreamListener::Setup()
     State.AddState(StateTemperature,0);
   #endif
 
+  #ifdef USE_DELTA_STATUS
+    // новая загрузка - новая эпоха: номера изменений начались заново, и клиент с номером от прошлой загрузки получит всё
+    deltaEpoch = (EEPROM.read(DELTA_EPOCH_EEPROM_ADDR) | (EEPROM.read(DELTA_EPOCH_EEPROM_ADDR+1) << 8)) + 1;
+    EEPROM.write(DELTA_EPOCH_EEPROM_ADDR,deltaEpoch & 0xFF);
+    EEPROM.write(DELTA_EPOCH_EEPROM_ADDR+1,deltaEpoch >> 8);
+  #endif
+
   #ifdef USE_RS485_GATE
     RS485.Setup();
   #endif
@@ -88,6 +99,68 @@ void ZeroStreamListener::Update(uint16_t dt)
 
 }
 
+#ifdef USE_LOOP_PROFILER
+// пишет в поток минимальное, среднее и максимальное значения счётчика профилировщика, через разделитель
+void PrintProfileCounter(Stream* pStream, const ProfileCounter& pc, char delim)
+{
+  pStream->print(pc.GetMin());
+  pStream->print(delim);
+  pStream->print(pc.GetAvg());
+  pStream->print(delim);
+  pStream->print(pc.Max);
+}
+#endif // USE_LOOP_PROFILER
+
+#ifdef WIFI_STREAM_RESPONSES
+StatusSnapshot* ActiveStatusSnapshot = NULL;
+
+uint8_t StatusSnapshot::Take(uint8_t value)
+{
+  if(!replaying)
+  {
+    data.push_back(value);
+    return value;
+  }
+
+  if(replayPos < data.size())
+    return data[replayPos++];
+
+  return value; // датчиков стало больше, чем при первом выполнении - ответ всё равно не сойдётся с ним по длине
+}
+#endif // WIFI_STREAM_RESPONSES
+
+// байт статусов или показаний для CTGET=0|STAT: при выполнении со снимком - из снимка
+static uint8_t StatusByte(uint8_t value)
+{
+#ifdef WIFI_STREAM_RESPONSES
+  if(ActiveStatusSnapshot)
+    return ActiveStatusSnapshot->Take(value);
+#endif
+  return value;
+}
+
+// yield при выводе CTGET=0|STAT. Со снимком команду выполняет клиент Wi-Fi, а yield опрашивает порт Wi-Fi - не зовём его
+static void StatusYield()
+{
+#ifdef WIFI_STREAM_RESPONSES
+  if(ActiveStatusSnapshot)
+    return;
+#endif
+  yield();
+}
+
+// байт статусов контроллера с номером byteNum
+static uint8_t GetStatusByte(uint8_t byteNum)
+{
+  uint8_t b = 0;
+  for(uint8_t bit=0;bit<8;bit++)
+  {
+    if(WORK_STATUS.GetStatus(byteNum*8 + bit))
+      b |= (1 << bit);
+  }
+  return b;
+}
+
 void ZeroStreamListener::PrintSensorsValues(uint8_t totalCount,ModuleStates wantedState,AbstractModule* module, Stream* outStream)
 {
   if(!totalCount) // нечего писать
@@ -95,14 +168,13 @@ void ZeroStreamListener::PrintSensorsValues(uint8_t totalCount,ModuleStates want
 
   // буфер под сырые данные, у нас максимум 4 байта на показание с датчика
   static uint8_t raw_data[sizeof(unsigned long)] = {0};
-  const char* noDataByte = "FF"; // байт - нет данных с датчика
 
   // пишем количество датчиков
   outStream->write(WorkStatus::ToHex(totalCount));
 
   for(uint8_t cntr=0;cntr<totalCount;cntr++)
   {
-    yield(); // немного даём поработать другим модулям
+    StatusYield(); // немного даём поработать другим модулям
     
     // получаем нужное состояние
     OneState* os = module->State.GetStateByOrder(wantedState,cntr);
@@ -117,29 +189,200 @@ void ZeroStreamListener::PrintSensorsValues(uint8_t totalCount,ModuleStates want
     uint8_t rawDataSize = os->GetRawData(raw_data);
 
     // сырые данные идут от младшего байта к старшему, но их надо слать
-    // старшим байтом вперёд.
+    // старшим байтом вперёд. Датчика нет на линии - пишем FF столько раз, сколько байт сырых данных мы получили
+    bool hasData = os->HasData();
     
-      if(os->HasData())
+    while(rawDataSize > 0)
+    {
+      rawDataSize--;
+      outStream->write(WorkStatus::ToHex(StatusByte(hasData ? raw_data[rawDataSize] : 0xFF)));
+    }
+    
+  } // for
+  
+}
+
+// накопитель двоичного статуса: складывает байты в небольшой буфер и пишет их в поток блоками,
+// попутно считая длину и CRC. Без потока - только считает длину.
+class BinaryStatusWriter
+{
+  public:
+    BinaryStatusWriter(Stream* s) : stream(s), pos(0), length(0), crc(0) {}
+
+    void Write(uint8_t b)
+    {
+      length++;
+      if(!stream)
+        return;
+        
+      crc = _crc16_update(crc,b);
+      buffer[pos++] = b;
+      if(pos >= sizeof(buffer))
+        Flush();
+    }
+    void Write(const char* str, uint8_t len)
+    {
+      for(uint8_t i=0;i<len;i++)
+        Write((uint8_t) str[i]);
+    }
+    void Flush()
+    {
+      if(pos && stream)
+        stream->write(buffer,pos);
+      pos = 0;
+    }
+    uint16_t GetLength() {return length;}
+    uint16_t GetCRC() {return crc;}
+
+  private:
+    Stream* stream;
+    uint8_t buffer[32];
+    uint8_t pos;
+    uint16_t length;
+    uint16_t crc;
+};
+
+// типы датчиков в двоичном статусе, в том же порядке, что и в CTGET=0|STAT
+static const ModuleStates BINARY_STATUS_TYPES[] = {StateTemperature, StateHumidity, StateLuminosity, StateWaterFlowInstant, StateWaterFlowIncremental, StateSoilMoisture, StatePH};
+
+// пишем двоичный статус: всё то же, что и в CTGET=0|STAT, только сырыми байтами, без перевода в HEX.
+// Внутри нет yield, поэтому при двух проходах (подсчёт длины и запись) набор датчиков не меняется.
+static void WriteBinaryStatus(BinaryStatusWriter& writer)
+{
+  // байты статусов
+  for(uint8_t i=0;i<STATUSES_BYTES;i++)
+    writer.Write(GetStatusByte(i));
+
+  static uint8_t raw_data[sizeof(unsigned long)] = {0};
+  const uint8_t typesCount = sizeof(BINARY_STATUS_TYPES)/sizeof(BINARY_STATUS_TYPES[0]);
+  
+  size_t modulesCount = MainController->GetModulesCount();
+  for(size_t i=0;i<modulesCount;i++)
+  {
+    AbstractModule* mod = MainController->GetModule(i);
+
+    uint8_t flags = 0;
+    for(uint8_t t=0;t<typesCount;t++)
+    {
+      if(mod->State.GetStateCount(BINARY_STATUS_TYPES[t]))
+        flags |= BINARY_STATUS_TYPES[t];
+    }
+
+    if(!flags) // пустой модуль, без интересующих нас датчиков
+      continue;
+
+    // флаги, длина имени модуля, имя
+    writer.Write(flags);
+    const char* moduleName = mod->GetID();
+    uint8_t mnamelen = strlen(moduleName);
+    writer.Write(mnamelen);
+    writer.Write(moduleName,mnamelen);
+
+    for(uint8_t t=0;t<typesCount;t++)
+    {
+      uint8_t cnt = mod->State.GetStateCount(BINARY_STATUS_TYPES[t]);
+      if(!cnt)
+        continue;
+
+      // кол-во датчиков, затем для каждого - индекс и показания старшим байтом вперёд (0xFF, если данных нет)
+      writer.Write(cnt);
+      for(uint8_t cntr=0;cntr<cnt;cntr++)
       {
-        do
+        OneState* os = mod->State.GetStateByOrder(BINARY_STATUS_TYPES[t],cntr);
+        writer.Write(os->GetIndex());
+
+        uint8_t rawDataSize = os->GetRawData(raw_data);
+        bool hasData = os->HasData();
+        
+        while(rawDataSize > 0)
         {
           rawDataSize--;
+          writer.Write(hasData ? raw_data[rawDataSize] : 0xFF);
+        }
+      } // for
+      
+    } // for
+    
+  } // for
 
-          outStream->write(WorkStatus::ToHex(raw_data[rawDataSize]));
-          
-        } while(rawDataSize > 0);
-        
-      } // if
-      else
+  writer.Flush();
+}
+
+#ifdef USE_DELTA_STATUS
+void ZeroStreamListener::PrintDeltaStatus(uint32_t since, Stream* pStream)
+{
+  // сначала запоминаем номер изменения, до которого отдаём данные: изменения, которые случатся, пока мы пишем ответ,
+  // клиент получит при следующем запросе
+  uint32_t seq = ModuleState::GetChangeSequence();
+  
+  pStream->print(OK_ANSWER);
+  pStream->print(COMMAND_DELIMITER);
+  pStream->print(DELTA_COMMAND);
+  pStream->print(PARAM_DELIMITER);
+  pStream->print(deltaEpoch);
+  pStream->print('.');
+  pStream->print(seq);
+  pStream->print(PARAM_DELIMITER);
+
+  // статусы и состояние контроллера - только если менялись
+  if(ModuleState::IsChangedSince(WORK_STATUS.GetChangeSeq(),since))
+  {
+    WORK_STATUS.WriteStatus(pStream,true);
+    
+    ControllerState& state = WORK_STATUS.GetState();
+    const uint8_t* ptr = (const uint8_t*) &state;
+    for(uint8_t i=0;i<sizeof(ControllerState);i++)
+      pStream->write(WorkStatus::ToHex(ptr[i]));
+  }
+
+  static uint8_t raw_data[sizeof(unsigned long)] = {0};
+  size_t modulesCount = MainController->GetModulesCount();
+  
+  for(size_t i=0;i<modulesCount;i++)
+  {
+    AbstractModule* mod = MainController->GetModule(i);
+    bool moduleWritten = false;
+
+    for(uint8_t t=0;t<sizeof(BINARY_STATUS_TYPES)/sizeof(BINARY_STATUS_TYPES[0]);t++)
+    {
+      uint8_t cnt = mod->State.GetStateCount(BINARY_STATUS_TYPES[t]);
+      for(uint8_t cntr=0;cntr<cnt;cntr++)
       {
-        // датчика нет на линии, пишем FF столько раз, сколько байт сырых данных мы получили
-        for(uint8_t i=0;i<rawDataSize;i++)
-          outStream->write(noDataByte);
+        OneState* os = mod->State.GetStateByOrder(BINARY_STATUS_TYPES[t],cntr);
+        if(!ModuleState::IsChangedSince(os->GetChangeSeq(),since))
+          continue;
+
+        if(!moduleWritten)
+        {
+          // данные каждого модуля идут так: |ИМЯ_МОДУЛЯ,записи
+          moduleWritten = true;
+          pStream->print(PARAM_DELIMITER);
+          pStream->print(mod->GetID());
+          pStream->print(',');
+        }
+
+        // запись: 1 байт - тип датчика, 1 байт - индекс, затем показания старшим байтом вперёд (FF, если данных нет)
+        pStream->write(WorkStatus::ToHex(BINARY_STATUS_TYPES[t]));
+        pStream->write(WorkStatus::ToHex(os->GetIndex()));
+
+        uint8_t rawDataSize = os->GetRawData(raw_data);
+        bool hasData = os->HasData();
+        while(rawDataSize > 0)
+        {
+          rawDataSize--;
+          pStream->write(WorkStatus::ToHex(hasData ? raw_data[rawDataSize] : 0xFF));
+        }
+      } // for
+    } // for
 
-      }    
+    if(moduleWritten)
+      yield(); // немного даём поработать другим модулям
+    
   } // for
-  
+
+  pStream->print(NEWLINE);
 }
+#endif
 
 bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
 {
@@ -292,7 +535,9 @@ bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
             pStream->print(OK_ANSWER);
             pStream->print(COMMAND_DELIMITER);
 
-            WORK_STATUS.WriteStatus(pStream,true); // просим записать статус
+            // пишем статус, байты - через снимок, как и показания датчиков
+            for(uint8_t i=0;i<STATUSES_BYTES;i++)
+              pStream->print(WorkStatus::ToHex(StatusByte(GetStatusByte(i))));
 
             // тут можем писать остальные статусы, типа показаний датчиков и т.п.:
 
@@ -306,7 +551,7 @@ bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
             
             for(size_t i=0;i<modulesCount;i++)
             {
-              yield(); // немного даём поработать другим модулям
+              StatusYield(); // немного даём поработать другим модулям
 
               AbstractModule* mod = MainController->GetModule(i);
              // if(mod == this) // себя пропускаем
@@ -373,7 +618,91 @@ bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
             
           } // wantAnswer
           
-        } // STATUS_COMMAND     
+        } // STATUS_COMMAND
+        else if(t == STATUS_BINARY_COMMAND) // получить статус в двоичном виде
+        {
+          if(wantAnswer)
+          {
+            canPublish = false; // пишем в поток сами
+            Stream* pStream = command.GetIncomingStream();
+
+            // сначала считаем длину, потом пишем заголовок и сами данные
+            BinaryStatusWriter counter(NULL);
+            WriteBinaryStatus(counter);
+
+            pStream->print(OK_ANSWER);
+            pStream->print(COMMAND_DELIMITER);
+            pStream->print(STATUS_BINARY_COMMAND);
+            pStream->print(PARAM_DELIMITER);
+            pStream->print(counter.GetLength());
+            pStream->print(NEWLINE);
+
+            BinaryStatusWriter writer(pStream);
+            WriteBinaryStatus(writer);
+
+            // в конце - CRC16 данных, старшим байтом вперёд
+            uint16_t crc = writer.GetCRC();
+            pStream->write((uint8_t) (crc >> 8));
+            pStream->write((uint8_t) (crc & 0xFF));
+            
+          } // wantAnswer
+        } // STATUS_BINARY_COMMAND
+        #ifdef USE_DELTA_STATUS
+        else if(t == DELTA_COMMAND) // получить изменения с момента изменения, номер которого передал клиент
+        {
+          if(wantAnswer)
+          {
+            canPublish = false; // пишем в поток сами
+
+            // клиент передаёт Эпоха.N из прошлого ответа; номер изменения из другой загрузки ничего не значит - отдаём всё
+            uint32_t since = 0;
+            if(argsCnt > 1)
+            {
+              char* seqPtr;
+              unsigned long epoch = strtoul(command.GetArg(1),&seqPtr,10);
+              if(*seqPtr == '.' && epoch == deltaEpoch)
+                since = strtoul(seqPtr+1,NULL,10);
+            }
+            PrintDeltaStatus(since,command.GetIncomingStream());
+          }
+        } // DELTA_COMMAND
+        #endif // USE_DELTA_STATUS
+        #ifdef USE_LOOP_PROFILER
+        else if(t == PROF_COMMAND) // получить данные профилировщика
+        {
+          if(wantAnswer)
+          {
+            // ответ длинный, пишем прямо в поток, не забивая общий буфер
+            canPublish = false;
+            Stream* pStream = command.GetIncomingStream();
+            pStream->print(OK_ANSWER);
+            pStream->print(COMMAND_DELIMITER);
+            pStream->print(PROF_COMMAND);
+            pStream->print(PARAM_DELIMITER);
+
+            // сначала - время между вызовами loop
+            PrintProfileCounter(pStream,MainController->GetLoopProfile(),'|');
+
+            // затем - по каждому модулю
+            size_t modulesCount = MainController->GetModulesCount();
+            for(size_t i=0;i<modulesCount;i++)
+            {
+              yield(); // немного даём поработать другим модулям
+              
+              ModuleProfileInfo& pi = MainController->GetModuleProfile(i);
+              
+              pStream->print(PARAM_DELIMITER);
+              pStream->print(MainController->GetModule(i)->GetID());
+              pStream->print(',');
+              PrintProfileCounter(pStream,pi.Update,',');
+              pStream->print(',');
+              PrintProfileCounter(pStream,pi.Exec,',');
+            } // for
+
+            pStream->print(NEWLINE);
+          } // wantAnswer
+        } // PROF_COMMAND
+        #endif // USE_LOOP_PROFILER
         else if(t == REGISTERED_MODULES_COMMAND) // пролистать зарегистрированные модули
         {
           PublishSingleton.AddModuleIDToAnswer = false;
@@ -441,6 +770,16 @@ bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
           PublishSingleton.Status = true;
         
         } // AUTO
+        #ifdef USE_LOOP_PROFILER
+        else
+        if(t == PROF_COMMAND) // CTSET=0|PROF - сбросить счётчики профилировщика
+        {
+          MainController->ResetProfiler();
+          PublishSingleton.Status = true;
+          PublishSingleton = PROF_COMMAND;
+          PublishSingleton << PARAM_DELIMITER << REG_DEL;
+        } // PROF_COMMAND
+        #endif // USE_LOOP_PROFILER
                 
       } // if
       else
@@ -452,7 +791,7 @@ bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
        {
           // ищем уже зарегистрированный
           String reqID = command.GetArg(1);
-          AbstractModule* mod = c->GetModuleByID(reqID);
+          AbstractModule* mod = MainController->GetModuleByID(reqID);
           if(mod)
           {
             // модуль уже зарегистрирован
@@ -462,8 +801,11 @@ bool  ZeroStreamListener::ExecCommand(const Command& command, bool wantAnswer)
           else
           {
             // регистрируем новый модуль
-            RemoteModule* remMod = new RemoteModule(reqID); 
-            c->RegisterModule(remMod);
+            // модуль хранит только указатель на свой ID, поэтому ID живёт столько же, сколько модуль
+            char* remID = new char[reqID.length()+1];
+            strcpy(remID,reqID.c_str());
+            RemoteModule* remMod = new RemoteModule(remID);
+            MainController->RegisterModule(remMod);
             PublishSingleton.Status = true;
             PublishSingleton = REG_SUCC; 
             PublishSingleton << PARAM_DELIMITER << reqID;
@@ -4,11 +4,38 @@
 #include "AbstractModule.h"
 #include "Globals.h"
 
+#ifdef WIFI_STREAM_RESPONSES
+// снимок ответа на CTGET=0|STAT для повторного выполнения команды клиентом Wi-Fi: при первом выполнении байты
+// статусов и показаний датчиков, из которых строится ответ, запоминаются, при повторных - берутся из снимка.
+// Пока клиент забирает ответ по пакетам, датчики успевают обновиться, а ответ остаётся прежним.
+class StatusSnapshot
+{
+  public:
+    StatusSnapshot() : replayPos(0), replaying(false) {}
+
+    void Record() { data.Clear(); replaying = false; } // первое выполнение: запоминаем байты
+    void Replay() { replayPos = 0; replaying = true; } // повторное выполнение: отдаём запомненные
+    void Clear() { data.Clear(); } // освобождаем память
+    uint8_t Take(uint8_t value); // байт ответа: запоминает value или возвращает байт из снимка
+
+  private:
+    Vector<uint8_t> data;
+    size_t replayPos;
+    bool replaying;
+};
+
+extern StatusSnapshot* ActiveStatusSnapshot; // снимок, с которым сейчас выполняется CTGET=0|STAT, NULL - живые данные
+#endif
+
 // класс модуля "0"
 class ZeroStreamListener : public AbstractModule
 {
   private:
     void PrintSensorsValues(uint8_t totalCount,ModuleStates wantedState,AbstractModule* module, Stream* outStream);
+#ifdef USE_DELTA_STATUS
+    void PrintDeltaStatus(uint32_t since, Stream* pStream); // пишем в поток изменения с момента изменения номер since
+    uint16_t deltaEpoch; // номер загрузки контроллера, отдаётся в ответе на CTGET=0|DELTA вместе с номером изменения
+#endif
   public:
     ZeroStreamListener() : AbstractModule("0") {}
 
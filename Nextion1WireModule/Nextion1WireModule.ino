@@ -8,6 +8,7 @@
 #include "NextionController.h"
 #include "LowLevel.h"
 #include "OneWireSlave.h"
+#include "UniFraming.h"
 //----------------------------------------------------------------------------------------------------------------
 // НАСТРОЙКИ
 //----------------------------------------------------------------------------------------------------------------
@@ -203,7 +204,7 @@ void displayNextSensorData(int8_t dir)
 //----------------------------------------------------------------------------------------------------------------
 void RecalcScratchpadChecksum() {
 
-  scratchpadS.crc8 = OneWireSlave::crc8((const byte*) scratchpad,sizeof(scratchpadS)-1);
+  UniSetCrc(scratchpadS);
 }
 //----------------------------------------------------------------------------------------------------------------
 void nSleep(NextionAbstractController* Sender)
@@ -0,0 +1,344 @@
+//----------------------------------------------------------------------------------------------------------------
+// правила модуля ALERT на ПК: разрешение связей между правилами (CompileRules и проход по evalOrder в Update).
+// Правило Ri следит за температурой i модуля-заглушки STATE и шлёт CTSET=CC|EXEC|i заглушке CC - по этим
+// командам видно, какие правила сработали. Связанные правила у Ri - те, при работе которых Ri не работает.
+// Кол-во правил - MAX_ALERT_RULES, Makefile собирает тест на 30 (как в прошивке), 64 и 128 правил.
+//   alert_rules_N          - закреплённое поведение колец и проверка на случайных связях с эталоном
+//   alert_rules_N --bench  - время Update с перекомпиляцией правил и без неё
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "Arduino.h"
+#include "../../Main/ModuleController.h"
+#include "../../Main/AlertModule.h"
+//----------------------------------------------------------------------------------------------------------------
+typedef std::vector<int> IntList;
+typedef std::vector<IntList> LinksList; // links[i] - индексы правил, связанных с Ri
+//----------------------------------------------------------------------------------------------------------------
+class StateStub : public AbstractModule // датчики температуры 0..MAX_ALERT_RULES-1
+{
+  public:
+    StateStub() : AbstractModule("STATE")
+    {
+      for(uint8_t i=0;i<MAX_ALERT_RULES;i++)
+        State.AddState(StateTemperature,i);
+    }
+    bool ExecCommand(const Command&, bool) { return true; }
+    void Setup() {}
+    void Update(uint16_t) {}
+
+    void SetTemperature(uint8_t idx, int8_t value)
+    {
+      Temperature t(value,0);
+      State.UpdateState(StateTemperature,idx,(void*)&t);
+    }
+};
+//----------------------------------------------------------------------------------------------------------------
+class CCStub : public AbstractModule // запоминает, какие правила прислали CTSET=CC|EXEC|i
+{
+  public:
+    IntList Fired;
+
+    CCStub() : AbstractModule("CC") {}
+    bool ExecCommand(const Command& command, bool)
+    {
+      if(command.GetArgsCount() > 1)
+        Fired.push_back(atoi(command.GetArg(1)));
+      return true;
+    }
+    void Setup() {}
+    void Update(uint16_t) {}
+};
+//----------------------------------------------------------------------------------------------------------------
+static ModuleController* controller;
+static StateStub* stateStub;
+static CCStub* ccStub;
+static AlertModule* alerts;
+//----------------------------------------------------------------------------------------------------------------
+static void Exec(const std::string& args)
+{
+  Command cmd;
+  cmd.Construct("ALERT",args.c_str(),ctSET);
+  controller->ProcessModuleCommand(cmd,alerts);
+}
+//----------------------------------------------------------------------------------------------------------------
+static void LoadRules(const LinksList& links)
+{
+  Exec("RULE_DELETE|ALL");
+
+  for(size_t i=0;i<links.size();i++)
+  {
+    std::string linked;
+    for(size_t j=0;j<links[i].size();j++)
+    {
+      if(j)
+        linked += ",";
+      linked += "R" + std::to_string(links[i][j]);
+    }
+    if(linked.empty())
+      linked = "_";
+
+    std::string n = std::to_string(i);
+    Exec("RULE_ADD|R" + n + "|STATE|TEMP|" + n + "|>|20|0|0|255|" + linked + "|0|CTSET=CC|EXEC|" + n);
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Raise(size_t count, const IntList& raised)
+{
+  for(size_t i=0;i<count;i++)
+    stateStub->SetTemperature(i,std::find(raised.begin(),raised.end(),(int)i) != raised.end() ? 30 : 10);
+}
+//----------------------------------------------------------------------------------------------------------------
+// какие правила сработают: правила загружены, сработали правила из raised
+static IntList Run(const LinksList& links, const IntList& raised)
+{
+  LoadRules(links);
+  Raise(links.size(),raised);
+  ccStub->Fired.clear();
+  alerts->Update(ALERT_UPDATE_INTERVAL);
+
+  IntList result = ccStub->Fired;
+  std::sort(result.begin(),result.end());
+  return result;
+}
+//----------------------------------------------------------------------------------------------------------------
+// эталон: правило ставится в порядок вычисления после всех своих связанных правил, правила из колец -
+// в конец по порядку номеров; правило работает, если сработало само и ни одно из связанных с ним ещё не работает
+static IntList Reference(const LinksList& links, const IntList& raised)
+{
+  size_t n = links.size();
+  std::vector<int> pending(n,0);
+  std::vector<bool> placed(n,false), works(n,false), isRaised(n,false);
+  LinksList compiled(n);
+  IntList order;
+
+  for(size_t i=0;i<n;i++)
+  {
+    for(size_t j=0;j<links[i].size();j++)
+    {
+      if(links[i][j] != (int)i)
+        compiled[i].push_back(links[i][j]);
+    }
+    pending[i] = compiled[i].size();
+  }
+  for(size_t i=0;i<raised.size();i++)
+    isRaised[raised[i]] = true;
+
+  for(bool any = true;any;)
+  {
+    any = false;
+    for(size_t i=0;i<n;i++)
+    {
+      if(placed[i] || pending[i])
+        continue;
+      order.push_back(i);
+      placed[i] = any = true;
+      for(size_t k=0;k<n;k++)
+        pending[k] -= std::count(compiled[k].begin(),compiled[k].end(),(int)i);
+    }
+  }
+  for(size_t i=0;i<n;i++)
+  {
+    if(!placed[i])
+      order.push_back(i);
+  }
+
+  for(size_t o=0;o<n;o++)
+  {
+    int i = order[o];
+    if(!isRaised[i])
+      continue;
+    works[i] = true;
+    for(size_t j=0;j<compiled[i].size();j++)
+    {
+      if(works[compiled[i][j]])
+        works[i] = false;
+    }
+  }
+
+  IntList result;
+  for(size_t i=0;i<n;i++)
+  {
+    if(works[i])
+      result.push_back(i);
+  }
+  return result;
+}
+//----------------------------------------------------------------------------------------------------------------
+static std::string ToString(const IntList& list)
+{
+  std::string s = "{";
+  for(size_t i=0;i<list.size();i++)
+    s += (i ? "," : "") + std::to_string(list[i]);
+  return s + "}";
+}
+//----------------------------------------------------------------------------------------------------------------
+static int failures = 0;
+static void Expect(const char* name, const LinksList& links, const IntList& raised, const IntList& expected)
+{
+  IntList got = Run(links,raised);
+  if(got != expected)
+  {
+    printf("FAIL %s: fired %s, expected %s\n",name,ToString(got).c_str(),ToString(expected).c_str());
+    failures++;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+static IntList All(size_t n)
+{
+  IntList l;
+  for(size_t i=0;i<n;i++)
+    l.push_back(i);
+  return l;
+}
+//----------------------------------------------------------------------------------------------------------------
+static LinksList EveryOther(size_t n) // каждое правило связано со всеми остальными - n*(n-1) связей, одно большое кольцо
+{
+  LinksList links(n);
+  for(size_t i=0;i<n;i++)
+    for(size_t j=0;j<n;j++)
+      if(i != j)
+        links[i].push_back(j);
+  return links;
+}
+//----------------------------------------------------------------------------------------------------------------
+static LinksList Random(size_t n, int maxLinks)
+{
+  LinksList links(n);
+  for(size_t i=0;i<n;i++)
+  {
+    int cnt = random(maxLinks+1);
+    for(int j=0;j<cnt;j++)
+    {
+      int k = random(n);
+      if(std::find(links[i].begin(),links[i].end(),k) == links[i].end()) // имена в списке связанных правил не повторяем
+        links[i].push_back(k);
+    }
+  }
+  return links;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Check()
+{
+  const size_t n = MAX_ALERT_RULES;
+
+  // кольцо R0 -> R1 -> R2 -> R0: правила кольца проверяются по порядку номеров, ещё не проверенное правило
+  // считается неработающим, поэтому R0 и R1 работают, а R2 - нет
+  Expect("ring of 3",LinksList{ {1}, {2}, {0} },IntList{0,1,2},IntList{0,1});
+
+  // то же кольцо, R0 не сработал: R1 ещё не знает, что R2 заработает, и работает вместе с ним
+  Expect("ring of 3, R0 quiet",LinksList{ {1}, {2}, {0} },IntList{1,2},IntList{1,2});
+
+  // R3 завязан на кольцо и сам попадает в хвост порядка вычисления, после R0
+  Expect("rule behind a ring",LinksList{ {1}, {2}, {0}, {0} },IntList{0,1,2,3},IntList{0,1});
+
+  // кольцо R0 <-> R1, R0 завязан ещё и на R2 вне кольца: R2 проверяется первым и выключает R0, R1 работает
+  Expect("ring blocked from outside",LinksList{ {1,2}, {0}, {} },IntList{0,1,2},IntList{1,2});
+
+  // ссылка правила на само себя не мешает ему работать
+  Expect("self link",LinksList{ {0} },IntList{0},IntList{0});
+
+  // связей больше 255: каждое правило завязано на все остальные, работает первое по номеру из сработавших
+  Expect("every rule linked to every other",EveryOther(n),All(n),IntList{0});
+  IntList allButFirst = All(n);
+  allButFirst.erase(allButFirst.begin());
+  Expect("every rule linked to every other, R0 quiet",EveryOther(n),allButFirst,IntList{1});
+
+  // без колец, Ri завязано на все правила с бОльшим номером: работает только последнее
+  LinksList later(n);
+  for(size_t i=0;i<n;i++)
+    for(size_t j=i+1;j<n;j++)
+      later[i].push_back(j);
+  Expect("every rule linked to later ones",later,All(n),IntList{(int)n-1});
+
+  // случайные связи с кольцами, в том числе больше 255 связей на всю таблицу
+  randomSeed(n);
+  for(int round=0;round<300;round++)
+  {
+    LinksList links = Random(n,round % 3 == 0 ? n : 4);
+    IntList raised;
+    for(size_t i=0;i<n;i++)
+    {
+      if(random(3))
+        raised.push_back(i);
+    }
+
+    IntList expected = Reference(links,raised);
+    IntList got = Run(links,raised);
+    if(got != expected)
+    {
+      printf("FAIL random round %d: fired %s, expected %s\n",round,ToString(got).c_str(),ToString(expected).c_str());
+      failures++;
+      break;
+    }
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+template<typename F> static double NsPerCall(F func, long rounds)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(long r=0;r<rounds;r++)
+    func();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double,std::nano>(end - start).count() / rounds;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Bench(const char* name, const LinksList& links)
+{
+  size_t n = links.size();
+  size_t linksCount = 0;
+  for(size_t i=0;i<n;i++)
+    linksCount += links[i].size();
+
+  IntList raised;
+  for(size_t i=0;i<n;i+=2)
+    raised.push_back(i);
+
+  LoadRules(links);
+  Raise(n,raised);
+
+  const long rounds = 20000;
+  double steady = NsPerCall([&]() { alerts->Update(ALERT_UPDATE_INTERVAL); },rounds);
+
+  // добавление и удаление датчика меняет раскладку состояний - правила перекомпилируются на следующем Update
+  double recompile = NsPerCall([&]()
+  {
+    ccStub->State.AddState(StateHumidity,0);
+    ccStub->State.RemoveState(StateHumidity,0);
+    alerts->Update(ALERT_UPDATE_INTERVAL);
+  },rounds);
+
+  printf("%6u %-12s %7u %12.0f %12.0f\n",(unsigned) n,name,(unsigned) linksCount,steady,recompile);
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  controller = new ModuleController();
+  controller->Setup(); // как в setup() прошивки: MainController, настройки из EEPROM
+  stateStub = new StateStub();
+  ccStub = new CCStub();
+  alerts = new AlertModule();
+  controller->RegisterModule(stateStub);
+  controller->RegisterModule(ccStub);
+  controller->RegisterModule(alerts);
+
+  if(argc > 1 && !strcmp(argv[1],"--bench"))
+  {
+    randomSeed(1);
+    Bench("none",Random(MAX_ALERT_RULES,0));
+    Bench("random 1-4",Random(MAX_ALERT_RULES,4));
+    Bench("every other",EveryOther(MAX_ALERT_RULES));
+    return 0;
+  }
+
+  Check();
+  if(failures)
+    return 1;
+
+  printf("AlertRules: %u rules, rings and random links resolved as expected\n",(unsigned) MAX_ALERT_RULES);
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
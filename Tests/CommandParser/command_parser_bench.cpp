@@ -0,0 +1,124 @@
+//----------------------------------------------------------------------------------------------------------------
+// замер разбора команд на ПК: корпус команд CTGET=/CTSET= (corpus.txt) гоняется через CommandParser::ParseCommand,
+// на каждую команду считаем выделения памяти в куче (new и расширения String) и время разбора.
+// Собирается дважды - с разбором через кучу и с USE_INPLACE_COMMAND_PARSER. На ПК важно соотношение, а не
+// абсолютные цифры: на AVR каждое выделение - это ещё и риск фрагментации 8 Кб ОЗУ.
+//   command_parser_bench <corpus>         - таблица по командам и итог
+//   command_parser_bench <corpus> --dump  - результат разбора (ID модуля и аргументы), для сверки двух режимов
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "HostShim.h"
+#include "../../Main/CommandParser.h"
+//----------------------------------------------------------------------------------------------------------------
+#ifdef USE_INPLACE_COMMAND_PARSER
+  #define PARSER_MODE "inplace"
+#else
+  #define PARSER_MODE "heap"
+#endif
+//----------------------------------------------------------------------------------------------------------------
+static volatile size_t sink; // чтобы компилятор не выкинул разбор
+//----------------------------------------------------------------------------------------------------------------
+static bool LoadCorpus(const char* fileName, std::vector<std::string>& lines)
+{
+  FILE* f = fopen(fileName,"r");
+  if(!f)
+    return false;
+
+  char buf[512];
+  while(fgets(buf,sizeof(buf),f))
+  {
+    std::string line = buf;
+    while(!line.empty() && (line[line.size()-1] == '\n' || line[line.size()-1] == '\r'))
+      line.erase(line.size()-1);
+    if(!line.empty())
+      lines.push_back(line);
+  }
+  fclose(f);
+  return true;
+}
+//----------------------------------------------------------------------------------------------------------------
+// разбор одной команды так, как это делает loop(): ParseCommand, потом модулю нужны ID и все аргументы
+static size_t ParseOnce(CommandParser& parser, const String& line)
+{
+  Command cmd;
+  if(!parser.ParseCommand(line,cmd))
+    return 0;
+
+  size_t result = strlen(cmd.GetTargetModuleIDPtr());
+  for(size_t i = 0;i < cmd.GetArgsCount();i++)
+    result += strlen(cmd.GetArg(i));
+
+  return result;
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  if(argc < 2)
+  {
+    printf("usage: %s corpus.txt [--dump]\n",argv[0]);
+    return 1;
+  }
+
+  std::vector<std::string> lines;
+  if(!LoadCorpus(argv[1],lines))
+  {
+    printf("can't read %s\n",argv[1]);
+    return 1;
+  }
+
+  CommandParser parser;
+  bool dump = argc > 2 && !strcmp(argv[2],"--dump");
+
+  if(dump)
+  {
+    for(size_t i = 0;i < lines.size();i++)
+    {
+      String line = lines[i].c_str();
+      Command cmd;
+      if(!parser.ParseCommand(line,cmd))
+      {
+        printf("REJECTED\n");
+        continue;
+      }
+      printf("%s %s",cmd.GetType() == ctGET ? "GET" : "SET",cmd.GetTargetModuleIDPtr());
+      for(size_t j = 0;j < cmd.GetArgsCount();j++)
+        printf(" [%s]",cmd.GetArg(j));
+      printf("\n");
+    }
+    return 0;
+  }
+
+  const long rounds = 20000;
+  unsigned long totalAllocs = 0;
+  double totalNs = 0;
+
+  printf("CommandParser, %s mode: %u commands, %ld rounds each\n",PARSER_MODE,(unsigned) lines.size(),rounds);
+  printf("%8s %10s  %s\n","allocs","ns/cmd","command");
+
+  for(size_t i = 0;i < lines.size();i++)
+  {
+    String line = lines[i].c_str(); // строка команды уже принята, как в CommandBuffer
+
+    unsigned long allocsBefore = HostHeapAllocations;
+    sink += ParseOnce(parser,line);
+    unsigned long allocs = HostHeapAllocations - allocsBefore;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(long r = 0;r < rounds;r++)
+      sink += ParseOnce(parser,line);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double,std::nano>(end - start).count() / rounds;
+
+    totalAllocs += allocs;
+    totalNs += ns;
+    printf("%8lu %10.1f  %s\n",allocs,ns,lines[i].c_str());
+  }
+
+  printf("average: %.2f allocs/cmd, %.1f ns/cmd\n",(double) totalAllocs / lines.size(),totalNs / lines.size());
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------------------------------------------
+// датчики DS18B20 на одной линии на ПК (USE_DS18B20_BUS): DS18B20Bus с линией-заглушкой из Tests/shim/OneWire.cpp
+// и EEPROM из Tests/shim/EEPROM.cpp. Датчик узнаём по температуре - у каждого своя. Цикл опроса повторяет
+// TempSensors::Update: поиск, если нужен, конвертация, чтение всех индексов, и так каждые TEMP_UPDATE_INTERVAL.
+// Проверяем, что:
+//   - индексы закреплены за адресами и не меняются после перезагрузки, даже если новый датчик идёт в поиске первым
+//   - датчик, которого не было на линии при старте, получает свободный индекс
+//   - датчик, поставленный вместо пропавшего, занимает его индекс, и это тоже переживает перезагрузку
+//   - когда все датчики на месте и свободных индексов нет, линия заново не просматривается
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include "Arduino.h"
+#include "HostShim.h"
+#include "EEPROM.h"
+#include "OneWire.h"
+#include "../../Main/Globals.h"
+#include "../../Main/DS18B20Query.h"
+//----------------------------------------------------------------------------------------------------------------
+#define TEST_PIN A11
+#define TEST_SENSORS 4
+//----------------------------------------------------------------------------------------------------------------
+// младший бит второго байта у D - ноль, поэтому при поиске он находится раньше всех
+static const uint8_t romA[8] = { 0x28, 0x01, 0x10, 0x20, 0x30, 0x40, 0x50, 0 };
+static const uint8_t romB[8] = { 0x28, 0x03, 0x11, 0x21, 0x31, 0x41, 0x51, 0 };
+static const uint8_t romC[8] = { 0x28, 0x05, 0x12, 0x22, 0x32, 0x42, 0x52, 0 };
+static const uint8_t romD[8] = { 0x28, 0x00, 0x13, 0x23, 0x33, 0x43, 0x53, 0 };
+static const uint8_t romE[8] = { 0x28, 0x07, 0x14, 0x24, 0x34, 0x44, 0x54, 0 };
+#define TEMP_A 20
+#define TEMP_B 21
+#define TEMP_C 22
+#define TEMP_D 23
+#define TEMP_E 24
+//----------------------------------------------------------------------------------------------------------------
+static unsigned long cycles = 0;
+//----------------------------------------------------------------------------------------------------------------
+// один проход опроса; temps[i] - целая часть температуры с индекса i или -1, если показаний нет
+static void Cycle(DS18B20Bus& bus, int* temps)
+{
+  if(bus.isSearchNeeded(DS18B20_BUS_SEARCH_INTERVAL) && bus.search())
+    bus.setResolution(temp12bit);
+
+  bus.startConversion();
+  HostAdvanceMicros(1000000UL);
+  bus.isConversionDone();
+
+  for(uint8_t i=0;i<TEST_SENSORS;i++)
+  {
+    DS18B20Temperature t;
+    temps[i] = bus.readTemperature(i,&t) ? t.Whole : -1;
+  }
+
+  HostAdvanceMicros((TEMP_UPDATE_INTERVAL - 1000UL) * 1000UL);
+  cycles++;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Cycles(DS18B20Bus& bus, int* temps, unsigned long ms)
+{
+  for(unsigned long i=0;i<=ms/TEMP_UPDATE_INTERVAL;i++)
+    Cycle(bus,temps);
+}
+//----------------------------------------------------------------------------------------------------------------
+static int IndexOf(const int* temps, int temp)
+{
+  for(uint8_t i=0;i<TEST_SENSORS;i++)
+  {
+    if(temps[i] == temp)
+      return i;
+  }
+  return -1;
+}
+//----------------------------------------------------------------------------------------------------------------
+static int Fail(const char* what, const int* temps)
+{
+  printf("%s: %s; temperatures by index:",__FILE__,what);
+  for(uint8_t i=0;i<TEST_SENSORS;i++)
+    printf(" %d",temps[i]);
+  printf("\n");
+  return 1;
+}
+//----------------------------------------------------------------------------------------------------------------
+int main()
+{
+  HostUseVirtualClock(true);
+  EEPROM.HostErase();
+  HostOneWireClear();
+
+  HostOneWireAttach(TEST_PIN,romA,TEMP_A);
+  HostOneWireAttach(TEST_PIN,romB,TEMP_B);
+  HostOneWireAttach(TEST_PIN,romC,TEMP_C);
+  HostOneWireAttach(TEST_PIN,romE,TEMP_E);
+  HostOneWireSetPresent(romE,false); // E при старте на линии нет
+
+  int temps[TEST_SENSORS] = { -1, -1, -1, -1 };
+
+  // первый старт: три датчика, один индекс свободен
+  DS18B20Bus* bus = new DS18B20Bus;
+  if(bus->begin(TEST_PIN,TEST_SENSORS,DS18B20_BUS_EEPROM_ADDR) != 3)
+    return Fail("3 sensors expected at first boot",temps);
+
+  Cycle(*bus,temps);
+  int idxA = IndexOf(temps,TEMP_A), idxB = IndexOf(temps,TEMP_B), idxC = IndexOf(temps,TEMP_C);
+  if(idxA < 0 || idxB < 0 || idxC < 0 || IndexOf(temps,-1) < 0)
+    return Fail("first boot: A, B, C and one free index expected",temps);
+
+  // E подключили после старта - находится при следующем поиске, остальные индексы не меняются
+  HostOneWireSetPresent(romE,true);
+  Cycles(*bus,temps,DS18B20_BUS_SEARCH_INTERVAL);
+  int idxE = IndexOf(temps,TEMP_E);
+  if(idxE < 0 || IndexOf(temps,TEMP_A) != idxA || IndexOf(temps,TEMP_B) != idxB || IndexOf(temps,TEMP_C) != idxC)
+    return Fail("sensor connected after boot is not found or indices moved",temps);
+
+  // все на месте, свободных индексов нет - линию больше не просматриваем
+  unsigned long steps = HostOneWireSearchSteps;
+  Cycles(*bus,temps,DS18B20_BUS_SEARCH_INTERVAL * 3);
+  if(HostOneWireSearchSteps != steps)
+    return Fail("bus searched again though all sensors answer",temps);
+
+  // перезагрузка: появился D, который в поиске идёт первым, но индексов для него нет - остальные не сдвигаются
+  HostOneWireAttach(TEST_PIN,romD,TEMP_D);
+  unsigned long eepromWrites = EEPROM.HostWrites;
+
+  bus = new DS18B20Bus;
+  bus->begin(TEST_PIN,TEST_SENSORS,DS18B20_BUS_EEPROM_ADDR);
+  Cycle(*bus,temps);
+  if(IndexOf(temps,TEMP_A) != idxA || IndexOf(temps,TEMP_B) != idxB || IndexOf(temps,TEMP_C) != idxC ||
+    IndexOf(temps,TEMP_E) != idxE || EEPROM.HostWrites != eepromWrites)
+    return Fail("indices changed after reboot",temps);
+
+  // A сгорел, вместо него D: A не отвечает - при следующем поиске D получает его индекс
+  HostOneWireSetPresent(romA,false);
+  Cycles(*bus,temps,DS18B20_BUS_SEARCH_INTERVAL);
+  if(IndexOf(temps,TEMP_D) != idxA || IndexOf(temps,TEMP_B) != idxB || IndexOf(temps,TEMP_C) != idxC || IndexOf(temps,TEMP_E) != idxE)
+    return Fail("replacement sensor did not take the index of the missing one",temps);
+
+  // перезагрузка, A снова на линии: индекс остаётся за D, A индекса не получает
+  HostOneWireSetPresent(romA,true);
+  bus = new DS18B20Bus;
+  bus->begin(TEST_PIN,TEST_SENSORS,DS18B20_BUS_EEPROM_ADDR);
+  Cycle(*bus,temps);
+  if(IndexOf(temps,TEMP_D) != idxA || IndexOf(temps,TEMP_B) != idxB || IndexOf(temps,TEMP_C) != idxC ||
+    IndexOf(temps,TEMP_E) != idxE || IndexOf(temps,TEMP_A) >= 0)
+    return Fail("replacement is not kept after reboot",temps);
+
+  printf("DS18B20Bus: indices survive reboots, late and replacement sensors found; %lu search() calls in %lu cycles\n",
+    HostOneWireSearchSteps,cycles);
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,18 @@
+#ifndef _HOST_TEST_CONFIG_H
+#define _HOST_TEST_CONFIG_H
+//----------------------------------------------------------------------------------------------------------------
+// прошивка на ПК: всё железо выключено, оставлены модули, которым хватает часов, SD-карты и EEPROM из Tests/shim
+//----------------------------------------------------------------------------------------------------------------
+#include "../shim/HostConfig.h"
+//----------------------------------------------------------------------------------------------------------------
+#define USE_DS3231_REALTIME_CLOCK
+#define USE_LOG_MODULE
+#define USE_DELTA_MODULE
+#define USE_COMPOSITE_COMMANDS_MODULE
+#define USE_RESERVATION_MODULE
+#define USE_TIMER_MODULE
+#define USE_REMOTE_MODULES // CTSET=0|ADD регистрирует модули на ходу, а с профилировщиком это ещё и проверка того,
+#define USE_LOOP_PROFILER // что ProcessModuleCommand не держит указатель на профиль модуля через RegisterModule
+#define USE_DELTA_STATUS // CTGET=0|DELTA: эпоха загрузки в EEPROM и номер изменения
+//----------------------------------------------------------------------------------------------------------------
+#endif
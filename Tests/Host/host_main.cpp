@@ -0,0 +1,36 @@
+//----------------------------------------------------------------------------------------------------------------
+// прошивка на ПК: Serial подключён к stdin/stdout, так что с контроллером можно говорить через pipe:
+//   printf 'CTGET=0|PING\r\n' | ./greenhouse_host
+// Часы виртуальные: каждый проход loop() - 1 мс. Когда stdin закончился, ещё HOST_IDLE_LOOPS проходов даём
+// модулям доделать начатое и выходим.
+//----------------------------------------------------------------------------------------------------------------
+#include <unistd.h>
+#include "Arduino.h"
+#include "HostShim.h"
+//----------------------------------------------------------------------------------------------------------------
+#define HOST_IDLE_LOOPS 2000
+//----------------------------------------------------------------------------------------------------------------
+void setup();
+void loop();
+//----------------------------------------------------------------------------------------------------------------
+int main()
+{
+  HostUseVirtualClock(true);
+  HostSetRTCTime(2017,6,1,12,0,0);
+  Serial.HostAttach(STDIN_FILENO,STDOUT_FILENO);
+
+  setup();
+
+  unsigned long idleLoops = 0;
+  while(idleLoops < HOST_IDLE_LOOPS)
+  {
+    loop();
+    HostAdvanceMicros(1000);
+
+    if(Serial.HostInputClosed())
+      idleLoops++;
+  }
+
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
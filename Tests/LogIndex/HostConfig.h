@@ -0,0 +1,12 @@
+#ifndef _HOST_TEST_CONFIG_H
+#define _HOST_TEST_CONFIG_H
+//----------------------------------------------------------------------------------------------------------------
+// индекс лога на ПК: часы и модуль логов с индексом .IDX
+//----------------------------------------------------------------------------------------------------------------
+#include "../shim/HostConfig.h"
+//----------------------------------------------------------------------------------------------------------------
+#define USE_DS3231_REALTIME_CLOCK
+#define USE_LOG_MODULE
+#define USE_LOG_INDEX
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,215 @@
+//----------------------------------------------------------------------------------------------------------------
+// индекс лога на ПК: месяц работы LogModule (30 файлов YYYYMMDD.LOG с индексами YYYYMMDD.IDX) на SD-карте из
+// Tests/shim, потом запросы CTGET=LOG|RANGE за разные промежутки времени. Кусок по индексу (GetRangeFromIndex)
+// сверяется со строками полного файла, отфильтрованными по времени, и сравнивается по времени и чтениям с карты
+// с тем, что делает клиент без индекса: CTGET=LOG|FILE и фильтр у себя.
+//   log_index          - куски по индексу совпадают с отфильтрованным полным файлом
+//   log_index --bench  - время и чтения с карты на запрос
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "HostShim.h"
+#include "SD.h"
+#include "../../Main/ModuleController.h"
+#include "../../Main/LogModule.h"
+//----------------------------------------------------------------------------------------------------------------
+#define MONTH_DAYS 30
+//----------------------------------------------------------------------------------------------------------------
+class SensorsStub : public AbstractModule
+{
+  public:
+    SensorsStub(const char* id, ModuleStates type, uint8_t count) : AbstractModule(id), stateType(type), sensorsCount(count)
+    {
+      for(uint8_t i=0;i<sensorsCount;i++)
+        State.AddState(stateType,i);
+    }
+    bool ExecCommand(const Command&, bool) { return true; }
+    void Setup() {}
+    void Update(uint16_t) {}
+
+    void SetValues(unsigned long step)
+    {
+      for(uint8_t i=0;i<sensorsCount;i++)
+      {
+        Temperature t((int8_t)(15 + (step + i * 3) % 20),(uint8_t)((step * 7 + i) % 100));
+        State.UpdateState(stateType,i,(void*)&t);
+      }
+    }
+
+  private:
+    ModuleStates stateType;
+    uint8_t sensorsCount;
+};
+//----------------------------------------------------------------------------------------------------------------
+static ModuleController* controller;
+static LogModule* logModule;
+//----------------------------------------------------------------------------------------------------------------
+// данные из ответа OK=FOLLOW|...\r\n<данные>OK=LOG|END_OF_FILE...\r\n
+static std::string Request(const std::string& args)
+{
+  Serial.HostClearOutput();
+
+  Command cmd;
+  cmd.Construct("LOG",args.c_str(),ctGET);
+  cmd.SetIncomingStream(&Serial);
+  controller->ProcessModuleCommand(cmd,logModule);
+
+  std::string answer(Serial.HostOutput(),Serial.HostOutputLength());
+  size_t dataStart = answer.find("\r\n");
+  size_t dataEnd = answer.rfind("\r\nOK=");
+  if(answer.compare(0,9,"OK=FOLLOW") || dataStart == std::string::npos || dataEnd == std::string::npos)
+  {
+    printf("unexpected answer to %s: %s\n",args.c_str(),answer.substr(0,80).c_str());
+    exit(1);
+  }
+  dataStart += 2;
+  dataEnd += 2;
+  return answer.substr(dataStart,dataEnd - dataStart);
+}
+//----------------------------------------------------------------------------------------------------------------
+// строки лога, у которых интервал индекса попадает в запрошенный промежуток - столько должен отдать RANGE
+static std::string Filter(const std::string& log, int fromMinutes, int toMinutes)
+{
+  int fromBucket = fromMinutes / LOG_INDEX_BUCKET_MINUTES;
+  int toBucket = toMinutes / LOG_INDEX_BUCKET_MINUTES;
+  std::string result;
+
+  for(size_t pos = 0;pos < log.size();)
+  {
+    size_t end = log.find("\r\n",pos);
+    end = (end == std::string::npos) ? log.size() : end + 2;
+
+    int bucket = (atoi(log.c_str() + pos) * 60 + atoi(log.c_str() + pos + 3)) / LOG_INDEX_BUCKET_MINUTES;
+    if(bucket >= fromBucket && bucket <= toBucket)
+      result.append(log,pos,end - pos);
+
+    pos = end;
+  }
+  return result;
+}
+//----------------------------------------------------------------------------------------------------------------
+struct Query
+{
+  const char* name;
+  int fromMinutes;
+  int toMinutes;
+};
+//----------------------------------------------------------------------------------------------------------------
+static const Query queries[] =
+{
+  { "00:00-00:14", 0, 14 },
+  { "12:07-12:07", 12*60 + 7, 12*60 + 7 },
+  { "12:00-12:59", 12*60, 12*60 + 59 },
+  { "23:00-23:59", 23*60, 23*60 + 59 },
+  { "06:00-17:59", 6*60, 17*60 + 59 },
+  { "00:00-23:59", 0, 23*60 + 59 },
+};
+static const size_t queriesCount = sizeof(queries)/sizeof(queries[0]);
+//----------------------------------------------------------------------------------------------------------------
+static std::string DayName(int day)
+{
+  char buf[16];
+  sprintf(buf,"201706%02d",day);
+  return buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+static std::string RangeArgs(int day, const Query& q)
+{
+  char buf[64];
+  sprintf(buf,"RANGE|%s|%02d:%02d|%02d:%02d",DayName(day).c_str(),q.fromMinutes/60,q.fromMinutes%60,q.toMinutes/60,q.toMinutes%60);
+  return buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool bench = argc > 1 && !strcmp(argv[1],"--bench");
+
+  HostUseVirtualClock(true);
+  HostSDFormat();
+  HostSetRTCTime(2017,6,1,0,0,0);
+
+  controller = new ModuleController();
+  controller->Setup();
+
+  SensorsStub temperatures("STATE",StateTemperature,12);
+  SensorsStub humidities("HUMIDITY",StateHumidity,6);
+  logModule = new LogModule();
+
+  controller->RegisterModule(&temperatures);
+  controller->RegisterModule(&humidities);
+  controller->RegisterModule(logModule);
+  controller->begin();
+
+  // месяц замеров раз в LOGGING_INTERVAL, Update - раз в минуту (dt у Update - uint16_t)
+  const unsigned long stepMs = 60000UL;
+  const unsigned long steps = MONTH_DAYS * 1440UL;
+  for(unsigned long step=1;step<=steps;step++)
+  {
+    HostAdvanceMicros(stepMs * 1000UL);
+    temperatures.SetValues(step);
+    humidities.SetValues(step);
+    logModule->Update(stepMs);
+  }
+
+  // закончили на полуночи 1 июля - все 30 файлов июня закрыты
+  if(!bench)
+  {
+    unsigned checked = 0;
+    for(int day=1;day<=MONTH_DAYS;day++)
+    {
+      std::string log = Request("FILE|" + DayName(day) + ".LOG");
+      if(log.empty())
+      {
+        printf("FAIL %s.LOG is empty\n",DayName(day).c_str());
+        return 1;
+      }
+
+      for(size_t q=0;q<queriesCount;q++)
+      {
+        std::string args = RangeArgs(day,queries[q]);
+        if(Request(args) != Filter(log,queries[q].fromMinutes,queries[q].toMinutes))
+        {
+          printf("FAIL %s: slice differs from the filtered log\n",args.c_str());
+          return 1;
+        }
+        checked++;
+      }
+    }
+
+    printf("LogIndex: %u RANGE requests over %d days match the filtered logs\n",checked,MONTH_DAYS);
+    return 0;
+  }
+
+  printf("%d days, %u bytes of log per day, index record every %d minutes\n",MONTH_DAYS,(unsigned) Request("FILE|20170615.LOG").size(),LOG_INDEX_BUCKET_MINUTES);
+  printf("%-12s %10s %10s %10s %10s %10s\n","request","bytes sent","SD read","index read","sec.reads","us/request");
+
+  const int rounds = 20;
+  for(size_t q=0;q<=queriesCount;q++)
+  {
+    bool full = (q == queriesCount); // без индекса: весь файл, фильтр - у клиента
+    double totalNs = 0;
+    unsigned long sent = 0;
+    HostSDResetStats();
+
+    for(int r=0;r<rounds;r++)
+    {
+      for(int day=1;day<=MONTH_DAYS;day++)
+      {
+        std::string args = full ? "FILE|" + DayName(day) + ".LOG" : RangeArgs(day,queries[q]);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sent += Request(args).size();
+        totalNs += std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - start).count();
+      }
+    }
+
+    unsigned long requests = rounds * MONTH_DAYS;
+    printf("%-12s %10lu %10lu %10lu %10.1f %10.1f\n",full ? "FILE" : queries[q].name,sent / requests,HostSD.bytesRead / requests,
+      (HostSD.bytesRead - sent) / requests,(double) HostSD.sectorReads / requests,totalNs / requests / 1000.0);
+  }
+
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
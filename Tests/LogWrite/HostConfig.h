@@ -0,0 +1,11 @@
+#ifndef _HOST_TEST_CONFIG_H
+#define _HOST_TEST_CONFIG_H
+//----------------------------------------------------------------------------------------------------------------
+// запись лога на ПК: часы и модуль логов, буфер записи (USE_LOG_WRITE_BUFFER) включает Makefile для одной из сборок
+//----------------------------------------------------------------------------------------------------------------
+#include "../shim/HostConfig.h"
+//----------------------------------------------------------------------------------------------------------------
+#define USE_DS3231_REALTIME_CLOCK
+#define USE_LOG_MODULE
+//----------------------------------------------------------------------------------------------------------------
+#endif
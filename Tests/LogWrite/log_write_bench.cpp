@@ -0,0 +1,151 @@
+//----------------------------------------------------------------------------------------------------------------
+// запись лога на ПК: сутки работы LogModule с интервалом LOGGING_INTERVAL на SD-карте из Tests/shim, которая
+// считает вызовы и операции с секторами (см. SD.h). Датчики - заглушки: 12 температур, 6 влажностей, 4 освещённости.
+// Makefile собирает две версии - без буфера записи и с USE_LOG_WRITE_BUFFER:
+//   log_write_* --dump   - законченные за сутки файлы в папке логов (у обеих сборок должны совпадать)
+//   log_write_* --bench  - усиление записи (байт в записанных секторах на байт данных) и время сбора показаний
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <chrono>
+#include "Arduino.h"
+#include "HostShim.h"
+#include "SD.h"
+#include "../../Main/ModuleController.h"
+#include "../../Main/LogModule.h"
+//----------------------------------------------------------------------------------------------------------------
+#ifdef USE_LOG_WRITE_BUFFER
+#define WRITE_MODE "buffered"
+#else
+#define WRITE_MODE "flush per line"
+#endif
+//----------------------------------------------------------------------------------------------------------------
+class SensorsStub : public AbstractModule
+{
+  public:
+    SensorsStub(const char* id, ModuleStates type, uint8_t count) : AbstractModule(id), stateType(type), sensorsCount(count)
+    {
+      for(uint8_t i=0;i<sensorsCount;i++)
+        State.AddState(stateType,i);
+    }
+    bool ExecCommand(const Command&, bool) { return true; }
+    void Setup() {}
+    void Update(uint16_t) {}
+
+    void SetValues(unsigned long step) // показания меняются от замера к замеру, но одинаково в обеих сборках
+    {
+      for(uint8_t i=0;i<sensorsCount;i++)
+      {
+        if(stateType == StateLuminosity)
+        {
+          long lux = (step * 37 + i * 101) % 20000;
+          State.UpdateState(stateType,i,(void*)&lux);
+        }
+        else
+        {
+          Temperature t((int8_t)(15 + (step + i * 3) % 20),(uint8_t)((step * 7 + i) % 100));
+          State.UpdateState(stateType,i,(void*)&t);
+        }
+      }
+    }
+
+  private:
+    ModuleStates stateType;
+    uint8_t sensorsCount;
+};
+//----------------------------------------------------------------------------------------------------------------
+// файл текущих суток открыт, и с буфером записи его хвост до LOG_FLUSH_INTERVAL лежит в ОЗУ - сверяем только законченные
+static void Dump(const String& path, const char* skipPrefix)
+{
+  File dir = SD.open(path);
+  while(true)
+  {
+    File entry = dir.openNextFile();
+    if(!entry)
+      break;
+
+    String entryPath = path + "/" + entry.name();
+    if(entry.isDirectory())
+    {
+      Dump(entryPath,skipPrefix);
+      continue;
+    }
+
+    if(!strncmp(entry.name(),skipPrefix,strlen(skipPrefix)))
+      continue;
+
+    printf("=== %s, %u bytes\n",entryPath.c_str(),(unsigned) entry.size());
+    int ch;
+    while((ch = entry.read()) != -1)
+      putchar(ch);
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool dump = argc > 1 && !strcmp(argv[1],"--dump");
+
+  HostUseVirtualClock(true);
+  HostSDFormat();
+  HostSetRTCTime(2017,6,1,0,0,0); // часы идут вместе с виртуальным millis()
+
+  ModuleController controller;
+  controller.Setup();
+
+  SensorsStub temperatures("STATE",StateTemperature,12);
+  SensorsStub humidities("HUMIDITY",StateHumidity,6);
+  SensorsStub lights("LIGHT",StateLuminosity,4);
+  LogModule logModule;
+
+  controller.RegisterModule(&temperatures);
+  controller.RegisterModule(&humidities);
+  controller.RegisterModule(&lights);
+  controller.RegisterModule(&logModule);
+  controller.begin();
+
+  HostSDResetStats();
+
+  // loop() зовёт Update модуля с dt в пару мс, здесь - раз в минуту: dt - uint16_t, а между замерами LOGGING_INTERVAL мс.
+  // Гоняем сутки и ещё один интервал: первый замер следующих суток открывает новый файл, старый сливается на карту
+  const unsigned long stepMs = 60000UL;
+  const unsigned long steps = (86400000UL + LOGGING_INTERVAL) / stepMs;
+  const unsigned long gathers = steps / (LOGGING_INTERVAL / stepMs);
+
+  double totalNs = 0, maxNs = 0;
+  unsigned long maxSectorOps = 0;
+
+  for(unsigned long step=1;step<=steps;step++)
+  {
+    HostAdvanceMicros(stepMs * 1000UL);
+    temperatures.SetValues(step);
+    humidities.SetValues(step);
+    lights.SetValues(step);
+
+    unsigned long sectorOps = HostSD.sectorReads + HostSD.sectorWrites;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    logModule.Update(stepMs);
+
+    double ns = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - start).count();
+    sectorOps = HostSD.sectorReads + HostSD.sectorWrites - sectorOps;
+
+    totalNs += ns;
+    if(ns > maxNs)
+      maxNs = ns;
+    if(sectorOps > maxSectorOps)
+      maxSectorOps = sectorOps;
+  }
+
+  if(dump)
+  {
+    Dump("logs","20170602");
+    return 0;
+  }
+
+  printf("%-15s %6lu %9lu %7lu %7lu %7lu %7.2f %7.1f %7lu %9.0f %9.0f\n",WRITE_MODE,gathers,HostSD.bytesWritten,
+    HostSD.sectorWrites,HostSD.sectorReads,HostSD.flushes,
+    (double) HostSD.sectorWrites * HOST_SD_SECTOR_SIZE / HostSD.bytesWritten,
+    (double) (HostSD.sectorWrites + HostSD.sectorReads) / gathers,maxSectorOps,totalNs / gathers,maxNs);
+
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,199 @@
+//----------------------------------------------------------------------------------------------------------------
+// замер поиска модулей на ПК: как было (перебор списка со strcmp) и как стало (двоичный поиск по отсортированным
+// ID в GetModuleByID и готовый ModuleHandle в GetModuleByHandle), плюс цена сортированной вставки в RegisterModule.
+// Модули - пустышки с ID настоящих модулей прошивки в порядке их регистрации в Main.ino; для 64, 128 и 250
+// модулей добавляются зарегистрированные на лету (CTSET=0|ADD). На ПК важно соотношение, а не абсолютные цифры.
+//   make        - проверить, что двоичный поиск находит то же, что и перебор
+//   make bench  - таблица
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "Arduino.h"
+#include "../../Main/ModuleController.h"
+//----------------------------------------------------------------------------------------------------------------
+class DummyModule : public AbstractModule
+{
+  public:
+    DummyModule(const char* id) : AbstractModule(id) {}
+    bool ExecCommand(const Command&, bool) { return true; }
+    void Setup() {}
+    void Update(uint16_t) {}
+};
+//----------------------------------------------------------------------------------------------------------------
+// модули прошивки в порядке регистрации в setup()
+static const char* firmwareIDs[] = { "PIN", "LOOP", "STAT", "STATE", "WATER", "LIGHT", "HUMIDITY", "DELTA", "HIST",
+  "LCD", "NXT", "FLOW", "CC", "SOIL", "PH", "LAN", "RSRV", "TMR", "LOG", "WIFI", "SMS", "IOT", "0", "ALERT" };
+static const size_t firmwareCount = sizeof(firmwareIDs)/sizeof(firmwareIDs[0]);
+//----------------------------------------------------------------------------------------------------------------
+static volatile uintptr_t sink;
+//----------------------------------------------------------------------------------------------------------------
+// поиск модуля до сортированного списка - как было в ModuleController::GetModuleByID
+static AbstractModule* LinearGetModuleByID(ModuleController& controller, const char* id)
+{
+  size_t sz = controller.GetModulesCount();
+  for(size_t i=0;i<sz;i++)
+  {
+    AbstractModule* mod = controller.GetModule(i);
+    if(!strcmp(mod->GetID(),id) )
+      return mod;
+  }
+  return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void MakeIDs(size_t count, std::vector<std::string>& ids)
+{
+  ids.clear();
+  for(size_t i = 0;i < count;i++)
+  {
+    if(i < firmwareCount)
+      ids.push_back(firmwareIDs[i]);
+    else
+    {
+      char buf[16];
+      sprintf(buf,"EXT%03u",(unsigned) i);
+      ids.push_back(buf);
+    }
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+// модули лежат в mods, контроллер хранит указатели на них - поэтому память под mods выделяем заранее
+static void Register(ModuleController& controller, std::vector<DummyModule>& mods, const std::vector<std::string>& ids)
+{
+  mods.reserve(ids.size());
+  for(size_t i = 0;i < ids.size();i++)
+    mods.push_back(DummyModule(ids[i].c_str()));
+
+  for(size_t i = 0;i < mods.size();i++)
+    controller.RegisterModule(&mods[i]);
+}
+//----------------------------------------------------------------------------------------------------------------
+template<typename F> static double NsPerCall(F func, long rounds)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(long r = 0;r < rounds;r++)
+    func();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double,std::nano>(end - start).count() / rounds;
+}
+//----------------------------------------------------------------------------------------------------------------
+static bool Check(size_t count)
+{
+  std::vector<std::string> ids;
+  MakeIDs(count,ids);
+  ModuleController controller;
+  std::vector<DummyModule> mods;
+  Register(controller,mods,ids);
+
+  for(size_t i = 0;i < ids.size();i++)
+  {
+    const char* id = ids[i].c_str();
+    ModuleHandle h = controller.GetModuleHandle(id);
+    if(controller.GetModuleByID(id) != LinearGetModuleByID(controller,id) || controller.GetModuleByHandle(h) != &mods[i])
+    {
+      printf("%u modules: lookup of %s differs\n",(unsigned) count,id);
+      return false;
+    }
+  }
+
+  if(controller.GetModuleByID("NOSUCH") || controller.GetModuleHandle("NOSUCH") != NO_MODULE_HANDLE || controller.GetModuleByID(""))
+  {
+    printf("%u modules: unknown module found\n",(unsigned) count);
+    return false;
+  }
+  return true;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Bench(size_t count)
+{
+  std::vector<std::string> ids;
+  MakeIDs(count,ids);
+
+  ModuleController controller;
+  std::vector<DummyModule> mods;
+  Register(controller,mods,ids);
+
+  // ищем каждый модуль по очереди и один несуществующий - как приходят команды
+  std::vector<std::string> queries = ids;
+  queries.push_back("NOSUCH");
+  std::vector<ModuleHandle> handles;
+  for(size_t i = 0;i < ids.size();i++)
+    handles.push_back(controller.GetModuleHandle(ids[i].c_str()));
+
+  const long rounds = 2000000L / queries.size() + 1;
+  size_t qn = queries.size();
+
+  double linear = NsPerCall([&]() { for(size_t i = 0;i < qn;i++) sink += (uintptr_t) LinearGetModuleByID(controller,queries[i].c_str()); },rounds) / qn;
+  double binary = NsPerCall([&]() { for(size_t i = 0;i < qn;i++) sink += (uintptr_t) controller.GetModuleByID(queries[i].c_str()); },rounds) / qn;
+  double byHandle = NsPerCall([&]() { for(size_t i = 0;i < handles.size();i++) sink += (uintptr_t) controller.GetModuleByHandle(handles[i]); },rounds) / handles.size();
+
+  // полный путь команды: ProcessModuleCommand ищет модуль сам, или ему передают найденный заранее
+  Command cmd;
+  cmd.Construct(ids[count/2].c_str(),"PING",ctGET);
+  AbstractModule* target = controller.GetModuleByID(ids[count/2].c_str());
+  double dispatchLinear = NsPerCall([&]() { controller.ProcessModuleCommand(cmd,LinearGetModuleByID(controller,cmd.GetTargetModuleIDPtr())); },200000L);
+  double dispatchSorted = NsPerCall([&]() { controller.ProcessModuleCommand(cmd); },200000L);
+  double dispatchHandle = NsPerCall([&]() { controller.ProcessModuleCommand(cmd,target); },200000L);
+
+  // вставка: ID по возрастанию - без сдвигов, по убыванию - каждый новый модуль сдвигает весь список
+  std::vector<std::string> ascending = ids;
+  std::sort(ascending.begin(),ascending.end());
+  std::vector<std::string> descending(ascending.rbegin(),ascending.rend());
+
+  double regOrder = 0, regAsc = 0, regDesc = 0;
+  const int regRounds = 2000;
+  for(int r = 0;r < regRounds;r++)
+  {
+    const std::vector<std::string>* orders[3] = { &ids, &ascending, &descending };
+    double* results[3] = { &regOrder, &regAsc, &regDesc };
+    for(int o = 0;o < 3;o++)
+    {
+      ModuleController c;
+      std::vector<DummyModule> local;
+      local.reserve(count);
+      for(size_t i = 0;i < count;i++)
+        local.push_back(DummyModule((*orders[o])[i].c_str()));
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for(size_t i = 0;i < count;i++)
+        c.RegisterModule(&local[i]);
+      std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+      *results[o] += std::chrono::duration<double,std::nano>(end - start).count() / count;
+    }
+  }
+
+  printf("%7u %10.1f %10.1f %10.1f | %10.1f %10.1f %10.1f | %10.1f %10.1f %10.1f\n",(unsigned) count,
+    linear,binary,byHandle,dispatchLinear,dispatchSorted,dispatchHandle,
+    regOrder/regRounds,regAsc/regRounds,regDesc/regRounds);
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  static const size_t counts[] = { firmwareCount, 64, 128, 250 };
+  bool bench = argc > 1 && !strcmp(argv[1],"--bench");
+
+  for(size_t i = 0;i < sizeof(counts)/sizeof(counts[0]);i++)
+  {
+    if(!Check(counts[i]))
+      return 1;
+  }
+
+  if(!bench)
+  {
+    printf("ModuleDispatch: binary search and handles match the linear lookup\n");
+    return 0;
+  }
+
+  printf("ns per call; lookup of every module plus one unknown ID, dispatch of CTGET=<middle module>|PING,\n");
+  printf("RegisterModule per module: firmware order / IDs ascending / IDs descending\n");
+  printf("%7s %10s %10s %10s | %10s %10s %10s | %10s %10s %10s\n","modules","linear","binary","handle",
+    "disp.lin","disp.bin","disp.hnd","reg.order","reg.asc","reg.desc");
+
+  for(size_t i = 0;i < sizeof(counts)/sizeof(counts[0]);i++)
+    Bench(counts[i]);
+
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
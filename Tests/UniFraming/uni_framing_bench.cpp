@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------------------------------------------------
+// замер скорости CRC8 на ПК, нс/байт: побитовый расчёт и UniCrc8 с той таблицей, с которой собран файл.
+// На ПК важно соотношение, а не абсолютные цифры - на AVR всё медленнее, но порядок тот же.
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "../../Main/UniFraming.h"
+//----------------------------------------------------------------------------------------------------------------
+static uint8_t BitwiseCrc8(const uint8_t* data, uint16_t len)
+{
+  uint8_t crc = 0;
+  while(len--)
+  {
+    uint8_t inbyte = *data++;
+    for(uint8_t i=8;i;i--)
+    {
+      uint8_t mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if(mix)
+        crc ^= 0x8C;
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+static volatile uint8_t sink; // чтобы компилятор не выкинул расчёт
+//----------------------------------------------------------------------------------------------------------------
+template<typename F> static double Measure(F func, const uint8_t* buffer, uint16_t len, long rounds)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(long i=0;i<rounds;i++)
+    sink ^= func(buffer,len);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double,std::nano>(end - start).count();
+  return ns/((double) rounds*len);
+}
+//----------------------------------------------------------------------------------------------------------------
+static uint8_t TableCrc8(const uint8_t* data, uint16_t len)
+{
+  return UniCrc8(data,len);
+}
+//----------------------------------------------------------------------------------------------------------------
+int main()
+{
+  // пакет RS-485 - 30 байт, пакет nRF - 32 байта; берём 32
+  uint8_t buffer[32];
+  for(uint8_t i=0;i<sizeof(buffer);i++)
+    buffer[i] = (uint8_t) rand();
+
+  const long rounds = 2000000L;
+
+#ifdef UNI_CRC8_FULL_TABLE
+  const char* table = "256-byte table";
+#else
+  const char* table = "nibble table";
+#endif
+
+  double bitwise = Measure(BitwiseCrc8,buffer,sizeof(buffer),rounds);
+  double tabled = Measure(TableCrc8,buffer,sizeof(buffer),rounds);
+
+  printf("bitwise loop:   %.2f ns/byte\n",bitwise);
+  printf("%-15s %.2f ns/byte (x%.1f)\n",table,tabled,bitwise/tabled);
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
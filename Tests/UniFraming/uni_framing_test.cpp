@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------------------------------------------
+// проверка UniFraming.h на ПК: табличная CRC8 сверяется с побитовым расчётом, которым CRC считалась раньше
+// (OneWire::crc8 / OneWireSlave::crc8), плюс обрамление пакетов RS-485.
+// Собирается дважды - с таблицей на полбайта и с UNI_CRC8_FULL_TABLE, см. Makefile.
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../Main/UniFraming.h"
+//----------------------------------------------------------------------------------------------------------------
+static uint8_t ReferenceCrc8(const uint8_t* data, uint16_t len) // побитовый расчёт, как в библиотеке OneWire
+{
+  uint8_t crc = 0;
+  while(len--)
+  {
+    uint8_t inbyte = *data++;
+    for(uint8_t i=8;i;i--)
+    {
+      uint8_t mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if(mix)
+        crc ^= 0x8C;
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+//----------------------------------------------------------------------------------------------------------------
+#pragma pack(push,1)
+typedef struct
+{
+  uint8_t header1;
+  uint8_t header2;
+  uint8_t direction;
+  uint8_t type;
+  uint8_t data[23];
+  uint8_t tail1;
+  uint8_t tail2;
+  uint8_t crc8;
+
+} TestPacket; // раскладка как у пакета RS-485 в UniversalSensors.h
+#pragma pack(pop)
+//----------------------------------------------------------------------------------------------------------------
+static int failures = 0;
+#define CHECK(cond) do { if(!(cond)) { printf("FAILED: %s (line %d)\n", #cond, __LINE__); failures++; } } while(0)
+//----------------------------------------------------------------------------------------------------------------
+static void TestKnownValues()
+{
+  // ROM-адрес из даташита DS18B20 (пример Maxim AN27): CRC первых 7 байт равна восьмому
+  const uint8_t rom[8] = { 0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2 };
+  CHECK(UniCrc8(rom,7) == rom[7]);
+  CHECK(UniCrc8(rom,8) == 0); // CRC блока вместе с его CRC - ноль
+  CHECK(UniCrc8(rom,0) == 0);
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestRandomBuffers()
+{
+  uint8_t buffer[64];
+  srand(12345);
+
+  for(long i=0;i<100000L;i++)
+  {
+    uint16_t len = rand() % (sizeof(buffer) + 1);
+    for(uint16_t k=0;k<len;k++)
+      buffer[k] = (uint8_t) rand();
+
+    uint8_t expected = ReferenceCrc8(buffer,len);
+    CHECK(UniCrc8(buffer,len) == expected);
+
+    // продолжение расчёта по частям даёт то же, что и расчёт за один раз
+    uint16_t split = len ? rand() % len : 0;
+    CHECK(UniCrc8(buffer + split,len - split,UniCrc8(buffer,split)) == expected);
+
+    if(failures > 10)
+      return;
+  }
+
+  // все значения одного байта после любого значения CRC
+  for(uint16_t crc=0;crc<256;crc++)
+    for(uint16_t b=0;b<256;b++)
+    {
+      uint8_t one = (uint8_t) b;
+      uint8_t expected = crc;
+      // побитовый расчёт с заданным начальным значением
+      for(uint8_t i=0, inbyte=one;i<8;i++, inbyte >>= 1)
+      {
+        uint8_t mix = (expected ^ inbyte) & 0x01;
+        expected >>= 1;
+        if(mix)
+          expected ^= 0x8C;
+      }
+      CHECK(UniCrc8Update((uint8_t) crc,one) == expected);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestFraming()
+{
+  TestPacket packet;
+  memset(&packet,0,sizeof(packet));
+  packet.direction = 1;
+  packet.type = 3;
+  for(uint8_t i=0;i<sizeof(packet.data);i++)
+    packet.data[i] = i*7;
+
+  UniFramePacket(packet);
+  CHECK(packet.header1 == UNI_PACKET_HEADER1 && packet.header2 == UNI_PACKET_HEADER2);
+  CHECK(packet.tail1 == UNI_PACKET_TAIL1 && packet.tail2 == UNI_PACKET_TAIL2);
+  CHECK(packet.crc8 == ReferenceCrc8((const uint8_t*) &packet,sizeof(packet)-1));
+  CHECK(UniIsPacketValid(packet));
+
+  // любой испорченный байт ловится
+  uint8_t* raw = (uint8_t*) &packet;
+  for(uint8_t i=0;i<sizeof(packet);i++)
+  {
+    raw[i] ^= 0x10;
+    CHECK(!UniIsPacketValid(packet));
+    raw[i] ^= 0x10;
+  }
+  CHECK(UniIsPacketValid(packet));
+
+  packet.header2 = 0;
+  UniSetCrc(packet); // CRC верная, но заголовок - нет
+  CHECK(UniIsCrcValid(packet));
+  CHECK(!UniHasPacketHeader(packet));
+  CHECK(!UniIsPacketValid(packet));
+}
+//----------------------------------------------------------------------------------------------------------------
+int main()
+{
+  TestKnownValues();
+  TestRandomBuffers();
+  TestFraming();
+
+#ifdef UNI_CRC8_FULL_TABLE
+  const char* table = "256-byte table";
+#else
+  const char* table = "nibble table";
+#endif
+
+  if(failures)
+  {
+    printf("UniFraming (%s): %d check(s) failed\n",table,failures);
+    return 1;
+  }
+
+  printf("UniFraming (%s): OK\n",table);
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,271 @@
+//----------------------------------------------------------------------------------------------------------------
+// проверка WiFiByteParser.h на ПК: записанный поток от ESP8266 прогоняется через побайтовый разбор так же,
+// как это делают WiFiModule::ProcessIncomingByte и TCPClient::CommandRequested, и сверяются строки ответов
+// и команды, которые получили клиенты.
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "../../Main/WiFiByteParser.h"
+//----------------------------------------------------------------------------------------------------------------
+#define MAX_WIFI_CLIENTS 4
+//----------------------------------------------------------------------------------------------------------------
+struct TestClient // то, что делает с данными пакета TCPClient
+{
+  std::string holder;
+  bool hasFullCommand;
+  bool lastWasCR;
+  std::vector<std::string> commands;
+
+  TestClient() : hasFullCommand(false), lastWasCR(false) {}
+
+  void CommandRequested(char ch)
+  {
+    if(hasFullCommand) // предыдущая команда ещё не обработана
+      return;
+
+    uint8_t what = WiFiClassifyCommandByte(ch,lastWasCR);
+    if(what == wcbEndOfCommand)
+      hasFullCommand = true;
+    else
+    if(what == wcbAppend)
+      holder += ch;
+  }
+
+  void Update() // клиент выполняет полученную команду
+  {
+    if(!hasFullCommand)
+      return;
+
+    commands.push_back(holder);
+    holder.clear();
+    hasFullCommand = false;
+  }
+};
+//----------------------------------------------------------------------------------------------------------------
+struct TestSession // то, что делает с потоком WiFiModule
+{
+  WiFiByteParser parser;
+  TestClient clients[MAX_WIFI_CLIENTS];
+  std::vector<std::string> lines;
+  uint8_t ipdClientID;
+  bool waitForDataWelcome;
+  int welcomes;
+
+  TestSession() : ipdClientID(MAX_WIFI_CLIENTS), waitForDataWelcome(false), welcomes(0) {}
+
+  void Feed(char ch)
+  {
+    switch(parser.Feed(ch,waitForDataWelcome))
+    {
+      case wbrIPDData:
+        if(ipdClientID < MAX_WIFI_CLIENTS)
+          clients[ipdClientID].CommandRequested(ch);
+      break;
+
+      case wbrIPDHeader:
+      {
+        int clientID = parser.GetIPDClientID();
+        lines.push_back(parser.GetLine());
+        ipdClientID = (clientID >= 0 && clientID < MAX_WIFI_CLIENTS) ? clientID : MAX_WIFI_CLIENTS;
+      }
+      break;
+
+      case wbrLine:
+        lines.push_back(parser.GetLine());
+      break;
+
+      case wbrDataWelcome:
+        waitForDataWelcome = false;
+        welcomes++;
+      break;
+    }
+  }
+
+  // кусок потока, прочитанный из Serial за один вызов; между кусками клиенты успевают выполнить команды
+  void Replay(const std::string& chunk)
+  {
+    for(size_t i=0;i<chunk.size();i++)
+      Feed(chunk[i]);
+
+    for(uint8_t i=0;i<MAX_WIFI_CLIENTS;i++)
+      clients[i].Update();
+  }
+};
+//----------------------------------------------------------------------------------------------------------------
+static int failures = 0;
+#define CHECK(cond) do { if(!(cond)) { printf("FAILED: %s (line %d)\n", #cond, __LINE__); failures++; } } while(0)
+//----------------------------------------------------------------------------------------------------------------
+static bool SameCommands(const TestClient& c, const char* first, const char* second = NULL)
+{
+  size_t expected = second ? 2 : (first ? 1 : 0);
+  if(c.commands.size() != expected)
+    return false;
+
+  if(first && c.commands[0] != first)
+    return false;
+
+  if(second && c.commands[1] != second)
+    return false;
+
+  return true;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestCrLfCommand()
+{
+  TestSession s;
+  s.Replay("0,CONNECT\r\n\r\n+IPD,0,14:CTGET=0|STAT\r\n");
+
+  CHECK(s.lines.size() == 3);
+  CHECK(s.lines.size() > 0 && s.lines[0] == "0,CONNECT");
+  CHECK(s.lines.size() > 1 && s.lines[1] == "");
+  CHECK(s.lines.size() > 2 && s.lines[2] == "+IPD,0,14:");
+  CHECK(SameCommands(s.clients[0],"CTGET=0|STAT"));
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestLfOnlyCommand()
+{
+  // клиенты, которые шлют только \n, раньше так и не получали ответа
+  TestSession s;
+  s.Replay("+IPD,1,13:CTGET=0|STAT\n");
+  s.Replay("+IPD,1,13:CTGET=0|LIST\n");
+
+  CHECK(SameCommands(s.clients[1],"CTGET=0|STAT","CTGET=0|LIST"));
+  CHECK(s.clients[0].commands.empty());
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestCrOnlyCommand()
+{
+  TestSession s;
+  s.Replay("+IPD,2,13:CTGET=0|STAT\r");
+  s.Replay("+IPD,2,13:CTGET=0|LIST\r");
+
+  CHECK(SameCommands(s.clients[2],"CTGET=0|STAT","CTGET=0|LIST"));
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestSplitCommand()
+{
+  // команда пришла несколькими пакетами, а пакет - несколькими кусками из Serial
+  TestSession s;
+  s.Replay("+IPD,0,6:CTGET=");
+  CHECK(s.clients[0].commands.empty());
+  s.Replay("+IPD,0,8:0|S");
+  s.Replay("TAT\r\n");
+
+  CHECK(SameCommands(s.clients[0],"CTGET=0|STAT"));
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestCrLfInSeparatePackets()
+{
+  // \r и \n пришли разными пакетами, а между ними клиент успел выполнить команду - пустой команды быть не должно
+  TestSession s;
+  s.Replay("+IPD,3,13:CTGET=0|STAT\r");
+  s.Replay("+IPD,3,1:\n");
+  s.Replay("+IPD,3,14:CTGET=0|LIST\r\n");
+
+  CHECK(SameCommands(s.clients[3],"CTGET=0|STAT","CTGET=0|LIST"));
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestBinarySafePayload()
+{
+  // внутри данных пакета - то, что в строках ответа имеет смысл: заголовок +IPD, приглашение >, двоеточия
+  TestSession s;
+  s.waitForDataWelcome = true;
+
+  std::string payload = "CTSET=X|+IPD,1,2:>|a>b";
+  payload += '\0';
+  payload += "\x81\xFF\r\n";
+  char header[32];
+  sprintf(header,"+IPD,0,%u:",(unsigned) payload.size());
+
+  s.Replay(std::string(header) + payload + "\r\nOK\r\n");
+
+  std::string expected = "CTSET=X|+IPD,1,2:>|a>b";
+  expected += '\0';
+  expected += "\x81\xFF";
+
+  CHECK(s.clients[0].commands.size() == 1);
+  CHECK(s.clients[0].commands.size() == 1 && s.clients[0].commands[0] == expected);
+  CHECK(s.clients[1].commands.empty());
+  CHECK(s.welcomes == 0);
+  CHECK(s.waitForDataWelcome);
+
+  // после пакета строки снова разбираются как строки
+  CHECK(s.lines.size() == 3 && s.lines[1] == "" && s.lines[2] == "OK");
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestDataWelcome()
+{
+  TestSession s;
+  s.Replay("AT+CIPSEND=0,10\r\n\r\nOK\r\n");
+  CHECK(s.welcomes == 0);
+
+  s.waitForDataWelcome = true;
+  s.Replay("> ");
+  CHECK(s.welcomes == 1);
+  CHECK(!s.waitForDataWelcome);
+
+  s.Replay("\r\nRecv 10 bytes\r\n\r\nSEND OK\r\n");
+  CHECK(s.lines.size() == 7);
+  CHECK(s.lines.size() == 7 && s.lines[6] == "SEND OK");
+
+  // без ожидания приглашения > - обычный символ строки
+  s.Replay(">x\r\n");
+  CHECK(s.welcomes == 1);
+  CHECK(s.lines.back() == ">x");
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestBrokenHeader()
+{
+  TestSession s;
+  s.Replay("+IPD,0\r\n");
+  s.Replay("+IPD,1,0:");
+  s.Replay("0,CLOSED\r\n");
+  s.Replay("+IPD,1,8:CTGET=0\n");
+
+  CHECK(s.lines.size() == 4);
+  CHECK(s.lines.size() == 4 && s.lines[0] == "+IPD,0");
+  CHECK(s.lines.size() == 4 && s.lines[1] == "+IPD,1,0:");
+  CHECK(s.lines.size() == 4 && s.lines[2] == "0,CLOSED");
+  CHECK(SameCommands(s.clients[1],"CTGET=0"));
+}
+//----------------------------------------------------------------------------------------------------------------
+static void TestLongLineAndReset()
+{
+  TestSession s;
+  std::string longLine(200,'x');
+  s.Replay(longLine + "\r\nOK\r\n");
+
+  CHECK(s.lines.size() == 2);
+  CHECK(s.lines.size() == 2 && s.lines[0] == std::string(WIFI_LINE_BUFFER_SIZE-1,'x'));
+  CHECK(s.lines.size() == 2 && s.lines[1] == "OK");
+
+  // ESP перезагрузили посреди пакета - хвост пакета не придёт, следующий байт - уже строка
+  s.Replay("+IPD,0,50:CTGET");
+  s.parser.Reset();
+  s.Replay("ready\r\n");
+  CHECK(s.lines.back() == "ready");
+}
+//----------------------------------------------------------------------------------------------------------------
+int main()
+{
+  TestCrLfCommand();
+  TestLfOnlyCommand();
+  TestCrOnlyCommand();
+  TestSplitCommand();
+  TestCrLfInSeparatePackets();
+  TestBinarySafePayload();
+  TestDataWelcome();
+  TestBrokenHeader();
+  TestLongLineAndReset();
+
+  if(failures)
+  {
+    printf("WiFiByteParser: %d check(s) failed\n",failures);
+    return 1;
+  }
+
+  printf("WiFiByteParser: OK\n");
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
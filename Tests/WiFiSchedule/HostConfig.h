@@ -0,0 +1,12 @@
+#ifndef _HOST_TEST_CONFIG_H
+#define _HOST_TEST_CONFIG_H
+//----------------------------------------------------------------------------------------------------------------
+// очередь клиентов Wi-Fi на ПК: модуль Wi-Fi с побайтовым разбором потока от ESP, WIFI_SHORTEST_FIRST включает
+// Makefile для одной из сборок
+//----------------------------------------------------------------------------------------------------------------
+#include "../shim/HostConfig.h"
+//----------------------------------------------------------------------------------------------------------------
+#define USE_WIFI_MODULE
+#define WIFI_BYTE_PARSER
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,308 @@
+//----------------------------------------------------------------------------------------------------------------
+// очередь клиентов Wi-Fi на ПК: WiFiModule с четырьмя клиентами и ESP8266-заглушкой на WIFI_SERIAL. Заглушка
+// отвечает на команды инициализации, на AT+CIPSENDBUF - приглашением >, а после данных пакета - SEND OK, когда
+// пакет прошёл через UART на WIFI_BAUDRATE и ушёл в эфир. Клиенты шлют запросы +IPD и ждут ответа целиком:
+// один выгружает большой ответ (как лог за день), другой - средний, двое часто опрашивают короткие ответы.
+// Часы виртуальные: проход цикла - 1 мс, плюс то время, которое прошивка простояла на записи в UART.
+// Makefile собирает две версии - отсыл по кругу (как обычно) и WIFI_SHORTEST_FIRST:
+//   wifi_schedule_* --test   - все ответы дошли целиком и без искажений, никто из клиентов не простаивает
+//   wifi_schedule_* --bench  - задержка от запроса до SEND OK последнего пакета по клиентам: перцентили, мс
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "HostShim.h"
+#include "SD.h"
+#include "../../Main/ModuleController.h"
+#include "../../Main/WiFiModule.h"
+//----------------------------------------------------------------------------------------------------------------
+#ifdef WIFI_SHORTEST_FIRST
+#define SCHEDULE_MODE "shortest-first"
+#else
+#define SCHEDULE_MODE "round-robin"
+#endif
+//----------------------------------------------------------------------------------------------------------------
+#define UART_BYTE_US (10 * 1000000UL / WIFI_BAUDRATE) // байт по UART: старт, 8 бит, стоп
+#define AIR_BYTE_US 2 // байт в эфире у ESP, около 4 Мбит/с
+#define ESP_ANSWER_US 2000 // через сколько ESP отвечает на команду
+#define ESP_BOOT_US 500000UL // сколько ESP грузится после AT+RST
+//----------------------------------------------------------------------------------------------------------------
+// модуль с ответом заданной длины: CTGET=DATA|<байт>
+class DataStub : public AbstractModule
+{
+  public:
+    DataStub() : AbstractModule("DATA") {}
+    bool ExecCommand(const Command& command, bool)
+    {
+      Stream* s = command.GetIncomingStream();
+      if(!s || !command.GetArgsCount())
+        return true;
+
+      unsigned long len = atol(command.GetArg(0));
+      s->print(F("OK="));
+      for(unsigned long i=0;i<len;i++)
+        s->write(Body(i));
+      s->print(F("\r\n"));
+
+      return true;
+    }
+    void Setup() {}
+    void Update(uint16_t) {}
+
+    static char Body(unsigned long i) { return 'a' + (i * 7 + i / 26) % 26; } // по порядку байт видно, что ничего не потерялось
+};
+//----------------------------------------------------------------------------------------------------------------
+struct SimClient
+{
+  const char* name;
+  unsigned long answerBytes; // длина тела ответа
+  unsigned long thinkMs; // пауза между ответом и следующим запросом
+  bool waiting; // ждёт ответа
+  unsigned long requestAt; // когда отослал запрос, мкс
+  unsigned long nextRequestAt; // когда отошлёт следующий, мкс
+  std::string expected;
+  std::string received;
+  std::vector<double> latencies; // мс
+};
+//----------------------------------------------------------------------------------------------------------------
+static SimClient simClients[MAX_WIFI_CLIENTS] =
+{
+  { "log download", 64000, 2000 },
+  { "history", 6000, 1000 },
+  { "status poll", 200, 250 },
+  { "status poll", 200, 400 },
+};
+//----------------------------------------------------------------------------------------------------------------
+static WiFiModule* wifi;
+static unsigned long nowUs = 0; // виртуальное время
+static unsigned long uartFreeAt = 0; // когда UART допишет то, что в него уже записали
+static unsigned long randomState = 12345;
+static int failures = 0;
+//----------------------------------------------------------------------------------------------------------------
+static unsigned long NextRandom()
+{
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (randomState >> 8) & 0xFFFF;
+}
+//----------------------------------------------------------------------------------------------------------------
+// то, что ESP отдаст в порт в момент времени at; client >= 0 - это SEND OK последнего пакета ответа клиенту
+struct EspEvent
+{
+  std::string bytes;
+  int completesClient;
+};
+static std::multimap<unsigned long,EspEvent> espEvents;
+//----------------------------------------------------------------------------------------------------------------
+static void EspSay(unsigned long at, const std::string& bytes, int completesClient = -1)
+{
+  EspEvent e = { bytes, completesClient };
+  espEvents.insert(std::make_pair(at,e));
+}
+//----------------------------------------------------------------------------------------------------------------
+// ESP-заглушка: принимает то, что прошивка пишет в WIFI_SERIAL
+static std::string espLine;
+static int espDataClient = -1;
+static unsigned long espDataLeft = 0;
+static unsigned long espPacketLength = 0;
+//----------------------------------------------------------------------------------------------------------------
+static void EspCommand(const std::string& line)
+{
+  unsigned long at = uartFreeAt + ESP_ANSWER_US;
+
+  if(line == "AT+RST")
+  {
+    EspSay(at,"\r\nOK\r\n");
+    EspSay(at + ESP_BOOT_US,"\r\nready\r\n");
+    return;
+  }
+
+  if(!line.compare(0,14,"AT+CIPSENDBUF="))
+  {
+    int id = 0;
+    unsigned long len = 0;
+    sscanf(line.c_str() + 14,"%d,%lu",&id,&len);
+    espDataClient = id;
+    espDataLeft = len;
+    espPacketLength = len;
+    EspSay(at,"\r\n>");
+    return;
+  }
+
+  if(!line.compare(0,12,"AT+CIPCLOSE="))
+  {
+    EspSay(at,line.substr(12) + ",CLOSED\r\n\r\nOK\r\n");
+    return;
+  }
+
+  EspSay(at,"\r\nOK\r\n");
+}
+//----------------------------------------------------------------------------------------------------------------
+static void EspReceive(const uint8_t* data, size_t size, void*)
+{
+  for(size_t i=0;i<size;i++)
+  {
+    uartFreeAt = max(uartFreeAt,nowUs) + UART_BYTE_US;
+    char ch = (char) data[i];
+
+    if(espDataLeft)
+    {
+      SimClient& c = simClients[espDataClient];
+      c.received += ch;
+
+      if(--espDataLeft)
+        continue;
+
+      // пакет целиком у ESP - уходит в эфир, потом SEND OK
+      bool complete = c.waiting && c.received.size() >= c.expected.size();
+      EspSay(uartFreeAt + ESP_ANSWER_US + AIR_BYTE_US * espPacketLength,"\r\nSEND OK\r\n",complete ? espDataClient : -1);
+      continue;
+    }
+
+    if(ch == '\n')
+    {
+      if(!espLine.empty() && espLine[espLine.size()-1] == '\r')
+        espLine.erase(espLine.size()-1);
+      if(!espLine.empty())
+        EspCommand(espLine);
+      espLine.clear();
+    }
+    else
+      espLine += ch;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Deliver(const EspEvent& e)
+{
+  for(size_t i=0;i<e.bytes.size();i++)
+    wifi->ProcessIncomingByte(e.bytes[i]);
+
+  if(e.completesClient < 0)
+    return;
+
+  SimClient& c = simClients[e.completesClient];
+  if(c.received != c.expected)
+  {
+    printf("%s (%s): client #%d (%s) got a wrong answer: %u bytes instead of %u\n",__FILE__,SCHEDULE_MODE,
+      e.completesClient,c.name,(unsigned) c.received.size(),(unsigned) c.expected.size());
+    failures++;
+  }
+
+  c.latencies.push_back((nowUs - c.requestAt) / 1000.0);
+  c.waiting = false;
+  c.received.clear();
+  c.nextRequestAt = nowUs + (c.thinkMs / 2 + NextRandom() % c.thinkMs) * 1000UL;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void Request(uint8_t id)
+{
+  SimClient& c = simClients[id];
+  char command[32];
+  sprintf(command,"CTGET=DATA|%lu\r\n",c.answerBytes);
+
+  char header[32];
+  sprintf(header,"\r\n+IPD,%u,%u:",id,(unsigned) strlen(command));
+  EspSay(nowUs,std::string(header) + command);
+
+  c.waiting = true;
+  c.requestAt = nowUs;
+}
+//----------------------------------------------------------------------------------------------------------------
+static double Percentile(std::vector<double> v, double p)
+{
+  if(v.empty())
+    return 0;
+  std::sort(v.begin(),v.end());
+  size_t idx = (size_t) (p * v.size());
+  return v[min(idx,v.size()-1)];
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool bench = argc > 1 && !strcmp(argv[1],"--bench");
+
+  HostUseVirtualClock(true);
+  HostSDFormat();
+
+  ModuleController* controller = new ModuleController;
+  controller->Setup();
+
+  DataStub dataModule;
+  wifi = new WiFiModule;
+  controller->RegisterModule(&dataModule);
+  controller->RegisterModule(wifi);
+
+  WIFI_SERIAL.HostSetWriteHook(EspReceive,NULL);
+  controller->begin();
+
+  for(uint8_t i=0;i<MAX_WIFI_CLIENTS;i++)
+  {
+    SimClient& c = simClients[i];
+    c.expected = "OK=";
+    for(unsigned long j=0;j<c.answerBytes;j++)
+      c.expected += DataStub::Body(j);
+    c.expected += "\r\n";
+    c.waiting = false;
+    c.nextRequestAt = 15000000UL + i * 100000UL; // клиенты подключаются, когда ESP уже настроен
+    EspSay(c.nextRequestAt - 50000UL,std::string("\r\n") + char('0' + i) + ",CONNECT\r\n");
+  }
+
+  const unsigned long runUs = (bench ? 600UL : 120UL) * 1000000UL + 15000000UL;
+  unsigned long lastUpdate = 0;
+
+  while(nowUs < runUs)
+  {
+    // WIFI_EVENT_FUNC: всё, что ESP успел отдать в порт
+    while(!espEvents.empty() && espEvents.begin()->first <= nowUs)
+    {
+      EspEvent e = espEvents.begin()->second;
+      espEvents.erase(espEvents.begin());
+      Deliver(e);
+    }
+
+    for(uint8_t i=0;i<MAX_WIFI_CLIENTS;i++)
+    {
+      if(!simClients[i].waiting && nowUs >= simClients[i].nextRequestAt)
+        Request(i);
+    }
+
+    wifi->Update((nowUs - lastUpdate) / 1000);
+    lastUpdate = nowUs;
+
+    // проход цикла - 1 мс, но не меньше, чем прошивка простояла на записи в UART
+    unsigned long next = max(nowUs + 1000UL,uartFreeAt);
+    HostAdvanceMicros(next - nowUs);
+    nowUs = next;
+  }
+
+  if(bench)
+  {
+    for(uint8_t i=0;i<MAX_WIFI_CLIENTS;i++)
+    {
+      SimClient& c = simClients[i];
+      printf("%-15s #%u %-13s %6lu %5u %8.0f %8.0f %8.0f %8.0f\n",SCHEDULE_MODE,i,c.name,c.answerBytes + 5,
+        (unsigned) c.latencies.size(),Percentile(c.latencies,0.5),Percentile(c.latencies,0.9),
+        Percentile(c.latencies,0.99),Percentile(c.latencies,1.0));
+    }
+    return failures ? 1 : 0;
+  }
+
+  for(uint8_t i=0;i<MAX_WIFI_CLIENTS;i++)
+  {
+    SimClient& c = simClients[i];
+    if(c.latencies.size() < 3 || (c.waiting && nowUs - c.requestAt > 30000000UL))
+    {
+      printf("%s (%s): client #%u (%s) is starving: %u answers\n",__FILE__,SCHEDULE_MODE,i,c.name,(unsigned) c.latencies.size());
+      failures++;
+    }
+  }
+
+  if(failures)
+    return 1;
+
+  printf("WiFiSchedule (%s): all answers delivered\n",SCHEDULE_MODE);
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
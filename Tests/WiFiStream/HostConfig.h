@@ -0,0 +1,9 @@
+#ifndef _HOST_TEST_CONFIG_H
+#define _HOST_TEST_CONFIG_H
+//----------------------------------------------------------------------------------------------------------------
+// ответ клиенту Wi-Fi на ПК: модулей с железом нет, повторное выполнение (WIFI_STREAM_RESPONSES) включает
+// Makefile для одной из сборок
+//----------------------------------------------------------------------------------------------------------------
+#include "../shim/HostConfig.h"
+//----------------------------------------------------------------------------------------------------------------
+#endif
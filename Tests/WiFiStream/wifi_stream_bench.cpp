@@ -0,0 +1,225 @@
+//----------------------------------------------------------------------------------------------------------------
+// ответ на CTGET=0|STAT клиенту Wi-Fi на ПК: TCPClient получает команду, готовит ответ и отдаёт его пакетами, а
+// между пакетами датчики-заглушки меняют показания - как это бывает, пока ESP забирает пакет за пакетом.
+// Клиент должен получить ровно тот ответ, который выдал бы CTGET=0|STAT в момент прихода команды.
+// Makefile собирает две версии - хвост ответа на SD (как обычно) и WIFI_STREAM_RESPONSES (повторное выполнение
+// со снимком показаний StatusSnapshot):
+//   wifi_stream_* --test   - ответ совпадает со снимком, yield не зовётся; со снимком смена набора датчиков
+//                            посреди ответа даёт ER=STREAM_BROKEN, а не испорченные данные
+//   wifi_stream_* --bench  - время и обращения к SD на запрос
+//----------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include "Arduino.h"
+#include "HostShim.h"
+#include "SD.h"
+#include "../../Main/ModuleController.h"
+#include "../../Main/ZeroStreamListener.h"
+#include "../../Main/TCPClient.h"
+//----------------------------------------------------------------------------------------------------------------
+#ifdef WIFI_STREAM_RESPONSES
+#define STREAM_MODE "replay"
+#else
+#define STREAM_MODE "SD file"
+#endif
+//----------------------------------------------------------------------------------------------------------------
+#define TEST_PACKET_LENGTH 2048 // как WIFI_PACKET_LENGTH у ESP8266
+#define TEST_MODULES 4 // модулей с датчиками
+//----------------------------------------------------------------------------------------------------------------
+static unsigned long yieldCalls = 0;
+void yield() // в прошивке yield опрашивает порт Wi-Fi, здесь - только считаем вызовы
+{
+  yieldCalls++;
+}
+//----------------------------------------------------------------------------------------------------------------
+class SensorsStub : public AbstractModule
+{
+  public:
+    SensorsStub(const char* id) : AbstractModule(id), sensorsCount(0) {}
+    bool ExecCommand(const Command&, bool) { return true; }
+    void Setup() {}
+    void Update(uint16_t) {}
+
+    void AddSensors(uint8_t count)
+    {
+      for(uint8_t i=0;i<count;i++,sensorsCount++)
+        State.AddState(StateTemperature,sensorsCount);
+    }
+
+    void SetValues(unsigned long step) // каждый шаг - новые показания, часть датчиков то пропадает, то появляется
+    {
+      for(uint8_t i=0;i<sensorsCount;i++)
+      {
+        Temperature t;
+        if((step + i) % 7)
+          t = Temperature((int8_t)(10 + (step * 3 + i) % 30),(uint8_t)((step * 11 + i) % 100));
+        State.UpdateState(StateTemperature,i,(void*)&t);
+      }
+    }
+
+  private:
+    uint8_t sensorsCount;
+};
+//----------------------------------------------------------------------------------------------------------------
+static ModuleController* controller;
+static SensorsStub* sensors[TEST_MODULES];
+static TCPClient* client;
+//----------------------------------------------------------------------------------------------------------------
+static void SetValues(unsigned long step)
+{
+  for(uint8_t i=0;i<TEST_MODULES;i++)
+    sensors[i]->SetValues(step);
+}
+//----------------------------------------------------------------------------------------------------------------
+// ответ CTGET=0|STAT прямо сейчас
+static std::string Status()
+{
+  Serial.HostClearOutput();
+
+  Command cmd;
+  cmd.Construct("0","STAT",ctGET);
+  cmd.SetIncomingStream(&Serial);
+  controller->ProcessModuleCommand(cmd);
+
+  return std::string(Serial.HostOutput(),Serial.HostOutputLength());
+}
+//----------------------------------------------------------------------------------------------------------------
+struct Request
+{
+  std::string answer; // что получил клиент
+  unsigned long packets;
+  double ns; // время на подготовку ответа и отсыл всех пакетов, без смены показаний
+  unsigned long yields;
+};
+//----------------------------------------------------------------------------------------------------------------
+// команда приходит клиенту, ответ уходит пакетами, перед каждым пакетом показания меняются.
+// addSensorAfter - после какого пакета добавить датчик (0 - не добавлять)
+static Request Send(unsigned long& step, unsigned long addSensorAfter = 0)
+{
+  Request r;
+  r.packets = 0;
+  r.ns = 0;
+
+  const char* command = "CTGET=0|STAT\r\n";
+  client->CommandRequested(strlen(command),command);
+
+  unsigned long yieldsBefore = yieldCalls;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  client->Update();
+  r.ns += std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  Serial.HostClearOutput();
+  while(client->HasPacket())
+  {
+    SetValues(++step);
+    if(addSensorAfter && r.packets == addSensorAfter)
+      sensors[0]->AddSensors(1);
+
+    start = std::chrono::steady_clock::now();
+    client->SendPacket(&Serial);
+    r.ns += std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - start).count();
+    r.packets++;
+  }
+
+  r.yields = yieldCalls - yieldsBefore;
+  r.answer = std::string(Serial.HostOutput(),Serial.HostOutputLength());
+  return r;
+}
+//----------------------------------------------------------------------------------------------------------------
+static int Fail(const char* what, uint8_t sensorsPerModule, unsigned long request)
+{
+  printf("%s (%s): %s, %u sensors per module, request %lu\n",__FILE__,STREAM_MODE,what,sensorsPerModule,request);
+  return 1;
+}
+//----------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool bench = argc > 1 && !strcmp(argv[1],"--bench");
+
+  HostUseVirtualClock(true);
+  HostSDFormat();
+
+  controller = new ModuleController;
+  controller->Setup();
+
+  ZeroStreamListener zeroStreamModule;
+  controller->RegisterModule(&zeroStreamModule);
+
+  const char* ids[TEST_MODULES] = { "STATE", "HUMIDITY", "LIGHT", "SOIL" };
+  for(uint8_t i=0;i<TEST_MODULES;i++)
+  {
+    sensors[i] = new SensorsStub(ids[i]);
+    controller->RegisterModule(sensors[i]);
+  }
+  controller->begin();
+
+  client = new TCPClient;
+  client->Setup(0,TEST_PACKET_LENGTH);
+  client->SetConnected(true);
+
+  // датчиков на модуль: ответ целиком в кеше, хвост в том же пакете, хвост на несколько пакетов
+  const uint8_t sensorsSteps[] = { 4, 16, 100 };
+  const unsigned long requests = bench ? 2000 : 50;
+  unsigned long step = 0;
+  uint8_t sensorsPerModule = 0;
+
+  for(size_t s=0;s<sizeof(sensorsSteps);s++)
+  {
+    for(uint8_t i=0;i<TEST_MODULES;i++)
+      sensors[i]->AddSensors(sensorsSteps[s] - sensorsPerModule);
+    sensorsPerModule = sensorsSteps[s];
+
+    double totalNs = 0;
+    unsigned long packets = 0, yields = 0;
+    size_t answerLength = 0;
+    HostSDResetStats();
+
+    for(unsigned long i=0;i<requests;i++)
+    {
+      SetValues(++step);
+      std::string expected = Status(); // то, что должен получить клиент: показания на момент прихода команды
+
+      Request r = Send(step);
+
+      if(r.answer != expected || client->IsStreamBroken())
+        return Fail("answer differs from CTGET=0|STAT at request time",sensorsPerModule,i);
+
+#ifdef WIFI_STREAM_RESPONSES
+      if(r.yields)
+        return Fail("yield() called while measuring or replaying the answer",sensorsPerModule,i);
+#endif
+
+      totalNs += r.ns;
+      packets += r.packets;
+      yields += r.yields;
+      answerLength = r.answer.size();
+    }
+
+    if(bench)
+    {
+      printf("%-8s %7u %7u %7.1f %9.0f %7.2f %7.2f %7.2f %7.1f\n",STREAM_MODE,sensorsPerModule * TEST_MODULES,
+        (unsigned) answerLength,(double) packets / requests,totalNs / requests,
+        (double) HostSD.opens / requests,(double) HostSD.writeCalls / requests,
+        (double) (HostSD.sectorReads + HostSD.sectorWrites) / requests,(double) yields / requests);
+    }
+  } // for
+
+  if(bench)
+    return 0;
+
+#ifdef WIFI_STREAM_RESPONSES
+  // набор датчиков поменялся посреди ответа - снимок уже не подходит, клиент должен узнать, что ответ испорчен
+  SetValues(++step);
+  std::string before = Status();
+  Request r = Send(step,1);
+  if(!client->IsStreamBroken() || r.answer.find("STREAM_BROKEN") == std::string::npos)
+    return Fail("sensor added in the middle of the answer, but the stream is not broken",sensorsPerModule + 1,0);
+  if(r.answer.compare(0,TEST_PACKET_LENGTH,before,0,TEST_PACKET_LENGTH))
+    return Fail("first packet differs from CTGET=0|STAT at request time",sensorsPerModule + 1,0);
+#endif
+
+  printf("WiFiStream (%s): CTGET=0|STAT answers match the state at request time\n",STREAM_MODE);
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
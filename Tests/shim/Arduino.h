@@ -0,0 +1,171 @@
+#ifndef _HOST_ARDUINO_SHIM_H
+#define _HOST_ARDUINO_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// замена Arduino.h для сборки частей прошивки на ПК. Всё, что на AVR лежит во флеше, на ПК лежит в обычной памяти.
+// Объявления - здесь, реализация - в файлах *.cpp этой папки (список - в shim.mk). Тестам, которые проверяют
+// только заголовки (UniFraming.h, WiFiByteParser.h), собирать реализацию не надо.
+//----------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <strings.h>
+//----------------------------------------------------------------------------------------------------------------
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+//----------------------------------------------------------------------------------------------------------------
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_byte_near(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_word_near(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcat_P strcat
+#define strstr_P strstr
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define memcpy_P memcpy
+#define strcasecmp_P strcasecmp
+//----------------------------------------------------------------------------------------------------------------
+// на ПК указатель на __FlashStringHelper - обычная строка
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define FPSTR(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+//----------------------------------------------------------------------------------------------------------------
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+#define SDA 20
+#define SCL 21
+#define MOSI 51
+#define MISO 50
+#define SCK 52
+#define SS 53
+#define F_CPU 16000000UL
+//----------------------------------------------------------------------------------------------------------------
+// Arduino-макросы; min, max, abs и round - макросы, как и на AVR, поэтому заголовки STL тесты подключают раньше этого файла
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+#ifndef abs
+#define abs(x) ((x)>0?(x):-(x))
+#endif
+#define round(x) ((x)>=0?(long)((x)+0.5):(long)((x)-0.5))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) (bitvalue ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+#define _BV(b) (1 << (b))
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+#define digitalPinToInterrupt(p) (p)
+#define clockCyclesPerMicrosecond() 16
+#define microsecondsToClockCycles(a) ((a)*16)
+#define sei()
+#define cli()
+#define noInterrupts()
+#define interrupts()
+//----------------------------------------------------------------------------------------------------------------
+// регистры, которые прошивка трогает напрямую - на ПК просто переменные
+extern volatile uint8_t UCSR0A, UCSR1A, UCSR2A, UCSR3A, UCSR0B, UCSR1B, UCSR2B, UCSR3B;
+extern uint8_t SREG;
+#define TXC0 6
+#define TXC1 6
+#define TXC2 6
+#define TXC3 6
+#define TXCIE3 6
+#define UDRIE3 5
+#define digitalPinToBitMask(p) ((uint8_t)(1<<((p)%8)))
+#define digitalPinToPort(p) ((uint8_t)((p)/8))
+#define portInputRegister(p) (&UCSR0A)
+#define portOutputRegister(p) (&UCSR0A)
+#define portModeRegister(p) (&UCSR0A)
+#ifndef ISR
+#define ISR(vector, ...) extern "C" void vector(void)
+#endif
+//----------------------------------------------------------------------------------------------------------------
+// время: по умолчанию - настоящее время с момента запуска, тест может перевести часы на виртуальное (см. HostShim.h)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void _delay_ms(double ms);
+void _delay_us(double us);
+void yield();
+//----------------------------------------------------------------------------------------------------------------
+// пины: запоминаем уровни, чтобы тест мог их проверить
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000L);
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+//----------------------------------------------------------------------------------------------------------------
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+//----------------------------------------------------------------------------------------------------------------
+// функции avr-libc, которых нет в glibc
+char* itoa(int value, char* str, int base);
+char* ltoa(long value, char* str, int base);
+char* utoa(unsigned value, char* str, int base);
+char* ultoa(unsigned long value, char* str, int base);
+char* dtostrf(double val, signed char width, unsigned char prec, char* sout);
+//----------------------------------------------------------------------------------------------------------------
+#ifdef __cplusplus
+#include "WString.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#endif
+//----------------------------------------------------------------------------------------------------------------
+#endif
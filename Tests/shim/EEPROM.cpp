@@ -0,0 +1,27 @@
+//----------------------------------------------------------------------------------------------------------------
+// EEPROM для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include "EEPROM.h"
+//----------------------------------------------------------------------------------------------------------------
+EEPROMClass EEPROM;
+//----------------------------------------------------------------------------------------------------------------
+EEPROMClass::EEPROMClass()
+{
+  HostErase();
+}
+//----------------------------------------------------------------------------------------------------------------
+void EEPROMClass::HostErase()
+{
+  memset(data,0xFF,sizeof(data));
+  HostWrites = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+void EEPROMClass::write(int idx, uint8_t val)
+{
+  if(idx < 0 || idx >= HOST_EEPROM_SIZE)
+    return;
+
+  data[idx] = val;
+  HostWrites++;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+#ifndef _HOST_EEPROM_SHIM_H
+#define _HOST_EEPROM_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// EEPROM для сборки на ПК: 4 Кб в памяти, стёртые ячейки - 0xFF, как у чистой меги. Запись считается в HostWrites
+//----------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+//----------------------------------------------------------------------------------------------------------------
+#define HOST_EEPROM_SIZE 4096
+//----------------------------------------------------------------------------------------------------------------
+struct EEPROMClass
+{
+  EEPROMClass();
+
+  uint8_t read(int idx) const { return (idx >= 0 && idx < HOST_EEPROM_SIZE) ? data[idx] : 0xFF; }
+  void write(int idx, uint8_t val);
+  void update(int idx, uint8_t val) { if(read(idx) != val) write(idx,val); }
+  uint8_t& operator[](int idx) { return data[idx % HOST_EEPROM_SIZE]; }
+  int length() const { return HOST_EEPROM_SIZE; }
+
+  template<typename T> T& get(int idx, T& t) const
+  {
+    uint8_t* ptr = (uint8_t*) &t;
+    for(size_t i = 0;i < sizeof(T);i++)
+      ptr[i] = read(idx + i);
+    return t;
+  }
+
+  template<typename T> const T& put(int idx, const T& t)
+  {
+    const uint8_t* ptr = (const uint8_t*) &t;
+    for(size_t i = 0;i < sizeof(T);i++)
+      update(idx + i,ptr[i]);
+    return t;
+  }
+
+  // для тестов
+  void HostErase(); // все ячейки - в 0xFF
+  unsigned long HostWrites; // сколько ячеек перезаписано
+
+  private:
+    uint8_t data[HOST_EEPROM_SIZE];
+};
+//----------------------------------------------------------------------------------------------------------------
+extern EEPROMClass EEPROM;
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------------------------------------------
+// UART для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include <deque>
+#include <string>
+#include <unistd.h>
+#include <poll.h>
+#include "Arduino.h"
+//----------------------------------------------------------------------------------------------------------------
+struct HostSerialState
+{
+  std::deque<uint8_t> input;
+  std::string output;
+  HostSerialWriteHook hook;
+  void* hookParam;
+  int inFd;
+  int outFd;
+  bool inputClosed;
+
+  HostSerialState() : hook(NULL), hookParam(NULL), inFd(-1), outFd(-1), inputClosed(false) {}
+
+  void Poll() // забираем из дескриптора всё, что уже пришло, не блокируясь
+  {
+    if(inFd < 0 || inputClosed)
+      return;
+
+    while(true)
+    {
+      pollfd pfd = { inFd, POLLIN, 0 };
+      if(poll(&pfd,1,0) <= 0 || !(pfd.revents & (POLLIN | POLLHUP)))
+        return;
+
+      uint8_t buf[256];
+      ssize_t rd = ::read(inFd,buf,sizeof(buf));
+      if(rd <= 0)
+      {
+        inputClosed = true;
+        return;
+      }
+      input.insert(input.end(),buf,buf + rd);
+    }
+  }
+};
+//----------------------------------------------------------------------------------------------------------------
+HardwareSerial Serial;
+HardwareSerial Serial1;
+HardwareSerial Serial2;
+HardwareSerial Serial3;
+//----------------------------------------------------------------------------------------------------------------
+HardwareSerial::HardwareSerial() : state(new HostSerialState())
+{
+}
+//----------------------------------------------------------------------------------------------------------------
+HardwareSerial::~HardwareSerial()
+{
+  delete state;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::begin(unsigned long baud, uint8_t config)
+{
+  (void) baud;
+  (void) config;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::end()
+{
+}
+//----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::available()
+{
+  state->Poll();
+  return (int) state->input.size();
+}
+//----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::read()
+{
+  state->Poll();
+  if(state->input.empty())
+    return -1;
+
+  uint8_t ch = state->input.front();
+  state->input.pop_front();
+  return ch;
+}
+//----------------------------------------------------------------------------------------------------------------
+int HardwareSerial::peek()
+{
+  state->Poll();
+  if(state->input.empty())
+    return -1;
+
+  return state->input.front();
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t HardwareSerial::write(uint8_t ch)
+{
+  return write(&ch,1);
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+  if(state->hook)
+    state->hook(buffer,size,state->hookParam);
+  else if(state->outFd >= 0)
+  {
+    size_t written = 0;
+    while(written < size)
+    {
+      ssize_t wr = ::write(state->outFd,buffer + written,size - written);
+      if(wr <= 0)
+        break;
+      written += wr;
+    }
+  }
+  else
+    state->output.append((const char*) buffer,size);
+
+  return size;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::flush()
+{
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::HostInject(const char* data, size_t size)
+{
+  state->input.insert(state->input.end(),data,data + size);
+}
+//----------------------------------------------------------------------------------------------------------------
+const char* HardwareSerial::HostOutput() const
+{
+  return state->output.c_str();
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t HardwareSerial::HostOutputLength() const
+{
+  return state->output.size();
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::HostClearOutput()
+{
+  state->output.clear();
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::HostSetWriteHook(HostSerialWriteHook hook, void* param)
+{
+  state->hook = hook;
+  state->hookParam = param;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HardwareSerial::HostAttach(int inFd, int outFd)
+{
+  state->inFd = inFd;
+  state->outFd = outFd;
+  state->inputClosed = false;
+}
+//----------------------------------------------------------------------------------------------------------------
+bool HardwareSerial::HostInputClosed() const
+{
+  state->Poll();
+  return state->inputClosed && state->input.empty();
+}
+//----------------------------------------------------------------------------------------------------------------
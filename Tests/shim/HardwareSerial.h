@@ -0,0 +1,54 @@
+#ifndef _HOST_HARDWARE_SERIAL_SHIM_H
+#define _HOST_HARDWARE_SERIAL_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// UART для сборки на ПК. Входящие байты тест подкладывает через HostInject, исходящие копятся в буфере
+// (HostOutput) или уходят в функцию теста (HostSetWriteHook) - так тест изображает ESP или модем.
+// HostAttach подключает порт к файловым дескрипторам - так прошивку можно гонять через pipe (см. Tests/Host).
+//----------------------------------------------------------------------------------------------------------------
+#include "Stream.h"
+//----------------------------------------------------------------------------------------------------------------
+#define SERIAL_8N1 0x06
+//----------------------------------------------------------------------------------------------------------------
+typedef void (*HostSerialWriteHook)(const uint8_t* data, size_t size, void* param);
+//----------------------------------------------------------------------------------------------------------------
+class HardwareSerial : public Stream
+{
+  public:
+    HardwareSerial();
+    virtual ~HardwareSerial();
+
+    void begin(unsigned long baud, uint8_t config = SERIAL_8N1);
+    void end();
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual size_t write(uint8_t ch);
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    virtual int availableForWrite() { return 63; }
+    virtual void flush();
+    operator bool() { return true; }
+
+    // для тестов
+    void HostInject(const char* data, size_t size); // положить байты во входящий буфер
+    void HostInject(const char* str) { HostInject(str,strlen(str)); }
+    const char* HostOutput() const; // всё, что прошивка записала в порт с последней очистки
+    size_t HostOutputLength() const;
+    void HostClearOutput();
+    void HostSetWriteHook(HostSerialWriteHook hook, void* param); // исходящие байты - в функцию, а не в буфер
+    void HostAttach(int inFd, int outFd); // читать из inFd, писать в outFd
+    bool HostInputClosed() const; // на подключённом дескрипторе кончились данные
+
+  private:
+    struct HostSerialState* state;
+    HardwareSerial(const HardwareSerial&);
+    HardwareSerial& operator=(const HardwareSerial&);
+};
+//----------------------------------------------------------------------------------------------------------------
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+extern HardwareSerial Serial3;
+//----------------------------------------------------------------------------------------------------------------
+#endif
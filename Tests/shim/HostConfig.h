@@ -0,0 +1,53 @@
+#ifndef _HOST_CONFIG_H
+#define _HOST_CONFIG_H
+//----------------------------------------------------------------------------------------------------------------
+// настройки прошивки для сборки на ПК (подключается из Globals.h при HOST_BUILD): выключаем всё, чему нужно
+// железо, которого на ПК нет. Тест, которому нужны модули, кладёт свой HostConfig.h рядом с собой, подключает
+// этот и включает нужное (см. Tests/Host/HostConfig.h)
+//----------------------------------------------------------------------------------------------------------------
+#undef USE_DS3231_REALTIME_CLOCK
+#undef USE_PIN_MODULE
+#undef USE_TEMP_SENSORS
+#undef USE_WINDOWS_SHIFT_REGISTER
+#undef USE_LOOP_MODULE
+#undef USE_STAT_MODULE
+#undef USE_SMS_MODULE
+#undef USE_WATERING_MODULE
+#undef USE_LUMINOSITY_MODULE
+#undef USE_HUMIDITY_MODULE
+#undef USE_SOIL_MOISTURE_MODULE
+#undef USE_PH_MODULE
+#undef USE_LOG_MODULE
+#undef USE_DELTA_MODULE
+#undef USE_HISTORY_MODULE
+#undef USE_WATERFLOW_MODULE
+#undef USE_COMPOSITE_COMMANDS_MODULE
+#undef USE_RESERVATION_MODULE
+#undef USE_TIMER_MODULE
+#undef USE_IOT_MODULE
+#undef USE_ALARM_DISPATCHER
+#undef USE_WIFI_REBOOT_PIN
+#undef USE_GSM_REBOOT_PIN
+#undef USE_NRF_REBOOT_PIN
+#undef USE_W5100_REBOOT_PIN
+#undef USE_EXTERNAL_WATCHDOG
+#undef USE_WIFI_MODULE_AS_IOT_GATE
+#undef USE_GSM_MODULE_AS_IOT_GATE
+#undef USE_UNIVERSAL_SENSORS
+#undef USE_UNI_NEXTION_MODULE
+#undef USE_UNI_EXECUTION_MODULE
+#undef USE_UNI_REGISTRATION_LINE
+#undef USE_RS485_GATE
+#undef USE_NRF_GATE
+#undef USE_PUMP_RELAY
+#undef USE_WIFI_MODULE
+#undef USE_W5100_MODULE
+#undef USE_LCD_MODULE
+#undef USE_NEXTION_MODULE
+#undef USE_READY_DIODE
+#undef BLINK_READY_DIODE
+#undef USE_WINDOWS_MANUAL_MODE_DIODE
+#undef USE_WATERING_MANUAL_MODE_DIODE
+#undef USE_LIGHT_MANUAL_MODE_DIODE
+//----------------------------------------------------------------------------------------------------------------
+#endif
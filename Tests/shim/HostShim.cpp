@@ -0,0 +1,207 @@
+//----------------------------------------------------------------------------------------------------------------
+// реализация функций ядра Arduino для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include <new>
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "HostShim.h"
+//----------------------------------------------------------------------------------------------------------------
+unsigned long HostHeapAllocations = 0;
+volatile uint8_t UCSR0A, UCSR1A, UCSR2A, UCSR3A, UCSR0B, UCSR1B, UCSR2B, UCSR3B;
+uint8_t SREG;
+//----------------------------------------------------------------------------------------------------------------
+// на AVR new - это malloc, считаем каждое выделение
+//----------------------------------------------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+  HostHeapAllocations++;
+  void* p = malloc(size ? size : 1);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+//----------------------------------------------------------------------------------------------------------------
+// время
+//----------------------------------------------------------------------------------------------------------------
+static bool virtualClock = false;
+static unsigned long virtualMicros = 0;
+//----------------------------------------------------------------------------------------------------------------
+static unsigned long long RealMicros()
+{
+  static unsigned long long start = 0;
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  unsigned long long now = (unsigned long long) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+  if(!start)
+    start = now;
+  return now - start;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostUseVirtualClock(bool use)
+{
+  virtualClock = use;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostAdvanceMicros(unsigned long us)
+{
+  virtualMicros += us;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned long micros()
+{
+  if(virtualClock)
+    return virtualMicros;
+
+  return (unsigned long) RealMicros();
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned long millis()
+{
+  if(virtualClock)
+    return virtualMicros / 1000;
+
+  return (unsigned long) (RealMicros() / 1000);
+}
+//----------------------------------------------------------------------------------------------------------------
+void delayMicroseconds(unsigned int us)
+{
+  if(virtualClock)
+    virtualMicros += us;
+  else
+    usleep(us);
+}
+//----------------------------------------------------------------------------------------------------------------
+void delay(unsigned long ms)
+{
+  if(virtualClock)
+    virtualMicros += ms * 1000;
+  else
+    usleep(ms * 1000);
+}
+//----------------------------------------------------------------------------------------------------------------
+void _delay_ms(double ms) { delay((unsigned long) ms); }
+void _delay_us(double us) { delayMicroseconds((unsigned int) us); }
+__attribute__((weak)) void yield() {}
+//----------------------------------------------------------------------------------------------------------------
+// пины
+//----------------------------------------------------------------------------------------------------------------
+static uint8_t pinLevels[100];
+static int analogValues[100];
+//----------------------------------------------------------------------------------------------------------------
+uint8_t HostGetPinLevel(uint8_t pin) { return pin < 100 ? pinLevels[pin] : 0; }
+void HostSetPinLevel(uint8_t pin, uint8_t level) { if(pin < 100) pinLevels[pin] = level; }
+void HostSetAnalogValue(uint8_t pin, int value) { if(pin < 100) analogValues[pin] = value; }
+//----------------------------------------------------------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if(mode == INPUT_PULLUP)
+    HostSetPinLevel(pin,HIGH);
+}
+void digitalWrite(uint8_t pin, uint8_t val) { HostSetPinLevel(pin,val ? HIGH : LOW); }
+int digitalRead(uint8_t pin) { return HostGetPinLevel(pin); }
+int analogRead(uint8_t pin) { return pin < 100 ? analogValues[pin] : 0; }
+void analogWrite(uint8_t pin, int val) { HostSetPinLevel(pin,val ? HIGH : LOW); }
+//----------------------------------------------------------------------------------------------------------------
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+{
+  for(uint8_t i = 0;i < 8;i++)
+  {
+    digitalWrite(dataPin,bitOrder == LSBFIRST ? (val & (1 << i)) : (val & (1 << (7 - i))));
+    digitalWrite(clockPin,HIGH);
+    digitalWrite(clockPin,LOW);
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned long pulseIn(uint8_t, uint8_t, unsigned long) { return 0; }
+void attachInterrupt(uint8_t, void (*)(void), int) {}
+void detachInterrupt(uint8_t) {}
+void tone(uint8_t, unsigned int, unsigned long) {}
+void noTone(uint8_t) {}
+//----------------------------------------------------------------------------------------------------------------
+// случайные числа - свой генератор, чтобы прогоны повторялись
+//----------------------------------------------------------------------------------------------------------------
+static unsigned long randomState = 1;
+//----------------------------------------------------------------------------------------------------------------
+void randomSeed(unsigned long seed)
+{
+  if(seed)
+    randomState = seed;
+}
+//----------------------------------------------------------------------------------------------------------------
+long random(long howbig)
+{
+  if(howbig <= 0)
+    return 0;
+
+  randomState = randomState * 1103515245UL + 12345UL;
+  return (long) ((randomState >> 8) % (unsigned long) howbig);
+}
+//----------------------------------------------------------------------------------------------------------------
+long random(long howsmall, long howbig)
+{
+  if(howsmall >= howbig)
+    return howsmall;
+
+  return random(howbig - howsmall) + howsmall;
+}
+//----------------------------------------------------------------------------------------------------------------
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+//----------------------------------------------------------------------------------------------------------------
+// avr-libc
+//----------------------------------------------------------------------------------------------------------------
+char* ultoa(unsigned long value, char* str, int base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char* p = &buf[sizeof(buf) - 1];
+  *p = '\0';
+  if(base < 2 || base > 36)
+    base = 10;
+  do
+  {
+    int d = value % base;
+    value /= base;
+    *--p = d < 10 ? '0' + d : 'a' + d - 10;
+  } while(value);
+
+  strcpy(str,p);
+  return str;
+}
+//----------------------------------------------------------------------------------------------------------------
+char* ltoa(long value, char* str, int base)
+{
+  if(base == 10 && value < 0)
+  {
+    str[0] = '-';
+    ultoa(-(unsigned long) value,str + 1,base);
+    return str;
+  }
+  return ultoa((unsigned long) value,str,base);
+}
+//----------------------------------------------------------------------------------------------------------------
+char* itoa(int value, char* str, int base)
+{
+  if(base != 10)
+    return ultoa((unsigned int) value,str,base); // как и на AVR: отрицательные - в дополнительном коде int
+  return ltoa(value,str,base);
+}
+//----------------------------------------------------------------------------------------------------------------
+char* utoa(unsigned value, char* str, int base)
+{
+  return ultoa(value,str,base);
+}
+//----------------------------------------------------------------------------------------------------------------
+char* dtostrf(double val, signed char width, unsigned char prec, char* sout)
+{
+  sprintf(sout,"%*.*f",width,prec,val);
+  return sout;
+}
+//----------------------------------------------------------------------------------------------------------------
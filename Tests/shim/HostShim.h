@@ -0,0 +1,24 @@
+#ifndef _HOST_SHIM_H
+#define _HOST_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// то, чего нет у Arduino, но нужно тестам на ПК: счётчик выделений памяти, виртуальные часы, уровни на пинах
+//----------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+//----------------------------------------------------------------------------------------------------------------
+extern unsigned long HostHeapAllocations; // сколько раз выделялась память (new, new[] и расширение String)
+//----------------------------------------------------------------------------------------------------------------
+// часы: по умолчанию millis() и micros() идут по настоящему времени. На виртуальных часах время стоит, пока
+// тест его не сдвинет, а delay() сдвигает его сам - так прогон не зависит от скорости ПК
+void HostUseVirtualClock(bool use);
+void HostAdvanceMicros(unsigned long us);
+//----------------------------------------------------------------------------------------------------------------
+// пины
+uint8_t HostGetPinLevel(uint8_t pin);
+void HostSetPinLevel(uint8_t pin, uint8_t level); // что вернёт digitalRead
+void HostSetAnalogValue(uint8_t pin, int value); // что вернёт analogRead
+//----------------------------------------------------------------------------------------------------------------
+// часы реального времени DS3231 на шине I2C (см. Wire.cpp): время, которое он покажет прямо сейчас
+void HostSetRTCTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second);
+void HostSetRTCTemperature(int8_t temperature);
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,324 @@
+//----------------------------------------------------------------------------------------------------------------
+// 1-Wire с датчиками DS18B20 для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include "OneWire.h"
+//----------------------------------------------------------------------------------------------------------------
+struct HostOneWireDevice
+{
+  uint8_t pin;
+  uint8_t rom[8];
+  bool present;
+  float temperature;
+  uint8_t th, tl, config;
+};
+//----------------------------------------------------------------------------------------------------------------
+static std::vector<HostOneWireDevice> devices;
+unsigned long HostOneWireSearchSteps = 0;
+//----------------------------------------------------------------------------------------------------------------
+typedef enum
+{
+  owIdle, // ждём reset
+  owRomCommand, // после reset ждём команду ROM
+  owFunction, // устройства выбраны, ждём команду
+  owWriteScratchpad // принимаем TH, TL и конфигурацию
+} HostOneWireState;
+//----------------------------------------------------------------------------------------------------------------
+static HostOneWireDevice* FindDevice(const uint8_t* rom)
+{
+  for(size_t i = 0;i < devices.size();i++)
+  {
+    if(!memcmp(devices[i].rom,rom,7))
+      return &devices[i];
+  }
+  return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostOneWireAttach(uint8_t pin, const uint8_t* rom, float temperature)
+{
+  HostOneWireDevice d;
+  d.pin = pin;
+  memcpy(d.rom,rom,7);
+  d.rom[7] = OneWire::crc8(d.rom,7);
+  d.present = true;
+  d.temperature = temperature;
+  d.th = d.tl = 0;
+  d.config = 0x7F;
+  devices.push_back(d);
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostOneWireSetPresent(const uint8_t* rom, bool present)
+{
+  HostOneWireDevice* d = FindDevice(rom);
+  if(d)
+    d->present = present;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostOneWireSetTemperature(const uint8_t* rom, float temperature)
+{
+  HostOneWireDevice* d = FindDevice(rom);
+  if(d)
+    d->temperature = temperature;
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostOneWireClear()
+{
+  devices.clear();
+  HostOneWireSearchSteps = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void MakeScratchpad(const HostOneWireDevice& d, uint8_t* data)
+{
+  int16_t raw;
+  if(d.rom[0] == 0x10) // DS18S20 - шаг 0,5 градуса
+    raw = (int16_t) (d.temperature * 2);
+  else
+    raw = (int16_t) (d.temperature * 16);
+
+  data[0] = raw & 0xFF;
+  data[1] = (raw >> 8) & 0xFF;
+  data[2] = d.th;
+  data[3] = d.tl;
+  data[4] = d.config;
+  data[5] = 0xFF;
+  data[6] = 0x0C;
+  data[7] = 0x10;
+  data[8] = OneWire::crc8(data,8);
+}
+//----------------------------------------------------------------------------------------------------------------
+OneWire::OneWire() : pin(0)
+{
+  begin(0);
+}
+//----------------------------------------------------------------------------------------------------------------
+OneWire::OneWire(uint8_t _pin) : pin(_pin)
+{
+  begin(_pin);
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::begin(uint8_t _pin)
+{
+  pin = _pin;
+  state = owIdle;
+  selected = 0;
+  readPos = writePos = sizeof(readBuffer);
+  reset_search();
+}
+//----------------------------------------------------------------------------------------------------------------
+uint8_t OneWire::reset()
+{
+  state = owRomCommand;
+  selected = 0;
+  readPos = sizeof(readBuffer);
+
+  for(size_t i = 0;i < devices.size();i++)
+  {
+    if(devices[i].pin == pin && devices[i].present)
+      return 1;
+  }
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::select(const uint8_t rom[8])
+{
+  selected = 0;
+  for(size_t i = 0;i < devices.size() && i < 32;i++)
+  {
+    if(devices[i].pin == pin && devices[i].present && !memcmp(devices[i].rom,rom,8))
+      selected |= (1UL << i);
+  }
+  state = owFunction;
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::skip()
+{
+  selected = 0;
+  for(size_t i = 0;i < devices.size() && i < 32;i++)
+  {
+    if(devices[i].pin == pin && devices[i].present)
+      selected |= (1UL << i);
+  }
+  state = owFunction;
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::write(uint8_t v, uint8_t)
+{
+  switch(state)
+  {
+    case owRomCommand:
+      if(v == 0xCC)
+        skip();
+      break;
+
+    case owFunction:
+      if(v == 0xBE) // READ SCRATCHPAD - все выбранные отвечают разом, линия даёт И их битов
+      {
+        memset(readBuffer,0xFF,sizeof(readBuffer));
+        for(size_t i = 0;i < devices.size() && i < 32;i++)
+        {
+          if(!(selected & (1UL << i)))
+            continue;
+          uint8_t data[9];
+          MakeScratchpad(devices[i],data);
+          for(uint8_t j = 0;j < sizeof(data);j++)
+            readBuffer[j] &= data[j];
+        }
+        readPos = 0;
+      }
+      else if(v == 0x4E) // WRITE SCRATCHPAD
+      {
+        state = owWriteScratchpad;
+        writePos = 0;
+      }
+      break;
+
+    case owWriteScratchpad:
+      for(size_t i = 0;i < devices.size() && i < 32;i++)
+      {
+        if(!(selected & (1UL << i)))
+          continue;
+        if(writePos == 0)
+          devices[i].th = v;
+        else if(writePos == 1)
+          devices[i].tl = v;
+        else if(writePos == 2)
+          devices[i].config = v;
+      }
+      if(++writePos > 2)
+        state = owFunction;
+      break;
+
+    default:
+      break;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::write_bytes(const uint8_t* buf, uint16_t count, bool)
+{
+  for(uint16_t i = 0;i < count;i++)
+    write(buf[i]);
+}
+//----------------------------------------------------------------------------------------------------------------
+uint8_t OneWire::read()
+{
+  if(readPos < sizeof(readBuffer))
+    return readBuffer[readPos++];
+
+  return 0xFF; // на линии никто не отвечает
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::read_bytes(uint8_t* buf, uint16_t count)
+{
+  for(uint16_t i = 0;i < count;i++)
+    buf[i] = read();
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::reset_search()
+{
+  lastDiscrepancy = 0;
+  lastDeviceFlag = false;
+  memset(lastRom,0,sizeof(lastRom));
+}
+//----------------------------------------------------------------------------------------------------------------
+void OneWire::target_search(uint8_t family_code)
+{
+  reset_search();
+  lastRom[0] = family_code;
+  lastDiscrepancy = 64;
+}
+//----------------------------------------------------------------------------------------------------------------
+uint8_t OneWire::search(uint8_t* newAddr, bool)
+{
+  // поиск по алгоритму Maxim (AN187): на каждом бите адреса линия сообщает, есть ли у оставшихся устройств 0 и 1
+  HostOneWireSearchSteps++;
+  state = owIdle;
+
+  if(lastDeviceFlag || !reset())
+  {
+    reset_search();
+    return false;
+  }
+
+  std::vector<size_t> candidates;
+  for(size_t i = 0;i < devices.size();i++)
+  {
+    if(devices[i].pin == pin && devices[i].present)
+      candidates.push_back(i);
+  }
+
+  uint8_t rom[8] = {0};
+  uint8_t lastZero = 0;
+
+  for(uint8_t bitNumber = 1;bitNumber <= 64;bitNumber++)
+  {
+    uint8_t byteIdx = (bitNumber - 1) / 8;
+    uint8_t mask = 1 << ((bitNumber - 1) % 8);
+
+    bool has0 = false, has1 = false;
+    for(size_t i = 0;i < candidates.size();i++)
+    {
+      if(devices[candidates[i]].rom[byteIdx] & mask)
+        has1 = true;
+      else
+        has0 = true;
+    }
+
+    if(!has0 && !has1)
+    {
+      reset_search();
+      return false;
+    }
+
+    bool dir;
+    if(has0 && has1)
+    {
+      if(bitNumber < lastDiscrepancy)
+        dir = (lastRom[byteIdx] & mask) != 0;
+      else
+        dir = (bitNumber == lastDiscrepancy);
+
+      if(!dir)
+        lastZero = bitNumber;
+    }
+    else
+      dir = has1;
+
+    if(dir)
+      rom[byteIdx] |= mask;
+
+    std::vector<size_t> rest;
+    for(size_t i = 0;i < candidates.size();i++)
+    {
+      if(((devices[candidates[i]].rom[byteIdx] & mask) != 0) == dir)
+        rest.push_back(candidates[i]);
+    }
+    candidates.swap(rest);
+  }
+
+  lastDiscrepancy = lastZero;
+  if(!lastDiscrepancy)
+    lastDeviceFlag = true;
+
+  memcpy(lastRom,rom,8);
+  memcpy(newAddr,rom,8);
+  return true;
+}
+//----------------------------------------------------------------------------------------------------------------
+uint8_t OneWire::crc8(const uint8_t* addr, uint8_t len)
+{
+  uint8_t crc = 0;
+  while(len--)
+  {
+    uint8_t inbyte = *addr++;
+    for(uint8_t i = 8;i;i--)
+    {
+      uint8_t mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if(mix)
+        crc ^= 0x8C;
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+//----------------------------------------------------------------------------------------------------------------
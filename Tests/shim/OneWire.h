@@ -0,0 +1,53 @@
+#ifndef _HOST_ONEWIRE_SHIM_H
+#define _HOST_ONEWIRE_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// 1-Wire для сборки на ПК: на линиях висят датчики DS18B20/DS18S20, которых тест подключает по ROM-адресу
+// (HostOneWireAttach). Датчики понимают SKIP ROM, MATCH ROM, поиск адресов (SEARCH ROM), конвертацию
+// и чтение/запись scratchpad; при SKIP ROM на чтение несколько датчиков дают монтажное И, как на настоящей линии.
+// Датчик можно "отсоединить" и вернуть (HostOneWireSetPresent), не меняя его адрес.
+//----------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+//----------------------------------------------------------------------------------------------------------------
+void HostOneWireAttach(uint8_t pin, const uint8_t* rom, float temperature); // rom - 8 байт, CRC в rom[7] считается сам
+void HostOneWireSetPresent(const uint8_t* rom, bool present);
+void HostOneWireSetTemperature(const uint8_t* rom, float temperature);
+void HostOneWireClear(); // убрать все датчики со всех линий
+extern unsigned long HostOneWireSearchSteps; // сколько раз вызывали search() - каждый вызов занимает линию на ~13 мс
+//----------------------------------------------------------------------------------------------------------------
+class OneWire
+{
+  public:
+    OneWire();
+    OneWire(uint8_t pin);
+
+    void begin(uint8_t pin);
+    uint8_t reset();
+    void select(const uint8_t rom[8]);
+    void skip();
+    void write(uint8_t v, uint8_t power = 0);
+    void write_bytes(const uint8_t* buf, uint16_t count, bool power = 0);
+    uint8_t read();
+    void read_bytes(uint8_t* buf, uint16_t count);
+    void write_bit(uint8_t v) { (void) v; }
+    uint8_t read_bit() { return 1; }
+    void depower() {}
+
+    void reset_search();
+    void target_search(uint8_t family_code);
+    uint8_t search(uint8_t* newAddr, bool search_mode = true);
+
+    static uint8_t crc8(const uint8_t* addr, uint8_t len);
+
+  private:
+    uint8_t pin;
+    uint8_t state; // что ждём следующим байтом
+    uint32_t selected; // битовая маска выбранных датчиков
+    uint8_t readBuffer[9];
+    uint8_t readPos;
+    uint8_t writePos;
+    uint8_t lastRom[8];
+    uint8_t lastDiscrepancy;
+    bool lastDeviceFlag;
+};
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,51 @@
+#ifndef _HOST_PRINT_SHIM_H
+#define _HOST_PRINT_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// Print для сборки на ПК, вывод чисел - как в ядре Arduino
+//----------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "WString.h"
+//----------------------------------------------------------------------------------------------------------------
+class Print
+{
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*) str,strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*) buffer,size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper* str);
+    size_t print(const String& str);
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(unsigned char num, int base = 10);
+    size_t print(int num, int base = 10);
+    size_t print(unsigned int num, int base = 10);
+    size_t print(long num, int base = 10);
+    size_t print(unsigned long num, int base = 10);
+    size_t print(double num, int digits = 2);
+
+    size_t println(const __FlashStringHelper* str);
+    size_t println(const String& str);
+    size_t println(const char* str);
+    size_t println(char c);
+    size_t println(unsigned char num, int base = 10);
+    size_t println(int num, int base = 10);
+    size_t println(unsigned int num, int base = 10);
+    size_t println(long num, int base = 10);
+    size_t println(unsigned long num, int base = 10);
+    size_t println(double num, int digits = 2);
+    size_t println();
+
+  private:
+    size_t printNumber(unsigned long n, uint8_t base);
+    size_t printFloat(double number, uint8_t digits);
+};
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,430 @@
+//----------------------------------------------------------------------------------------------------------------
+// SD-карта в памяти для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "SD.h"
+//----------------------------------------------------------------------------------------------------------------
+typedef std::vector<uint8_t> HostFileData;
+//----------------------------------------------------------------------------------------------------------------
+static std::map<std::string,HostFileData> files;
+static std::set<std::string> dirs;
+HostSDStats HostSD;
+SDClass SD;
+//----------------------------------------------------------------------------------------------------------------
+// кэш сектора, один на всю карту
+//----------------------------------------------------------------------------------------------------------------
+static const HostFileData* cacheFile = NULL;
+static uint32_t cacheSector = 0;
+static bool cacheDirty = false;
+//----------------------------------------------------------------------------------------------------------------
+static void CacheEvict()
+{
+  if(cacheDirty)
+    HostSD.sectorWrites++;
+
+  cacheDirty = false;
+  cacheFile = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void CacheSelect(const HostFileData* data, uint32_t sector, bool needRead)
+{
+  if(cacheFile == data && cacheSector == sector)
+    return;
+
+  CacheEvict();
+  if(needRead)
+    HostSD.sectorReads++;
+
+  cacheFile = data;
+  cacheSector = sector;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void CacheForget(const HostFileData* data) // файл удалён или усечён - его сектор больше не нужен
+{
+  if(cacheFile == data)
+  {
+    cacheDirty = false;
+    cacheFile = NULL;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostSDResetStats()
+{
+  memset(&HostSD,0,sizeof(HostSD));
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostSDFormat()
+{
+  files.clear();
+  dirs.clear();
+  cacheFile = NULL;
+  cacheDirty = false;
+  HostSDResetStats();
+}
+//----------------------------------------------------------------------------------------------------------------
+static std::string NormalizePath(const char* path) // LOGS/20170101.LOG - без ведущих и двойных слешей, в верхнем регистре
+{
+  std::string result;
+  for(const char* p = path;p && *p;p++)
+  {
+    if(*p == '/' && (result.empty() || result[result.size()-1] == '/'))
+      continue;
+    result += (char) toupper(*p);
+  }
+  if(!result.empty() && result[result.size()-1] == '/')
+    result.erase(result.size()-1);
+
+  return result;
+}
+//----------------------------------------------------------------------------------------------------------------
+static std::string ParentOf(const std::string& path)
+{
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? std::string() : path.substr(0,slash);
+}
+//----------------------------------------------------------------------------------------------------------------
+static bool IsDir(const std::string& path)
+{
+  return path.empty() || dirs.count(path) > 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+struct HostFileHandle
+{
+  int refs;
+  bool isOpen;
+  bool isDir;
+  bool modified; // запись каталога надо обновить при flush
+  std::string path;
+  std::string baseName;
+  HostFileData* data;
+  uint32_t pos;
+  uint8_t mode;
+  size_t dirIndex; // для openNextFile
+
+  HostFileHandle() : refs(1), isOpen(true), isDir(false), modified(false), data(NULL), pos(0), mode(0), dirIndex(0) {}
+
+  void Sync()
+  {
+    HostSD.flushes++;
+    if(cacheFile == data)
+      CacheEvict();
+
+    if(modified) // сектор каталога: прочитать, поправить размер, записать
+    {
+      HostSD.sectorReads++;
+      HostSD.sectorWrites++;
+      modified = false;
+    }
+  }
+};
+//----------------------------------------------------------------------------------------------------------------
+File SDClass::open(const char* path, uint8_t mode)
+{
+  std::string p = NormalizePath(path);
+  HostFileHandle* h = NULL;
+
+  if(IsDir(p))
+  {
+    h = new HostFileHandle();
+    h->isDir = true;
+  }
+  else
+  {
+    std::map<std::string,HostFileData>::iterator it = files.find(p);
+    if(it == files.end())
+    {
+      if(!(mode & O_CREAT) || !IsDir(ParentOf(p)))
+        return File();
+
+      it = files.insert(std::make_pair(p,HostFileData())).first;
+      HostSD.sectorReads++; // новая запись каталога
+      HostSD.sectorWrites++;
+    }
+
+    h = new HostFileHandle();
+    h->data = &it->second;
+    if((mode & O_TRUNC) && (mode & O_WRITE) && !h->data->empty())
+    {
+      CacheForget(h->data);
+      h->data->clear();
+      h->modified = true;
+    }
+
+    if(mode & (O_APPEND | O_WRITE))
+      h->pos = h->data->size();
+  }
+
+  HostSD.opens++;
+  h->path = p;
+  size_t slash = p.rfind('/');
+  h->baseName = slash == std::string::npos ? p : p.substr(slash + 1);
+  h->mode = mode;
+  return File(h);
+}
+//----------------------------------------------------------------------------------------------------------------
+bool SDClass::exists(const char* path)
+{
+  std::string p = NormalizePath(path);
+  return IsDir(p) || files.count(p) > 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+bool SDClass::mkdir(const char* path) // как и в библиотеке SD, создаём все недостающие папки по пути
+{
+  std::string p = NormalizePath(path);
+  size_t from = 0;
+  while(true)
+  {
+    size_t slash = p.find('/',from);
+    std::string part = p.substr(0,slash);
+    if(files.count(part))
+      return false;
+    dirs.insert(part);
+    if(slash == std::string::npos)
+      return true;
+    from = slash + 1;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+bool SDClass::remove(const char* path)
+{
+  std::map<std::string,HostFileData>::iterator it = files.find(NormalizePath(path));
+  if(it == files.end())
+    return false;
+
+  CacheForget(&it->second);
+  files.erase(it);
+  return true;
+}
+//----------------------------------------------------------------------------------------------------------------
+bool SDClass::rmdir(const char* path)
+{
+  std::string p = NormalizePath(path);
+  std::string prefix = p + "/";
+  for(std::map<std::string,HostFileData>::iterator it = files.begin();it != files.end();++it)
+  {
+    if(!it->first.compare(0,prefix.size(),prefix))
+      return false;
+  }
+  return dirs.erase(p) > 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+// File
+//----------------------------------------------------------------------------------------------------------------
+File::File() : handle(NULL)
+{
+}
+//----------------------------------------------------------------------------------------------------------------
+File::File(HostFileHandle* h) : handle(h)
+{
+}
+//----------------------------------------------------------------------------------------------------------------
+File::File(const File& rhs) : Stream(), handle(rhs.handle)
+{
+  if(handle)
+    handle->refs++;
+}
+//----------------------------------------------------------------------------------------------------------------
+File& File::operator=(const File& rhs)
+{
+  if(rhs.handle)
+    rhs.handle->refs++;
+  Release();
+  handle = rhs.handle;
+  return *this;
+}
+//----------------------------------------------------------------------------------------------------------------
+File::~File()
+{
+  Release();
+}
+//----------------------------------------------------------------------------------------------------------------
+void File::Release()
+{
+  if(handle && !--handle->refs)
+    delete handle;
+  handle = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------
+File::operator bool()
+{
+  return handle && handle->isOpen;
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t File::write(uint8_t ch)
+{
+  return write(&ch,1);
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t File::write(const uint8_t* buffer, size_t size)
+{
+  if(!*this || handle->isDir || !(handle->mode & O_WRITE))
+    return 0;
+
+  HostSD.writeCalls++;
+  HostSD.bytesWritten += size;
+
+  HostFileData& data = *handle->data;
+  if(handle->mode & O_APPEND)
+    handle->pos = data.size();
+
+  size_t done = 0;
+  while(done < size)
+  {
+    uint32_t sector = handle->pos / HOST_SD_SECTOR_SIZE;
+    uint32_t offset = handle->pos % HOST_SD_SECTOR_SIZE;
+    size_t chunk = HOST_SD_SECTOR_SIZE - offset;
+    if(chunk > size - done)
+      chunk = size - done;
+
+    // сектор с уже записанными данными, который перезаписываем не целиком, сначала читается с карты
+    bool hasData = (uint32_t) sector * HOST_SD_SECTOR_SIZE < data.size();
+    bool whole = offset == 0 && chunk == HOST_SD_SECTOR_SIZE;
+    CacheSelect(&data,sector,hasData && !whole);
+    cacheDirty = true;
+
+    if(data.size() < handle->pos + chunk)
+      data.resize(handle->pos + chunk);
+    memcpy(&data[handle->pos],buffer + done,chunk);
+
+    handle->pos += chunk;
+    done += chunk;
+  }
+
+  handle->modified = true;
+  return size;
+}
+//----------------------------------------------------------------------------------------------------------------
+int File::read(void* buffer, uint16_t size)
+{
+  if(!*this || handle->isDir)
+    return -1;
+
+  HostSD.readCalls++;
+  HostFileData& data = *handle->data;
+  uint16_t done = 0;
+  while(done < size && handle->pos < data.size())
+  {
+    uint32_t sector = handle->pos / HOST_SD_SECTOR_SIZE;
+    uint32_t offset = handle->pos % HOST_SD_SECTOR_SIZE;
+    size_t chunk = HOST_SD_SECTOR_SIZE - offset;
+    if(chunk > (size_t) (size - done))
+      chunk = size - done;
+    if(chunk > data.size() - handle->pos)
+      chunk = data.size() - handle->pos;
+
+    CacheSelect(&data,sector,true);
+    memcpy((uint8_t*) buffer + done,&data[handle->pos],chunk);
+    handle->pos += chunk;
+    done += chunk;
+  }
+
+  HostSD.bytesRead += done;
+  return done;
+}
+//----------------------------------------------------------------------------------------------------------------
+int File::read()
+{
+  uint8_t ch;
+  return read(&ch,1) == 1 ? ch : -1;
+}
+//----------------------------------------------------------------------------------------------------------------
+int File::peek()
+{
+  if(!*this || handle->isDir || handle->pos >= handle->data->size())
+    return -1;
+
+  return (*handle->data)[handle->pos];
+}
+//----------------------------------------------------------------------------------------------------------------
+int File::available()
+{
+  if(!*this || handle->isDir)
+    return 0;
+
+  uint32_t left = handle->data->size() - handle->pos;
+  return left > 0x7FFF ? 0x7FFF : (int) left;
+}
+//----------------------------------------------------------------------------------------------------------------
+void File::flush()
+{
+  if(*this && !handle->isDir)
+    handle->Sync();
+}
+//----------------------------------------------------------------------------------------------------------------
+bool File::seek(uint32_t pos)
+{
+  if(!*this || handle->isDir || pos > handle->data->size())
+    return false;
+
+  handle->pos = pos;
+  return true;
+}
+//----------------------------------------------------------------------------------------------------------------
+uint32_t File::position()
+{
+  return *this && !handle->isDir ? handle->pos : 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+uint32_t File::size()
+{
+  return *this && !handle->isDir ? handle->data->size() : 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+void File::close()
+{
+  if(!*this)
+    return;
+
+  if(!handle->isDir)
+    handle->Sync();
+
+  HostSD.closes++;
+  handle->isOpen = false;
+}
+//----------------------------------------------------------------------------------------------------------------
+char* File::name()
+{
+  return handle ? (char*) handle->baseName.c_str() : (char*) "";
+}
+//----------------------------------------------------------------------------------------------------------------
+bool File::isDirectory()
+{
+  return *this && handle->isDir;
+}
+//----------------------------------------------------------------------------------------------------------------
+File File::openNextFile(uint8_t mode)
+{
+  if(!isDirectory())
+    return File();
+
+  // содержимое папки: вложенные папки и файлы, по алфавиту
+  std::set<std::string> entries;
+  std::string prefix = handle->path.empty() ? std::string() : handle->path + "/";
+  for(std::set<std::string>::iterator it = dirs.begin();it != dirs.end();++it)
+  {
+    if(!it->compare(0,prefix.size(),prefix) && it->find('/',prefix.size()) == std::string::npos && *it != handle->path)
+      entries.insert(*it);
+  }
+  for(std::map<std::string,HostFileData>::iterator it = files.begin();it != files.end();++it)
+  {
+    if(!it->first.compare(0,prefix.size(),prefix) && it->first.find('/',prefix.size()) == std::string::npos)
+      entries.insert(it->first);
+  }
+
+  if(handle->dirIndex >= entries.size())
+    return File();
+
+  std::set<std::string>::iterator it = entries.begin();
+  std::advance(it,handle->dirIndex++);
+  return SD.open(it->c_str(),mode);
+}
+//----------------------------------------------------------------------------------------------------------------
+void File::rewindDirectory()
+{
+  if(handle)
+    handle->dirIndex = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,97 @@
+#ifndef _HOST_SD_SHIM_H
+#define _HOST_SD_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// SD-карта для сборки на ПК: файловая система в памяти, имена - без учёта регистра, как на FAT.
+// Кроме файлов, считаем обращения к карте (HostSD): вызовы и байты, а также чтения и записи секторов по модели
+// SdFat - один кэш сектора на 512 байт на всю карту; flush() и close() записывают грязный сектор данных и
+// перечитывают и переписывают сектор каталога с размером файла. Выделение кластеров в FAT не считаем.
+//----------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+//----------------------------------------------------------------------------------------------------------------
+#define O_READ 0x01
+#define O_RDONLY O_READ
+#define O_WRITE 0x02
+#define O_WRONLY O_WRITE
+#define O_RDWR (O_READ | O_WRITE)
+#define O_APPEND 0x04
+#define O_SYNC 0x08
+#define O_CREAT 0x10
+#define O_EXCL 0x20
+#define O_TRUNC 0x40
+#define FILE_READ O_READ
+#define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
+//----------------------------------------------------------------------------------------------------------------
+#define HOST_SD_SECTOR_SIZE 512
+//----------------------------------------------------------------------------------------------------------------
+struct HostSDStats
+{
+  unsigned long opens;
+  unsigned long closes;
+  unsigned long readCalls;
+  unsigned long bytesRead;
+  unsigned long writeCalls;
+  unsigned long bytesWritten;
+  unsigned long flushes;
+  unsigned long sectorReads;
+  unsigned long sectorWrites;
+};
+//----------------------------------------------------------------------------------------------------------------
+extern HostSDStats HostSD;
+void HostSDResetStats(); // обнулить счётчики
+void HostSDFormat(); // стереть все файлы и обнулить счётчики
+//----------------------------------------------------------------------------------------------------------------
+struct HostFileHandle;
+//----------------------------------------------------------------------------------------------------------------
+class File : public Stream
+{
+  public:
+    File();
+    File(HostFileHandle* handle);
+    File(const File& rhs);
+    File& operator=(const File& rhs);
+    virtual ~File();
+
+    virtual size_t write(uint8_t ch);
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    virtual int read();
+    int read(void* buffer, uint16_t size);
+    virtual int peek();
+    virtual int available();
+    virtual void flush();
+    bool seek(uint32_t pos);
+    uint32_t position();
+    uint32_t size();
+    void close();
+    operator bool();
+    char* name();
+    bool isDirectory();
+    File openNextFile(uint8_t mode = O_READ);
+    void rewindDirectory();
+
+  private:
+    HostFileHandle* handle;
+    void Release();
+};
+//----------------------------------------------------------------------------------------------------------------
+typedef File SDFile;
+//----------------------------------------------------------------------------------------------------------------
+class SDClass
+{
+  public:
+    bool begin(uint8_t csPin = SS) { (void) csPin; return true; }
+    File open(const char* path, uint8_t mode = FILE_READ);
+    File open(const String& path, uint8_t mode = FILE_READ) { return open(path.c_str(),mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+};
+//----------------------------------------------------------------------------------------------------------------
+extern SDClass SD;
+//----------------------------------------------------------------------------------------------------------------
+#endif
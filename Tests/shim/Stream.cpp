@@ -0,0 +1,170 @@
+//----------------------------------------------------------------------------------------------------------------
+// Stream для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+//----------------------------------------------------------------------------------------------------------------
+int Stream::timedRead()
+{
+  unsigned long startMillis = millis();
+  do
+  {
+    int c = read();
+    if(c >= 0)
+      return c;
+    yield();
+  } while(millis() - startMillis < _timeout);
+
+  return -1;
+}
+//----------------------------------------------------------------------------------------------------------------
+int Stream::timedPeek()
+{
+  unsigned long startMillis = millis();
+  do
+  {
+    int c = peek();
+    if(c >= 0)
+      return c;
+    yield();
+  } while(millis() - startMillis < _timeout);
+
+  return -1;
+}
+//----------------------------------------------------------------------------------------------------------------
+int Stream::peekNextDigit()
+{
+  while(true)
+  {
+    int c = timedPeek();
+    if(c < 0 || c == '-' || (c >= '0' && c <= '9') || c == '.')
+      return c;
+    read();
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+bool Stream::find(const char* target)
+{
+  size_t len = strlen(target);
+  size_t index = 0;
+  if(!len)
+    return true;
+
+  while(true)
+  {
+    int c = timedRead();
+    if(c < 0)
+      return false;
+
+    if(c == target[index])
+    {
+      if(++index >= len)
+        return true;
+    }
+    else
+      index = (c == target[0]) ? 1 : 0;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+  size_t count = 0;
+  while(count < length)
+  {
+    int c = timedRead();
+    if(c < 0)
+      break;
+    *buffer++ = (char) c;
+    count++;
+  }
+  return count;
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length)
+{
+  size_t index = 0;
+  while(index < length)
+  {
+    int c = timedRead();
+    if(c < 0 || c == terminator)
+      break;
+    *buffer++ = (char) c;
+    index++;
+  }
+  return index;
+}
+//----------------------------------------------------------------------------------------------------------------
+String Stream::readString()
+{
+  String ret;
+  int c = timedRead();
+  while(c >= 0)
+  {
+    ret += (char) c;
+    c = timedRead();
+  }
+  return ret;
+}
+//----------------------------------------------------------------------------------------------------------------
+String Stream::readStringUntil(char terminator)
+{
+  String ret;
+  int c = timedRead();
+  while(c >= 0 && c != terminator)
+  {
+    ret += (char) c;
+    c = timedRead();
+  }
+  return ret;
+}
+//----------------------------------------------------------------------------------------------------------------
+long Stream::parseInt()
+{
+  bool isNegative = false;
+  long value = 0;
+  int c = peekNextDigit();
+  if(c < 0)
+    return 0;
+
+  do
+  {
+    if(c == '-')
+      isNegative = true;
+    else if(c >= '0' && c <= '9')
+      value = value * 10 + c - '0';
+    read();
+    c = timedPeek();
+  } while((c >= '0' && c <= '9'));
+
+  return isNegative ? -value : value;
+}
+//----------------------------------------------------------------------------------------------------------------
+float Stream::parseFloat()
+{
+  bool isNegative = false;
+  bool isFraction = false;
+  long value = 0;
+  float fraction = 1.0;
+  int c = peekNextDigit();
+  if(c < 0)
+    return 0;
+
+  do
+  {
+    if(c == '-')
+      isNegative = true;
+    else if(c == '.')
+      isFraction = true;
+    else if(c >= '0' && c <= '9')
+    {
+      value = value * 10 + c - '0';
+      if(isFraction)
+        fraction *= 0.1f;
+    }
+    read();
+    c = timedPeek();
+  } while((c >= '0' && c <= '9') || (c == '.' && !isFraction));
+
+  float result = isFraction ? value * fraction : value;
+  return isNegative ? -result : result;
+}
+//----------------------------------------------------------------------------------------------------------------
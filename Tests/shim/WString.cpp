@@ -0,0 +1,515 @@
+//----------------------------------------------------------------------------------------------------------------
+// String для сборки на ПК, ведёт себя так же, как String из ядра Arduino
+//----------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "HostShim.h"
+//----------------------------------------------------------------------------------------------------------------
+String::String(const char* cstr) : buffer(NULL), capacity(0), len(0)
+{
+  if(cstr)
+    copy(cstr,strlen(cstr));
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(const String& str) : buffer(NULL), capacity(0), len(0)
+{
+  *this = str;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(const __FlashStringHelper* str) : buffer(NULL), capacity(0), len(0)
+{
+  *this = str;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(char c) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[2] = {c, 0};
+  *this = buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(unsigned char value, unsigned char base) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[1 + 8 * sizeof(unsigned char)];
+  utoa(value,buf,base);
+  *this = buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(int value, unsigned char base) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[2 + 8 * sizeof(int)];
+  itoa(value,buf,base);
+  *this = buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(unsigned int value, unsigned char base) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[1 + 8 * sizeof(unsigned int)];
+  utoa(value,buf,base);
+  *this = buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(long value, unsigned char base) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[2 + 8 * sizeof(long)];
+  ltoa(value,buf,base);
+  *this = buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(unsigned long value, unsigned char base) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[1 + 8 * sizeof(unsigned long)];
+  ultoa(value,buf,base);
+  *this = buf;
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(float value, unsigned char decimalPlaces) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[64];
+  *this = dtostrf(value,(decimalPlaces + 2),decimalPlaces,buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+String::String(double value, unsigned char decimalPlaces) : buffer(NULL), capacity(0), len(0)
+{
+  char buf[64];
+  *this = dtostrf(value,(decimalPlaces + 2),decimalPlaces,buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+String::~String()
+{
+  free(buffer);
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::invalidate()
+{
+  free(buffer);
+  buffer = NULL;
+  capacity = len = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::reserve(unsigned int size)
+{
+  if(buffer && capacity >= size)
+    return 1;
+
+  if(changeBuffer(size))
+  {
+    if(len == 0)
+      buffer[0] = 0;
+    return 1;
+  }
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::changeBuffer(unsigned int maxStrLen)
+{
+  char* newbuffer = (char*) realloc(buffer,maxStrLen + 1);
+  if(!newbuffer)
+    return 0;
+
+  HostHeapAllocations++; // как и на AVR, каждое расширение строки - это realloc
+  buffer = newbuffer;
+  capacity = maxStrLen;
+  return 1;
+}
+//----------------------------------------------------------------------------------------------------------------
+String& String::copy(const char* cstr, unsigned int length)
+{
+  if(!reserve(length))
+  {
+    invalidate();
+    return *this;
+  }
+  len = length;
+  memmove(buffer,cstr,length);
+  buffer[len] = 0;
+  return *this;
+}
+//----------------------------------------------------------------------------------------------------------------
+String& String::operator=(const String& rhs)
+{
+  if(this == &rhs)
+    return *this;
+
+  if(rhs.buffer)
+    copy(rhs.buffer,rhs.len);
+  else
+    invalidate();
+
+  return *this;
+}
+//----------------------------------------------------------------------------------------------------------------
+String& String::operator=(const char* cstr)
+{
+  if(cstr)
+    copy(cstr,strlen(cstr));
+  else
+    invalidate();
+
+  return *this;
+}
+//----------------------------------------------------------------------------------------------------------------
+String& String::operator=(const __FlashStringHelper* str)
+{
+  return *this = (const char*) str;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(const String& s)
+{
+  return concat(s.buffer,s.len);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(const char* cstr, unsigned int length)
+{
+  unsigned int newlen = len + length;
+  if(!cstr)
+    return 0;
+  if(length == 0)
+    return 1;
+  if(!reserve(newlen))
+    return 0;
+  memmove(buffer + len,cstr,length);
+  len = newlen;
+  buffer[len] = 0;
+  return 1;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(const char* cstr)
+{
+  if(!cstr)
+    return 0;
+  return concat(cstr,strlen(cstr));
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(char c)
+{
+  char buf[2] = {c, 0};
+  return concat(buf,1);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(unsigned char num)
+{
+  char buf[1 + 3 * sizeof(unsigned char)];
+  itoa(num,buf,10);
+  return concat(buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(int num)
+{
+  char buf[2 + 3 * sizeof(int)];
+  itoa(num,buf,10);
+  return concat(buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(unsigned int num)
+{
+  char buf[1 + 3 * sizeof(unsigned int)];
+  utoa(num,buf,10);
+  return concat(buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(long num)
+{
+  char buf[2 + 3 * sizeof(long)];
+  ltoa(num,buf,10);
+  return concat(buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(unsigned long num)
+{
+  char buf[1 + 3 * sizeof(unsigned long)];
+  ultoa(num,buf,10);
+  return concat(buf);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(float num)
+{
+  char buf[64];
+  return concat(dtostrf(num,4,2,buf));
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(double num)
+{
+  char buf[64];
+  return concat(dtostrf(num,4,2,buf));
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::concat(const __FlashStringHelper* str)
+{
+  return concat((const char*) str);
+}
+//----------------------------------------------------------------------------------------------------------------
+String operator+(const String& lhs, const String& rhs) { String r(lhs); r.concat(rhs); return r; }
+String operator+(const String& lhs, const char* cstr) { String r(lhs); r.concat(cstr); return r; }
+String operator+(const String& lhs, char c) { String r(lhs); r.concat(c); return r; }
+String operator+(const String& lhs, unsigned char num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, int num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, unsigned int num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, long num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, unsigned long num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, float num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, double num) { String r(lhs); r.concat(num); return r; }
+String operator+(const String& lhs, const __FlashStringHelper* rhs) { String r(lhs); r.concat(rhs); return r; }
+//----------------------------------------------------------------------------------------------------------------
+int String::compareTo(const String& s) const
+{
+  return strcmp(c_str(),s.c_str());
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::equals(const String& s) const
+{
+  return len == s.len && compareTo(s) == 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::equals(const char* cstr) const
+{
+  return strcmp(c_str(),cstr ? cstr : "") == 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::equalsIgnoreCase(const String& s) const
+{
+  return len == s.len && strcasecmp(c_str(),s.c_str()) == 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::startsWith(const String& prefix) const
+{
+  if(len < prefix.len)
+    return 0;
+  return startsWith(prefix,0);
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::startsWith(const String& prefix, unsigned int offset) const
+{
+  if(offset > len - prefix.len || !buffer || !prefix.buffer)
+    return 0;
+  return strncmp(&buffer[offset],prefix.buffer,prefix.len) == 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+unsigned char String::endsWith(const String& suffix) const
+{
+  if(len < suffix.len || !buffer || !suffix.buffer)
+    return 0;
+  return strcmp(&buffer[len - suffix.len],suffix.buffer) == 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+char String::charAt(unsigned int index) const
+{
+  return operator[](index);
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::setCharAt(unsigned int index, char c)
+{
+  if(index < len)
+    buffer[index] = c;
+}
+//----------------------------------------------------------------------------------------------------------------
+char String::operator[](unsigned int index) const
+{
+  if(index >= len || !buffer)
+    return 0;
+  return buffer[index];
+}
+//----------------------------------------------------------------------------------------------------------------
+char& String::operator[](unsigned int index)
+{
+  static char dummy_writable_char;
+  if(index >= len || !buffer)
+  {
+    dummy_writable_char = 0;
+    return dummy_writable_char;
+  }
+  return buffer[index];
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const
+{
+  if(!bufsize || !buf)
+    return;
+  if(index >= len)
+  {
+    buf[0] = 0;
+    return;
+  }
+  unsigned int n = bufsize - 1;
+  if(n > len - index)
+    n = len - index;
+  strncpy((char*) buf,buffer + index,n);
+  buf[n] = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::indexOf(char ch) const
+{
+  return indexOf(ch,0);
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+  if(fromIndex >= len)
+    return -1;
+  const char* temp = strchr(buffer + fromIndex,ch);
+  if(!temp)
+    return -1;
+  return temp - buffer;
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::indexOf(const String& s2) const
+{
+  return indexOf(s2,0);
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::indexOf(const String& s2, unsigned int fromIndex) const
+{
+  if(fromIndex >= len)
+    return -1;
+  const char* found = strstr(buffer + fromIndex,s2.c_str());
+  if(!found)
+    return -1;
+  return found - buffer;
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::lastIndexOf(char ch) const
+{
+  return lastIndexOf(ch,len - 1);
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::lastIndexOf(char ch, unsigned int fromIndex) const
+{
+  if(fromIndex >= len)
+    return -1;
+  for(int i = fromIndex;i >= 0;i--)
+  {
+    if(buffer[i] == ch)
+      return i;
+  }
+  return -1;
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::lastIndexOf(const String& s2) const
+{
+  return lastIndexOf(s2,len - s2.len);
+}
+//----------------------------------------------------------------------------------------------------------------
+int String::lastIndexOf(const String& s2, unsigned int fromIndex) const
+{
+  if(s2.len == 0 || len == 0 || s2.len > len)
+    return -1;
+  if(fromIndex >= len)
+    fromIndex = len - 1;
+  int found = -1;
+  for(const char* p = buffer;p <= buffer + fromIndex;p++)
+  {
+    p = strstr(p,s2.buffer);
+    if(!p)
+      break;
+    if((unsigned int)(p - buffer) <= fromIndex)
+      found = p - buffer;
+  }
+  return found;
+}
+//----------------------------------------------------------------------------------------------------------------
+String String::substring(unsigned int left, unsigned int right) const
+{
+  if(left > right)
+  {
+    unsigned int temp = right;
+    right = left;
+    left = temp;
+  }
+  String out;
+  if(left >= len)
+    return out;
+  if(right > len)
+    right = len;
+  out.copy(buffer + left,right - left);
+  return out;
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::replace(char find, char replace)
+{
+  if(!buffer)
+    return;
+  for(char* p = buffer;*p;p++)
+  {
+    if(*p == find)
+      *p = replace;
+  }
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::replace(const String& find, const String& replace)
+{
+  if(len == 0 || find.len == 0)
+    return;
+
+  String out;
+  unsigned int pos = 0;
+  while(pos < len)
+  {
+    const char* found = strstr(buffer + pos,find.buffer);
+    if(!found)
+      break;
+    unsigned int idx = found - buffer;
+    out.concat(buffer + pos,idx - pos);
+    out.concat(replace);
+    pos = idx + find.len;
+  }
+  if(pos < len)
+    out.concat(buffer + pos,len - pos);
+  *this = out;
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::remove(unsigned int index)
+{
+  remove(index,(unsigned int) -1);
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::remove(unsigned int index, unsigned int count)
+{
+  if(index >= len || count == 0)
+    return;
+  if(count > len - index)
+    count = len - index;
+  memmove(buffer + index,buffer + index + count,len - index - count);
+  len -= count;
+  buffer[len] = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::toLowerCase()
+{
+  if(!buffer)
+    return;
+  for(char* p = buffer;*p;p++)
+    *p = tolower(*p);
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::toUpperCase()
+{
+  if(!buffer)
+    return;
+  for(char* p = buffer;*p;p++)
+    *p = toupper(*p);
+}
+//----------------------------------------------------------------------------------------------------------------
+void String::trim()
+{
+  if(!buffer || len == 0)
+    return;
+  char* begin = buffer;
+  while(isspace(*begin))
+    begin++;
+  char* end = buffer + len - 1;
+  while(isspace(*end) && end >= begin)
+    end--;
+  len = end + 1 - begin;
+  if(begin > buffer)
+    memmove(buffer,begin,len);
+  buffer[len] = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+long String::toInt() const
+{
+  return buffer ? atol(buffer) : 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+float String::toFloat() const
+{
+  return buffer ? atof(buffer) : 0;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+#ifndef _HOST_WSTRING_SHIM_H
+#define _HOST_WSTRING_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// String для сборки на ПК: тот же интерфейс, что и у String из ядра Arduino, память - через malloc/realloc,
+// как и на AVR. Каждое выделение памяти считается в HostHeapAllocations (см. HostShim.h).
+// Конструкторы из чисел не explicit: прошивка присваивает строкам char и long (PublishStruct::operator=),
+// avr-gcc это пропускает с -fpermissive, а здесь такое присваивание честно превращает число в текст.
+//----------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+//----------------------------------------------------------------------------------------------------------------
+class __FlashStringHelper;
+//----------------------------------------------------------------------------------------------------------------
+class String
+{
+  public:
+    String(const char* cstr = "");
+    String(const String& str);
+    String(const __FlashStringHelper* str);
+    String(char c);
+    String(unsigned char value, unsigned char base = 10);
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(float value, unsigned char decimalPlaces = 2);
+    String(double value, unsigned char decimalPlaces = 2);
+    ~String();
+
+    unsigned char reserve(unsigned int size);
+    unsigned int length() const { return len; }
+
+    String& operator=(const String& rhs);
+    String& operator=(const char* cstr);
+    String& operator=(const __FlashStringHelper* str);
+
+    unsigned char concat(const String& str);
+    unsigned char concat(const char* cstr);
+    unsigned char concat(const char* cstr, unsigned int length);
+    unsigned char concat(char c);
+    unsigned char concat(unsigned char num);
+    unsigned char concat(int num);
+    unsigned char concat(unsigned int num);
+    unsigned char concat(long num);
+    unsigned char concat(unsigned long num);
+    unsigned char concat(float num);
+    unsigned char concat(double num);
+    unsigned char concat(const __FlashStringHelper* str);
+
+    template<typename T> String& operator+=(T rhs) { concat(rhs); return *this; }
+
+    friend String operator+(const String& lhs, const String& rhs);
+    friend String operator+(const String& lhs, const char* cstr);
+    friend String operator+(const String& lhs, char c);
+    friend String operator+(const String& lhs, unsigned char num);
+    friend String operator+(const String& lhs, int num);
+    friend String operator+(const String& lhs, unsigned int num);
+    friend String operator+(const String& lhs, long num);
+    friend String operator+(const String& lhs, unsigned long num);
+    friend String operator+(const String& lhs, float num);
+    friend String operator+(const String& lhs, double num);
+    friend String operator+(const String& lhs, const __FlashStringHelper* rhs);
+
+    typedef void (String::*StringIfHelperType)() const;
+    void StringIfHelper() const {}
+    operator StringIfHelperType() const { return buffer ? &String::StringIfHelper : 0; }
+
+    int compareTo(const String& s) const;
+    unsigned char equals(const String& s) const;
+    unsigned char equals(const char* cstr) const;
+    unsigned char operator==(const String& rhs) const { return equals(rhs); }
+    unsigned char operator==(const char* cstr) const { return equals(cstr); }
+    unsigned char operator!=(const String& rhs) const { return !equals(rhs); }
+    unsigned char operator!=(const char* cstr) const { return !equals(cstr); }
+    unsigned char operator<(const String& rhs) const { return compareTo(rhs) < 0; }
+    unsigned char operator>(const String& rhs) const { return compareTo(rhs) > 0; }
+    unsigned char operator<=(const String& rhs) const { return compareTo(rhs) <= 0; }
+    unsigned char operator>=(const String& rhs) const { return compareTo(rhs) >= 0; }
+    unsigned char equalsIgnoreCase(const String& s) const;
+    unsigned char startsWith(const String& prefix) const;
+    unsigned char startsWith(const String& prefix, unsigned int offset) const;
+    unsigned char endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const;
+    void setCharAt(unsigned int index, char c);
+    char operator[](unsigned int index) const;
+    char& operator[](unsigned int index);
+    void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const { getBytes((unsigned char*) buf,bufsize,index); }
+    const char* c_str() const { return buffer ? buffer : ""; }
+    char* begin() { return buffer; }
+    char* end() { return buffer + len; }
+
+    int indexOf(char ch) const;
+    int indexOf(char ch, unsigned int fromIndex) const;
+    int indexOf(const String& str) const;
+    int indexOf(const String& str, unsigned int fromIndex) const;
+    int lastIndexOf(char ch) const;
+    int lastIndexOf(char ch, unsigned int fromIndex) const;
+    int lastIndexOf(const String& str) const;
+    int lastIndexOf(const String& str, unsigned int fromIndex) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex,len); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+
+  private:
+    char* buffer;
+    unsigned int capacity;
+    unsigned int len;
+
+    void invalidate();
+    unsigned char changeBuffer(unsigned int maxStrLen);
+    String& copy(const char* cstr, unsigned int length);
+};
+//----------------------------------------------------------------------------------------------------------------
+#endif
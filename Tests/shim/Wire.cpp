@@ -0,0 +1,125 @@
+//----------------------------------------------------------------------------------------------------------------
+// I2C с часами DS3231 для сборки на ПК
+//----------------------------------------------------------------------------------------------------------------
+#include <time.h>
+#include "Wire.h"
+#include "HostShim.h"
+//----------------------------------------------------------------------------------------------------------------
+#define HOST_DS3231_ADDRESS 0x68
+//----------------------------------------------------------------------------------------------------------------
+TwoWire Wire;
+//----------------------------------------------------------------------------------------------------------------
+static time_t rtcBase = 1483228800; // 01.01.2017 00:00:00
+static unsigned long rtcBaseMillis = 0;
+static int8_t rtcTemperature = 25;
+//----------------------------------------------------------------------------------------------------------------
+static uint8_t dec2bcd(uint8_t val) { return (val / 10 * 16) + (val % 10); }
+static uint8_t bcd2dec(uint8_t val) { return (val / 16 * 10) + (val % 16); }
+//----------------------------------------------------------------------------------------------------------------
+void HostSetRTCTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second)
+{
+  tm t;
+  memset(&t,0,sizeof(t));
+  t.tm_year = year - 1900;
+  t.tm_mon = month - 1;
+  t.tm_mday = day;
+  t.tm_hour = hour;
+  t.tm_min = minute;
+  t.tm_sec = second;
+  rtcBase = timegm(&t);
+  rtcBaseMillis = millis();
+}
+//----------------------------------------------------------------------------------------------------------------
+void HostSetRTCTemperature(int8_t temperature)
+{
+  rtcTemperature = temperature;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void ReadRTCRegisters(uint8_t* regs) // регистры 0x00-0x12
+{
+  time_t now = rtcBase + (millis() - rtcBaseMillis) / 1000;
+  tm t;
+  gmtime_r(&now,&t);
+
+  memset(regs,0,0x13);
+  regs[0] = dec2bcd(t.tm_sec);
+  regs[1] = dec2bcd(t.tm_min);
+  regs[2] = dec2bcd(t.tm_hour);
+  regs[3] = dec2bcd(t.tm_wday ? t.tm_wday : 7); // 1 - понедельник
+  regs[4] = dec2bcd(t.tm_mday);
+  regs[5] = dec2bcd(t.tm_mon + 1);
+  regs[6] = dec2bcd(t.tm_year % 100);
+  regs[0x11] = (uint8_t) rtcTemperature;
+  regs[0x12] = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+static void WriteRTCRegisters(const uint8_t* data, uint8_t len) // data[0] - номер регистра
+{
+  if(len < 8 || data[0] != 0)
+    return;
+
+  HostSetRTCTime(2000 + bcd2dec(data[7]),bcd2dec(data[6]),bcd2dec(data[5]),bcd2dec(data[3] & 0x3F),bcd2dec(data[2]),bcd2dec(data[1] & 0x7F));
+}
+//----------------------------------------------------------------------------------------------------------------
+TwoWire::TwoWire() : txAddress(0), txLength(0), rxLength(0), rxIndex(0), rtcPointer(0)
+{
+}
+//----------------------------------------------------------------------------------------------------------------
+void TwoWire::beginTransmission(uint8_t address)
+{
+  txAddress = address;
+  txLength = 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t TwoWire::write(uint8_t data)
+{
+  if(txLength >= sizeof(txBuffer))
+    return 0;
+
+  txBuffer[txLength++] = data;
+  return 1;
+}
+//----------------------------------------------------------------------------------------------------------------
+size_t TwoWire::write(const uint8_t* data, size_t quantity)
+{
+  for(size_t i = 0;i < quantity;i++)
+  {
+    if(!write(data[i]))
+      return i;
+  }
+  return quantity;
+}
+//----------------------------------------------------------------------------------------------------------------
+uint8_t TwoWire::endTransmission(bool)
+{
+  if(txAddress != HOST_DS3231_ADDRESS)
+    return 2;
+
+  if(txLength)
+  {
+    rtcPointer = txBuffer[0];
+    WriteRTCRegisters(txBuffer,txLength);
+  }
+  txLength = 0;
+  return 0;
+}
+//----------------------------------------------------------------------------------------------------------------
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t)
+{
+  rxIndex = rxLength = 0;
+  if(address != HOST_DS3231_ADDRESS)
+    return 0;
+
+  uint8_t regs[0x13];
+  ReadRTCRegisters(regs);
+
+  if(quantity > sizeof(rxBuffer))
+    quantity = sizeof(rxBuffer);
+
+  for(uint8_t i = 0;i < quantity;i++)
+    rxBuffer[i] = regs[(rtcPointer + i) % 0x13];
+
+  rxLength = quantity;
+  return quantity;
+}
+//----------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+#ifndef _HOST_WIRE_SHIM_H
+#define _HOST_WIRE_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// I2C для сборки на ПК. На шине висят только часы DS3231 (адрес 0x68): регистры времени и температуры
+// отдаются в BCD, как у настоящей микросхемы, время задаёт тест (HostSetRTCTime), дальше оно идёт по millis().
+// Остальные адреса не отвечают - endTransmission возвращает 2 (NACK на адрес).
+//----------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+//----------------------------------------------------------------------------------------------------------------
+class TwoWire : public Stream
+{
+  public:
+    TwoWire();
+
+    void begin() {}
+    void begin(uint8_t) {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t) address); }
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = 1);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t) address,(uint8_t) quantity); }
+
+    virtual size_t write(uint8_t data);
+    virtual size_t write(const uint8_t* data, size_t quantity);
+    using Print::write;
+    virtual int available() { return rxLength - rxIndex; }
+    virtual int read() { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+    virtual int peek() { return rxIndex < rxLength ? rxBuffer[rxIndex] : -1; }
+    virtual void flush() {}
+
+    void send(uint8_t data) { write(data); }
+    void send(int data) { write((uint8_t) data); }
+    uint8_t receive() { return (uint8_t) read(); }
+
+  private:
+    uint8_t txAddress;
+    uint8_t txBuffer[32];
+    uint8_t txLength;
+    uint8_t rxBuffer[32];
+    uint8_t rxLength;
+    uint8_t rxIndex;
+    uint8_t rtcPointer; // регистр DS3231, с которого пойдёт чтение
+};
+//----------------------------------------------------------------------------------------------------------------
+extern TwoWire Wire;
+//----------------------------------------------------------------------------------------------------------------
+#endif
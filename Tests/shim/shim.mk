@@ -0,0 +1,5 @@
+# реализация замены ядра Arduino и библиотек для тестов, которые собирают исходники прошивки на ПК:
+#   include ../shim/shim.mk  - даёт SHIM_SOURCES и SHIM_HEADERS
+SHIM_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
+SHIM_SOURCES = $(addprefix $(SHIM_DIR),HostShim.cpp WString.cpp Print.cpp Stream.cpp HardwareSerial.cpp SD.cpp EEPROM.cpp Wire.cpp OneWire.cpp)
+SHIM_HEADERS = $(wildcard $(SHIM_DIR)*.h $(SHIM_DIR)*/*.h)
@@ -0,0 +1,40 @@
+#ifndef _HOST_UTIL_CRC16_SHIM_H
+#define _HOST_UTIL_CRC16_SHIM_H
+//----------------------------------------------------------------------------------------------------------------
+// util/crc16.h из avr-libc: те же функции на C вместо ассемблера
+//----------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+//----------------------------------------------------------------------------------------------------------------
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t a)
+{
+  crc ^= a;
+  for(uint8_t i = 0;i < 8;++i)
+    crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+  return crc;
+}
+//----------------------------------------------------------------------------------------------------------------
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+  crc = crc ^ ((uint16_t) data << 8);
+  for(uint8_t i = 0;i < 8;i++)
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  return crc;
+}
+//----------------------------------------------------------------------------------------------------------------
+static inline uint8_t _crc_ibutton_update(uint8_t crc, uint8_t data)
+{
+  crc = crc ^ data;
+  for(uint8_t i = 0;i < 8;i++)
+    crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : (crc >> 1);
+  return crc;
+}
+//----------------------------------------------------------------------------------------------------------------
+static inline uint8_t _crc8_ccitt_update(uint8_t inCrc, uint8_t inData)
+{
+  uint8_t data = inCrc ^ inData;
+  for(uint8_t i = 0;i < 8;i++)
+    data = (data & 0x80) ? (data << 1) ^ 0x07 : (data << 1);
+  return data;
+}
+//----------------------------------------------------------------------------------------------------------------
+#endif
@@ -3,6 +3,7 @@
 #include "Common.h"
 #include "LowLevel.h"
 #include "OneWireSlave.h"
+#include "UniFraming.h"
 //----------------------------------------------------------------------------------------------------------------
 /*
 Прошивка для универсального модуля, предназначена для подключения
@@ -327,9 +328,7 @@ void ProcessNRF()
     if(nrfPacket.controller_id == scratchpadS.controller_id)
     {
        // это пакет с нашего контроллера пришёл, обновляем данные
-       byte checksum = OneWireSlave::crc8((const byte*) &nrfPacket,sizeof(NRFControllerStatePacket)-1);
-       
-       if(checksum == nrfPacket.crc8) // чексумма сошлась
+       if(UniIsCrcValid(nrfPacket)) // чексумма сошлась
        {
       //  Serial.println(F("Update from nRF"));
         UpdateFromControllerState(&(nrfPacket.state));
@@ -407,14 +406,14 @@ void ProcessRS485Packet()
   // начала пакета, поэтому мы сначала ищем заголовок и убеждаемся, что он валидный. 
   // если мы нашли заголовок и он не в начале пакета - значит, с синхронизацией проблемы,
   // и мы должны сдвинуть заголовок в начало пакета, чтобы потом дочитать остаток.
-  if(!(rs485Packet.header1 == 0xAB && rs485Packet.header2 == 0xBA))
+  if(!UniHasPacketHeader(rs485Packet))
   {
      // заголовок неправильный, ищем возможное начало пакета
      byte readPtr = 0;
      bool startPacketFound = false;
      while(readPtr < sizeof(RS485Packet))
      {
-       if(rsPacketPtr[readPtr] == 0xAB)
+       if(rsPacketPtr[readPtr] == UNI_PACKET_HEADER1)
        {
         startPacketFound = true;
         break;
@@ -451,7 +450,7 @@ void ProcessRS485Packet()
   else
   {
     // заголовок правильный, проверяем окончание
-    if(!(rs485Packet.tail1 == 0xDE && rs485Packet.tail2 == 0xAD))
+    if(!UniHasPacketTail(rs485Packet))
     {
       // окончание неправильное, сбрасываем указатель чтения и выходим
       rs485WritePtr = 0;
@@ -461,8 +460,7 @@ void ProcessRS485Packet()
     rs485WritePtr = 0;
 
     // проверяем контрольную сумму
-    byte crc = OneWireSlave::crc8((const byte*) rsPacketPtr,sizeof(RS485Packet) - 1);
-    if(crc != rs485Packet.crc8)
+    if(!UniIsCrcValid(rs485Packet))
     {
       // не сошлось, игнорируем
       return;
@@ -580,7 +578,7 @@ void setup()
     #endif
 
 
-  scratchpadS.crc8 = OneWireSlave::crc8((const byte*) scratchpad,sizeof(scratchpadS)-1);
+  UniSetCrc(scratchpadS);
   memcpy(&scratchpadToSend,&scratchpadS,sizeof(scratchpadS));
   
   OWSlave.setReceiveCallback(&owReceive);
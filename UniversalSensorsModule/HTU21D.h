@@ -98,6 +98,14 @@ SI70xx_TEMP_READ_AFTER_RH_MEASURMENT = 0xE0  //Read Temperature value from previ
 }
 HTU21D_tempOperationMode;
 
+typedef enum
+{
+HTU21D_MEASURE_OK        = 0x00,             //Measurement has been read & CRC8 is valid
+HTU21D_MEASURE_NOT_READY = 0x01,             //Sensor NACKs read request, measurement is still in progress (No Hold master mode)
+HTU21D_MEASURE_ERROR     = 0x02              //CRC8 or communication error
+}
+HTU21D_measureStatus;
+
 typedef enum
 {
 HTU21D_ON  = 0x04,                           //Heater ON
@@ -134,6 +142,12 @@ class HTU21D
    uint16_t readDeviceID(void);
    uint8_t  readFirmwareVersion(void);
 
+   bool                 triggerMeasurement(uint8_t sensorOperationMode);                //Non-blocking: sends trigger command only, use with *_NOHOLD modes
+   uint8_t              measurementTime(bool humidityMeasurement);                      //Max. conversion time for current resolution, msec
+   HTU21D_measureStatus readMeasurement(uint16_t &rawData);                             //Non-blocking: reads result once, no polling
+   static float         rawToHumidity(uint16_t rawHumidity);
+   static float         rawToTemperature(uint16_t rawTemperature);
+
   private:
    HTU21D_Resolution _HTU21D_Resolution;
 
@@ -1,4 +1,5 @@
 #include "OneWireSlave.h"
+#include "UniFraming.h"
 
 // uncomment this line to enable sending messages along with errors (but takes more program memory)
 //#define ERROR_MESSAGES
@@ -227,18 +228,7 @@ void OneWireSlave::alarmed(bool value)
 
 byte OneWireSlave::crc8(const byte* data, short numBytes)
 {
-	byte crc = 0;
-
-	while (numBytes--) {
-		byte inbyte = *data++;
-		for (byte i = 8; i; i--) {
-			byte mix = (crc ^ inbyte) & 0x01;
-			crc >>= 1;
-			if (mix) crc ^= 0x8C;
-			inbyte >>= 1;
-		}
-	}
-	return crc;
+	return UniCrc8(data, numBytes);
 }
 
 void OneWireSlave::setTimerEvent_(short delayMicroSeconds, void(*handler)())
@@ -90,7 +90,7 @@ typedef struct
 #define MEASURE_MIN_TIME 1000 // через сколько минимум можно читать с датчиков после запуска конвертации
 //----------------------------------------------------------------------------------------------------------------
 enum {RS485FromMaster = 1, RS485FromSlave = 2};
-enum {RS485ControllerStatePacket = 1, RS485SensorDataPacket = 2};
+enum {RS485ControllerStatePacket = 1, RS485SensorDataPacket = 2, RS485AllSensorsDataPacket = 3};
 //----------------------------------------------------------------------------------------------------------------
 typedef struct
 {
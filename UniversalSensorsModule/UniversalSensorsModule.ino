@@ -8,6 +8,7 @@
 #include "DHTSupport.h"
 #include "LowLevel.h"
 #include "OneWireSlave.h"
+#include "UniFraming.h"
 //----------------------------------------------------------------------------------------------------------------
 /*
 Прошивка для универсального модуля, предназначена для подключения
@@ -211,14 +212,14 @@ void ProcessRS485Packet()
   // начала пакета, поэтому мы сначала ищем заголовок и убеждаемся, что он валидный. 
   // если мы нашли заголовок и он не в начале пакета - значит, с синхронизацией проблемы,
   // и мы должны сдвинуть заголовок в начало пакета, чтобы потом дочитать остаток.
-  if(!(rs485Packet.header1 == 0xAB && rs485Packet.header2 == 0xBA))
+  if(!UniHasPacketHeader(rs485Packet))
   {
      // заголовок неправильный, ищем возможное начало пакета
      byte readPtr = 0;
      bool startPacketFound = false;
      while(readPtr < sizeof(RS485Packet))
      {
-       if(rsPacketPtr[readPtr] == 0xAB)
+       if(rsPacketPtr[readPtr] == UNI_PACKET_HEADER1)
        {
         startPacketFound = true;
         break;
@@ -255,7 +256,7 @@ void ProcessRS485Packet()
   else
   {
     // заголовок правильный, проверяем окончание
-    if(!(rs485Packet.tail1 == 0xDE && rs485Packet.tail2 == 0xAD))
+    if(!UniHasPacketTail(rs485Packet))
     {
       // окончание неправильное, сбрасываем указатель чтения и выходим
       rs485WritePtr = 0;
@@ -265,8 +266,7 @@ void ProcessRS485Packet()
     rs485WritePtr = 0;
 
     // проверяем контрольную сумму
-    byte crc = OneWireSlave::crc8((const byte*) rsPacketPtr,sizeof(RS485Packet) - 1);
-    if(crc != rs485Packet.crc8)
+    if(!UniIsCrcValid(rs485Packet))
     {
       // не сошлось, игнорируем
       return;
@@ -278,7 +278,7 @@ void ProcessRS485Packet()
     if(rs485Packet.direction != RS485FromMaster) // не от мастера пакет
       return;
 
-    if(rs485Packet.type != RS485SensorDataPacket) // пакет не c запросом показаний датчика
+    if(rs485Packet.type != RS485SensorDataPacket && rs485Packet.type != RS485AllSensorsDataPacket) // пакет не c запросом показаний датчика
       return;
 
      // теперь приводим пакет к нужному виду
@@ -334,14 +334,35 @@ void ProcessRS485Packet()
       Serial.println(" - GOT SENSOR !!!");
       Serial.println(sizeof(RS485Packet));
 */
-     memcpy(readPtr,sMatch->data,4); // у нас 4 байта на показания, копируем их все
+     if(rs485Packet.type == RS485AllSensorsDataPacket)
+     {
+       // просят показания всех наших датчиков сразу: в первом байте - их кол-во,
+       // дальше для каждого - тип датчика, индекс в системе и 4 байта показаний
+       memset(rs485Packet.data,0,sizeof(rs485Packet.data));
+       byte* writePtr = rs485Packet.data;
+       byte* countPtr = writePtr++;
+       
+       sensor* allSensors[] = { &(scratchpadS.sensor1), &(scratchpadS.sensor2), &(scratchpadS.sensor3) };
+       for(byte i=0;i<sizeof(allSensors)/sizeof(allSensors[0]);i++)
+       {
+         if(allSensors[i]->type == uniNone) // нет датчика в слоте
+          continue;
+
+         *writePtr++ = allSensors[i]->type;
+         *writePtr++ = allSensors[i]->index;
+         memcpy(writePtr,allSensors[i]->data,4);
+         writePtr += 4;
+         (*countPtr)++;
+       } // for
+     }
+     else
+      memcpy(readPtr,sMatch->data,4); // у нас 4 байта на показания, копируем их все
 
      // выставляем нужное направление пакета
-     rs485Packet.direction = RS485FromSlave;
-     rs485Packet.type = RS485SensorDataPacket;
+     rs485Packet.direction = RS485FromSlave; // тип пакета оставляем тем же, что и в запросе
 
      // подсчитываем CRC
-     rs485Packet.crc8 = OneWireSlave::crc8((const byte*) &rs485Packet,sizeof(RS485Packet)-1 );
+     UniSetCrc(rs485Packet);
 
      // теперь переключаемся на передачу
      RS485Send();
@@ -1233,7 +1254,7 @@ void sendDataViaNRF()
     uint8_t writePipeNum = random(0,5);
 
     // подсчитываем контрольную сумму
-    scratchpadS.crc8 = OneWireSlave::crc8((const byte*)&scratchpadS,sizeof(scratchpadS)-1);
+    UniSetCrc(scratchpadS);
   //  radio.stopListening(); // останавливаем прослушку
     radio.openWritingPipe(writingPipes[writePipeNum]); // открываем канал для записи
     if(!radio.write(&scratchpadS,sizeof(scratchpadS))) // пишем в него
@@ -1298,7 +1319,7 @@ void setup()
       initNRF();
     #endif
 
-  scratchpadS.crc8 = OneWireSlave::crc8((const byte*) scratchpad,sizeof(scratchpadS)-1);
+  UniSetCrc(scratchpadS);
   memcpy(&scratchpadToSend,&scratchpadS,sizeof(scratchpadS));
 
   oneWireLastCommandTimer = millis();
@@ -1450,7 +1471,7 @@ void loop()
      ReadSensors();
 
      // прочитали, всё в скратчпаде, вычисляем CRC
-     scratchpadS.crc8 = OneWireSlave::crc8((const byte*) scratchpad,sizeof(scratchpadS)-1);
+     UniSetCrc(scratchpadS);
      // и копируем скратчпад в скратчпад для отсылки, чтобы данные оставались валидными до тех пор, пока мастер их не примет.
      memcpy(&scratchpadToSend,&scratchpadS,sizeof(scratchpadS));
 
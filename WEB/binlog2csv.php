@@ -0,0 +1,178 @@
+<?php
+// перевод двоичного лога контроллера (logs/YYYYMMDD.BIN, USE_BINARY_LOG в Globals.h) в формат CSV-лога:
+// HH:MM,MODULE_NAME,SENSOR_TYPE,SENSOR_IDX,SENSOR_DATA
+// (при LOG_CNANGE_NAME_TO_IDX и LOG_CHANGE_TYPE_TO_IDX - индекс модуля и числовой тип, как в CSV-логе с этими настройками)
+// запуск из командной строки: php binlog2csv.php 20170101.BIN > 20170101.LOG
+
+$DictionaryMark = 0xFFFF; // BINARY_LOG_DICTIONARY_MARK - вместо записи идёт словарь
+$FlagNameToIdx = 1; // BINARY_LOG_FLAG_NAME_TO_IDX
+$FlagTypeToIdx = 2; // BINARY_LOG_FLAG_TYPE_TO_IDX
+
+$StateTemperature = 1;
+$StateLuminosity = 4;
+$StateHumidity = 8;
+$StateWaterFlowInstant = 16;
+$StateWaterFlowIncremental = 32;
+$StateSoilMoisture = 64;
+$StatePH = 128;
+
+function fail($message)
+{
+  fwrite(STDERR, $message . "\n");
+  exit(1);
+}
+
+// обрамляем данные по правилам CSV, как это делает контроллер
+function csv($input)
+{
+  $input = str_replace('"', '""', $input);
+  if(strpbrk($input, "\",;\r\n") !== false)
+    return '"' . $input . '"';
+
+  return $input;
+}
+
+// переводим сырые данные в строку так же, как это делает OneState на контроллере
+function formatRawData($type, $raw)
+{
+  global $StateTemperature, $StateHumidity, $StateSoilMoisture, $StatePH, $StateLuminosity;
+
+  switch($type)
+  {
+    case $StateTemperature:
+    case $StateHumidity:
+    case $StateSoilMoisture:
+    case $StatePH:
+      // первый байт - сотые, второй - целая часть со знаком
+      $fract = ord($raw[0]);
+      $value = ord($raw[1]);
+      if($value > 127)
+        $value -= 256;
+      return sprintf("%d,%02u", $value, $fract);
+
+    case $StateLuminosity:
+      // освещённость хранится в двух байтах, 0xFFFF - нет показаний (-1)
+      $lum = unpack("v", substr($raw, 0, 2));
+      $lum = $lum[1];
+      if($lum == 0xFFFF)
+        $lum = -1;
+      return strval($lum);
+
+    default:
+      // расход воды - 4 байта без знака
+      $flow = unpack("V", $raw);
+      return sprintf("%u", $flow[1]);
+  }
+}
+
+if($argc < 2)
+  fail("Usage: php binlog2csv.php FILE.BIN");
+
+$data = file_get_contents($argv[1]);
+if($data === false)
+  fail("Unable to read " . $argv[1]);
+
+$len = strlen($data);
+$pos = 0;
+
+function readByte()
+{
+  global $data, $len, $pos;
+  if($pos >= $len)
+    fail("Unexpected end of file");
+
+  return ord($data[$pos++]);
+}
+
+function readString()
+{
+  global $data, $len, $pos;
+  $strLen = readByte();
+  if($pos + $strLen > $len)
+    fail("Unexpected end of file");
+
+  $str = substr($data, $pos, $strLen);
+  $pos += $strLen;
+  return $str;
+}
+
+// словарь: модули и типы датчиков для всех записей после него
+function readDictionary()
+{
+  global $modules, $types;
+
+  $modules = array();
+  $modulesCount = readByte();
+  for($i = 0; $i < $modulesCount; $i++)
+  {
+    $handle = readByte();
+    $modules[$handle] = readString();
+  }
+
+  $types = array();
+  $typesCount = readByte();
+  for($i = 0; $i < $typesCount; $i++)
+  {
+    $type = readByte();
+    $types[$type] = readString();
+  }
+}
+
+// заголовок
+if(substr($data, 0, 4) != "GHBL")
+  fail("Not a binary log file");
+
+$pos = 4;
+$version = readByte();
+if($version != 1 && $version != 2)
+  fail("Unsupported binary log version: $version");
+
+$recordSize = readByte();
+$pos += 4; // год, месяц и день есть в имени файла
+
+$modules = array();
+$types = array();
+$flags = 0;
+
+if($version == 1)
+  readDictionary(); // в первой версии словарь один, сразу за заголовком
+else
+  $flags = readByte();
+
+// записи и словари
+while($pos + 2 <= $len)
+{
+  $minutes = unpack("v", substr($data, $pos, 2));
+  if($minutes[1] == $DictionaryMark)
+  {
+    // список модулей поменялся или контроллер перезапустился - дальше действует новый словарь
+    $pos += 2;
+    readDictionary();
+    continue;
+  }
+
+  if($pos + $recordSize > $len)
+    break;
+
+  $record = unpack("vminutes/Cmodule/Ctype/Cindex", substr($data, $pos, 5));
+  $raw = substr($data, $pos + 5, 4);
+  $pos += $recordSize;
+
+  if($flags & $FlagNameToIdx)
+    $moduleName = strval($record['module']);
+  else
+    $moduleName = isset($modules[$record['module']]) ? $modules[$record['module']] : strval($record['module']);
+
+  if($flags & $FlagTypeToIdx)
+    $typeName = strval($record['type']);
+  else
+    $typeName = isset($types[$record['type']]) ? $types[$record['type']] : strval($record['type']);
+
+  echo sprintf("%02u:%02u", intval($record['minutes'] / 60), $record['minutes'] % 60) . ","
+    . $moduleName . ","
+    . $typeName . ","
+    . $record['index'] . ","
+    . csv(formatRawData($record['type'], $raw)) . "\r\n";
+}
+
+?>
@@ -53,6 +53,23 @@ class SocketTransport
     return true;
   }
 
+  //
+  // Reads one answer line up to "\n", whatever its length. The controller may keep
+  // the connection open (W5100_KEEP_ALIVE), so an unread tail would be returned
+  // as the answer to the next query: on timeout or partial line the connection is closed
+  //
+  function readLine()
+  {
+     if(!$this->sock)
+       return false;
+
+     $line = @fgets($this->sock);
+     if($line === false || substr($line,-1) != "\n")
+      $this->close();
+
+     return $line;
+  }
+
   //
   // Base query method
   //
@@ -64,7 +81,9 @@ class SocketTransport
      @fwrite($this->sock, 'CTGET=' . $query . "\r\n");
      @stream_set_timeout($this->sock,$this->timeout);
      
-     $line = @fgets($this->sock,1024);
+     $line = $this->readLine();
+     if($line === false)
+      return false;
      
      $pos = strstr($line,"OK=FOLLOW");
      if($pos === false)
@@ -74,7 +93,9 @@ class SocketTransport
 
      while(true)
      {
-        $line = @fgets($this->sock,1024);
+        $line = $this->readLine();
+        if($line === false)
+          break;
         $data .= $line;
         $pos = strstr($line,"OK=LOG|END_OF_FILE");
         if(!($pos === false))
@@ -85,6 +106,98 @@ class SocketTransport
               
     // return @fgets($this->sock);
   }
+  //
+  // Binary status: CTGET=0|STATB. Returns the same text as ctget('0|STAT'),
+  // so existing parsers can be used, or false on error or CRC mismatch
+  //
+  function ctgetBinaryStatus()
+  {
+      if(!$this->sock)
+        return false;
+
+     @fwrite($this->sock, "CTGET=0|STATB\r\n");
+     @stream_set_timeout($this->sock,$this->timeout);
+
+     $line = trim($this->readLine());
+     if(!$this->sock || strpos($line,"OK=STATB|") !== 0)
+      return false;
+
+     $length = intval(substr($line,9));
+     $data = '';
+     $toRead = $length + 2; // data and CRC16
+
+     while(strlen($data) < $toRead)
+     {
+        $chunk = @fread($this->sock, $toRead - strlen($data));
+        if($chunk === false || $chunk === '')
+          return false;
+        $data .= $chunk;
+     }
+
+     $payload = substr($data,0,$length);
+     $crc = (ord($data[$length]) << 8) | ord($data[$length+1]);
+     if($crc != self::crc16($payload))
+      return false;
+
+     return self::binaryStatusToText($payload);
+  }
+
+  //
+  // CRC16 as computed by the controller (_crc16_update, polynomial 0xA001)
+  //
+  static function crc16($data)
+  {
+    $crc = 0;
+    $len = strlen($data);
+    for($i = 0; $i < $len; $i++)
+    {
+      $crc ^= ord($data[$i]);
+      for($bit = 0; $bit < 8; $bit++)
+      {
+        if($crc & 1)
+          $crc = ($crc >> 1) ^ 0xA001;
+        else
+          $crc >>= 1;
+      }
+    }
+    return $crc;
+  }
+
+  //
+  // Converts STATB payload into CTGET=0|STAT answer: hex bytes, module names as is
+  //
+  static function binaryStatusToText($payload)
+  {
+    // data sizes of sensors, in the order the controller writes them:
+    // temperature, humidity, luminosity, water flow (instant, incremental), soil moisture, pH
+    $types = array(1 => 2, 8 => 2, 4 => 2, 16 => 4, 32 => 4, 64 => 2, 128 => 2);
+
+    $len = strlen($payload);
+    $pos = 2; // status bytes
+    $text = 'OK=' . strtoupper(bin2hex(substr($payload,0,2)));
+
+    while($pos < $len)
+    {
+      $flags = ord($payload[$pos++]);
+      $nameLen = ord($payload[$pos++]);
+      $text .= sprintf("%02X%02X", $flags, $nameLen) . substr($payload,$pos,$nameLen);
+      $pos += $nameLen;
+
+      foreach($types as $type => $dataSize)
+      {
+        if(!($flags & $type))
+          continue;
+
+        $cnt = ord($payload[$pos++]);
+        $recordSize = $cnt * (1 + $dataSize);
+        $text .= sprintf("%02X", $cnt) . strtoupper(bin2hex(substr($payload,$pos,$recordSize)));
+        $pos += $recordSize;
+      }
+    }
+
+    return $text . "\r\n";
+  }
+
   //
   //  Base set method
   //
@@ -96,7 +209,7 @@ class SocketTransport
      @fwrite($this->sock, 'CTSET=' . $query . "\r\n");
      @stream_set_timeout($this->sock,$this->timeout);
                
-     return @fgets($this->sock, 1024);
+     return $this->readLine();
   }
 
 